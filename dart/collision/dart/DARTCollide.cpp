@@ -32,8 +32,9 @@
 
 #include "dart/collision/dart/DARTCollide.hpp"
 
+#include <atomic>
 #include <memory>
-#include <thread>
+#include <unordered_map>
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -3525,12 +3526,37 @@ inline void setCcdDefaultSettings(ccd_t& ccd)
   ccd.max_iterations = 10000;
 }
 
+/// The CCD collision search data is cached per thread, so that worlds can be
+/// stepped on many threads at once without any locking. Clearing bumps a
+/// global generation counter, and each thread lazily drops its own cache the
+/// next time it notices the generation has changed.
+static std::atomic<long> _ccdCacheGeneration(0);
+
+struct CcdCache
+{
+  long generation = -1;
+  std::unordered_map<long, ccd_vec3_t> values;
+
+  std::unordered_map<long, ccd_vec3_t>& get()
+  {
+    long currentGeneration = _ccdCacheGeneration.load();
+    if (generation != currentGeneration)
+    {
+      values.clear();
+      generation = currentGeneration;
+    }
+    return values;
+  }
+};
+
+static thread_local CcdCache _ccdDirCache;
+static thread_local CcdCache _ccdPosCache;
+
 /// This allows us to prevent weird effects where we don't want to carry over
 /// cacheing
 void clearCcdCache()
 {
-  _ccdDirCache.clear();
-  _ccdPosCache.clear();
+  _ccdCacheGeneration++;
 }
 
 /*
@@ -3696,8 +3722,7 @@ bool get2DLineIntersection(
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 {
   long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& pos = _ccdPosCache[tid][key];
+  ccd_vec3_t& pos = _ccdPosCache.get()[key];
   return pos;
 }
 
@@ -3705,8 +3730,7 @@ ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2)
 {
   long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& dir = _ccdDirCache[tid][key];
+  ccd_vec3_t& dir = _ccdDirCache.get()[key];
   return dir;
 }
 
@@ -421,12 +421,6 @@ inline void setCcdDefaultSettings(ccd_t& ccd);
 /// cacheing
 void clearCcdCache();
 
-/// This is the static cache for all the CCD collision search data
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdDirCache;
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdPosCache;
-
 } // namespace collision
 } // namespace dart
 
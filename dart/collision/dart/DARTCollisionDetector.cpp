@@ -147,28 +147,41 @@ bool DARTCollisionDetector::collide(
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
-  for (auto i = 0u; i < objects.size() - 1; ++i)
-  {
-    auto* collObj1 = objects[i];
+  // This runs the narrowphase on a pair, and returns true once we can stop
+  // checking
+  auto checkCandidate = [&](CollisionObject* collObj1,
+                            CollisionObject* collObj2) {
+    if (filter && filter->ignoresCollision(collObj1, collObj2))
+      return false;
 
-    for (auto j = i + 1u; j < objects.size(); ++j)
-    {
-      auto* collObj2 = objects[j];
+    if (checkPair(collObj1, collObj2, option, result))
+      collisionFound = true;
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    if (result)
+      return result->getNumContacts() >= option.maxNumContacts;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    // If no result is passed, stop checking when the first contact is found
+    return collisionFound;
+  };
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
+  if (casted->mBroadphaseEnabled)
+  {
+    // The pairs come back in the same order as the nested loop below, so this
+    // finds exactly the same contacts, it just skips pairs that can't touch
+    casted->updateBoundingBoxes();
+    for (const auto& pair : casted->computeOverlappingPairs())
+    {
+      if (checkCandidate(objects[pair.first], objects[pair.second]))
+        return true;
+    }
+  }
+  else
+  {
+    for (auto i = 0u; i < objects.size() - 1; ++i)
+    {
+      for (auto j = i + 1u; j < objects.size(); ++j)
       {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
+        if (checkCandidate(objects[i], objects[j]))
           return true;
       }
     }
@@ -209,6 +222,16 @@ bool DARTCollisionDetector::collide(
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
+  // Culling with the bounding boxes is much cheaper than the narrowphase, even
+  // though we still test every pair of boxes
+  const auto useBroadphase
+      = casted1->mBroadphaseEnabled && casted2->mBroadphaseEnabled;
+  if (useBroadphase)
+  {
+    casted1->updateBoundingBoxes();
+    casted2->updateBoundingBoxes();
+  }
+
   for (auto i = 0u; i < objects1.size(); ++i)
   {
     auto* collObj1 = objects1[i];
@@ -217,10 +240,14 @@ bool DARTCollisionDetector::collide(
     {
       auto* collObj2 = objects2[j];
 
+      if (useBroadphase && !casted1->boundingBoxesOverlap(i, casted2, j))
+        continue;
+
       if (filter && filter->ignoresCollision(collObj1, collObj2))
         continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+      if (checkPair(collObj1, collObj2, option, result))
+        collisionFound = true;
 
       if (result)
       {
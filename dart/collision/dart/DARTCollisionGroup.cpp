@@ -32,7 +32,12 @@
 
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 
+#include <algorithm>
+#include <limits>
+
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/Shape.hpp"
+#include "dart/math/Geometry.hpp"
 
 namespace dart {
 namespace collision {
@@ -40,11 +45,156 @@ namespace collision {
 //==============================================================================
 DARTCollisionGroup::DARTCollisionGroup(
     const CollisionDetectorPtr& collisionDetector)
-  : CollisionGroup(collisionDetector)
+  : CollisionGroup(collisionDetector),
+    mBroadphaseEnabled(true),
+    mBroadphaseMargin(1e-2),
+    mSweepOrderDirty(true),
+    mSweepAxis(0)
 {
   // Do nothing
 }
 
+//==============================================================================
+void DARTCollisionGroup::setBroadphaseEnabled(bool enabled)
+{
+  mBroadphaseEnabled = enabled;
+}
+
+//==============================================================================
+bool DARTCollisionGroup::getBroadphaseEnabled() const
+{
+  return mBroadphaseEnabled;
+}
+
+//==============================================================================
+void DARTCollisionGroup::setBroadphaseMargin(double margin)
+{
+  mBroadphaseMargin = margin;
+}
+
+//==============================================================================
+double DARTCollisionGroup::getBroadphaseMargin() const
+{
+  return mBroadphaseMargin;
+}
+
+//==============================================================================
+void DARTCollisionGroup::updateBoundingBoxes()
+{
+  const std::size_t n = mCollisionObjects.size();
+  mBoundingBoxMin.resize(n);
+  mBoundingBoxMax.resize(n);
+
+  Eigen::Vector3d centerSum = Eigen::Vector3d::Zero();
+  Eigen::Vector3d centerSquaredSum = Eigen::Vector3d::Zero();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const CollisionObject* object = mCollisionObjects[i];
+    const math::BoundingBox& box = object->getShape()->getBoundingBox();
+    const Eigen::Isometry3d& transform = object->getTransform();
+
+    const Eigen::Vector3d center = transform * box.computeCenter();
+    const Eigen::Vector3d halfExtents
+        = transform.linear().cwiseAbs() * box.computeHalfExtents().cwiseAbs()
+          + Eigen::Vector3d::Constant(mBroadphaseMargin);
+
+    if (center.allFinite() && halfExtents.allFinite())
+    {
+      mBoundingBoxMin[i] = center - halfExtents;
+      mBoundingBoxMax[i] = center + halfExtents;
+      centerSum += center;
+      centerSquaredSum += center.cwiseProduct(center);
+    }
+    else
+    {
+      // If we can't bound the shape (an empty mesh, say), it has to be checked
+      // against everything
+      mBoundingBoxMin[i]
+          = Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity());
+      mBoundingBoxMax[i]
+          = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+    }
+  }
+
+  // Sweeping along the axis with the most variance culls the most pairs
+  int axis = mSweepAxis;
+  if (n > 0)
+  {
+    const Eigen::Vector3d mean = centerSum / n;
+    const Eigen::Vector3d variance
+        = centerSquaredSum / n - mean.cwiseProduct(mean);
+    variance.maxCoeff(&axis);
+  }
+
+  auto isBelow = [this](std::size_t a, std::size_t b) {
+    return mBoundingBoxMin[a](mSweepAxis) < mBoundingBoxMin[b](mSweepAxis);
+  };
+
+  if (mSweepOrderDirty || axis != mSweepAxis || mSweepOrder.size() != n)
+  {
+    mSweepAxis = axis;
+    mSweepOrder.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      mSweepOrder[i] = i;
+    std::sort(mSweepOrder.begin(), mSweepOrder.end(), isBelow);
+    mSweepOrderDirty = false;
+  }
+  else
+  {
+    // Insertion sort is linear on the nearly sorted order from the last call
+    for (std::size_t i = 1; i < n; ++i)
+    {
+      const std::size_t index = mSweepOrder[i];
+      std::size_t j = i;
+      while (j > 0 && isBelow(index, mSweepOrder[j - 1]))
+      {
+        mSweepOrder[j] = mSweepOrder[j - 1];
+        --j;
+      }
+      mSweepOrder[j] = index;
+    }
+  }
+}
+
+//==============================================================================
+const std::vector<std::pair<std::size_t, std::size_t>>&
+DARTCollisionGroup::computeOverlappingPairs()
+{
+  mOverlappingPairs.clear();
+
+  const std::size_t n = mSweepOrder.size();
+  for (std::size_t a = 0; a < n; ++a)
+  {
+    const std::size_t i = mSweepOrder[a];
+    for (std::size_t b = a + 1; b < n; ++b)
+    {
+      const std::size_t j = mSweepOrder[b];
+
+      // Everything after this starts above the top of i along the sweep axis
+      if (mBoundingBoxMin[j](mSweepAxis) > mBoundingBoxMax[i](mSweepAxis))
+        break;
+
+      if (boundingBoxesOverlap(i, this, j))
+        mOverlappingPairs.emplace_back(std::min(i, j), std::max(i, j));
+    }
+  }
+
+  // Put the pairs back in the order of a nested loop over mCollisionObjects
+  std::sort(mOverlappingPairs.begin(), mOverlappingPairs.end());
+
+  return mOverlappingPairs;
+}
+
+//==============================================================================
+bool DARTCollisionGroup::boundingBoxesOverlap(
+    std::size_t i, const DARTCollisionGroup* other, std::size_t j) const
+{
+  return (mBoundingBoxMin[i].array() <= other->mBoundingBoxMax[j].array())
+             .all()
+         && (other->mBoundingBoxMin[j].array() <= mBoundingBoxMax[i].array())
+                .all();
+}
+
 //==============================================================================
 void DARTCollisionGroup::initializeEngineData()
 {
@@ -58,6 +208,7 @@ void DARTCollisionGroup::addCollisionObjectToEngine(CollisionObject* object)
       == mCollisionObjects.end())
   {
     mCollisionObjects.push_back(object);
+    mSweepOrderDirty = true;
   }
 }
 
@@ -75,12 +226,14 @@ void DARTCollisionGroup::removeCollisionObjectFromEngine(
 {
   mCollisionObjects.erase(
       std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object));
+  mSweepOrderDirty = true;
 }
 
 //==============================================================================
 void DARTCollisionGroup::removeAllCollisionObjectsFromEngine()
 {
   mCollisionObjects.clear();
+  mSweepOrderDirty = true;
 }
 
 //==============================================================================
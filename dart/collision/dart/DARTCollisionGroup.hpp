@@ -33,6 +33,11 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
 #include "dart/collision/CollisionGroup.hpp"
 
 namespace dart {
@@ -52,6 +57,23 @@ public:
   /// Destructor
   virtual ~DARTCollisionGroup() = default;
 
+  /// Enables or disables the sweep-and-prune broadphase. With the broadphase
+  /// disabled, DARTCollisionDetector runs the narrowphase on every pair of
+  /// objects, which is only really useful for benchmarking and testing. The
+  /// broadphase is enabled by default.
+  void setBroadphaseEnabled(bool enabled);
+
+  /// Returns true if the broadphase is enabled
+  bool getBroadphaseEnabled() const;
+
+  /// The broadphase inflates the bounding box of each object by this much on
+  /// every side, so that pairs which are just barely touching always reach the
+  /// narrowphase. This defaults to 1e-2.
+  void setBroadphaseMargin(double margin);
+
+  /// Returns the amount the broadphase inflates bounding boxes by
+  double getBroadphaseMargin() const;
+
 protected:
 
   // Documentation inherited
@@ -75,9 +97,56 @@ protected:
 
 protected:
 
+  /// This recomputes the world space bounding boxes of the objects in this
+  /// group from their current transforms, and re-sorts them along the sweep
+  /// axis. Objects mostly move a little between calls, so the previous order
+  /// is nearly sorted, and this is usually linear in the number of objects.
+  void updateBoundingBoxes();
+
+  /// This returns every pair (i, j) of indices into mCollisionObjects, with
+  /// i < j, whose bounding boxes overlap. Call updateBoundingBoxes() first.
+  /// The pairs are in the same order that a nested loop over the objects would
+  /// visit them in, so the narrowphase produces exactly the same contacts (in
+  /// the same order) as checking every pair would.
+  const std::vector<std::pair<std::size_t, std::size_t>>&
+  computeOverlappingPairs();
+
+  /// Returns true if the bounding box of object `i` in this group overlaps the
+  /// bounding box of object `j` in `other`. Call updateBoundingBoxes() on both
+  /// groups first.
+  bool boundingBoxesOverlap(
+      std::size_t i, const DARTCollisionGroup* other, std::size_t j) const;
+
   /// CollisionObjects added to this DARTCollisionGroup
   std::vector<CollisionObject*> mCollisionObjects;
 
+  /// True if the broadphase is enabled
+  bool mBroadphaseEnabled;
+
+  /// The amount we inflate bounding boxes by, on every side
+  double mBroadphaseMargin;
+
+  /// This is set when objects are added or removed, which invalidates
+  /// mSweepOrder
+  bool mSweepOrderDirty;
+
+  /// The axis we sort along, which is the one the objects are most spread out
+  /// along
+  int mSweepAxis;
+
+  /// The world space bounding box of each object, in the same order as
+  /// mCollisionObjects
+  std::vector<Eigen::Vector3d> mBoundingBoxMin;
+  std::vector<Eigen::Vector3d> mBoundingBoxMax;
+
+  /// Indices into mCollisionObjects, sorted by the bottom of their bounding
+  /// boxes along mSweepAxis
+  std::vector<std::size_t> mSweepOrder;
+
+  /// The result of the last computeOverlappingPairs(), kept to avoid
+  /// reallocating on every call
+  std::vector<std::pair<std::size_t, std::size_t>> mOverlappingPairs;
+
 };
 
 }  // namespace collision
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/common/ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace dart {
+namespace common {
+
+namespace {
+
+/// The pool that owns the current thread (if any), and the thread's index in
+/// that pool
+thread_local const ThreadPool* tCurrentPool = nullptr;
+thread_local int tCurrentWorkerIndex = -1;
+
+} // namespace
+
+//==============================================================================
+ThreadPool::ThreadPool(std::size_t numThreads)
+  : mNextQueue(0), mNumShared(0), mShutdown(false)
+{
+  if (numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  mQueues.reserve(numThreads);
+  for (std::size_t i = 0; i < numThreads; i++)
+  {
+    mQueues.push_back(std::make_unique<WorkerQueue>());
+  }
+  mThreads.reserve(numThreads);
+  for (std::size_t i = 0; i < numThreads; i++)
+  {
+    mThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+//==============================================================================
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    mShutdown = true;
+  }
+  mWakeCondition.notify_all();
+  for (std::thread& thread : mThreads)
+  {
+    thread.join();
+  }
+}
+
+//==============================================================================
+std::size_t ThreadPool::getNumThreads() const
+{
+  return mThreads.size();
+}
+
+//==============================================================================
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+  std::packaged_task<void()> packaged(std::move(task));
+  std::future<void> future = packaged.get_future();
+  WorkerQueue& queue = *mQueues[mNextQueue++ % mQueues.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    queue.mShared.push_back(std::move(packaged));
+    mNumShared++;
+  }
+  // Taking mWakeMutex makes sure a worker that just found nothing to do is
+  // either already waiting (and gets notified), or will see the new task
+  {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+  }
+  mWakeCondition.notify_one();
+  return future;
+}
+
+//==============================================================================
+std::future<void> ThreadPool::submitToWorker(
+    std::size_t worker, std::function<void()> task)
+{
+  std::packaged_task<void()> packaged(std::move(task));
+  std::future<void> future = packaged.get_future();
+  WorkerQueue& queue = *mQueues[worker % mQueues.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    queue.mPinned.push_back(std::move(packaged));
+    queue.mNumPinned++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+  }
+  // We need to be sure that the specific worker we're targeting wakes up
+  mWakeCondition.notify_all();
+  return future;
+}
+
+//==============================================================================
+void ThreadPool::parallelFor(
+    std::size_t n, const std::function<void(std::size_t)>& fn)
+{
+  if (getCurrentWorkerIndex() != -1)
+  {
+    for (std::size_t i = 0; i < n; i++)
+      fn(i);
+    return;
+  }
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(n);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    futures.push_back(submit([&fn, i]() { fn(i); }));
+  }
+
+  // Wait on everything before rethrowing, since the tasks reference `fn`
+  std::exception_ptr firstException = nullptr;
+  for (std::future<void>& future : futures)
+  {
+    try
+    {
+      future.get();
+    }
+    catch (...)
+    {
+      if (firstException == nullptr)
+        firstException = std::current_exception();
+    }
+  }
+  if (firstException != nullptr)
+    std::rethrow_exception(firstException);
+}
+
+//==============================================================================
+int ThreadPool::getCurrentWorkerIndex() const
+{
+  return tCurrentPool == this ? tCurrentWorkerIndex : -1;
+}
+
+//==============================================================================
+std::shared_ptr<ThreadPool> ThreadPool::getDefault()
+{
+  static std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>();
+  return pool;
+}
+
+//==============================================================================
+void ThreadPool::workerLoop(std::size_t index)
+{
+  tCurrentPool = this;
+  tCurrentWorkerIndex = static_cast<int>(index);
+
+  while (true)
+  {
+    std::packaged_task<void()> task;
+    if (popTask(index, task))
+    {
+      // Exceptions are captured in the task's future
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    // Check for work first, so we drain the queues before shutting down
+    if (!hasWork(index) && mShutdown)
+      return;
+    mWakeCondition.wait(lock, [&]() { return hasWork(index) || mShutdown; });
+  }
+}
+
+//==============================================================================
+bool ThreadPool::popTask(std::size_t index, std::packaged_task<void()>& out)
+{
+  {
+    WorkerQueue& own = *mQueues[index];
+    std::lock_guard<std::mutex> lock(own.mMutex);
+    if (!own.mPinned.empty())
+    {
+      out = std::move(own.mPinned.front());
+      own.mPinned.pop_front();
+      own.mNumPinned--;
+      return true;
+    }
+    if (!own.mShared.empty())
+    {
+      out = std::move(own.mShared.front());
+      own.mShared.pop_front();
+      mNumShared--;
+      return true;
+    }
+  }
+  // Steal from the back of the other workers' queues. We only try_lock them,
+  // so we never stall a worker that's busy with its own queue. If we miss a
+  // task because its queue was locked, mNumShared stays above zero, so we'll
+  // come straight back here instead of going to sleep.
+  for (std::size_t offset = 1; offset < mQueues.size(); offset++)
+  {
+    WorkerQueue& other = *mQueues[(index + offset) % mQueues.size()];
+    std::unique_lock<std::mutex> lock(other.mMutex, std::try_to_lock);
+    if (lock.owns_lock() && !other.mShared.empty())
+    {
+      out = std::move(other.mShared.back());
+      other.mShared.pop_back();
+      mNumShared--;
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+bool ThreadPool::hasWork(std::size_t index) const
+{
+  return mNumShared > 0 || mQueues[index]->mNumPinned > 0;
+}
+
+} // namespace common
+} // namespace dart
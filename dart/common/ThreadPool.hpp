@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_THREADPOOL_HPP_
+#define DART_COMMON_THREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+/// A persistent pool of worker threads. Each worker has its own queue of
+/// tasks, behind its own lock. Tasks submitted with submit() may be stolen by
+/// any idle worker, which keeps all the workers busy when tasks have uneven
+/// costs. Thieves only try_lock other workers' queues, so they never block a
+/// worker that's popping from its own queue. Tasks submitted with
+/// submitToWorker() will only ever run on that worker, which is useful when a
+/// task touches state that belongs to a specific worker.
+class ThreadPool
+{
+public:
+  /// Creates a pool with `numThreads` workers. If `numThreads` is 0, this uses
+  /// one worker per hardware thread.
+  explicit ThreadPool(std::size_t numThreads = 0);
+
+  /// Finishes all queued tasks, then joins the workers
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Returns the number of worker threads in this pool
+  std::size_t getNumThreads() const;
+
+  /// Queues a task to be run by whichever worker gets to it first
+  std::future<void> submit(std::function<void()> task);
+
+  /// Queues a task that will only be run by the `worker`'th worker thread
+  /// (modulo the number of threads)
+  std::future<void> submitToWorker(
+      std::size_t worker, std::function<void()> task);
+
+  /// Runs fn(i) for every i in [0, n) across the pool, and blocks until they've
+  /// all finished. If any of the calls throw, this rethrows the first
+  /// exception after all the calls have finished. If this is called from one of
+  /// this pool's own workers, the calls run serially on the calling thread to
+  /// avoid deadlocking the pool.
+  void parallelFor(std::size_t n, const std::function<void(std::size_t)>& fn);
+
+  /// Returns the index of the pool worker that's calling this, or -1 if the
+  /// calling thread isn't a worker in this pool.
+  int getCurrentWorkerIndex() const;
+
+  /// Returns a lazily created pool, shared across the whole process, with one
+  /// worker per hardware thread.
+  static std::shared_ptr<ThreadPool> getDefault();
+
+protected:
+  struct WorkerQueue
+  {
+    /// Guards both deques
+    std::mutex mMutex;
+    /// Tasks that any worker may steal
+    std::deque<std::packaged_task<void()>> mShared;
+    /// Tasks that may only run on this worker
+    std::deque<std::packaged_task<void()>> mPinned;
+    /// The size of mPinned, so a sleeping worker can check it without taking
+    /// mMutex. This only changes with mMutex held.
+    std::atomic<std::size_t> mNumPinned{0};
+  };
+
+  /// The main loop for each worker thread
+  void workerLoop(std::size_t index);
+
+  /// Finds the next task for worker `index` to run, taking the queue locks it
+  /// needs. Returns false if there's nothing to do.
+  bool popTask(std::size_t index, std::packaged_task<void()>& out);
+
+  /// Returns true if worker `index` has something it could run. This must be
+  /// called with mWakeMutex held.
+  bool hasWork(std::size_t index) const;
+
+  std::vector<std::thread> mThreads;
+  std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+  std::atomic<std::size_t> mNextQueue;
+  /// The total number of tasks sitting in all the mShared queues. Each change
+  /// happens with the lock of the queue that changed held, so this never
+  /// counts a task that's already been popped.
+  std::atomic<std::size_t> mNumShared;
+
+  // Idle workers sleep on mWakeCondition. The queues have their own locks, so
+  // this mutex only orders going to sleep against new tasks arriving, so
+  // wakeups aren't lost.
+  bool mShutdown;
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCondition;
+};
+
+} // namespace common
+} // namespace dart
+
+#endif // DART_COMMON_THREADPOOL_HPP_
@@ -168,6 +168,12 @@ ConstBoxedLcpSolverPtr BoxedLcpConstraintSolver::getSecondaryBoxedLcpSolver()
   return mSecondaryBoxedLcpSolver;
 }
 
+//==============================================================================
+const BoxedLcpWorkspace& BoxedLcpConstraintSolver::getWorkspace() const
+{
+  return mWorkspace;
+}
+
 /// This gets the cached LCP solution, which is useful to be able to get/set
 /// because it can effect the forward solutions of physics problems because of
 /// our optimistic LCP-stabilization-to-acceptance approach.
@@ -196,11 +202,20 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   if (0u == n)
     return;
 
+  // Lay out all our scratch buffers. This only touches the heap if this is the
+  // biggest LCP we've seen so far.
+  mWorkspace.resize(n, numConstraints);
+  auto& mA = mWorkspace.A;
+  auto& mB = mWorkspace.b;
+  auto& mW = mWorkspace.w;
+  auto& mLo = mWorkspace.lo;
+  auto& mHi = mWorkspace.hi;
+  auto& mFIndex = mWorkspace.fIndex;
+  auto& mOffset = mWorkspace.offset;
+
   const int nSkip = dPAD(n); // nSkip = n + (n % 4);
-#ifdef NDEBUG                // release
-  mA.resize(n, nSkip);
-#else // debug
-  mA.setZero(n, nSkip); // rows = n, cols = n + (n % 4)
+#ifndef NDEBUG
+  mA.setZero(); // rows = n, cols = n + (n % 4)
 #endif
   bool mXResized = mX.size() != n;
   if (mXResized)
@@ -208,14 +223,10 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     mX.resize(n);
     mX.setZero();
   }
-  mB.resize(n);
-  mW.setZero(n); // set w to 0
-  mLo.resize(n);
-  mHi.resize(n);
-  mFIndex.setConstant(n, -1); // set findex to -1
+  mW.setZero();            // set w to 0
+  mFIndex.setConstant(-1); // set findex to -1
 
   // Compute offset indices
-  mOffset.resize(numConstraints);
   mOffset[0] = 0;
   for (std::size_t i = 1; i < numConstraints; ++i)
   {
@@ -252,7 +263,6 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     // Fill a matrix by impulse tests: A
     constraint->excite();
 
-    double* impulses = new double[constraint->getDimension()];
     for (std::size_t j = 0; j < constraint->getDimension(); ++j)
     {
       // Adjust findex for global index
@@ -319,7 +329,6 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
             constraint, j);
       }
     }
-    delete[] impulses;
 
     assert(isSymmetric(
         n, mA.data(), mOffset[i], mOffset[i] + constraint->getDimension() - 1));
@@ -344,33 +353,25 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   std::cout << std::endl;
   */
 
-  // Solve LCP using the primary solver and fallback to secondary solver when
-  // the parimary solver failed.
-  if (mSecondaryBoxedLcpSolver)
-  {
-    // Make backups for the secondary LCP solver because the primary solver
-    // modifies the original terms.
-    mABackup = mA;
-    mXBackup = mX;
-    mBBackup = mB;
-    mLoBackup = mLo;
-    mHiBackup = mHi;
-    mFIndexBackup = mFIndex;
-  }
-  // Always make backups of these variables, regardless of whether we're using
-  // a secondary solver, because we need them for gradients
-  Eigen::VectorXd loGradientBackup = mLo;
-  Eigen::VectorXd hiGradientBackup = mHi;
-  Eigen::VectorXi fIndexGradientBackup = mFIndex;
-  Eigen::VectorXd bGradientBackup = mB;
-  Eigen::VectorXd aColNormGradientBackup = Eigen::VectorXd::Zero(n);
-  for (std::size_t i = 0; i < n; i++)
-  {
-    aColNormGradientBackup(i) = mA.col(i).squaredNorm();
-  }
+  // Take pristine copies of the LCP before any solver runs, because the
+  // solvers modify the original terms in place. We need these to restart the
+  // secondary solver if the primary one fails, to check solutions, and for
+  // gradients.
+  auto& aBackup = mWorkspace.ABackup;
+  auto& xBackup = mWorkspace.xBackup;
+  auto& bBackup = mWorkspace.bBackup;
+  auto& loBackup = mWorkspace.loBackup;
+  auto& hiBackup = mWorkspace.hiBackup;
+  auto& fIndexBackup = mWorkspace.fIndexBackup;
+  auto& aColNorms = mWorkspace.aColNorms;
   // mA can actually be non-square, for efficiency reasons, so we make sure we
   // keep just the square block.
-  Eigen::MatrixXd aGradientBackup = mA.block(0, 0, n, n);
+  aBackup = mA.leftCols(n);
+  bBackup = mB;
+  loBackup = mLo;
+  hiBackup = mHi;
+  fIndexBackup = mFIndex;
+  aColNorms = aBackup.colwise().squaredNorm().transpose();
 
   bool success = false;
   bool shortCircuitLCP = false;
@@ -380,9 +381,9 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   // reasonable guess, since those are often correct.
   if (mXResized)
   {
-    mX = LCPUtils::guessSolution(aGradientBackup, mB, mHi, mLo, mFIndex);
-    mXBackup = mX;
+    mX = LCPUtils::guessSolution(aBackup, mB, mHi, mLo, mFIndex);
   }
+  xBackup = mX;
 
   // Pre-solve, if we're using gradients. We're going to assume that the
   // initialization mX is from last time step, and then guess that nothing has
@@ -401,14 +402,7 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     std::shared_ptr<neural::ConstrainedGroupGradientMatrices> grads
         = group.getGradientConstraintMatrices();
     grads->registerLCPResults(
-        mX,
-        mHi,
-        mLo,
-        mFIndex,
-        mB,
-        aColNormGradientBackup,
-        aGradientBackup,
-        false);
+        mX, mHi, mLo, mFIndex, mB, aColNorms, aBackup, false);
     grads->constructMatrices(world);
     success = grads->areResultsStandardized();
     // If this worked, we don't need to reconstruct our constraint matrices,
@@ -426,63 +420,7 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   {
     const bool earlyTermination = (mSecondaryBoxedLcpSolver != nullptr);
     assert(mBoxedLcpSolver);
-
-    Eigen::MatrixXd mAReduced = mA.block(0, 0, n, n);
-    Eigen::VectorXd mXReduced = mX;
-    Eigen::VectorXd mBReduced = mB;
-    Eigen::VectorXd mHiReduced = mHi;
-    Eigen::VectorXd mLoReduced = mLo;
-    Eigen::VectorXi mFIndexReduced = mFIndex;
-    Eigen::MatrixXd mapOut = LCPUtils::reduce(
-        mAReduced,
-        mXReduced,
-        mBReduced,
-        mHiReduced,
-        mLoReduced,
-        mFIndexReduced);
-    int reducedN = mXReduced.size();
-    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-        reducedAPadded = Eigen::MatrixXd::Zero(reducedN, dPAD(reducedN));
-    reducedAPadded.block(0, 0, reducedN, reducedN) = mAReduced;
-
-    success = mBoxedLcpSolver->solve(
-        reducedN,
-        reducedAPadded.data(),
-        mXReduced.data(),
-        mBReduced.data(),
-        0,
-        mLoReduced.data(),
-        mHiReduced.data(),
-        mFIndexReduced.data(),
-        earlyTermination);
-
-    if (success)
-    {
-      mX = mapOut * mXReduced;
-      // Double check if the LCP solution is valid. The ODE solver can sometimes
-      // return invalid solutions with success=true >:(
-      if (!LCPUtils::isLCPSolutionValid(
-              aGradientBackup,
-              mX,
-              mBBackup,
-              mHiBackup,
-              mLoBackup,
-              mFIndexBackup,
-              false))
-      {
-        /*
-        std::cout << "ODE failed to produce a valid solution" << std::endl;
-        LCPUtils::printReplicationCode(
-            aGradientBackup,
-            mXBackup,
-            mLoBackup,
-            mHiBackup,
-            mBBackup,
-            mFIndexBackup);
-        */
-        success = false;
-      }
-    }
+    success = solveFromBackup(mBoxedLcpSolver.get(), earlyTermination);
   }
 
   // Sanity check. LCP solvers should not report success with nan values, but
@@ -498,51 +436,9 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   // If Dantzig failed to solve the problem, fall back to PGS
   if (!success && mSecondaryBoxedLcpSolver)
   {
-    Eigen::MatrixXd mAReduced = mABackup.block(0, 0, n, n);
-    Eigen::VectorXd mXReduced = mXBackup;
-    Eigen::VectorXd mBReduced = mBBackup;
-    Eigen::VectorXd mHiReduced = mHiBackup;
-    Eigen::VectorXd mLoReduced = mLoBackup;
-    Eigen::VectorXi mFIndexReduced = mFIndexBackup;
-    Eigen::MatrixXd mapOut = LCPUtils::reduce(
-        mAReduced,
-        mXReduced,
-        mBReduced,
-        mHiReduced,
-        mLoReduced,
-        mFIndexReduced);
-    int reducedN = mXReduced.size();
-    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-        reducedAPadded = Eigen::MatrixXd::Zero(reducedN, dPAD(reducedN));
-    reducedAPadded.block(0, 0, reducedN, reducedN) = mAReduced;
-
-    success = mSecondaryBoxedLcpSolver->solve(
-        reducedN,
-        reducedAPadded.data(),
-        mXReduced.data(),
-        mBReduced.data(),
-        0,
-        mLoReduced.data(),
-        mHiReduced.data(),
-        mFIndexReduced.data(),
-        false);
-    if (success)
-    {
-      mX = mapOut * mXReduced;
-      if (!LCPUtils::isLCPSolutionValid(
-              aGradientBackup,
-              mX,
-              bGradientBackup,
-              hiGradientBackup,
-              loGradientBackup,
-              fIndexGradientBackup,
-              false))
-      {
-        success = false;
-        // This is fine and allowed, as long as there's friction. Boxed LCPs
-        // aren't guaranteed to be solvable with friction.
-      }
-    }
+    // This is fine and allowed to fail, as long as there's friction. Boxed
+    // LCPs aren't guaranteed to be solvable with friction.
+    success = solveFromBackup(mSecondaryBoxedLcpSolver.get(), false);
   }
 
   // If Dantzig (and PGS, if we've got it) both failed to solve the problem, our
@@ -552,16 +448,19 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   // like the best we can do, given the limitations of boxed LCP solvers. In the
   // long run, we should probably reformulate the LCP problem to guarantee
   // solvability.
+  //
+  // This is a rare last resort, so unlike the paths above it doesn't bother
+  // to avoid allocating.
   if (!success)
   {
     hadToIgnoreFrictionToSolve = true;
 
-    Eigen::MatrixXd mAReduced = mABackup.block(0, 0, n, n);
-    Eigen::VectorXd mXReduced = mXBackup;
-    Eigen::VectorXd mBReduced = mBBackup;
-    Eigen::VectorXd mHiReduced = mHiBackup;
-    Eigen::VectorXd mLoReduced = mLoBackup;
-    Eigen::VectorXi mFIndexReduced = mFIndexBackup;
+    Eigen::MatrixXd mAReduced = aBackup;
+    Eigen::VectorXd mXReduced = xBackup;
+    Eigen::VectorXd mBReduced = bBackup;
+    Eigen::VectorXd mHiReduced = hiBackup;
+    Eigen::VectorXd mLoReduced = loBackup;
+    Eigen::VectorXi mFIndexReduced = fIndexBackup;
     Eigen::MatrixXd mapOut = LCPUtils::removeFriction(
         mAReduced,
         mXReduced,
@@ -634,12 +533,12 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   // blemishes on the clamping indices
   /*
   LCPUtils::cleanUpResults(
-      aGradientBackup,
+      mWorkspace.ABackup,
       mX,
-      bGradientBackup,
-      hiGradientBackup,
-      loGradientBackup,
-      fIndexGradientBackup);
+      mWorkspace.bBackup,
+      mWorkspace.hiBackup,
+      mWorkspace.loBackup,
+      mWorkspace.fIndexBackup);
   */
 
   // If our short circuit didn't work, then we had to use the full LCP to get a
@@ -648,12 +547,12 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   {
     group.getGradientConstraintMatrices()->registerLCPResults(
         mX,
-        hiGradientBackup,
-        loGradientBackup,
-        fIndexGradientBackup,
-        bGradientBackup,
-        aColNormGradientBackup,
-        aGradientBackup,
+        hiBackup,
+        loBackup,
+        fIndexBackup,
+        bBackup,
+        aColNorms,
+        aBackup,
         hadToIgnoreFrictionToSolve);
     group.getGradientConstraintMatrices()->constructMatrices(world);
     if (group.getGradientConstraintMatrices()->areResultsStandardized())
@@ -683,6 +582,94 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   }
 }
 
+//==============================================================================
+bool BoxedLcpConstraintSolver::solveFromBackup(
+    BoxedLcpSolver* solver, bool earlyTermination)
+{
+  const int n = mWorkspace.ABackup.rows();
+
+  if (LCPUtils::isReducible(
+          mWorkspace.ABackup,
+          mWorkspace.bBackup,
+          mWorkspace.hiBackup,
+          mWorkspace.loBackup,
+          mWorkspace.fIndexBackup))
+  {
+    // We've got near-identical contact points, which some solvers choke on, so
+    // merge them before solving. This is rare enough that we don't mind
+    // allocating here.
+    Eigen::MatrixXd mAReduced = mWorkspace.ABackup;
+    Eigen::VectorXd mXReduced = mWorkspace.xBackup;
+    Eigen::VectorXd mBReduced = mWorkspace.bBackup;
+    Eigen::VectorXd mHiReduced = mWorkspace.hiBackup;
+    Eigen::VectorXd mLoReduced = mWorkspace.loBackup;
+    Eigen::VectorXi mFIndexReduced = mWorkspace.fIndexBackup;
+    Eigen::MatrixXd mapOut = LCPUtils::reduce(
+        mAReduced,
+        mXReduced,
+        mBReduced,
+        mHiReduced,
+        mLoReduced,
+        mFIndexReduced);
+    int reducedN = mXReduced.size();
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        reducedAPadded = Eigen::MatrixXd::Zero(reducedN, dPAD(reducedN));
+    reducedAPadded.block(0, 0, reducedN, reducedN) = mAReduced;
+
+    if (!solver->solve(
+            reducedN,
+            reducedAPadded.data(),
+            mXReduced.data(),
+            mBReduced.data(),
+            0,
+            mLoReduced.data(),
+            mHiReduced.data(),
+            mFIndexReduced.data(),
+            earlyTermination))
+    {
+      return false;
+    }
+    mX = mapOut * mXReduced;
+  }
+  else
+  {
+    // Nothing to merge, so solve directly in the workspace. The solvers
+    // overwrite their inputs, so restore them from the backups first.
+    mWorkspace.A.leftCols(n) = mWorkspace.ABackup;
+    mWorkspace.x = mWorkspace.xBackup;
+    mWorkspace.b = mWorkspace.bBackup;
+    mWorkspace.hi = mWorkspace.hiBackup;
+    mWorkspace.lo = mWorkspace.loBackup;
+    mWorkspace.fIndex = mWorkspace.fIndexBackup;
+
+    if (!solver->solve(
+            n,
+            mWorkspace.A.data(),
+            mWorkspace.x.data(),
+            mWorkspace.b.data(),
+            0,
+            mWorkspace.lo.data(),
+            mWorkspace.hi.data(),
+            mWorkspace.fIndex.data(),
+            earlyTermination))
+    {
+      return false;
+    }
+    mX = mWorkspace.x;
+  }
+
+  // Double check if the LCP solution is valid. The ODE solver can sometimes
+  // return invalid solutions with success=true >:(
+  return LCPUtils::isLCPSolutionValid(
+      mWorkspace.ABackup,
+      mX,
+      mWorkspace.bBackup,
+      mWorkspace.hiBackup,
+      mWorkspace.loBackup,
+      mWorkspace.fIndexBackup,
+      false);
+}
+
 //==============================================================================
 #ifndef NDEBUG
 bool BoxedLcpConstraintSolver::isSymmetric(std::size_t n, double* A)
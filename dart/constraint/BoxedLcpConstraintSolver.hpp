@@ -33,6 +33,7 @@
 #ifndef DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 #define DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 
+#include "dart/constraint/BoxedLcpWorkspace.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/constraint/SmartPointer.hpp"
 
@@ -102,6 +103,9 @@ public:
   /// failed
   ConstBoxedLcpSolverPtr getSecondaryBoxedLcpSolver() const;
 
+  /// Returns the scratch buffers we use to assemble and solve LCPs
+  const BoxedLcpWorkspace& getWorkspace() const;
+
   /// This gets the cached LCP solution, which is useful to be able to get/set
   /// because it can effect the forward solutions of physics problems because of
   /// our optimistic LCP-stabilization-to-acceptance approach.
@@ -127,48 +131,18 @@ protected:
   // TODO(JS): Hold as unique_ptr because there is no reason to share. Make this
   // change in DART 7 because it's API breaking change.
 
-  /// Cache data for boxed LCP formulation
-  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> mA;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-      mABackup;
+  /// Restores the LCP from the backups in mWorkspace, solves it with
+  /// `solver`, and writes the result into mX. Returns true if the solver
+  /// succeeded and its solution is valid.
+  bool solveFromBackup(BoxedLcpSolver* solver, bool earlyTermination);
 
-  /// Cache data for boxed LCP formulation
+  /// The solution to the last LCP we solved, which we use to warm start the
+  /// next one
   Eigen::VectorXd mX;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mXBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mB;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mBBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mW;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mLo;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mLoBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mHi;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXd mHiBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mFIndex;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mFIndexBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mOffset;
+  /// Scratch buffers for the boxed LCP formulation, which we reuse across
+  /// timesteps
+  BoxedLcpWorkspace mWorkspace;
 
 #ifndef NDEBUG
 private:
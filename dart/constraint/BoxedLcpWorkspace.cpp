@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/BoxedLcpWorkspace.hpp"
+
+#include <new>
+
+#include "dart/external/odelcpsolver/lcp.h"
+
+namespace dart {
+namespace constraint {
+
+namespace {
+
+//==============================================================================
+/// Re-seats an Eigen::Map to point at new memory
+template <typename MapType>
+void reseat(
+    MapType& map, typename MapType::PointerArgType data, int rows, int cols)
+{
+  new (&map) MapType(data, rows, cols);
+}
+
+//==============================================================================
+/// Re-seats an Eigen::Map vector to point at new memory
+template <typename MapType>
+void reseat(MapType& map, typename MapType::PointerArgType data, int size)
+{
+  new (&map) MapType(data, size);
+}
+
+//==============================================================================
+/// Rounds a buffer length up so that every buffer in an arena starts on a
+/// 32-byte boundary
+std::size_t padLength(std::size_t length)
+{
+  return (length + 3) & ~static_cast<std::size_t>(3);
+}
+
+} // namespace
+
+//==============================================================================
+BoxedLcpWorkspace::BoxedLcpWorkspace()
+  : A(nullptr, 0, 0),
+    ABackup(nullptr, 0, 0),
+    aColNorms(nullptr, 0),
+    x(nullptr, 0),
+    xBackup(nullptr, 0),
+    b(nullptr, 0),
+    bBackup(nullptr, 0),
+    w(nullptr, 0),
+    lo(nullptr, 0),
+    loBackup(nullptr, 0),
+    hi(nullptr, 0),
+    hiBackup(nullptr, 0),
+    fIndex(nullptr, 0),
+    fIndexBackup(nullptr, 0),
+    offset(nullptr, 0),
+    mNumArenaAllocations(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void BoxedLcpWorkspace::resize(std::size_t n, std::size_t numConstraints)
+{
+  const std::size_t nSkip = dPAD(n);
+  const std::size_t matrixLength = padLength(n * nSkip);
+  const std::size_t squareLength = padLength(n * n);
+  const std::size_t vectorLength = padLength(n);
+
+  // A, ABackup, and 10 vectors of doubles
+  const std::size_t numDoubles
+      = matrixLength + squareLength + 10 * vectorLength;
+  // 2 vectors of ints the size of the LCP, plus the offsets
+  const std::size_t numInts = 2 * n + numConstraints;
+
+  if (numDoubles > mDoubleArena.size() || numInts > mIntArena.size())
+  {
+    mNumArenaAllocations++;
+    if (numDoubles > mDoubleArena.size())
+      mDoubleArena.resize(numDoubles);
+    if (numInts > mIntArena.size())
+      mIntArena.resize(numInts);
+  }
+
+  double* doubles = mDoubleArena.data();
+  reseat(A, doubles, n, nSkip);
+  doubles += matrixLength;
+  reseat(ABackup, doubles, n, n);
+  doubles += squareLength;
+  for (Eigen::Map<Eigen::VectorXd>* vector : {&aColNorms,
+                                               &x,
+                                               &xBackup,
+                                               &b,
+                                               &bBackup,
+                                               &w,
+                                               &lo,
+                                               &loBackup,
+                                               &hi,
+                                               &hiBackup})
+  {
+    reseat(*vector, doubles, n);
+    doubles += vectorLength;
+  }
+
+  int* ints = mIntArena.data();
+  reseat(fIndex, ints, n);
+  ints += n;
+  reseat(fIndexBackup, ints, n);
+  ints += n;
+  reseat(offset, ints, numConstraints);
+
+  // The solvers never read the padding columns, but keep them deterministic
+  A.rightCols(nSkip - n).setZero();
+}
+
+//==============================================================================
+std::size_t BoxedLcpWorkspace::getNumArenaAllocations() const
+{
+  return mNumArenaAllocations;
+}
+
+} // namespace constraint
+} // namespace dart
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_CONSTRAINT_BOXEDLCPWORKSPACE_HPP_
+#define DART_CONSTRAINT_BOXEDLCPWORKSPACE_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace constraint {
+
+/// BoxedLcpWorkspace holds all the scratch buffers BoxedLcpConstraintSolver
+/// needs to assemble and solve the LCP for a constrained group.
+///
+/// Every buffer is a view into one of two arenas (one for doubles, one for
+/// ints). The arenas only ever grow, so once the workspace has seen the largest
+/// LCP a simulation produces, resize() just re-seats the views and stepping
+/// performs no heap allocations, even as the number of contacts changes from
+/// one timestep to the next.
+///
+/// The views are invalidated by the next call to resize().
+class BoxedLcpWorkspace
+{
+public:
+  using RowMajorMatrixXd
+      = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /// Constructor
+  BoxedLcpWorkspace();
+
+  // The views point into this workspace's own arenas, so copying would alias
+  BoxedLcpWorkspace(const BoxedLcpWorkspace&) = delete;
+  BoxedLcpWorkspace& operator=(const BoxedLcpWorkspace&) = delete;
+
+  /// Lays out the buffers for an LCP with n dimensions across numConstraints
+  /// constraints. This only allocates if the problem is bigger than any we've
+  /// laid out before. The contents of the buffers are unspecified afterwards,
+  /// except for the padding columns of A, which are zero.
+  void resize(std::size_t n, std::size_t numConstraints);
+
+  /// Returns the number of times resize() has had to grow the arenas
+  std::size_t getNumArenaAllocations() const;
+
+  /// The LCP matrix, n rows by dPAD(n) columns, in the layout the boxed LCP
+  /// solvers expect. The solvers overwrite this in place.
+  Eigen::Map<RowMajorMatrixXd> A;
+
+  /// A pristine, square (n by n) copy of A, taken before any solver runs. This
+  /// is used to restart after a failed solve, to check solutions, and for
+  /// gradients.
+  Eigen::Map<Eigen::MatrixXd> ABackup;
+
+  /// The squared norms of the columns of A
+  Eigen::Map<Eigen::VectorXd> aColNorms;
+
+  /// Working copy of the solution, which the solvers overwrite in place
+  Eigen::Map<Eigen::VectorXd> x;
+
+  /// The initial guess for the solution, before any solver runs
+  Eigen::Map<Eigen::VectorXd> xBackup;
+
+  /// Bias term
+  Eigen::Map<Eigen::VectorXd> b;
+
+  /// Pristine copy of b
+  Eigen::Map<Eigen::VectorXd> bBackup;
+
+  /// Slack variable
+  Eigen::Map<Eigen::VectorXd> w;
+
+  /// Lower bound of x
+  Eigen::Map<Eigen::VectorXd> lo;
+
+  /// Pristine copy of lo
+  Eigen::Map<Eigen::VectorXd> loBackup;
+
+  /// Upper bound of x
+  Eigen::Map<Eigen::VectorXd> hi;
+
+  /// Pristine copy of hi
+  Eigen::Map<Eigen::VectorXd> hiBackup;
+
+  /// Friction index
+  Eigen::Map<Eigen::VectorXi> fIndex;
+
+  /// Pristine copy of fIndex
+  Eigen::Map<Eigen::VectorXi> fIndexBackup;
+
+  /// The offset of each constraint into the LCP
+  Eigen::Map<Eigen::VectorXi> offset;
+
+protected:
+  /// Backing storage for all the double buffers
+  std::vector<double, Eigen::aligned_allocator<double>> mDoubleArena;
+
+  /// Backing storage for all the int buffers
+  std::vector<int> mIntArena;
+
+  /// The number of times we've had to grow the arenas
+  std::size_t mNumArenaAllocations;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_BOXEDLCPWORKSPACE_HPP_
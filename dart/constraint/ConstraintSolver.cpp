@@ -773,11 +773,36 @@ void ConstraintSolver::buildConstrainedGroups()
   // Create the gradient matrices for this gradient mode
   if (mGradientEnabled)
   {
+    std::unordered_map<
+        std::string,
+        std::shared_ptr<neural::LCPFactorizationCache>>
+        factorizationCaches;
     for (auto& constrainedGroup : mConstrainedGroups)
     {
       auto m = neural::createGradientMatrices(constrainedGroup, mTimeStep);
+
+      // Warm start the LCP factorizations from the same group on the last
+      // timestep. We copy the cache, rather than sharing it, so that this
+      // timestep's factorizations don't evict the ones the last timestep's
+      // snapshot may still need during backprop.
+      const std::string& name = constrainedGroup.mRootSkeleton->getName();
+      std::shared_ptr<neural::LCPFactorizationCache> cache;
+      auto previous = mFactorizationCaches.find(name);
+      if (previous != mFactorizationCaches.end())
+      {
+        cache = std::make_shared<neural::LCPFactorizationCache>(
+            *previous->second);
+      }
+      else
+      {
+        cache = std::make_shared<neural::LCPFactorizationCache>();
+      }
+      m->setFactorizationCache(cache);
+      factorizationCaches[name] = cache;
+
       constrainedGroup.setGradientConstraintMatrices(m);
     }
+    mFactorizationCaches = factorizationCaches;
   }
 
   //----------------------------------------------------------------------------
@@ -34,6 +34,8 @@
 #define DART_CONSTRAINT_CONSTRAINTSOVER_HPP_
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -43,6 +45,7 @@
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/constraint/ConstraintBase.hpp"
 #include "dart/constraint/SmartPointer.hpp"
+#include "dart/neural/LCPFactorization.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 
 namespace dart {
@@ -311,6 +314,14 @@ protected:
   /// The type of gradients we want to use for backprop
   bool mGradientEnabled;
 
+  /// The LCP factorization caches from the last timestep, keyed by the name of
+  /// the root skeleton of each constrained group. Each new timestep's gradient
+  /// matrices are warm-started from these.
+  std::unordered_map<
+      std::string,
+      std::shared_ptr<neural::LCPFactorizationCache>>
+      mFactorizationCaches;
+
   /// True if we want to enable artificial penetration correction forces
   bool mPenetrationCorrectionEnabled;
 
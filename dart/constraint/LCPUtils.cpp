@@ -8,17 +8,41 @@
 namespace dart {
 namespace constraint {
 
+namespace {
+
 //==============================================================================
+/// Returns true if columns colA and colB of the LCP are near-identical, and so
+/// can be merged
+bool areColumnsMergeable(
+    const Eigen::Ref<const Eigen::MatrixXd>& A,
+    const Eigen::Ref<const Eigen::VectorXd>& b,
+    const Eigen::Ref<const Eigen::VectorXd>& hi,
+    const Eigen::Ref<const Eigen::VectorXd>& lo,
+    const Eigen::Ref<const Eigen::VectorXi>& fIndex,
+    int colA,
+    int colB)
+{
+  return (A.col(colA) - A.col(colB)).squaredNorm() < MERGE_THRESHOLD
+         && (std::abs(b(colA) - b(colB)) < MERGE_THRESHOLD)
+         && (fIndex(colA) == fIndex(colB)) && (hi(colA) == hi(colB))
+         && (lo(colA) == lo(colB));
+}
+
+} // namespace
+
+//==============================================================================
+/// This checks that mX solves the boxed LCP. This takes Eigen::Ref
+/// arguments, and doesn't allocate, so that it can check solutions held in
+/// a BoxedLcpWorkspace on every timestep.
 bool LCPUtils::isLCPSolutionValid(
-    const Eigen::MatrixXd& mA,
-    const Eigen::VectorXd& mX,
-    const Eigen::VectorXd& mB,
-    const Eigen::VectorXd& mHi,
-    const Eigen::VectorXd& mLo,
-    const Eigen::VectorXi& mFIndex,
+    const Eigen::Ref<const Eigen::MatrixXd>& mA,
+    const Eigen::Ref<const Eigen::VectorXd>& mX,
+    const Eigen::Ref<const Eigen::VectorXd>& mB,
+    const Eigen::Ref<const Eigen::VectorXd>& mHi,
+    const Eigen::Ref<const Eigen::VectorXd>& mLo,
+    const Eigen::Ref<const Eigen::VectorXi>& mFIndex,
     bool ignoreFrictionIndices)
 {
-  Eigen::VectorXd v = mA * mX - mB;
   for (int i = 0; i < mX.size(); i++)
   {
     double upperLimit = mHi(i);
@@ -36,6 +60,8 @@ bool LCPUtils::isLCPSolutionValid(
     }
 
     const double tol = 1e-5;
+    // The relative velocity at this index, (A*x - b)(i)
+    const double v_i = mA.row(i).dot(mX) - mB(i);
 
     /// Solves constriant impulses for a constrained group. The LCP formulation
     /// setting that this function solve is A*x = b + w where each x[i], w[i]
@@ -55,19 +81,19 @@ bool LCPUtils::isLCPSolutionValid(
     // If force is at the lower bound, velocity must be >= 0
     else if (std::abs(mX(i) - lowerLimit) < tol)
     {
-      if (v(i) < -tol)
+      if (v_i < -tol)
         return false;
     }
     // If force is at the upper bound, velocity must be <= 0
     else if (std::abs(mX(i) - upperLimit) < tol)
     {
-      if (v(i) > tol)
+      if (v_i > tol)
         return false;
     }
     // If force is within bounds, then velocity must be zero
     else if (mX(i) > lowerLimit && mX(i) < upperLimit)
     {
-      if (std::abs(v(i)) > tol)
+      if (std::abs(v_i) > tol)
         return false;
     }
     // If force is out of bounds, we're always illegal
@@ -140,6 +166,29 @@ Eigen::VectorXd LCPUtils::guessSolution(
   return fullX;
 }
 
+//==============================================================================
+/// This returns true if reduce() would be able to merge any near-identical
+/// contact points in this LCP problem. This doesn't allocate, so it's cheap
+/// to check this before paying for a call to reduce().
+bool LCPUtils::isReducible(
+    const Eigen::Ref<const Eigen::MatrixXd>& A,
+    const Eigen::Ref<const Eigen::VectorXd>& b,
+    const Eigen::Ref<const Eigen::VectorXd>& hi,
+    const Eigen::Ref<const Eigen::VectorXd>& lo,
+    const Eigen::Ref<const Eigen::VectorXi>& fIndex)
+{
+  const int n = A.cols();
+  for (int i = 0; i < n - 1; i++)
+  {
+    for (int j = i + 1; j < n; j++)
+    {
+      if (areColumnsMergeable(A, b, hi, lo, fIndex, i, j))
+        return true;
+    }
+  }
+  return false;
+}
+
 //==============================================================================
 /// This reduces an LCP problem by merging any near-identical contact points.
 Eigen::MatrixXd LCPUtils::reduce(
@@ -167,10 +216,14 @@ Eigen::MatrixXd LCPUtils::reduce(
     {
       for (int b = a + 1; b < n; b++)
       {
-        if ((reducedA.col(a) - reducedA.col(b)).squaredNorm() < MERGE_THRESHOLD
-            && (std::abs(reducedB(a) - reducedB(b)) < MERGE_THRESHOLD)
-            && (reducedFIndex(a) == reducedFIndex(b))
-            && (reducedHi(a) == reducedHi(b)) && (reducedLo(a) == reducedLo(b)))
+        if (areColumnsMergeable(
+                reducedA,
+                reducedB,
+                reducedHi,
+                reducedLo,
+                reducedFIndex,
+                a,
+                b))
         {
           foundDuplicates = true;
           mergeLCPColumns(
@@ -274,10 +327,14 @@ bool LCPUtils::solveDeduplicated(
     {
       for (int b = a + 1; b < n; b++)
       {
-        if ((reducedA.col(a) - reducedA.col(b)).squaredNorm() < MERGE_THRESHOLD
-            && (std::abs(reducedB(a) - reducedB(b)) < MERGE_THRESHOLD)
-            && (reducedFIndex(a) == reducedFIndex(b))
-            && (reducedHi(a) == reducedHi(b)) && (reducedLo(a) == reducedLo(b)))
+        if (areColumnsMergeable(
+                reducedA,
+                reducedB,
+                reducedHi,
+                reducedLo,
+                reducedFIndex,
+                a,
+                b))
         {
           foundDuplicates = true;
           mergeLCPColumns(
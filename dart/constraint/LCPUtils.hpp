@@ -13,13 +13,16 @@ namespace constraint {
 class LCPUtils
 {
 public:
+  /// This checks that mX solves the boxed LCP. This takes Eigen::Ref
+  /// arguments, and doesn't allocate, so that it can check solutions held in
+  /// a BoxedLcpWorkspace on every timestep.
   static bool isLCPSolutionValid(
-      const Eigen::MatrixXd& mA,
-      const Eigen::VectorXd& mX,
-      const Eigen::VectorXd& mB,
-      const Eigen::VectorXd& mHi,
-      const Eigen::VectorXd& mLo,
-      const Eigen::VectorXi& mFIndex,
+      const Eigen::Ref<const Eigen::MatrixXd>& mA,
+      const Eigen::Ref<const Eigen::VectorXd>& mX,
+      const Eigen::Ref<const Eigen::VectorXd>& mB,
+      const Eigen::Ref<const Eigen::VectorXd>& mHi,
+      const Eigen::Ref<const Eigen::VectorXd>& mLo,
+      const Eigen::Ref<const Eigen::VectorXi>& mFIndex,
       bool ignoreFrictionIndices);
 
   /// This applies a simple algorithm to guess the solution to the LCP problem.
@@ -32,6 +35,16 @@ public:
       const Eigen::VectorXd& mLo,
       const Eigen::VectorXi& mFIndex);
 
+  /// This returns true if reduce() would be able to merge any near-identical
+  /// contact points in this LCP problem. This doesn't allocate, so it's cheap
+  /// to check this before paying for a call to reduce().
+  static bool isReducible(
+      const Eigen::Ref<const Eigen::MatrixXd>& A,
+      const Eigen::Ref<const Eigen::VectorXd>& b,
+      const Eigen::Ref<const Eigen::VectorXd>& hi,
+      const Eigen::Ref<const Eigen::VectorXd>& lo,
+      const Eigen::Ref<const Eigen::VectorXi>& fIndex);
+
   /// This reduces an LCP problem by merging any near-identical contact points.
   /// It returns a mapOut matrix, such that if you solve this LCP and then
   /// multiply the resulting x as mapOut*x, you'll get the solution to the
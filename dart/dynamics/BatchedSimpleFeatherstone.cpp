@@ -0,0 +1,899 @@
+#include "dart/dynamics/BatchedSimpleFeatherstone.hpp"
+
+#include <algorithm>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/PlanarJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+// All of these work on "lanes", which are (batch size x N) arrays where each
+// column holds one scalar for every lane. See BatchedFeatherstoneScratchSpace
+// for the layout. Every line in here is an elementwise expression over whole
+// columns, which is what lets Eigen vectorize across the batch.
+using LanesIn = Eigen::Ref<const Eigen::ArrayXXd>;
+using LanesOut = Eigen::Ref<Eigen::ArrayXXd>;
+
+// These set out.col(outCol) to the sum over k of
+// a.col(aCol + k * aStride) * b.col(bCol + k * bStride), for 3 or 6 terms. Each
+// is a single expression, so Eigen evaluates it in one pass over the lanes,
+// rather than writing out every partial sum. If `accumulate`, they add to
+// out.col(outCol) instead.
+void dot3(
+    const LanesIn& a,
+    int aCol,
+    int aStride,
+    const LanesIn& b,
+    int bCol,
+    int bStride,
+    LanesOut out,
+    int outCol,
+    bool accumulate = false)
+{
+  auto sum = a.col(aCol) * b.col(bCol)
+             + a.col(aCol + aStride) * b.col(bCol + bStride)
+             + a.col(aCol + 2 * aStride) * b.col(bCol + 2 * bStride);
+  if (accumulate)
+    out.col(outCol) += sum;
+  else
+    out.col(outCol) = sum;
+}
+
+void dot6(
+    const LanesIn& a,
+    int aCol,
+    int aStride,
+    const LanesIn& b,
+    int bCol,
+    int bStride,
+    LanesOut out,
+    int outCol,
+    bool accumulate = false)
+{
+  auto sum = a.col(aCol) * b.col(bCol)
+             + a.col(aCol + aStride) * b.col(bCol + bStride)
+             + a.col(aCol + 2 * aStride) * b.col(bCol + 2 * bStride)
+             + a.col(aCol + 3 * aStride) * b.col(bCol + 3 * bStride)
+             + a.col(aCol + 4 * aStride) * b.col(bCol + 4 * bStride)
+             + a.col(aCol + 5 * aStride) * b.col(bCol + 5 * bStride);
+  if (accumulate)
+    out.col(outCol) += sum;
+  else
+    out.col(outCol) = sum;
+}
+
+// out = a * b, where `a` holds (aRows x aCols) matrices and `b` holds
+// (aCols x bCols) matrices. If `accumulate`, this is out += a * b instead.
+void multiply(
+    const LanesIn& a,
+    int aRows,
+    int aCols,
+    const LanesIn& b,
+    int bCols,
+    LanesOut out,
+    bool accumulate = false)
+{
+  for (int j = 0; j < bCols; j++)
+  {
+    for (int i = 0; i < aRows; i++)
+    {
+      if (aCols == 6)
+      {
+        dot6(a, i, aRows, b, j * 6, 1, out, i + j * aRows, accumulate);
+        continue;
+      }
+      int k = 0;
+      if (!accumulate)
+      {
+        out.col(i + j * aRows) = a.col(i) * b.col(j * aCols);
+        k = 1;
+      }
+      for (; k < aCols; k++)
+      {
+        out.col(i + j * aRows) += a.col(i + k * aRows) * b.col(k + j * aCols);
+      }
+    }
+  }
+}
+
+// out = a^T * b, where `a` holds (aRows x aCols) matrices and `b` holds
+// (aRows x bCols) matrices
+void multiplyTransposed(
+    const LanesIn& a,
+    int aRows,
+    int aCols,
+    const LanesIn& b,
+    int bCols,
+    LanesOut out)
+{
+  for (int j = 0; j < bCols; j++)
+  {
+    for (int i = 0; i < aCols; i++)
+    {
+      if (aRows == 6)
+      {
+        dot6(a, i * 6, 1, b, j * 6, 1, out, i + j * aCols);
+        continue;
+      }
+      out.col(i + j * aCols) = a.col(i * aRows) * b.col(j * aRows);
+      for (int k = 1; k < aRows; k++)
+      {
+        out.col(i + j * aCols)
+            += a.col(k + i * aRows) * b.col(k + j * aRows);
+      }
+    }
+  }
+}
+
+// out = m * v, where `m` is the same 6x6 matrix for every lane, and `v` holds
+// 6-vectors
+void multiplyConst(const Eigen::Matrix6d& m, const LanesIn& v, LanesOut out)
+{
+  for (int i = 0; i < 6; i++)
+  {
+    out.col(i) = m(i, 0) * v.col(0) + m(i, 1) * v.col(1) + m(i, 2) * v.col(2)
+                 + m(i, 3) * v.col(3) + m(i, 4) * v.col(4)
+                 + m(i, 5) * v.col(5);
+  }
+}
+
+// out = a x b, for 3-vectors. If `accumulate`, this is out += a x b instead.
+// `out` must not alias `a` or `b`.
+void cross(const LanesIn& a, const LanesIn& b, LanesOut out, bool accumulate)
+{
+  if (!accumulate)
+    out.setZero();
+  out.col(0) += a.col(1) * b.col(2) - a.col(2) * b.col(1);
+  out.col(1) += a.col(2) * b.col(0) - a.col(0) * b.col(2);
+  out.col(2) += a.col(0) * b.col(1) - a.col(1) * b.col(0);
+}
+
+// Lanes version of math::ad()
+void ad(const LanesIn& x, const LanesIn& y, LanesOut out)
+{
+  cross(x.leftCols(3), y.leftCols(3), out.leftCols(3), false);
+  cross(x.leftCols(3), y.rightCols(3), out.rightCols(3), false);
+  cross(x.rightCols(3), y.leftCols(3), out.rightCols(3), true);
+}
+
+// Lanes version of math::dad()
+void dad(const LanesIn& s, const LanesIn& t, LanesOut out)
+{
+  cross(t.leftCols(3), s.leftCols(3), out.leftCols(3), false);
+  cross(t.rightCols(3), s.rightCols(3), out.leftCols(3), true);
+  cross(t.rightCols(3), s.leftCols(3), out.rightCols(3), false);
+}
+
+// This fills in the 6x6 matrix math::AdInvT() applies, for each lane of
+// `transform`. The top right block is always zero, so we never write it, and
+// the caller has to zero it once up front.
+void adInvTMatrix(const LanesIn& transform, LanesOut out)
+{
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      out.col(r + 6 * c) = transform.col(c + 3 * r);
+      out.col((3 + r) + 6 * (3 + c)) = transform.col(c + 3 * r);
+    }
+    // The bottom left block is -R^T [p]
+    out.col(3 + r) = transform.col(2 + 3 * r) * transform.col(10)
+                     - transform.col(1 + 3 * r) * transform.col(11);
+    out.col(3 + r + 6) = transform.col(3 * r) * transform.col(11)
+                         - transform.col(2 + 3 * r) * transform.col(9);
+    out.col(3 + r + 12) = transform.col(1 + 3 * r) * transform.col(9)
+                          - transform.col(3 * r) * transform.col(10);
+  }
+}
+
+// Lanes version of math::AdInvT(), using the matrix from adInvTMatrix()
+void adInvT(const LanesIn& adInv, const LanesIn& v, LanesOut out)
+{
+  // The top right block is zero, so the top half only needs 3 terms
+  for (int i = 0; i < 3; i++)
+  {
+    dot3(adInv, i, 6, v, 0, 1, out, i);
+    dot6(adInv, 3 + i, 6, v, 0, 1, out, 3 + i);
+  }
+}
+
+// Lanes version of out += math::dAdInvT(), using the matrix from
+// adInvTMatrix(), since dAdInvT(T, F) = AdInvT(T)^T * F
+void addDAdInvT(const LanesIn& adInv, const LanesIn& f, LanesOut out)
+{
+  // The top right block is zero, so the bottom half only needs 3 terms
+  for (int i = 0; i < 3; i++)
+  {
+    dot6(adInv, 6 * i, 1, f, 0, 1, out, i, true);
+    dot3(adInv, 3 + 6 * (3 + i), 1, f, 3, 1, out, 3 + i, true);
+  }
+}
+
+// Lanes version of out += math::transformInertia(T.inverse(), inertia), using
+// the matrix from adInvTMatrix(), since that's AdInvT(T)^T * I * AdInvT(T).
+// `tmp` needs 36 columns. `out` is assumed to be symmetric, so we only compute
+// the upper triangle and mirror it.
+void addTransformedInertia(
+    const LanesIn& adInv, const LanesIn& inertia, LanesOut tmp, LanesOut out)
+{
+  // tmp = I * AdInvT(T), where the top right block of AdInvT(T) is zero
+  for (int i = 0; i < 6; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      dot6(inertia, i, 6, adInv, 6 * j, 1, tmp, i + 6 * j);
+      dot3(inertia, i + 18, 6, adInv, 3 + 6 * (3 + j), 1, tmp, i + 6 * (3 + j));
+    }
+  }
+  // out += AdInvT(T)^T * tmp
+  for (int j = 0; j < 6; j++)
+  {
+    for (int i = 0; i <= j; i++)
+    {
+      if (i < 3)
+        dot6(adInv, 6 * i, 1, tmp, 6 * j, 1, out, i + 6 * j, true);
+      else
+        dot3(adInv, 3 + 6 * i, 1, tmp, 3 + 6 * j, 1, out, i + 6 * j, true);
+    }
+  }
+  for (int i = 0; i < 6; i++)
+  {
+    for (int j = i + 1; j < 6; j++)
+    {
+      out.col(j + 6 * i) = out.col(i + 6 * j);
+    }
+  }
+}
+
+// This inverts symmetric positive definite (n x n) matrices, in place, by
+// Gauss-Jordan elimination. This doesn't pivot, which is fine for SPD
+// matrices. `tmp` needs 2 columns.
+void invertSPD(LanesOut a, int n, LanesOut out, LanesOut tmp)
+{
+  if (n == 1)
+  {
+    out.col(0) = a.col(0).inverse();
+    return;
+  }
+  out.setZero();
+  for (int i = 0; i < n; i++)
+  {
+    out.col(i + n * i).setOnes();
+  }
+  for (int p = 0; p < n; p++)
+  {
+    tmp.col(0) = a.col(p + n * p).inverse();
+    for (int c = 0; c < n; c++)
+    {
+      a.col(p + n * c) *= tmp.col(0);
+      out.col(p + n * c) *= tmp.col(0);
+    }
+    for (int r = 0; r < n; r++)
+    {
+      if (r == p)
+        continue;
+      tmp.col(1) = a.col(r + n * p);
+      for (int c = 0; c < n; c++)
+      {
+        a.col(r + n * c) -= tmp.col(1) * a.col(p + n * c);
+        out.col(r + n * c) -= tmp.col(1) * out.col(p + n * c);
+      }
+    }
+  }
+}
+
+// Lanes version of math::expMapRot(), which writes the rotation into the
+// first 9 columns of `out`. `tmp` needs 4 columns.
+void expMapRot(const LanesIn& w, LanesOut out, LanesOut tmp)
+{
+  auto theta2 = tmp.col(0);
+  auto theta = tmp.col(1);
+  auto a = tmp.col(2);
+  auto b = tmp.col(3);
+  theta2 = w.col(0).square() + w.col(1).square() + w.col(2).square();
+  theta = theta2.sqrt();
+  // Near zero, fall back to the Taylor expansions, like math::expMapRot() does
+  a = (theta < 1e-3).select(1.0 - theta2 / 6.0, theta.sin() / theta);
+  b = (theta < 1e-3).select(0.5 - theta2 / 24.0, (1.0 - theta.cos()) / theta2);
+
+  // R = I + a * [w] + b * [w]^2, where [w]^2 = w * w^T - theta^2 * I
+  out.col(0) = 1.0 + b * (w.col(0).square() - theta2);
+  out.col(1) = a * w.col(2) + b * w.col(0) * w.col(1);
+  out.col(2) = -a * w.col(1) + b * w.col(0) * w.col(2);
+  out.col(3) = -a * w.col(2) + b * w.col(0) * w.col(1);
+  out.col(4) = 1.0 + b * (w.col(1).square() - theta2);
+  out.col(5) = a * w.col(0) + b * w.col(1) * w.col(2);
+  out.col(6) = a * w.col(1) + b * w.col(0) * w.col(2);
+  out.col(7) = -a * w.col(0) + b * w.col(1) * w.col(2);
+  out.col(8) = 1.0 + b * (w.col(2).square() - theta2);
+}
+
+// Lanes version of math::expMap(axis * q), for a constant screw axis, which
+// writes the whole transform into `out`. `tmp` needs 3 columns.
+void expMapScrew(
+    const Eigen::Vector6d& axis, const LanesIn& q, LanesOut out, LanesOut tmp)
+{
+  double scale = axis.head<3>().norm();
+  if (scale == 0.0)
+  {
+    // Pure translation
+    for (int c = 0; c < 9; c++)
+    {
+      out.col(c).setConstant(c % 4 == 0 ? 1.0 : 0.0);
+    }
+    for (int r = 0; r < 3; r++)
+    {
+      out.col(9 + r) = axis(3 + r) * q.col(0);
+    }
+    return;
+  }
+
+  Eigen::Vector3d w = axis.head<3>() / scale;
+  Eigen::Vector3d v = axis.tail<3>() / scale;
+  Eigen::Matrix3d skew = math::makeSkewSymmetric(w);
+  Eigen::Matrix3d skew2 = skew * skew;
+  Eigen::Vector3d u = w.cross(v);
+  Eigen::Vector3d wu = w.cross(u);
+  double pitch = w.dot(v);
+
+  auto phi = tmp.col(0);
+  auto sinPhi = tmp.col(1);
+  auto oneMinusCosPhi = tmp.col(2);
+  phi = scale * q.col(0);
+  sinPhi = phi.sin();
+  oneMinusCosPhi = 1.0 - phi.cos();
+
+  // R = I + sin(phi) * [w] + (1 - cos(phi)) * [w]^2
+  for (int c = 0; c < 3; c++)
+  {
+    for (int r = 0; r < 3; r++)
+    {
+      out.col(r + 3 * c) = skew(r, c) * sinPhi + skew2(r, c) * oneMinusCosPhi
+                           + (r == c ? 1.0 : 0.0);
+    }
+  }
+  // p = (I - R) * (w x v) + w * (w . v) * phi, which simplifies because
+  // (w x v) is orthogonal to w
+  for (int r = 0; r < 3; r++)
+  {
+    out.col(9 + r)
+        = u(r) * oneMinusCosPhi - wu(r) * sinPhi + w(r) * pitch * phi;
+  }
+}
+
+// out = a * m, where `a` is the same for every lane
+void composeConstLeft(
+    const Eigen::Isometry3d& a, const LanesIn& m, LanesOut out)
+{
+  Eigen::Matrix3d R = a.linear();
+  Eigen::Vector3d p = a.translation();
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      out.col(r + 3 * c) = R(r, 0) * m.col(3 * c) + R(r, 1) * m.col(1 + 3 * c)
+                           + R(r, 2) * m.col(2 + 3 * c);
+    }
+    out.col(9 + r) = R(r, 0) * m.col(9) + R(r, 1) * m.col(10)
+                     + R(r, 2) * m.col(11) + p(r);
+  }
+}
+
+// out = m * b, where `b` is the same for every lane
+void composeConstRight(
+    const LanesIn& m, const Eigen::Isometry3d& b, LanesOut out)
+{
+  Eigen::Matrix3d R = b.linear();
+  Eigen::Vector3d p = b.translation();
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      out.col(r + 3 * c) = m.col(r) * R(0, c) + m.col(r + 3) * R(1, c)
+                           + m.col(r + 6) * R(2, c);
+    }
+    out.col(9 + r) = m.col(r) * p(0) + m.col(r + 3) * p(1)
+                     + m.col(r + 6) * p(2) + m.col(9 + r);
+  }
+}
+
+} // namespace
+
+constexpr int BatchedSimpleFeatherstone::MAX_TILE_SIZE;
+
+BatchedSimpleFeatherstone::BatchedSimpleFeatherstone(int batchSize)
+  : mBatchSize(batchSize),
+    mTileSize(std::min(batchSize, MAX_TILE_SIZE)),
+    mNumDofs(0),
+    mGravity(Eigen::Vector3d::Zero())
+{
+  assert(batchSize > 0);
+}
+
+// The number of lanes (environments) we compute at once
+int BatchedSimpleFeatherstone::getBatchSize() const
+{
+  return mBatchSize;
+}
+
+// The number of joints in this skeleton
+int BatchedSimpleFeatherstone::len() const
+{
+  return mJointsAndBodies.size();
+}
+
+// The number of DOFs in this skeleton
+int BatchedSimpleFeatherstone::getNumDofs() const
+{
+  return mNumDofs;
+}
+
+// This sets the gravity vector, in world coordinates
+void BatchedSimpleFeatherstone::setGravity(const Eigen::Vector3d& gravity)
+{
+  mGravity = gravity;
+}
+
+// Returns the gravity vector, in world coordinates
+const Eigen::Vector3d& BatchedSimpleFeatherstone::getGravity() const
+{
+  return mGravity;
+}
+
+// This computes accelerations for every lane at once
+void BatchedSimpleFeatherstone::forwardDynamics(
+    const Eigen::MatrixXd& pos,
+    const Eigen::MatrixXd& vel,
+    const Eigen::MatrixXd& force,
+    /* OUT */ Eigen::MatrixXd& accelerations)
+{
+  assert(pos.rows() == mNumDofs && pos.cols() == mBatchSize);
+  assert(vel.rows() == mNumDofs && vel.cols() == mBatchSize);
+  assert(force.rows() == mNumDofs && force.cols() == mBatchSize);
+
+  // We run the batch a tile of lanes at a time, so that all the scratch space
+  // for a tile stays in cache. On the last tile, the lanes past the end of the
+  // batch still hold finite values from the previous tile, so it's safe to
+  // compute them and throw them away.
+  accelerations.resize(mNumDofs, mBatchSize);
+  for (int start = 0; start < mBatchSize; start += mTileSize)
+  {
+    int width = std::min(mTileSize, mBatchSize - start);
+    mPos.topRows(width) = pos.middleCols(start, width).transpose().array();
+    mVel.topRows(width) = vel.middleCols(start, width).transpose().array();
+    mForce.topRows(width) = force.middleCols(start, width).transpose().array();
+    forwardDynamicsTile();
+    accelerations.middleCols(start, width)
+        = mAccel.topRows(width).transpose().matrix();
+  }
+}
+
+// This runs forward dynamics on a single tile of lanes, from mPos, mVel and
+// mForce into mAccel
+void BatchedSimpleFeatherstone::forwardDynamicsTile()
+{
+  // Forward pass
+  for (int i = 0; i < len(); i++)
+  {
+    const BatchedJointAndBody& joint = mJointsAndBodies[i];
+    BatchedFeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    int n = joint.numDofs;
+
+    updateTransformAndAxis(i);
+
+    // mTmpVector = axis * vel, which is the velocity of the joint
+    if (n > 0)
+    {
+      multiply(
+          scratch.axis,
+          6,
+          n,
+          mVel.middleCols(joint.dofOffset, n),
+          1,
+          mTmpVector);
+    }
+    else
+    {
+      mTmpVector.setZero();
+    }
+
+    if (joint.parentIndex != -1)
+    {
+      adInvT(
+          scratch.adInvTransform,
+          mScratchSpace[joint.parentIndex].spatialVelocity,
+          scratch.spatialVelocity);
+      scratch.spatialVelocity += mTmpVector;
+    }
+    else
+    {
+      scratch.spatialVelocity = mTmpVector;
+    }
+
+    ad(scratch.spatialVelocity, mTmpVector, scratch.partialAcceleration);
+    if (joint.type == BatchedJointType::PLANAR)
+    {
+      multiply(
+          scratch.axisDeriv,
+          6,
+          n,
+          mVel.middleCols(joint.dofOffset, n),
+          1,
+          scratch.partialAcceleration,
+          true);
+    }
+
+    // Initialize the sums for the backwards pass with this body's own inertia
+    // and bias force. The children add onto these in the backwards pass.
+    for (int c = 0; c < 36; c++)
+    {
+      scratch.articulatedInertia.col(c).setConstant(joint.inertia(c));
+    }
+    multiplyConst(joint.inertia, scratch.spatialVelocity, mTmpVector2);
+    dad(scratch.spatialVelocity, mTmpVector2, scratch.articulatedBiasForce);
+    scratch.articulatedBiasForce *= -1.0;
+  }
+
+  // Backward pass
+  for (int i = len() - 1; i >= 0; i--)
+  {
+    const BatchedJointAndBody& joint = mJointsAndBodies[i];
+    BatchedFeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    int n = joint.numDofs;
+
+    // mTmpVector = AI * eta + AB
+    mTmpVector = scratch.articulatedBiasForce;
+    multiply(
+        scratch.articulatedInertia,
+        6,
+        6,
+        scratch.partialAcceleration,
+        1,
+        mTmpVector,
+        true);
+
+    if (n > 0)
+    {
+      multiply(scratch.articulatedInertia, 6, 6, scratch.axis, n, scratch.AIS);
+      multiplyTransposed(scratch.axis, 6, n, scratch.AIS, n, mTmpMatrix);
+      invertSPD(mTmpMatrix, n, scratch.psi, mTmpLanes);
+
+      // Total force on the joint, see GenericJoint.hpp:2028 for DART
+      // equivalent Inside GenericJoint::addChildBiasForceToDynamic()
+      multiplyTransposed(scratch.axis, 6, n, mTmpVector, 1, scratch.totalForce);
+      scratch.totalForce
+          = mForce.middleCols(joint.dofOffset, n) - scratch.totalForce;
+    }
+
+    if (joint.parentIndex == -1)
+      continue;
+    BatchedFeatherstoneScratchSpace& parent = mScratchSpace[joint.parentIndex];
+
+    // Sum into our parents
+    // See GenericJoint.hpp:1801 for DART equivalent,
+    // GenericJoint::addChildArtInertiaToDynamic()
+    mTmpMatrix = scratch.articulatedInertia;
+    if (n > 0)
+    {
+      // mTmpMatrix2 = AIS * psi
+      multiply(scratch.AIS, 6, n, scratch.psi, n, mTmpMatrix2);
+
+      // beta = AI * eta + AB + AIS * psi * totalForce
+      multiply(mTmpMatrix2, 6, n, scratch.totalForce, 1, mTmpVector, true);
+
+      // PI = AI - AIS * psi * AIS^T
+      for (int c = 0; c < 6; c++)
+      {
+        for (int r = 0; r < 6; r++)
+        {
+          for (int k = 0; k < n; k++)
+          {
+            mTmpMatrix.col(r + 6 * c)
+                -= mTmpMatrix2.col(r + 6 * k) * scratch.AIS.col(c + 6 * k);
+          }
+        }
+      }
+    }
+    addTransformedInertia(
+        scratch.adInvTransform,
+        mTmpMatrix,
+        mTmpMatrix2,
+        parent.articulatedInertia);
+    addDAdInvT(
+        scratch.adInvTransform, mTmpVector, parent.articulatedBiasForce);
+  }
+
+  // Last forward pass
+  for (int i = 0; i < len(); i++)
+  {
+    const BatchedJointAndBody& joint = mJointsAndBodies[i];
+    BatchedFeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    int n = joint.numDofs;
+
+    // mTmpVector is the acceleration of our parent, in our frame. Rather than
+    // applying gravity to every body, we accelerate the world upwards, which
+    // gives the same joint accelerations.
+    if (joint.parentIndex != -1)
+    {
+      adInvT(
+          scratch.adInvTransform,
+          mScratchSpace[joint.parentIndex].spatialAcceleration,
+          mTmpVector);
+    }
+    else
+    {
+      mTmpVector.leftCols(3).setZero();
+      for (int r = 0; r < 3; r++)
+      {
+        mTmpVector.col(3 + r)
+            = -mGravity(0) * scratch.adInvTransform.col(3 + r + 18)
+              - mGravity(1) * scratch.adInvTransform.col(3 + r + 24)
+              - mGravity(2) * scratch.adInvTransform.col(3 + r + 30);
+      }
+    }
+
+    scratch.spatialAcceleration = mTmpVector + scratch.partialAcceleration;
+    if (n > 0)
+    {
+      // accel = psi * (totalForce - AIS^T * parentAccel)
+      multiplyTransposed(scratch.AIS, 6, n, mTmpVector, 1, mTmpVector2);
+      mTmpVector2.leftCols(n) = scratch.totalForce - mTmpVector2.leftCols(n);
+      multiply(
+          scratch.psi,
+          n,
+          n,
+          mTmpVector2,
+          1,
+          mAccel.middleCols(joint.dofOffset, n));
+      multiply(
+          scratch.axis,
+          6,
+          n,
+          mAccel.middleCols(joint.dofOffset, n),
+          1,
+          scratch.spatialAcceleration,
+          true);
+    }
+  }
+}
+
+// This gets the values from a DART skeleton to populate our Featherstone
+// implementation
+void BatchedSimpleFeatherstone::populateFromSkeleton(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton)
+{
+  mJointsAndBodies.clear();
+  mScratchSpace.clear();
+  mNumDofs = skeleton->getNumDofs();
+  mGravity = skeleton->getGravity();
+
+  int K = mTileSize;
+  for (std::size_t i = 0; i < skeleton->getNumBodyNodes(); i++)
+  {
+    BodyNode* body = skeleton->getBodyNode(i);
+    Joint* joint = body->getParentJoint();
+
+    mJointsAndBodies.emplace_back();
+    BatchedJointAndBody& jointAndBody = mJointsAndBodies.back();
+    jointAndBody.numDofs = joint->getNumDofs();
+    jointAndBody.dofOffset
+        = jointAndBody.numDofs > 0 ? joint->getIndexInSkeleton(0) : 0;
+    jointAndBody.transformFromParent = joint->getTransformFromParentBodyNode();
+    jointAndBody.transformToChild
+        = joint->getTransformFromChildBodyNode().inverse();
+    jointAndBody.axis = joint->getRelativeJacobian();
+    jointAndBody.inertia = body->getInertia().getSpatialTensor();
+    jointAndBody.parentIndex = -1;
+    if (body->getParentBodyNode() != nullptr)
+    {
+      jointAndBody.parentIndex
+          = body->getParentBodyNode()->getIndexInSkeleton();
+    }
+    assert(jointAndBody.parentIndex < static_cast<int>(i));
+
+    const std::string& type = joint->getType();
+    if (type == WeldJoint::getStaticType())
+    {
+      jointAndBody.type = BatchedJointType::WELD;
+    }
+    else if (
+        type == RevoluteJoint::getStaticType()
+        || type == PrismaticJoint::getStaticType()
+        || type == ScrewJoint::getStaticType())
+    {
+      jointAndBody.type = BatchedJointType::SINGLE_DOF;
+    }
+    else if (type == BallJoint::getStaticType())
+    {
+      jointAndBody.type = BatchedJointType::BALL;
+    }
+    else if (type == FreeJoint::getStaticType())
+    {
+      jointAndBody.type = BatchedJointType::FREE;
+    }
+    else if (type == PlanarJoint::getStaticType())
+    {
+      PlanarJoint* planar = static_cast<PlanarJoint*>(joint);
+      jointAndBody.type = BatchedJointType::PLANAR;
+      jointAndBody.planarTransAxis1 = planar->getTranslationalAxis1();
+      jointAndBody.planarTransAxis2 = planar->getTranslationalAxis2();
+      jointAndBody.planarRotAxis = planar->getRotationalAxis();
+      // Only the rotational column is constant
+      jointAndBody.axis.leftCols(2).setZero();
+    }
+    else
+    {
+      assert(
+          false
+          && "BatchedSimpleFeatherstone only supports weld, revolute, "
+             "prismatic, screw, ball, free and planar joints");
+    }
+
+    int n = jointAndBody.numDofs;
+    mScratchSpace.emplace_back();
+    BatchedFeatherstoneScratchSpace& scratch = mScratchSpace.back();
+    scratch.transformFromParent = Eigen::ArrayXXd::Zero(K, 12);
+    scratch.adInvTransform = Eigen::ArrayXXd::Zero(K, 36);
+    scratch.axis = Eigen::ArrayXXd::Zero(K, 6 * n);
+    scratch.axisDeriv = Eigen::ArrayXXd::Zero(K, 6 * n);
+    scratch.spatialVelocity = Eigen::ArrayXXd::Zero(K, 6);
+    scratch.spatialAcceleration = Eigen::ArrayXXd::Zero(K, 6);
+    scratch.articulatedInertia = Eigen::ArrayXXd::Zero(K, 36);
+    scratch.articulatedBiasForce = Eigen::ArrayXXd::Zero(K, 6);
+    scratch.psi = Eigen::ArrayXXd::Zero(K, n * n);
+    scratch.totalForce = Eigen::ArrayXXd::Zero(K, n);
+    scratch.partialAcceleration = Eigen::ArrayXXd::Zero(K, 6);
+    scratch.AIS = Eigen::ArrayXXd::Zero(K, 6 * n);
+
+    // The constant parts of the axis are the same for every lane, so we only
+    // need to fill them in once
+    for (int c = 0; c < 6 * n; c++)
+    {
+      scratch.axis.col(c).setConstant(jointAndBody.axis(c));
+    }
+    // Weld joints never move, so neither does their transform
+    if (jointAndBody.type == BatchedJointType::WELD)
+    {
+      Eigen::Isometry3d transform
+          = jointAndBody.transformFromParent * jointAndBody.transformToChild;
+      Eigen::Matrix3d rotation = transform.linear();
+      for (int c = 0; c < 9; c++)
+      {
+        scratch.transformFromParent.col(c).setConstant(rotation(c));
+      }
+      for (int r = 0; r < 3; r++)
+      {
+        scratch.transformFromParent.col(9 + r).setConstant(
+            transform.translation()(r));
+      }
+      adInvTMatrix(scratch.transformFromParent, scratch.adInvTransform);
+    }
+  }
+
+  mPos = Eigen::ArrayXXd::Zero(K, mNumDofs);
+  mVel = Eigen::ArrayXXd::Zero(K, mNumDofs);
+  mForce = Eigen::ArrayXXd::Zero(K, mNumDofs);
+  mAccel = Eigen::ArrayXXd::Zero(K, mNumDofs);
+  mMotion = Eigen::ArrayXXd::Zero(K, 12);
+  mTmpTransform = Eigen::ArrayXXd::Zero(K, 12);
+  mTmpVector = Eigen::ArrayXXd::Zero(K, 6);
+  mTmpVector2 = Eigen::ArrayXXd::Zero(K, 6);
+  mTmpMatrix = Eigen::ArrayXXd::Zero(K, 36);
+  mTmpMatrix2 = Eigen::ArrayXXd::Zero(K, 36);
+  mTmpLanes = Eigen::ArrayXXd::Zero(K, 4);
+}
+
+// This recomputes the relative transform of joint `i` (and its Jacobian, for
+// PLANAR joints) for every lane, from mPos and mVel
+void BatchedSimpleFeatherstone::updateTransformAndAxis(int i)
+{
+  const BatchedJointAndBody& joint = mJointsAndBodies[i];
+  BatchedFeatherstoneScratchSpace& scratch = mScratchSpace[i];
+  auto q = mPos.middleCols(joint.dofOffset, joint.numDofs);
+
+  switch (joint.type)
+  {
+    case BatchedJointType::WELD:
+      // This was computed once in populateFromSkeleton()
+      return;
+    case BatchedJointType::SINGLE_DOF:
+      // The axis is in the child frame, so
+      // T = T_parent * exp(S_joint * q) * T_child^-1
+      //   = T_parent * T_child^-1 * exp(axis * q)
+      expMapScrew(joint.axis.col(0), q, mMotion, mTmpLanes);
+      composeConstLeft(
+          joint.transformFromParent * joint.transformToChild,
+          mMotion,
+          scratch.transformFromParent);
+      break;
+    case BatchedJointType::BALL:
+      expMapRot(q, mMotion, mTmpLanes);
+      mMotion.rightCols(3).setZero();
+      composeConstRight(mMotion, joint.transformToChild, mTmpTransform);
+      composeConstLeft(
+          joint.transformFromParent,
+          mTmpTransform,
+          scratch.transformFromParent);
+      break;
+    case BatchedJointType::FREE:
+      expMapRot(q.leftCols(3), mMotion, mTmpLanes);
+      mMotion.rightCols(3) = q.rightCols(3);
+      composeConstRight(mMotion, joint.transformToChild, mTmpTransform);
+      composeConstLeft(
+          joint.transformFromParent,
+          mTmpTransform,
+          scratch.transformFromParent);
+      break;
+    case BatchedJointType::PLANAR: {
+      Eigen::Vector6d rotation = Eigen::Vector6d::Zero();
+      rotation.head<3>() = joint.planarRotAxis;
+      expMapScrew(rotation, q.col(2), mMotion, mTmpLanes);
+      for (int r = 0; r < 3; r++)
+      {
+        mMotion.col(9 + r) = joint.planarTransAxis1(r) * q.col(0)
+                             + joint.planarTransAxis2(r) * q.col(1);
+      }
+      composeConstRight(mMotion, joint.transformToChild, mTmpTransform);
+      composeConstLeft(
+          joint.transformFromParent,
+          mTmpTransform,
+          scratch.transformFromParent);
+
+      // See PlanarJoint::getRelativeJacobianStatic(). The translational
+      // columns are R_child * R(q)^T * transAxis, with no angular part.
+      Eigen::Matrix3d childRotation
+          = joint.transformToChild.linear().transpose();
+      Eigen::Vector3d rotAxis = joint.axis.col(2).head<3>();
+      for (int k = 0; k < 2; k++)
+      {
+        const Eigen::Vector3d& transAxis
+            = k == 0 ? joint.planarTransAxis1 : joint.planarTransAxis2;
+        auto localAxis = mTmpTransform.leftCols(3);
+        for (int r = 0; r < 3; r++)
+        {
+          localAxis.col(r) = mMotion.col(3 * r) * transAxis(0)
+                             + mMotion.col(1 + 3 * r) * transAxis(1)
+                             + mMotion.col(2 + 3 * r) * transAxis(2);
+        }
+        auto linear = scratch.axis.middleCols(6 * k + 3, 3);
+        for (int r = 0; r < 3; r++)
+        {
+          linear.col(r) = childRotation(r, 0) * localAxis.col(0)
+                          + childRotation(r, 1) * localAxis.col(1)
+                          + childRotation(r, 2) * localAxis.col(2);
+        }
+
+        // See PlanarJoint::updateRelativeJacobianTimeDeriv(), which works out
+        // to -(rotAxis * vel[2]) x linear
+        auto linearDeriv = scratch.axisDeriv.middleCols(6 * k + 3, 3);
+        linearDeriv.col(0)
+            = rotAxis(1) * linear.col(2) - rotAxis(2) * linear.col(1);
+        linearDeriv.col(1)
+            = rotAxis(2) * linear.col(0) - rotAxis(0) * linear.col(2);
+        linearDeriv.col(2)
+            = rotAxis(0) * linear.col(1) - rotAxis(1) * linear.col(0);
+        for (int r = 0; r < 3; r++)
+        {
+          linearDeriv.col(r) *= -mVel.col(joint.dofOffset + 2);
+        }
+      }
+      break;
+    }
+  }
+
+  adInvTMatrix(scratch.transformFromParent, scratch.adInvTransform);
+}
+
+} // namespace dynamics
+} // namespace dart
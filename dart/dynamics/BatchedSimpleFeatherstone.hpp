@@ -0,0 +1,181 @@
+#ifndef DART_BATCHED_FAST_FEATHERSTONE
+#define DART_BATCHED_FAST_FEATHERSTONE
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/Memory.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Skeleton;
+
+enum class BatchedJointType
+{
+  // Zero DOFs, the child is rigidly attached to the parent
+  WELD,
+  // Revolute, prismatic and screw joints, which all have a single DOF moving
+  // along a constant screw axis
+  SINGLE_DOF,
+  // Three rotational DOFs, as an exponential map
+  BALL,
+  // Three rotational DOFs (as an exponential map) followed by three
+  // translational DOFs
+  FREE,
+  // Two translational DOFs and one rotational DOF, where the Jacobian depends
+  // on the rotation
+  PLANAR
+};
+
+struct BatchedJointAndBody
+{
+  BatchedJointType type;
+  int numDofs;
+  // The index of this joint's first DOF in the skeleton
+  int dofOffset;
+  // This is the transform from the parent
+  Eigen::Isometry3d transformFromParent;
+  // This is the inverse of the transform from the child
+  Eigen::Isometry3d transformToChild;
+  // This is the relative Jacobian of the joint (6 x numDofs), in the child
+  // body frame. For every joint type except PLANAR this is constant, so it's
+  // the same for every lane. For PLANAR joints, this only holds the constant
+  // rotational column, and the translational columns are recomputed from the
+  // position of each lane.
+  Eigen::MatrixXd axis;
+  // These are only used by PLANAR joints, and are in the joint frame
+  Eigen::Vector3d planarTransAxis1;
+  Eigen::Vector3d planarTransAxis2;
+  Eigen::Vector3d planarRotAxis;
+  // This is the spatial inertia matrix for the body node
+  Eigen::Matrix6d inertia;
+  // -1 indicates this is the root element, otherwise this is the index into
+  // BatchedSimpleFeatherstone::mJointsAndBodies where the parent lives
+  int parentIndex;
+};
+
+// Every value in here is stored with one row per lane (environment) in the
+// current tile (see BatchedSimpleFeatherstone::MAX_TILE_SIZE), and one column
+// per scalar. A matrix with R rows keeps element (r, c) in column (r + c * R).
+// That means each scalar is contiguous across the tile, so all the math in
+// BatchedSimpleFeatherstone is elementwise loops over lanes, which Eigen
+// vectorizes to whatever SIMD width the build targets (AVX2 or AVX-512 when
+// DART_ENABLE_SIMD is on).
+struct BatchedFeatherstoneScratchSpace
+{
+  // 12 columns: the rotation (column major), then the translation
+  Eigen::ArrayXXd transformFromParent;
+  // 36 columns: math::AdInvT() of transformFromParent, as a 6x6 matrix
+  Eigen::ArrayXXd adInvTransform;
+  // 6 * numDofs columns: the relative Jacobian, and its time derivative
+  Eigen::ArrayXXd axis;
+  Eigen::ArrayXXd axisDeriv;
+
+  Eigen::ArrayXXd spatialVelocity;
+  // Gravity is applied by accelerating the world, so this is offset by
+  // gravity compared to BodyNode::getSpatialAcceleration()
+  Eigen::ArrayXXd spatialAcceleration;
+
+  // 36 columns
+  Eigen::ArrayXXd articulatedInertia;
+  Eigen::ArrayXXd articulatedBiasForce;
+
+  // Intermediate values without convenient names. From the symbols on
+  // page 12 of http://www.cs.cmu.edu/~junggon/tools/liegroupdynamics.pdf
+  Eigen::ArrayXXd psi; // numDofs * numDofs columns
+  Eigen::ArrayXXd totalForce; // numDofs columns
+  Eigen::ArrayXXd partialAcceleration; // = eta
+  // AIS = Articulated_Inertia_times_axiS, 6 * numDofs columns
+  Eigen::ArrayXXd AIS;
+};
+
+// This runs the same algorithm as SimpleFeatherstone, but on a whole batch of
+// copies of the same skeleton at once, each in its own state. This is meant
+// for stepping lots of environments in lockstep, like in batched RL rollouts.
+//
+// Unlike SimpleFeatherstone, this supports multi-DOF joints (ball, free and
+// planar), as well as weld joints, and gravity. Like SimpleFeatherstone, this
+// ignores joint damping, springs, armature, friction and external forces.
+class BatchedSimpleFeatherstone
+{
+public:
+  // We compute this many lanes at a time, which keeps the scratch space for
+  // each tile small enough to stay in cache
+  static constexpr int MAX_TILE_SIZE = 64;
+
+  BatchedSimpleFeatherstone(int batchSize);
+
+  // The number of lanes (environments) we compute at once
+  int getBatchSize() const;
+
+  // The number of joints in this skeleton
+  int len() const;
+
+  // The number of DOFs in this skeleton
+  int getNumDofs() const;
+
+  // This sets the gravity vector, in world coordinates. populateFromSkeleton()
+  // sets this to the gravity of the skeleton.
+  void setGravity(const Eigen::Vector3d& gravity);
+
+  // Returns the gravity vector, in world coordinates
+  const Eigen::Vector3d& getGravity() const;
+
+  // This computes accelerations for every lane at once. All the arguments are
+  // getNumDofs() x getBatchSize(), with one column per lane, which is the same
+  // layout BatchedWorld uses.
+  void forwardDynamics(
+      const Eigen::MatrixXd& pos,
+      const Eigen::MatrixXd& vel,
+      const Eigen::MatrixXd& force,
+      /* OUT */ Eigen::MatrixXd& accelerations);
+
+  // This gets the values from a DART skeleton to populate our Featherstone
+  // implementation, and allocates all the scratch space for the batch
+  void populateFromSkeleton(
+      const std::shared_ptr<dynamics::Skeleton>& skeleton);
+
+  // protected:
+  // This runs forward dynamics on a single tile of lanes, from mPos, mVel and
+  // mForce into mAccel
+  void forwardDynamicsTile();
+
+  // This recomputes the relative transform of joint `i` (and its Jacobian, for
+  // PLANAR joints) for every lane, from mPos and mVel
+  void updateTransformAndAxis(int i);
+
+  int mBatchSize;
+  int mTileSize;
+  int mNumDofs;
+  Eigen::Vector3d mGravity;
+
+  // BatchedJointAndBody holds fixed size Eigen types, which need more alignment
+  // than std::allocator guarantees once AVX is on
+  common::aligned_vector<BatchedJointAndBody> mJointsAndBodies;
+  std::vector<BatchedFeatherstoneScratchSpace> mScratchSpace;
+
+  // These are tile size x DOFs, which is the transpose of what
+  // forwardDynamics() takes, so each DOF is contiguous across lanes
+  Eigen::ArrayXXd mPos;
+  Eigen::ArrayXXd mVel;
+  Eigen::ArrayXXd mForce;
+  Eigen::ArrayXXd mAccel;
+
+  // Scratch space shared between joints, so forwardDynamics() never allocates
+  Eigen::ArrayXXd mMotion;
+  Eigen::ArrayXXd mTmpTransform;
+  Eigen::ArrayXXd mTmpVector;
+  Eigen::ArrayXXd mTmpVector2;
+  Eigen::ArrayXXd mTmpMatrix;
+  Eigen::ArrayXXd mTmpMatrix2;
+  Eigen::ArrayXXd mTmpLanes;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
@@ -49,11 +49,18 @@
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/Marker.hpp"
 #include "dart/dynamics/PointMass.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/SoftBodyNode.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 
 #define SET_ALL_FLAGS(X)                                                       \
   for (auto& cache : mTreeCache)                                               \
@@ -1573,8 +1580,17 @@ void Skeleton::setGradientConstraintMatrices(
 //==============================================================================
 Eigen::MatrixXd Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
 {
-  // TOOD(keenon): replace with the GEAR approach
-  return finiteDifferenceJacobianOfC(wrt);
+  if (wrt == neural::WithRespectTo::FORCE)
+  {
+    // C(pos, vel) doesn't depend on the control forces
+    return Eigen::MatrixXd::Zero(getNumDofs(), wrt->dim(this));
+  }
+  if (!canComputeAnalyticalJacobianOfID(wrt))
+  {
+    return finiteDifferenceJacobianOfC(wrt);
+  }
+  // C(pos, vel) is just the inverse dynamics with zero acceleration
+  return getJacobianOfID(Eigen::VectorXd::Zero(getNumDofs()), true, wrt);
 }
 
 //==============================================================================
@@ -1582,8 +1598,291 @@ Eigen::MatrixXd Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
 Eigen::MatrixXd Skeleton::getJacobianOfMinv(
     Eigen::VectorXd f, neural::WithRespectTo* wrt)
 {
-  // TOOD(keenon): replace with the GEAR approach
-  return finiteDifferenceJacobianOfMinv(f, wrt);
+  if (wrt == neural::WithRespectTo::VELOCITY
+      || wrt == neural::WithRespectTo::FORCE)
+  {
+    // M(pos) doesn't depend on velocities or forces
+    return Eigen::MatrixXd::Zero(getNumDofs(), wrt->dim(this));
+  }
+  if (!canComputeAnalyticalJacobianOfID(wrt))
+  {
+    return finiteDifferenceJacobianOfMinv(f, wrt);
+  }
+  // d/dx (M^{-1} f) = -M^{-1} (d/dx M) M^{-1} f, and (d/dx M) M^{-1} f is just
+  // the Jacobian of the inverse dynamics (with no velocity or gravity) at the
+  // acceleration M^{-1} f
+  Eigen::VectorXd Minv_f = multiplyByImplicitInvMassMatrix(f);
+  return -getInvMassMatrix() * getJacobianOfID(Minv_f, false, wrt);
+}
+
+//==============================================================================
+/// The analytical inverse dynamics Jacobians assume that each joint's relative
+/// Jacobian is constant when expressed in the child body frame. That's true of
+/// all the single DOF joints, and of BallJoint and FreeJoint (whose velocities
+/// are body twists), but not of joints like EulerJoint or PlanarJoint.
+static bool hasConstantRelativeJacobian(const Joint* joint)
+{
+  const std::string& type = joint->getType();
+  return type == WeldJoint::getStaticType()
+         || type == RevoluteJoint::getStaticType()
+         || type == PrismaticJoint::getStaticType()
+         || type == ScrewJoint::getStaticType()
+         || type == TranslationalJoint::getStaticType()
+         || type == TranslationalJoint2D::getStaticType()
+         || type == BallJoint::getStaticType()
+         || type == FreeJoint::getStaticType();
+}
+
+//==============================================================================
+bool Skeleton::canComputeAnalyticalJacobianOfID(neural::WithRespectTo* wrt)
+{
+  if (wrt != neural::WithRespectTo::POSITION
+      && wrt != neural::WithRespectTo::VELOCITY
+      && dynamic_cast<neural::WithRespectToMass*>(wrt) == nullptr)
+  {
+    return false;
+  }
+  // Soft bodies add point mass dynamics that the sweep doesn't model
+  if (getNumSoftBodyNodes() > 0)
+    return false;
+  for (std::size_t i = 0; i < getNumJoints(); i++)
+  {
+    if (!hasConstantRelativeJacobian(getJoint(i)))
+      return false;
+  }
+  return true;
+}
+
+//==============================================================================
+Eigen::MatrixXd Skeleton::getJacobianOfID(
+    const Eigen::VectorXd& accelerations,
+    bool withCoriolisAndGravity,
+    neural::WithRespectTo* wrt)
+{
+  assert(canComputeAnalyticalJacobianOfID(wrt));
+
+  const std::size_t n = getNumDofs();
+  const int m = wrt->dim(this);
+  assert(static_cast<std::size_t>(accelerations.size()) == n);
+
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(n, m);
+  if (n == 0 || m == 0)
+    return J;
+
+  const bool wrtPos = (wrt == neural::WithRespectTo::POSITION);
+  const bool wrtVel = (wrt == neural::WithRespectTo::VELOCITY);
+  neural::WithRespectToMass* wrtMass
+      = dynamic_cast<neural::WithRespectToMass*>(wrt);
+  // Only the position and velocity derivatives move the kinematics, mass
+  // derivatives just change the inertias in the backward pass
+  const bool hasKinematicTangents = wrtPos || wrtVel;
+
+  if (wrtVel && !withCoriolisAndGravity)
+    return J;
+
+  const Eigen::VectorXd dq
+      = withCoriolisAndGravity ? getVelocities() : Eigen::VectorXd::Zero(n);
+  Eigen::Vector6d gravity = Eigen::Vector6d::Zero();
+  if (withCoriolisAndGravity)
+    gravity.tail<3>() = mAspectProperties.mGravity;
+
+  // For mass derivatives, map each body to the columns of the Jacobian that
+  // perturb its inertia
+  std::vector<
+      std::vector<std::pair<const neural::WrtMassBodyNodyEntry*, int>>>
+      massEntries(getNumBodyNodes());
+  if (wrtMass != nullptr)
+  {
+    int cursor = 0;
+    for (const neural::WrtMassBodyNodyEntry& entry :
+         wrtMass->getNodes(this))
+    {
+      massEntries[getBodyNode(entry.linkName)->getIndexInSkeleton()]
+          .emplace_back(&entry, cursor);
+      cursor += entry.dim();
+    }
+    assert(cursor == m);
+  }
+
+  // These are all indexed by the BodyNode's index in the skeleton. The
+  // tangents (d*) hold one column per column of the Jacobian, so we sweep the
+  // skeleton once for all the columns simultaneously.
+  const std::size_t numBodies = getNumBodyNodes();
+  common::aligned_vector<Eigen::Vector6d> V(numBodies);
+  common::aligned_vector<Eigen::Vector6d> A(numBodies);
+  common::aligned_vector<Eigen::Vector6d> G(numBodies);
+  common::aligned_vector<Eigen::Vector6d> F(numBodies);
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> dV(numBodies);
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> dA(numBodies);
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> dG(numBodies);
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> dF(numBodies);
+  // The parent joint's screw axes for position, expressed in the child frame
+  std::vector<Eigen::Matrix<double, 6, Eigen::Dynamic>> posScrews(numBodies);
+
+  for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
+  {
+    const std::vector<BodyNode*>& bodyNodes = mTreeCache[tree].mBodyNodes;
+
+    // Forward pass: velocities, accelerations and gravity in body frames
+    for (BodyNode* body : bodyNodes)
+    {
+      const std::size_t i = body->getIndexInSkeleton();
+      const Joint* joint = body->getParentJoint();
+      const BodyNode* parent = body->getParentBodyNode();
+      const Eigen::Isometry3d& T = joint->getRelativeTransform();
+      const math::Jacobian S = joint->getRelativeJacobian();
+      const std::size_t jointDofs = joint->getNumDofs();
+
+      Eigen::VectorXd jointVel(jointDofs);
+      Eigen::VectorXd jointAcc(jointDofs);
+      for (std::size_t l = 0; l < jointDofs; l++)
+      {
+        jointVel(l) = dq(joint->getIndexInSkeleton(l));
+        jointAcc(l) = accelerations(joint->getIndexInSkeleton(l));
+      }
+      const Eigen::Vector6d S_dq = S * jointVel;
+
+      Eigen::Vector6d parentV = Eigen::Vector6d::Zero();
+      Eigen::Vector6d parentA = Eigen::Vector6d::Zero();
+      Eigen::Vector6d parentG = gravity;
+      if (parent != nullptr)
+      {
+        const std::size_t p = parent->getIndexInSkeleton();
+        parentV = V[p];
+        parentA = A[p];
+        parentG = G[p];
+      }
+      const Eigen::Vector6d transformedV = math::AdInvT(T, parentV);
+      const Eigen::Vector6d transformedA = math::AdInvT(T, parentA);
+      const Eigen::Vector6d transformedG = math::AdInvT(T, parentG);
+
+      V[i] = transformedV + S_dq;
+      A[i] = transformedA + math::ad(V[i], S_dq) + S * jointAcc;
+      G[i] = transformedG;
+
+      if (!hasKinematicTangents)
+        continue;
+
+      if (parent != nullptr)
+      {
+        const std::size_t p = parent->getIndexInSkeleton();
+        dV[i] = math::AdInvTJac(T, dV[p]);
+        dA[i] = math::AdInvTJac(T, dA[p]);
+        dG[i] = math::AdInvTJac(T, dG[p]);
+      }
+      else
+      {
+        dV[i] = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, m);
+        dA[i] = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, m);
+        dG[i] = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, m);
+      }
+
+      if (wrtPos)
+      {
+        // Moving a DOF of this joint perturbs T by exp(screw), so
+        // d/dq AdInvT(T, x) = -ad(screw, AdInvT(T, x))
+        posScrews[i].resize(6, jointDofs);
+        for (std::size_t l = 0; l < jointDofs; l++)
+        {
+          const std::size_t k = joint->getIndexInSkeleton(l);
+          const Eigen::Vector6d screw = math::AdInvT(
+              body->getWorldTransform(),
+              joint->getWorldAxisScrewForPosition(l));
+          posScrews[i].col(l) = screw;
+          dV[i].col(k) -= math::ad(screw, transformedV);
+          dA[i].col(k) -= math::ad(screw, transformedA);
+          dG[i].col(k) -= math::ad(screw, transformedG);
+        }
+      }
+      else if (wrtVel)
+      {
+        for (std::size_t l = 0; l < jointDofs; l++)
+        {
+          const std::size_t k = joint->getIndexInSkeleton(l);
+          dV[i].col(k) += S.col(l);
+          dA[i].col(k) += math::ad(V[i], S.col(l));
+        }
+      }
+
+      // d/dx ad(V, S*dq) where only V is moving, which is -ad(S*dq, dV)
+      dA[i] -= math::adJac(S_dq, dV[i]);
+    }
+
+    // Backward pass: body forces, and their projection onto the joints
+    for (auto it = bodyNodes.rbegin(); it != bodyNodes.rend(); ++it)
+    {
+      BodyNode* body = *it;
+      const std::size_t i = body->getIndexInSkeleton();
+      const Joint* joint = body->getParentJoint();
+      const Eigen::Matrix6d& I = body->getSpatialInertia();
+      const bool gravityMode = body->getGravityMode();
+
+      const Eigen::Vector6d IV = I * V[i];
+      F[i] = I * A[i] - math::dad(V[i], IV);
+      if (gravityMode)
+        F[i] -= I * G[i];
+
+      if (hasKinematicTangents)
+      {
+        dF[i] = I * dA[i];
+        if (gravityMode)
+          dF[i] -= I * dG[i];
+        for (int c = 0; c < m; c++)
+        {
+          const Eigen::Vector6d dVc = dV[i].col(c);
+          dF[i].col(c) -= math::dad(dVc, IV) + math::dad(V[i], I * dVc);
+        }
+      }
+      else
+      {
+        dF[i] = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, m);
+      }
+
+      for (const auto& massEntry : massEntries[i])
+      {
+        const Eigen::Vector6d netA = gravityMode ? (A[i] - G[i]) : A[i];
+        for (int idx = 0; idx < massEntry.first->dim(); idx++)
+        {
+          const Eigen::Matrix6d dI
+              = massEntry.first->getSpatialInertiaGradient(this, idx);
+          dF[i].col(massEntry.second + idx)
+              += dI * netA - math::dad(V[i], dI * V[i]);
+        }
+      }
+
+      for (std::size_t c = 0; c < body->getNumChildBodyNodes(); c++)
+      {
+        const BodyNode* child = body->getChildBodyNode(c);
+        const std::size_t ci = child->getIndexInSkeleton();
+        const Joint* childJoint = child->getParentJoint();
+        const Eigen::Isometry3d& childT = childJoint->getRelativeTransform();
+
+        F[i] += math::dAdInvT(childT, F[ci]);
+        for (int col = 0; col < m; col++)
+        {
+          dF[i].col(col) += math::dAdInvT(childT, dF[ci].col(col));
+        }
+        if (wrtPos)
+        {
+          // d/dq dAdInvT(T, x) = -dAdInvT(T, dad(screw, x))
+          for (std::size_t l = 0; l < childJoint->getNumDofs(); l++)
+          {
+            const std::size_t k = childJoint->getIndexInSkeleton(l);
+            dF[i].col(k) -= math::dAdInvT(
+                childT, math::dad(posScrews[ci].col(l), F[ci]));
+          }
+        }
+      }
+
+      const math::Jacobian S = joint->getRelativeJacobian();
+      for (std::size_t l = 0; l < joint->getNumDofs(); l++)
+      {
+        J.row(joint->getIndexInSkeleton(l)) = S.col(l).transpose() * dF[i];
+      }
+    }
+  }
+
+  return J;
 }
 
 //==============================================================================
@@ -1604,8 +1903,11 @@ Eigen::MatrixXd Skeleton::getUnconstrainedVelJacobianWrt(
 //==============================================================================
 Eigen::MatrixXd Skeleton::getVelCJacobian()
 {
-  // TOOD(keenon): replace with the GEAR approach
-  return finiteDifferenceVelCJacobian();
+  if (!canComputeAnalyticalJacobianOfID(neural::WithRespectTo::VELOCITY))
+  {
+    return finiteDifferenceVelCJacobian();
+  }
+  return getJacobianOfC(neural::WithRespectTo::VELOCITY);
 }
 
 //==============================================================================
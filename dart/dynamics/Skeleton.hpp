@@ -590,6 +590,23 @@ public:
   Eigen::MatrixXd getJacobianOfMinv(
       Eigen::VectorXd f, neural::WithRespectTo* wrt);
 
+  /// This gives the unconstrained Jacobian of the inverse dynamics,
+  /// M(pos)*accelerations + C(pos, vel), with respect to `wrt`, holding
+  /// `accelerations` fixed. If `withCoriolisAndGravity` is false, this drops
+  /// the velocity and gravity terms, which leaves the Jacobian of
+  /// M(pos)*accelerations. This is computed analytically, with one forward and
+  /// one backward sweep over the skeleton that carries the derivatives for all
+  /// the columns of the Jacobian at once.
+  Eigen::MatrixXd getJacobianOfID(
+      const Eigen::VectorXd& accelerations,
+      bool withCoriolisAndGravity,
+      neural::WithRespectTo* wrt);
+
+  /// Returns true if getJacobianOfID() supports this skeleton and `wrt`.
+  /// Otherwise the Jacobians of C(pos, vel) and M^{-1}f fall back to finite
+  /// differencing.
+  bool canComputeAnalyticalJacobianOfID(neural::WithRespectTo* wrt);
+
   /// VERY SLOW: Only for testing. This computes the unconstrained Jacobian
   /// giving the difference in C(pos, vel) for finite changes
   Eigen::MatrixXd finiteDifferenceJacobianOfC(neural::WithRespectTo* wrt);
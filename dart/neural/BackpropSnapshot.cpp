@@ -2,6 +2,7 @@
 
 #include <iostream>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -39,6 +40,8 @@ BackpropSnapshot::BackpropSnapshot(
     Eigen::VectorXd preStepLCPCache)
   : mUseFDOverride(world->getUseFDOverride()),
     mSlowDebugResultsAgainstFD(world->getSlowDebugResultsAgainstFD()),
+    mUseVJPBackprop(world->getUseVJPBackprop()),
+    mFactorizationCache(std::make_shared<LCPFactorizationCache>()),
     mNumDOFs(0),
     mNumConstraintDim(0),
     mNumClamping(0),
@@ -120,6 +123,12 @@ void BackpropSnapshot::backprop(
     const LossGradient& nextTimestepLoss,
     PerformanceLog* perfLog)
 {
+  if (mUseVJPBackprop && !mUseFDOverride && !mSlowDebugResultsAgainstFD)
+  {
+    backpropVJP(world, thisTimestepLoss, nextTimestepLoss, perfLog);
+    return;
+  }
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -306,6 +315,565 @@ void BackpropSnapshot::backprop(
   */
 }
 
+//==============================================================================
+/// This computes the same thing as backprop(), but works in terms of
+/// vector-Jacobian products wherever it can. Mass matrix products go through
+/// the implicit (Featherstone) multiply, solves against the LCP matrix use its
+/// cached factorization, and the finite-difference terms differentiate a scalar
+/// per skeleton instead of a whole Jacobian. That means it never forms the
+/// full (world DOFs x world DOFs) position or velocity Jacobians, or the world
+/// mass matrix or its inverse. It does still form the per-skeleton integrator
+/// and dC/dv blocks, the (clamping x clamping) constraint matrix Q and its
+/// pseudo-inverse, and the bounce approximation when there are bounces.
+/// backprop() calls this if World::setUseVJPBackprop() was set when this
+/// snapshot was taken.
+void BackpropSnapshot::backpropVJP(
+    WorldPtr world,
+    LossGradient& thisTimestepLoss,
+    const LossGradient& nextTimestepLoss,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.backpropVJP");
+  }
+#endif
+
+  // Like backprop(), this leaves the world at the pre-step position and
+  // velocity
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  RestorableSnapshot snapshot(world);
+  world->setExternalForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  const Eigen::VectorXd& lossWrtNextPos = nextTimestepLoss.lossWrtPosition;
+  const Eigen::VectorXd& lossWrtNextVel = nextTimestepLoss.lossWrtVelocity;
+  const double dt = world->getTimeStep();
+
+  //////////////////////////////////////////////////////////
+  // The next position only depends on this position and velocity through each
+  // skeleton's integrator, followed by the bounce approximation
+
+  Eigen::VectorXd posPosT = Eigen::VectorXd::Zero(mNumDOFs);
+  Eigen::VectorXd velPosT = Eigen::VectorXd::Zero(mNumDOFs);
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    std::size_t dofs = skel->getNumDofs();
+    posPosT.segment(cursor, dofs)
+        = skel->getPosPosJac(skel->getPositions(), skel->getVelocities(), dt)
+              .transpose()
+          * lossWrtNextPos.segment(cursor, dofs);
+    velPosT.segment(cursor, dofs)
+        = skel->getVelPosJac(skel->getPositions(), skel->getVelocities(), dt)
+              .transpose()
+          * lossWrtNextPos.segment(cursor, dofs);
+    cursor += dofs;
+  }
+  if (hasBounces())
+  {
+    const Eigen::MatrixXd& bounce
+        = getBounceApproximationJacobian(world, thisLog);
+    posPosT = bounce.transpose() * posPosT;
+    velPosT = bounce.transpose() * velPosT;
+  }
+
+  //////////////////////////////////////////////////////////
+  // The next velocity. This mirrors getVelJacobianWrt(), transposed. M^{-1}
+  // is symmetric, so we can always apply it directly to the incoming loss.
+
+  Eigen::VectorXd tau = world->getExternalForces();
+  Eigen::VectorXd C = world->getCoriolisAndGravityAndExternalForces();
+  Eigen::VectorXd w = implicitMultiplyByInvMassMatrix(world, lossWrtNextVel);
+
+  // Each (lhs, x) pair here contributes lhs^T * d(M^{-1} x), and cLhs
+  // contributes cLhs^T * dC. We push all of these through the per-skeleton
+  // Jacobians once we've collected them.
+  typedef std::vector<std::pair<Eigen::VectorXd, Eigen::VectorXd>> MinvTerms;
+  MinvTerms minvTerms;
+  MinvTerms minvPosTerms;
+  MinvTerms minvMassTerms;
+  Eigen::VectorXd cLhs;
+  // This collects the terms from the derivatives of A_c and A_ub with respect
+  // to position, which come straight from the contact Jacobians
+  Eigen::VectorXd contactPosT = Eigen::VectorXd::Zero(mNumDOFs);
+
+  Eigen::VectorXd forceVelT;
+  Eigen::VectorXd velVelT;
+
+  Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
+  if (A_c.cols() == 0)
+  {
+    // force-vel is just dt * M^{-1}, and vel-vel is I - force-vel * dC/dv,
+    // where dC/dv is block diagonal
+    forceVelT = dt * w;
+    velVelT = lossWrtNextVel;
+    cursor = 0;
+    for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    {
+      SkeletonPtr skel = world->getSkeleton(i);
+      std::size_t dofs = skel->getNumDofs();
+      velVelT.segment(cursor, dofs) -= skel->getVelCJacobian().transpose()
+                                       * forceVelT.segment(cursor, dofs);
+      cursor += dofs;
+    }
+
+    minvTerms.emplace_back(lossWrtNextVel, dt * (tau - C));
+    cLhs = -dt * w;
+  }
+  else
+  {
+    Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix(world);
+    Eigen::MatrixXd E = getUpperBoundMappingMatrix();
+    Eigen::MatrixXd A = A_c + A_ub * E;
+    Eigen::VectorXd f_c = getClampingConstraintImpulses();
+    Eigen::VectorXd b = getClampingConstraintRelativeVels();
+    Eigen::VectorXd v_f = getPreConstraintVelocity();
+    Eigen::VectorXd f = mPreStepTorques - C;
+
+    // This is built exactly the way the Jacobian getters build it, so we share
+    // their factorization
+    BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+    Eigen::MatrixXd Q = A_c.transpose() * Minv * A;
+    std::shared_ptr<const LCPFactorization> Qfac
+        = mFactorizationCache->factor(Q);
+
+    // The loss only reaches the constraint forces through M^{-1} * A * f_c, so
+    // we push it back through the solve against Q once, up front
+    Eigen::VectorXd r = A.transpose() * w;
+    Eigen::VectorXd s = Qfac->solveTranspose(r);
+    Eigen::VectorXd t = getBounceDiagonals().cwiseProduct(s);
+    Eigen::VectorXd A_c_t = A_c * t;
+    Eigen::VectorXd Minv_A_c_t = implicitMultiplyByInvMassMatrix(world, A_c_t);
+
+    forceVelT = dt * (w - Minv_A_c_t);
+    Eigen::VectorXd velCLhs = w - Minv_A_c_t;
+    velVelT = lossWrtNextVel - A_c_t
+              - dt
+                    * stackGradientsPerSkeleton(
+                        world,
+                        WithRespectTo::VELOCITY,
+                        [&](dynamics::Skeleton* skel, std::size_t dofOffset) {
+                          return Eigen::VectorXd(
+                              skel->getVelCJacobian().transpose()
+                              * velCLhs.segment(
+                                  dofOffset, skel->getNumDofs()));
+                        });
+
+    Eigen::VectorXd y = dt * A_c_t;
+    minvTerms.emplace_back(lossWrtNextVel, dt * (tau - C) + A * f_c);
+    minvTerms.emplace_back(-y, f);
+    cLhs = implicitMultiplyByInvMassMatrix(world, y) - dt * w;
+
+    // The contact Jacobians with respect to position
+
+    std::vector<DofBlockJacobian> clampingJacs;
+    for (std::shared_ptr<DifferentiableContactConstraint> constraint :
+         getClampingConstraints())
+    {
+      clampingJacs.push_back(
+          constraint->getConstraintForcesJacobianBlock(world));
+    }
+    std::vector<DofBlockJacobian> upperBoundJacs;
+    for (std::shared_ptr<DifferentiableContactConstraint> constraint :
+         getUpperBoundConstraints())
+    {
+      upperBoundJacs.push_back(
+          constraint->getConstraintForcesJacobianBlock(world));
+    }
+
+    // This adds sum_i weights(i) * J_i^T * v into contactPosT
+    auto addJacobiansTransposeTimes
+        = [&contactPosT](
+              const std::vector<DofBlockJacobian>& jacs,
+              const Eigen::VectorXd& weights,
+              const Eigen::VectorXd& v) {
+            for (std::size_t i = 0; i < jacs.size(); i++)
+            {
+              if (weights(i) != 0)
+                contactPosT += weights(i) * jacs[i].transposeTimes(v);
+            }
+          };
+
+    addJacobiansTransposeTimes(clampingJacs, f_c, w);
+    addJacobiansTransposeTimes(upperBoundJacs, E * f_c, w);
+    addJacobiansTransposeTimes(clampingJacs, -t, v_f);
+
+    // These are p^T * dQ(z) and p^T * dQT(z), where dQ and dQT are the
+    // Jacobians of Q * z and Q^T * z that
+    // getJacobianOfLCPConstraintMatrixClampingSubset() uses
+    auto addDQ = [&](const Eigen::VectorXd& p, const Eigen::VectorXd& z) {
+      Eigen::VectorXd Minv_A_z = implicitMultiplyByInvMassMatrix(world, A * z);
+      Eigen::VectorXd Minv_A_c_p
+          = implicitMultiplyByInvMassMatrix(world, A_c * p);
+      addJacobiansTransposeTimes(clampingJacs, p, Minv_A_z);
+      addJacobiansTransposeTimes(clampingJacs, z, Minv_A_c_p);
+      addJacobiansTransposeTimes(upperBoundJacs, E * z, Minv_A_c_p);
+      minvPosTerms.emplace_back(A_c * p, A * z);
+    };
+    auto addDQT = [&](const Eigen::VectorXd& p, const Eigen::VectorXd& z) {
+      Eigen::VectorXd Minv_A_c_z
+          = implicitMultiplyByInvMassMatrix(world, A_c * z);
+      Eigen::VectorXd Minv_A_p = implicitMultiplyByInvMassMatrix(world, A * p);
+      addJacobiansTransposeTimes(clampingJacs, p, Minv_A_c_z);
+      addJacobiansTransposeTimes(clampingJacs, z, Minv_A_p);
+      addJacobiansTransposeTimes(upperBoundJacs, E * p, Minv_A_c_z);
+      minvPosTerms.emplace_back(A * p, A_c * z);
+    };
+
+    // This is the gradient of the pseudoinverse, see
+    // https://mathoverflow.net/a/29511/163259
+    const Eigen::MatrixXd& Qinv = Qfac->getPseudoInverse();
+    Eigen::VectorXd QinvT_r = Qinv.transpose() * r;
+    Eigen::VectorXd Qinv_b = Qinv * b;
+    addDQ(-QinvT_r, Qinv_b);
+    addDQT(Qinv * QinvT_r, b - Q * Qinv_b);
+    addDQT(r - Q.transpose() * QinvT_r, Qinv.transpose() * Qinv_b);
+
+    // Every other WRT treats A_c as constant
+    Eigen::VectorXd A_c_s = A_c * s;
+    minvMassTerms.emplace_back(-A_c_s, A_c * Qfac->solve(b));
+  }
+
+  // These are sum_i lhs_i^T * d/dx (M^{-1} rhs_i) + cLhs^T * d/dx C, using the
+  // analytical Jacobians of the inverse dynamics. Each skeleton still builds
+  // its (dofs x wrt-dim) Jacobian blocks and multiplies by their transposes,
+  // so this is O(n^2) per skeleton, but it never runs Featherstone once per
+  // perturbed coordinate like finite differencing does.
+  const MinvTerms& sharedMinvTerms = minvTerms;
+  auto gradient = [&](const MinvTerms& extraTerms, WithRespectTo* wrt) {
+    return stackGradientsPerSkeleton(
+        world, wrt, [&](dynamics::Skeleton* skel, std::size_t dofOffset) {
+          std::size_t dofs = skel->getNumDofs();
+          Eigen::VectorXd grad = getSkeletonJacobianOfC(skel, wrt).transpose()
+                                 * cLhs.segment(dofOffset, dofs);
+          for (const MinvTerms* list : {&sharedMinvTerms, &extraTerms})
+          {
+            for (const std::pair<Eigen::VectorXd, Eigen::VectorXd>& term :
+                 *list)
+            {
+              grad += getSkeletonJacobianOfMinvTransposeTimes(
+                  skel,
+                  term.first.segment(dofOffset, dofs),
+                  term.second.segment(dofOffset, dofs),
+                  wrt);
+            }
+          }
+          return grad;
+        });
+  };
+
+  Eigen::VectorXd posVelT
+      = contactPosT + gradient(minvPosTerms, WithRespectTo::POSITION);
+  Eigen::VectorXd massVelT
+      = gradient(minvMassTerms, world->getWrtMass().get());
+
+  thisTimestepLoss.lossWrtPosition = posPosT + posVelT;
+  thisTimestepLoss.lossWrtVelocity = velPosT + velVelT;
+  thisTimestepLoss.lossWrtTorque = forceVelT;
+  thisTimestepLoss.lossWrtMass = massVelT;
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This is the forward-mode counterpart of backprop(). It pushes tangent
+/// directions on this timestep's inputs forward to tangents on the next
+/// position and velocity, without forming any Jacobians. Each column of the
+/// inputs is one direction. `tangentPos`, `tangentVel` and `tangentForce`
+/// are (numDofs x k), and `tangentMass` is either (massDims x k), or has no
+/// rows if the directions don't move the masses. The cost scales with k,
+/// rather than with the number of DOFs or masses.
+StateTangent BackpropSnapshot::jvp(
+    WorldPtr world,
+    const Eigen::MatrixXd& tangentPos,
+    const Eigen::MatrixXd& tangentVel,
+    const Eigen::MatrixXd& tangentForce,
+    const Eigen::MatrixXd& tangentMass,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.jvp");
+  }
+#endif
+
+  const int k = tangentPos.cols();
+  assert(tangentPos.rows() == mNumDOFs);
+  assert(tangentVel.rows() == mNumDOFs && tangentVel.cols() == k);
+  assert(tangentForce.rows() == mNumDOFs && tangentForce.cols() == k);
+  const bool useMass = tangentMass.rows() > 0 && world->getMassDims() > 0;
+  assert(!useMass || tangentMass.rows() == world->getMassDims());
+  assert(!useMass || tangentMass.cols() == k);
+
+  RestorableSnapshot snapshot(world);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setExternalForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  const double dt = world->getTimeStep();
+
+  StateTangent result;
+  result.position = Eigen::MatrixXd::Zero(mNumDOFs, k);
+  result.velocity = Eigen::MatrixXd::Zero(mNumDOFs, k);
+
+  //////////////////////////////////////////////////////////
+  // The next position goes through the bounce approximation, and then through
+  // each skeleton's integrator
+
+  Eigen::MatrixXd bouncedPos = tangentPos;
+  Eigen::MatrixXd bouncedVel = tangentVel;
+  if (hasBounces())
+  {
+    const Eigen::MatrixXd& bounce
+        = getBounceApproximationJacobian(world, thisLog);
+    bouncedPos = bounce * tangentPos;
+    bouncedVel = bounce * tangentVel;
+  }
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    std::size_t dofs = skel->getNumDofs();
+    result.position.middleRows(cursor, dofs)
+        = skel->getPosPosJac(skel->getPositions(), skel->getVelocities(), dt)
+              * bouncedPos.middleRows(cursor, dofs)
+          + skel->getVelPosJac(skel->getPositions(), skel->getVelocities(), dt)
+                * bouncedVel.middleRows(cursor, dofs);
+    cursor += dofs;
+  }
+
+  //////////////////////////////////////////////////////////
+  // The next velocity. This mirrors getVelJacobianWrt(), applied to one
+  // direction at a time. The finite-differenced terms are taken as
+  // directional derivatives, so each costs a single perturbation per skeleton
+  // per direction.
+
+  Eigen::VectorXd tau = world->getExternalForces();
+  Eigen::VectorXd C = world->getCoriolisAndGravityAndExternalForces();
+  Eigen::VectorXd f = mPreStepTorques - C;
+  WithRespectTo* wrtMass = world->getWrtMass().get();
+
+  Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
+  const bool clamping = A_c.cols() > 0;
+
+  Eigen::MatrixXd A_ub;
+  Eigen::MatrixXd E;
+  Eigen::MatrixXd A;
+  Eigen::VectorXd f_c;
+  Eigen::VectorXd b;
+  Eigen::VectorXd v_f;
+  Eigen::VectorXd bounceDiagonals;
+  Eigen::MatrixXd Q;
+  std::shared_ptr<const LCPFactorization> Qfac;
+  std::vector<DofBlockJacobian> clampingJacs;
+  std::vector<DofBlockJacobian> upperBoundJacs;
+  if (clamping)
+  {
+    A_ub = getUpperBoundConstraintMatrix(world);
+    E = getUpperBoundMappingMatrix();
+    A = A_c + A_ub * E;
+    f_c = getClampingConstraintImpulses();
+    b = getClampingConstraintRelativeVels();
+    v_f = getPreConstraintVelocity();
+    bounceDiagonals = getBounceDiagonals();
+    // This is built exactly the way the Jacobian getters build it, so we share
+    // their factorization
+    BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+    Q = A_c.transpose() * Minv * A;
+    Qfac = mFactorizationCache->factor(Q);
+
+    if (!tangentPos.isZero())
+    {
+      for (std::shared_ptr<DifferentiableContactConstraint> constraint :
+           getClampingConstraints())
+      {
+        clampingJacs.push_back(
+            constraint->getConstraintForcesJacobianBlock(world));
+      }
+      for (std::shared_ptr<DifferentiableContactConstraint> constraint :
+           getUpperBoundConstraints())
+      {
+        upperBoundJacs.push_back(
+            constraint->getConstraintForcesJacobianBlock(world));
+      }
+    }
+  }
+
+  // The vectors we need d(M^{-1} x) for, with respect to position and mass
+  Eigen::MatrixXd minvPosRhs;
+  Eigen::MatrixXd minvMassRhs;
+  // The pieces of the pseudoinverse gradient, see
+  // getJacobianOfLCPConstraintMatrixClampingSubset()
+  Eigen::MatrixXd Qinv;
+  Eigen::VectorXd Qinv_b;
+  Eigen::VectorXd r2;
+  Eigen::VectorXd r3;
+  Eigen::VectorXd QinvSolve_b;
+  if (clamping)
+  {
+    Qinv = Qfac->getPseudoInverse();
+    Qinv_b = Qinv * b;
+    r2 = b - Q * Qinv_b;
+    r3 = Qinv.transpose() * Qinv_b;
+    QinvSolve_b = Qfac->solve(b);
+
+    minvPosRhs = Eigen::MatrixXd(mNumDOFs, 5);
+    minvPosRhs.col(0) = dt * (tau - C) + A * f_c;
+    minvPosRhs.col(1) = f;
+    minvPosRhs.col(2) = A * Qinv_b;
+    minvPosRhs.col(3) = A_c * r2;
+    minvPosRhs.col(4) = A_c * r3;
+    minvMassRhs = Eigen::MatrixXd(mNumDOFs, 3);
+    minvMassRhs.col(0) = minvPosRhs.col(0);
+    minvMassRhs.col(1) = f;
+    minvMassRhs.col(2) = A_c * QinvSolve_b;
+  }
+  else
+  {
+    minvPosRhs = dt * (tau - C);
+    minvMassRhs = minvPosRhs;
+  }
+
+  auto cFn = [](dynamics::Skeleton* skel, std::size_t /* dofOffset */) {
+    return Eigen::MatrixXd(
+        skel->getCoriolisAndGravityForces() - skel->getExternalForces());
+  };
+  auto minvFn = [](const Eigen::MatrixXd& rhs) {
+    return [&rhs](dynamics::Skeleton* skel, std::size_t dofOffset) {
+      std::size_t dofs = skel->getNumDofs();
+      Eigen::MatrixXd out(dofs, rhs.cols());
+      for (int j = 0; j < rhs.cols(); j++)
+      {
+        out.col(j) = skel->multiplyByImplicitInvMassMatrix(
+            rhs.col(j).segment(dofOffset, dofs));
+      }
+      return out;
+    };
+  };
+
+  for (int col = 0; col < k; col++)
+  {
+    Eigen::VectorXd dp = tangentPos.col(col);
+    Eigen::VectorXd dv = tangentVel.col(col);
+    Eigen::VectorXd dtau = tangentForce.col(col);
+
+    // These use the same step sizes as finiteDifferenceJacobianOfC() and
+    // finiteDifferenceJacobianOfMinv()
+    Eigen::VectorXd dC
+        = finiteDifferenceDirectionalPerSkeleton(
+              world, WithRespectTo::POSITION, 1e-7, dp, 1, cFn)
+          + finiteDifferenceDirectionalPerSkeleton(
+              world, WithRespectTo::VELOCITY, 1e-7, dv, 1, cFn);
+    Eigen::MatrixXd dMinvPos = finiteDifferenceDirectionalPerSkeleton(
+        world,
+        WithRespectTo::POSITION,
+        5e-7,
+        dp,
+        minvPosRhs.cols(),
+        minvFn(minvPosRhs));
+    Eigen::MatrixXd dMinvMass
+        = Eigen::MatrixXd::Zero(mNumDOFs, minvMassRhs.cols());
+    if (useMass)
+    {
+      Eigen::VectorXd dm = tangentMass.col(col);
+      dC += finiteDifferenceDirectionalPerSkeleton(
+          world, wrtMass, 1e-7, dm, 1, cFn);
+      dMinvMass = finiteDifferenceDirectionalPerSkeleton(
+          world, wrtMass, 5e-7, dm, minvMassRhs.cols(), minvFn(minvMassRhs));
+    }
+
+    if (!clamping)
+    {
+      result.velocity.col(col)
+          = dv + dMinvPos.col(0) + dMinvMass.col(0)
+            + implicitMultiplyByInvMassMatrix(world, dt * (dtau - dC));
+      continue;
+    }
+
+    // The derivatives of A_c and A_ub along dp, one column per constraint
+    Eigen::MatrixXd dA_c = Eigen::MatrixXd::Zero(mNumDOFs, A_c.cols());
+    Eigen::MatrixXd dA_ub = Eigen::MatrixXd::Zero(mNumDOFs, A_ub.cols());
+    for (std::size_t i = 0; i < clampingJacs.size(); i++)
+      dA_c.col(i) = clampingJacs[i].times(dp);
+    for (std::size_t i = 0; i < upperBoundJacs.size(); i++)
+      dA_ub.col(i) = upperBoundJacs[i].times(dp);
+    Eigen::MatrixXd dA = dA_c + dA_ub * E;
+
+    // The directional derivative of Q * z, and of Q^T * z, with respect to
+    // position, given d(M^{-1} * (A * z)) or d(M^{-1} * (A_c * z))
+    auto dQ = [&](const Eigen::VectorXd& z, const Eigen::VectorXd& dMinv_A_z) {
+      return Eigen::VectorXd(
+          dA_c.transpose() * implicitMultiplyByInvMassMatrix(world, A * z)
+          + A_c.transpose()
+                * (dMinv_A_z + implicitMultiplyByInvMassMatrix(world, dA * z)));
+    };
+    auto dQT
+        = [&](const Eigen::VectorXd& z, const Eigen::VectorXd& dMinv_A_c_z) {
+            return Eigen::VectorXd(
+                dA.transpose()
+                    * implicitMultiplyByInvMassMatrix(world, A_c * z)
+                + A.transpose()
+                      * (dMinv_A_c_z
+                         + implicitMultiplyByInvMassMatrix(world, dA_c * z)));
+          };
+
+    Eigen::VectorXd dMinv_f = dMinvPos.col(1) + dMinvMass.col(1);
+    Eigen::VectorXd dB
+        = -bounceDiagonals.cwiseProduct(
+            dA_c.transpose() * v_f
+            + A_c.transpose()
+                  * (dv + dt * dMinv_f
+                     + implicitMultiplyByInvMassMatrix(
+                         world, dt * (dtau - dC))));
+
+    Eigen::VectorXd dF_c = Qfac->solve(dB);
+    if (!dp.isZero())
+    {
+      // This is the gradient of the pseudoinverse, see
+      // https://mathoverflow.net/a/29511/163259
+      Eigen::VectorXd dQT_r3 = dQT(r3, dMinvPos.col(4));
+      dF_c += -Qinv * dQ(Qinv_b, dMinvPos.col(2))
+              + Qinv * (Qinv.transpose() * dQT(r2, dMinvPos.col(3)))
+              + dQT_r3 - Qinv * (Q * dQT_r3);
+    }
+    if (useMass)
+    {
+      dF_c -= Qfac->solve(A_c.transpose() * dMinvMass.col(2));
+    }
+
+    result.velocity.col(col)
+        = dv + dMinvPos.col(0) + dMinvMass.col(0)
+          + implicitMultiplyByInvMassMatrix(
+              world, A * dF_c + dA * f_c + dt * (dtau - dC));
+  }
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return result;
+}
+
 //==============================================================================
 const Eigen::MatrixXd& BackpropSnapshot::getForceVelJacobian(
     WorldPtr world, PerformanceLog* perfLog)
@@ -335,14 +903,13 @@ const Eigen::MatrixXd& BackpropSnapshot::getForceVelJacobian(
     else
     {
       Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
-      Eigen::MatrixXd Minv = getInvMassMatrix(world);
 
       // If there are no clamping constraints, then force-vel is just the
       // mTimeStep
       // * Minv
       if (A_c.size() == 0)
       {
-        mCachedForceVel = mTimeStep * Minv;
+        mCachedForceVel = mTimeStep * getInvMassMatrix(world);
       }
       else
       {
@@ -630,14 +1197,14 @@ Eigen::VectorXd BackpropSnapshot::getAnalyticalNextV(
   Eigen::MatrixXd E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXd Minv = world->getInvMassMatrix();
+  BlockDiagonalMassMatrix Minv = world->getBlockInvMassMatrix();
   Eigen::VectorXd tau = world->getExternalForces();
   Eigen::VectorXd C = world->getCoriolisAndGravityAndExternalForces();
   double dt = world->getTimeStep();
   Eigen::VectorXd f_c = estimateClampingConstraintImpulses(world, A_c, A_ub, E);
 
-  Eigen::VectorXd preSolveV = mPreStepVelocity + dt * Minv * (tau - C);
-  Eigen::VectorXd f_cDeltaV = Minv * A_c_ub_E * f_c;
+  Eigen::VectorXd preSolveV = mPreStepVelocity + dt * (Minv * (tau - C));
+  Eigen::VectorXd f_cDeltaV = Minv * (A_c_ub_E * f_c);
   Eigen::VectorXd postSolveV = preSolveV + f_cDeltaV;
   return postSolveV;
 
@@ -672,7 +1239,7 @@ Eigen::MatrixXd BackpropSnapshot::getScratchAnalytical(
   Eigen::MatrixXd dM
       = getJacobianOfMinv(world, dt * (tau - C) + A_c_ub_E * f_c, wrt);
 
-  Eigen::MatrixXd Minv = world->getInvMassMatrix();
+  BlockDiagonalMassMatrix Minv = world->getBlockInvMassMatrix();
   Eigen::MatrixXd dC = getJacobianOfC(world, wrt);
 
   Eigen::MatrixXd dF_c = getJacobianOfConstraintForce(world, wrt);
@@ -709,7 +1276,7 @@ Eigen::VectorXd BackpropSnapshot::scratch(simulation::WorldPtr world)
   Eigen::MatrixXd E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXd Minv = world->getInvMassMatrix();
+  BlockDiagonalMassMatrix Minv = world->getBlockInvMassMatrix();
 
   Eigen::MatrixXd Q = A_c.transpose() * Minv * A_c_ub_E;
 
@@ -797,68 +1364,113 @@ Eigen::MatrixXd BackpropSnapshot::getVelJacobianWrt(
   world->setExternalForces(mPreStepTorques);
   world->setCachedLCPSolution(mPreStepLCPCache);
 
-  Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
-  Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix(world);
-  Eigen::MatrixXd E = getUpperBoundMappingMatrix();
-  Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
-
-  Eigen::VectorXd tau = world->getExternalForces();
-  Eigen::VectorXd C = world->getCoriolisAndGravityAndExternalForces();
-  Eigen::VectorXd f_c = getClampingConstraintImpulses();
-  double dt = world->getTimeStep();
-
-  Eigen::MatrixXd dM
-      = getJacobianOfMinv(world, dt * (tau - C) + A_c_ub_E * f_c, wrt);
-
-  Eigen::MatrixXd Minv = world->getInvMassMatrix();
-
-  Eigen::MatrixXd dF_c = getJacobianOfConstraintForce(world, wrt);
-
-  if (wrt == WithRespectTo::FORCE)
+  // Lay out where each skeleton's columns go serially, so the blocks below
+  // only ever read this bookkeeping
+  std::unordered_map<std::string, std::size_t> wrtOffset;
+  std::unordered_map<std::string, std::size_t> skelWrtDim;
+  std::size_t wrtCursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
   {
-    /*
-    std::cout << "A_c_ub_E:" << std::endl << A_c_ub_E << std::endl;
-    std::cout << "dF_c:" << std::endl << dF_c << std::endl;
-    std::cout << "A_c_ub_E * dF_c:" << std::endl
-              << A_c_ub_E * dF_c << std::endl;
-    std::cout << "Minv * (A_c_ub_E * dF_c):" << std::endl
-              << Minv * (A_c_ub_E * dF_c) << std::endl;
-    std::cout << "Minv * (dt * I):" << std::endl
-              << Minv
-                     * (dt
-                        * Eigen::MatrixXd::Identity(
-                            world->getNumDofs(), world->getNumDofs()))
-              << std::endl;
-    */
-    snapshot.restore();
-    return Minv
-           * ((A_c_ub_E * dF_c)
-              + (dt
-                 * Eigen::MatrixXd::Identity(
-                     world->getNumDofs(), world->getNumDofs())));
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    wrtOffset[skel->getName()] = wrtCursor;
+    skelWrtDim[skel->getName()] = wrt->dim(skel);
+    wrtCursor += skelWrtDim[skel->getName()];
   }
 
-  Eigen::MatrixXd dC = getJacobianOfC(world, wrt);
-
-  if (wrt == WithRespectTo::VELOCITY)
+  // Any skeleton that isn't in a constrained group gets a block of its own
+  std::unordered_map<std::string, bool> inGroup;
+  for (std::shared_ptr<ConstrainedGroupGradientMatrices> group :
+       mGradientMatrices)
   {
-    snapshot.restore();
-    return Eigen::MatrixXd::Identity(world->getNumDofs(), world->getNumDofs())
-           + Minv * (A_c_ub_E * dF_c - dt * dC);
+    for (const std::string& skelName : group->getSkeletons())
+    {
+      inGroup[skelName] = true;
+    }
   }
-  else if (wrt == WithRespectTo::POSITION)
+  std::vector<dynamics::Skeleton*> unconstrained;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
   {
-    Eigen::MatrixXd dA_c = getJacobianOfClampingConstraints(world, f_c);
-    Eigen::MatrixXd dA_ubE = getJacobianOfUpperBoundConstraints(world, E * f_c);
-    snapshot.restore();
-    return dM + Minv * (A_c_ub_E * dF_c + dA_c + dA_ubE - dt * dC);
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    if (inGroup.find(skel->getName()) == inGroup.end()
+        && skel->getNumDofs() > 0 && skelWrtDim[skel->getName()] > 0)
+    {
+      unconstrained.push_back(skel);
+    }
+  }
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumDOFs, wrtDim);
+
+  // Each block only changes the state of its own skeletons, and writes a
+  // disjoint part of the result. The contact terms also read the transforms
+  // and Jacobians of the bodies they touch, which can be on a static skeleton
+  // shared between groups (like the floor). BodyNode and Joint build those
+  // caches lazily on first read, so two groups reading the same stale cache
+  // would both write it. We build them all here, serially, so the blocks only
+  // ever read caches on skeletons they don't own.
+  auto computeBlock = [&](std::size_t i) {
+    if (i < mGradientMatrices.size())
+    {
+      const std::shared_ptr<ConstrainedGroupGradientMatrices>& group
+          = mGradientMatrices[i];
+      Eigen::MatrixXd groupJac = group->getVelJacobianWrt(world, wrt);
+
+      // Shuffle the group's rows and columns into the world's order
+      std::size_t groupRow = 0;
+      for (const std::string& rowSkel : group->getSkeletons())
+      {
+        std::size_t dofs = mSkeletonDofs.at(rowSkel);
+        std::size_t groupCol = 0;
+        for (const std::string& colSkel : group->getSkeletons())
+        {
+          std::size_t cols = skelWrtDim.at(colSkel);
+          result.block(
+              mSkeletonOffset.at(rowSkel), wrtOffset.at(colSkel), dofs, cols)
+              = groupJac.block(groupRow, groupCol, dofs, cols);
+          groupCol += cols;
+        }
+        groupRow += dofs;
+      }
+    }
+    else
+    {
+      dynamics::Skeleton* skel = unconstrained[i - mGradientMatrices.size()];
+      const std::string& skelName = skel->getName();
+      result.block(
+          mSkeletonOffset.at(skelName),
+          wrtOffset.at(skelName),
+          skel->getNumDofs(),
+          skelWrtDim.at(skelName))
+          = getUnconstrainedVelJacobianWrt(skel, wrt);
+    }
+  };
+
+  std::size_t numBlocks = mGradientMatrices.size() + unconstrained.size();
+  std::shared_ptr<common::ThreadPool> pool = world->getGradientThreadPool();
+  if (pool)
+  {
+    for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    {
+      dynamics::Skeleton* skel = world->getSkeleton(i).get();
+      for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+      {
+        dynamics::BodyNode* body = skel->getBodyNode(j);
+        body->getWorldTransform();
+        body->getWorldJacobian();
+        body->getParentJoint()->getRelativeTransform();
+        body->getParentJoint()->getRelativeJacobian();
+      }
+    }
+    pool->parallelFor(numBlocks, computeBlock);
   }
   else
   {
-    snapshot.restore();
-    return dM + Minv * (A_c_ub_E * dF_c - dt * dC);
+    for (std::size_t i = 0; i < numBlocks; i++)
+      computeBlock(i);
   }
 
+  snapshot.restore();
+  return result;
+
   // std::cout << "dA_c: " << std::endl << dA_c << std::endl;
 
   // return dM + Minv * (dA_c + A_c_ub_E * dF_c - dt * dC);
@@ -1163,6 +1775,12 @@ Eigen::VectorXd BackpropSnapshot::getPreStepTorques()
   return mPreStepTorques;
 }
 
+//==============================================================================
+Eigen::VectorXd BackpropSnapshot::getPreStepLCPCache()
+{
+  return mPreStepLCPCache;
+}
+
 //==============================================================================
 Eigen::VectorXd BackpropSnapshot::getPreConstraintVelocity()
 {
@@ -1258,17 +1876,31 @@ Eigen::MatrixXd BackpropSnapshot::getBouncingConstraintMatrix(WorldPtr world)
 Eigen::MatrixXd BackpropSnapshot::getMassMatrix(
     WorldPtr world, bool forFiniteDifferencing)
 {
-  return assembleBlockDiagonalMatrix(
+  return getBlockMassMatrix(world, forFiniteDifferencing).toDense();
+}
+
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::getInvMassMatrix(
+    WorldPtr world, bool forFiniteDifferencing)
+{
+  return getBlockInvMassMatrix(world, forFiniteDifferencing).toDense();
+}
+
+//==============================================================================
+BlockDiagonalMassMatrix BackpropSnapshot::getBlockMassMatrix(
+    WorldPtr world, bool forFiniteDifferencing)
+{
+  return assembleBlockMassMatrix(
       world,
       BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS,
       forFiniteDifferencing);
 }
 
 //==============================================================================
-Eigen::MatrixXd BackpropSnapshot::getInvMassMatrix(
+BlockDiagonalMassMatrix BackpropSnapshot::getBlockInvMassMatrix(
     WorldPtr world, bool forFiniteDifferencing)
 {
-  return assembleBlockDiagonalMatrix(
+  return assembleBlockMassMatrix(
       world,
       BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS,
       forFiniteDifferencing);
@@ -1583,6 +2215,12 @@ void BackpropSnapshot::setSlowDebugResultsAgainstFD(bool slowDebug)
   mSlowDebugResultsAgainstFD = slowDebug;
 }
 
+//==============================================================================
+void BackpropSnapshot::setUseVJPBackprop(bool vjpBackprop)
+{
+  mUseVJPBackprop = vjpBackprop;
+}
+
 //==============================================================================
 Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelVelJacobian(WorldPtr world)
 {
@@ -2233,7 +2871,7 @@ Eigen::MatrixXd BackpropSnapshot::getProjectionIntoClampsMatrix(
         = getUpperBoundConstraintMatrixAt(world, world->getPositions());
     Eigen::MatrixXd E
         = getUpperBoundMappingMatrixAt(world, world->getPositions());
-    Eigen::MatrixXd Minv = getInvMassMatrix(world, true);
+    BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world, true);
     constraintForceToImpliedTorques = Minv * (A_c + (A_ub * E));
 
     Eigen::MatrixXd forceToVel
@@ -2248,7 +2886,7 @@ Eigen::MatrixXd BackpropSnapshot::getProjectionIntoClampsMatrix(
   {
     Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix(world);
     Eigen::MatrixXd E = getUpperBoundMappingMatrix();
-    Eigen::MatrixXd Minv = getInvMassMatrix(world, false);
+    BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world, false);
     constraintForceToImpliedTorques = Minv * (A_c + (A_ub * E));
     // We don't use the massed formulation anymore because it introduces slight
     // numerical instability
@@ -2261,7 +2899,7 @@ Eigen::MatrixXd BackpropSnapshot::getProjectionIntoClampsMatrix(
     Eigen::MatrixXd bounce = getBounceDiagonals().asDiagonal();
     Eigen::MatrixXd rightHandSize = bounce * A_c.transpose();
     return (1.0 / mTimeStep)
-           * forceToVel.completeOrthogonalDecomposition().solve(rightHandSize);
+           * mFactorizationCache->factor(forceToVel)->solve(rightHandSize);
   }
 }
 
@@ -2320,12 +2958,12 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfConstraintForce(
   world->setExternalForces(mPreStepTorques);
   world->setCachedLCPSolution(mPreStepLCPCache);
 
-  Eigen::MatrixXd Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
   Eigen::MatrixXd Q = A_c.transpose() * Minv * A_c_ub_E;
 
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> Qfac
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const LCPFactorization> Qfac
+      = mFactorizationCache->factor(Q);
 
   Eigen::MatrixXd dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
@@ -2333,7 +2971,7 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfConstraintForce(
   {
     // dQ_b is 0, so don't compute it
     snapshot.restore();
-    return Qfac.solve(dB);
+    return Qfac->solve(dB);
   }
 
   Eigen::VectorXd b = getClampingConstraintRelativeVels();
@@ -2342,7 +2980,7 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfConstraintForce(
 
   snapshot.restore();
 
-  return dQ_b + Qfac.solve(dB);
+  return dQ_b + Qfac->solve(dB);
 }
 
 //==============================================================================
@@ -2370,16 +3008,16 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
   Eigen::MatrixXd E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXd Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXd Q = A_c.transpose() * Minv * (A_c + A_ub * E);
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const LCPFactorization> Qfactored
+      = mFactorizationCache->factor(Q);
 
-  Eigen::VectorXd Qinv_b = Qfactored.solve(b);
+  Eigen::VectorXd Qinv_b = Qfactored->solve(b);
 
   if (wrt == WithRespectTo::POSITION)
   {
-    Eigen::MatrixXd Qinv = Qfactored.pseudoInverse();
+    const Eigen::MatrixXd& Qinv = Qfactored->getPseudoInverse();
     Eigen::MatrixXd I = Eigen::MatrixXd::Identity(Q.rows(), Q.cols());
 
     // Position is the only term that affects A_c and A_ub. We use the full
@@ -2390,7 +3028,7 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
     {
 
 #define dQ(rhs)                                                                \
-  (getJacobianOfClampingConstraintsTranspose(world, Minv * A_c_ub_E * rhs)     \
+  (getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c_ub_E * rhs))   \
    + (A_c.transpose()                                                          \
       * (getJacobianOfMinv(world, A_c_ub_E * rhs, wrt)                         \
          + (Minv                                                               \
@@ -2398,12 +3036,13 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
                + getJacobianOfUpperBoundConstraints(world, E * rhs))))))
 
 #define dQT(rhs)                                                               \
-  ((getJacobianOfClampingConstraintsTranspose(world, Minv * A_c * rhs)         \
+  ((getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c * rhs))       \
     + (A_c.transpose()                                                         \
        * (getJacobianOfMinv(world, A_c * rhs, wrt)                             \
           + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))         \
    + (E.transpose()                                                            \
-      * (getJacobianOfUpperBoundConstraintsTranspose(world, Minv * A_c * rhs)  \
+      * (getJacobianOfUpperBoundConstraintsTranspose(                          \
+            world, Minv * (A_c * rhs))                                         \
          + A_ub.transpose()                                                    \
                * (getJacobianOfMinv(world, A_c * rhs, wrt)                     \
                   + (Minv                                                      \
@@ -2441,7 +3080,7 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
       // A_ub = 0 here
 
 #define dQ(rhs)                                                                \
-  (getJacobianOfClampingConstraintsTranspose(world, Minv * A_c * rhs)          \
+  (getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c * rhs))        \
    + (A_c.transpose()                                                          \
       * (getJacobianOfMinv(world, A_c * rhs, wrt)                              \
          + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))
@@ -2477,7 +3116,7 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
     // All other terms get to treat A_c as constant
     Eigen::MatrixXd innerTerms
         = A_c.transpose() * getJacobianOfMinv(world, A_c * Qinv_b, wrt);
-    Eigen::MatrixXd result = -Qfactored.solve(innerTerms);
+    Eigen::MatrixXd result = -Qfactored->solve(innerTerms);
 
     snapshot.restore();
     return result;
@@ -2520,7 +3159,7 @@ BackpropSnapshot::finiteDifferenceJacobianOfLCPConstraintMatrixClampingSubset(
         = estimateUpperBoundConstraintMatrixAt(world, world->getPositions());
     Eigen::MatrixXd E = getUpperBoundMappingMatrix();
     Eigen::MatrixXd Q
-        = A_c.transpose() * world->getInvMassMatrix() * (A_c + A_ub * E);
+        = A_c.transpose() * world->getBlockInvMassMatrix() * (A_c + A_ub * E);
 
     /*
     std::cout << "+" << i << ": " << A_c.cols() << " :: " << mNumClamping
@@ -2536,7 +3175,7 @@ BackpropSnapshot::finiteDifferenceJacobianOfLCPConstraintMatrixClampingSubset(
     A_c = estimateClampingConstraintMatrixAt(world, world->getPositions());
     A_ub = estimateUpperBoundConstraintMatrixAt(world, world->getPositions());
     E = getUpperBoundMappingMatrix();
-    Q = A_c.transpose() * world->getInvMassMatrix() * (A_c + A_ub * E);
+    Q = A_c.transpose() * world->getBlockInvMassMatrix() * (A_c + A_ub * E);
 
     /*
     std::cout << "-" << i << ": " << A_c.cols() << " :: " << mNumClamping
@@ -2565,7 +3204,7 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfLCPOffsetClampingSubset(
   world->setCachedLCPSolution(mPreStepLCPCache);
 
   double dt = world->getTimeStep();
-  Eigen::MatrixXd Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
   Eigen::MatrixXd dC = getJacobianOfC(world, wrt);
   if (wrt == WithRespectTo::VELOCITY)
@@ -2574,7 +3213,7 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfLCPOffsetClampingSubset(
     return getBounceDiagonals().asDiagonal() * -A_c.transpose()
            * (Eigen::MatrixXd::Identity(
                   world->getNumDofs(), world->getNumDofs())
-              - dt * Minv * dC);
+              - dt * (Minv * dC));
   }
   else if (wrt == WithRespectTo::FORCE)
   {
@@ -2744,11 +3383,12 @@ void BackpropSnapshot::computeLCPConstraintMatrixClampingSubset(
   */
   if (A_ub.cols() > 0)
   {
-    Q = A_c.transpose() * getInvMassMatrix(world, true) * (A_c + A_ub * E);
+    Q = A_c.transpose() * getBlockInvMassMatrix(world, true)
+        * (A_c + A_ub * E);
   }
   else
   {
-    Q = A_c.transpose() * getInvMassMatrix(world, true) * A_c;
+    Q = A_c.transpose() * getBlockInvMassMatrix(world, true) * A_c;
   }
 }
 
@@ -2827,7 +3467,8 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfProjectionIntoClampsMatrix(
   Eigen::MatrixXd constraintForceToImpliedTorques = V_c + (V_ub * E);
   Eigen::MatrixXd A_c_ub_E = A_c + (A_ub * E);
   Eigen::MatrixXd Q = A_c.eval().transpose() * constraintForceToImpliedTorques;
-  auto XFactor = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const LCPFactorization> XFactor
+      = mFactorizationCache->factor(Q);
   Eigen::MatrixXd bounce = getBounceDiagonals().asDiagonal();
 
   // New formulation
@@ -2837,19 +3478,18 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfProjectionIntoClampsMatrix(
     Eigen::MatrixXd rightHandSide = bounce * A_c.transpose();
     Eigen::MatrixXd dRhs
         = bounce * getJacobianOfClampingConstraintsTranspose(world, v);
-    Eigen::MatrixXd Minv = getInvMassMatrix(world);
+    BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
 
-    Eigen::MatrixXd Qinv = XFactor.pseudoInverse();
-    Eigen::VectorXd Qinv_v = XFactor.solve(rightHandSide * v);
+    Eigen::VectorXd Qinv_v = XFactor->solve(rightHandSide * v);
     Eigen::MatrixXd dQ
         = getJacobianOfClampingConstraintsTranspose(
-              world, Minv * A_c_ub_E * Qinv_v)
+              world, Minv * (A_c_ub_E * Qinv_v))
           + A_c.transpose()
                 * (getJacobianOfMinv(world, A_c_ub_E * Qinv_v, wrt)
                    + Minv * getJacobianOfClampingConstraints(world, Qinv_v));
 
     return (1 / world->getTimeStep())
-           * (XFactor.solve(dRhs) - XFactor.solve(dQ));
+           * (XFactor->solve(dRhs) - XFactor->solve(dQ));
   }
   else
   {
@@ -2859,12 +3499,12 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfProjectionIntoClampsMatrix(
     // of derivation
 
     Eigen::VectorXd tau
-        = A_c_ub_E * XFactor.solve(bounce * A_c.transpose() * v);
+        = A_c_ub_E * XFactor->solve(bounce * A_c.transpose() * v);
 
     Eigen::MatrixXd MinvJac = getJacobianOfMinv(world, tau, wrt);
 
     return -(1.0 / world->getTimeStep())
-           * XFactor.solve(A_c.transpose() * MinvJac);
+           * XFactor->solve(A_c.transpose() * MinvJac);
   }
 
   // An older approach that attempted to handle pseudoinverse distinct from
@@ -2903,7 +3543,11 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfProjectionIntoClampsMatrix(
 Eigen::MatrixXd BackpropSnapshot::getJacobianOfMinv(
     simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt)
 {
-  return finiteDifferenceJacobianOfMinv(world, tau, wrt);
+  return assemblePerSkeleton(
+      world, wrt, [&tau, wrt](dynamics::Skeleton* skel, std::size_t dofOffset) {
+        return skel->getJacobianOfMinv(
+            tau.segment(dofOffset, skel->getNumDofs()), wrt);
+      });
 }
 
 //==============================================================================
@@ -2912,16 +3556,91 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfMinv(
 Eigen::MatrixXd BackpropSnapshot::getJacobianOfC(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
-  return finiteDifferenceJacobianOfC(world, wrt);
+  return assemblePerSkeleton(
+      world, wrt, [wrt](dynamics::Skeleton* skel, std::size_t /* dofOffset */) {
+        return getSkeletonJacobianOfC(skel, wrt);
+      });
 }
 
+//==============================================================================
 /// This returns the jacobian of M^{-1}(pos, inertia) * (C(pos, inertia, vel) +
 /// mPreStepTorques), holding everything constant except the value of
 /// WithRespectTo
 Eigen::MatrixXd BackpropSnapshot::getJacobianOfMinvC(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
-  return finiteDifferenceJacobianOfMinvC(world, wrt);
+  return assemblePerSkeleton(
+      world, wrt, [this, wrt](dynamics::Skeleton* skel, std::size_t dofOffset) {
+        // d(M^{-1} f) = dM^{-1} f + M^{-1} df, where f = tau - C
+        Eigen::VectorXd f
+            = mPreStepTorques.segment(dofOffset, skel->getNumDofs())
+              - (skel->getCoriolisAndGravityForces()
+                 - skel->getExternalForces());
+        return Eigen::MatrixXd(
+            skel->getJacobianOfMinv(f, wrt)
+            - skel->getInvMassMatrix()
+                  * getSkeletonJacobianOfC(skel, wrt));
+      });
+}
+
+//==============================================================================
+/// This returns one skeleton's block of getJacobianOfC()
+Eigen::MatrixXd BackpropSnapshot::getSkeletonJacobianOfC(
+    dynamics::Skeleton* skel, WithRespectTo* wrt)
+{
+  Eigen::MatrixXd dC = skel->getJacobianOfC(wrt);
+  if (wrt == WithRespectTo::VELOCITY || wrt == WithRespectTo::FORCE
+      || skel->getExternalForces().isZero())
+  {
+    return dC;
+  }
+
+  // Skeleton::getJacobianOfC() leaves out the external forces, which move
+  // with the body Jacobians. They're cheap to evaluate (no mass matrix
+  // involved), so we central difference just that term.
+  const double EPS = 1e-7;
+  Eigen::VectorXd before = wrt->get(skel);
+  for (std::size_t j = 0; j < dC.cols(); j++)
+  {
+    Eigen::VectorXd perturbed = before;
+    perturbed(j) += EPS;
+    wrt->set(skel, perturbed);
+    Eigen::VectorXd plus = skel->getExternalForces();
+    perturbed = before;
+    perturbed(j) -= EPS;
+    wrt->set(skel, perturbed);
+    Eigen::VectorXd minus = skel->getExternalForces();
+    dC.col(j) -= (plus - minus) / (2 * EPS);
+  }
+  wrt->set(skel, before);
+  return dC;
+}
+
+//==============================================================================
+/// This returns the block of getVelJacobianWrt() for a skeleton that isn't in
+/// any constrained group. That's the same formula as getVelJacobianWrt(), with
+/// no constraint forces.
+Eigen::MatrixXd BackpropSnapshot::getUnconstrainedVelJacobianWrt(
+    dynamics::Skeleton* skel, WithRespectTo* wrt)
+{
+  Eigen::MatrixXd Minv = skel->getInvMassMatrix();
+  if (wrt == WithRespectTo::FORCE)
+  {
+    return mTimeStep * Minv;
+  }
+
+  Eigen::MatrixXd dC = getSkeletonJacobianOfC(skel, wrt);
+  if (wrt == WithRespectTo::VELOCITY)
+  {
+    return Eigen::MatrixXd::Identity(skel->getNumDofs(), skel->getNumDofs())
+           - mTimeStep * Minv * dC;
+  }
+
+  Eigen::VectorXd tau = skel->getForces();
+  Eigen::VectorXd C
+      = skel->getCoriolisAndGravityForces() - skel->getExternalForces();
+  return skel->getJacobianOfMinv(mTimeStep * (tau - C), wrt)
+         - mTimeStep * Minv * dC;
 }
 
 //==============================================================================
@@ -3082,7 +3801,8 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfClampingConstraints(
   assert(constraints.size() == f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += f0(i) * constraints[i]->getConstraintForcesJacobian(world);
+    constraints[i]->getConstraintForcesJacobianBlock(world).addTo(
+        result, f0(i));
   }
 
   snapshot.restore();
@@ -3108,8 +3828,9 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfClampingConstraintsTranspose(
   Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumClamping, dofs);
   for (int i = 0; i < constraints.size(); i++)
   {
-    result.row(i)
-        = constraints[i]->getConstraintForcesJacobian(world).transpose() * v0;
+    result.row(i) = constraints[i]
+                        ->getConstraintForcesJacobianBlock(world)
+                        .transposeTimes(v0);
   }
 
   snapshot.restore();
@@ -3129,7 +3850,8 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfUpperBoundConstraints(
   assert(constraints.size() == E_f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += E_f0(i) * constraints[i]->getConstraintForcesJacobian(world);
+    constraints[i]->getConstraintForcesJacobianBlock(world).addTo(
+        result, E_f0(i));
   }
   return result;
 }
@@ -3147,8 +3869,9 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfUpperBoundConstraintsTranspose(
   Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumUpperBound, dofs);
   for (int i = 0; i < constraints.size(); i++)
   {
-    result.row(i)
-        = constraints[i]->getConstraintForcesJacobian(world).transpose() * v0;
+    result.row(i) = constraints[i]
+                        ->getConstraintForcesJacobianBlock(world)
+                        .transposeTimes(v0);
   }
 
   return result;
@@ -3496,110 +4219,278 @@ BackpropSnapshot::finiteDifferenceJacobianOfProjectionIntoClampsMatrix(
 Eigen::MatrixXd BackpropSnapshot::finiteDifferenceJacobianOfMinv(
     simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt)
 {
-  std::size_t innerDim = wrt->dim(world.get());
+  return finiteDifferencePerSkeleton(
+      world,
+      wrt,
+      5e-7,
+      [&tau](dynamics::Skeleton* skel, std::size_t dofOffset) {
+        return skel->multiplyByImplicitInvMassMatrix(
+            tau.segment(dofOffset, skel->getNumDofs()));
+      });
+}
 
-  // These are predicted contact forces at the clamping contacts
-  Eigen::VectorXd original = implicitMultiplyByInvMassMatrix(world, tau);
+//==============================================================================
+/// This computes and returns the jacobian of C(pos, inertia, vel) by finite
+/// differences.
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceJacobianOfC(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  return finiteDifferencePerSkeleton(
+      world,
+      wrt,
+      1e-7,
+      [](dynamics::Skeleton* skel, std::size_t /* dofOffset */) {
+        return Eigen::VectorXd(
+            skel->getCoriolisAndGravityForces() - skel->getExternalForces());
+      });
+}
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(original.size(), innerDim);
+//==============================================================================
+/// This computes and returns the jacobian of M^{-1}(pos, inertia) * C(pos,
+/// inertia, vel) by finite differences. This is SUPER SLOW, and is only here
+/// for testing.
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceJacobianOfMinvC(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  return finiteDifferencePerSkeleton(
+      world,
+      wrt,
+      1e-7,
+      [this](dynamics::Skeleton* skel, std::size_t dofOffset) {
+        return skel->multiplyByImplicitInvMassMatrix(
+            mPreStepTorques.segment(dofOffset, skel->getNumDofs())
+            - (skel->getCoriolisAndGravityForces()
+               - skel->getExternalForces()));
+      });
+}
 
-  Eigen::VectorXd before = wrt->get(world.get());
+//==============================================================================
+/// This assembles a block diagonal Jacobian with respect to `wrt`, where
+/// `block(skel, dofOffset)` returns the (skel->getNumDofs() x
+/// wrt->dim(skel)) block for `skel`. Each block must only touch the state of
+/// its own skeleton, so if the world has a gradient thread pool we compute the
+/// blocks in parallel.
+Eigen::MatrixXd BackpropSnapshot::assemblePerSkeleton(
+    simulation::WorldPtr world,
+    WithRespectTo* wrt,
+    const std::function<Eigen::MatrixXd(
+        dynamics::Skeleton* skel, std::size_t dofOffset)>& block)
+{
+  // Lay out the offsets serially, since every block needs to know where the
+  // blocks before it end
+  std::size_t numSkels = world->getNumSkeletons();
+  std::vector<std::size_t> dofOffsets(numSkels);
+  std::vector<std::size_t> wrtOffsets(numSkels);
+  std::vector<std::size_t> wrtDims(numSkels);
+  std::size_t dofCursor = 0;
+  std::size_t wrtCursor = 0;
+  for (std::size_t i = 0; i < numSkels; i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    dofOffsets[i] = dofCursor;
+    wrtOffsets[i] = wrtCursor;
+    wrtDims[i] = wrt->dim(skel);
+    dofCursor += skel->getNumDofs();
+    wrtCursor += wrtDims[i];
+  }
 
-  const double EPS = 5e-7;
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dofCursor, wrtCursor);
 
-  for (std::size_t i = 0; i < innerDim; i++)
+  auto computeBlock = [&](std::size_t i) {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    std::size_t dofs = skel->getNumDofs();
+    if (dofs == 0 || wrtDims[i] == 0)
+      return;
+    result.block(dofOffsets[i], wrtOffsets[i], dofs, wrtDims[i])
+        = block(skel, dofOffsets[i]);
+  };
+
+  std::shared_ptr<common::ThreadPool> pool = world->getGradientThreadPool();
+  if (pool)
   {
-    Eigen::VectorXd perturbed = before;
-    perturbed(i) += EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd newVPlus = implicitMultiplyByInvMassMatrix(world, tau);
-    perturbed = before;
-    perturbed(i) -= EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd newVMinus = implicitMultiplyByInvMassMatrix(world, tau);
-    Eigen::VectorXd diff = newVPlus - newVMinus;
-    result.col(i) = diff / (2 * EPS);
+    pool->parallelFor(numSkels, computeBlock);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < numSkels; i++)
+      computeBlock(i);
   }
-
-  wrt->set(world.get(), before);
 
   return result;
 }
 
 //==============================================================================
-/// This computes and returns the jacobian of C(pos, inertia, vel) by finite
-/// differences.
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceJacobianOfC(
-    simulation::WorldPtr world, WithRespectTo* wrt)
+/// This central-differences a per-skeleton function with respect to `wrt`.
+/// `fn(skel, dofOffset)` must return a vector of skel->getNumDofs() that
+/// only depends on the state of `skel`, which is true of anything built from
+/// the skeleton's mass matrix and its Coriolis, gravity and external forces.
+/// Perturbing one skeleton can't change another skeleton's output, so the
+/// Jacobian is block diagonal, and we only ever evaluate the diagonal
+/// blocks, see assemblePerSkeleton().
+Eigen::MatrixXd BackpropSnapshot::finiteDifferencePerSkeleton(
+    simulation::WorldPtr world,
+    WithRespectTo* wrt,
+    double eps,
+    const std::function<Eigen::VectorXd(
+        dynamics::Skeleton* skel, std::size_t dofOffset)>& fn)
 {
-  std::size_t innerDim = wrt->dim(world.get());
-
-  // These are predicted contact forces at the clamping contacts
-  Eigen::VectorXd original = world->getCoriolisAndGravityAndExternalForces();
+  return assemblePerSkeleton(
+      world, wrt, [&](dynamics::Skeleton* skel, std::size_t dofOffset) {
+        std::size_t wrtDim = wrt->dim(skel);
+        Eigen::MatrixXd J
+            = Eigen::MatrixXd::Zero(skel->getNumDofs(), wrtDim);
+        Eigen::VectorXd before = wrt->get(skel);
+        for (std::size_t j = 0; j < wrtDim; j++)
+        {
+          Eigen::VectorXd perturbed = before;
+          perturbed(j) += eps;
+          wrt->set(skel, perturbed);
+          Eigen::VectorXd plus = fn(skel, dofOffset);
+          perturbed = before;
+          perturbed(j) -= eps;
+          wrt->set(skel, perturbed);
+          Eigen::VectorXd minus = fn(skel, dofOffset);
+          J.col(j) = (plus - minus) / (2 * eps);
+        }
+        wrt->set(skel, before);
+        return J;
+      });
+}
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(original.size(), innerDim);
+//==============================================================================
+/// This is the vector-Jacobian product version of assemblePerSkeleton().
+/// `grad(skel, dofOffset)` returns the wrt->dim(skel) gradient for `skel`,
+/// and this stacks them into one vector, computing them in parallel if the
+/// world has a gradient thread pool.
+Eigen::VectorXd BackpropSnapshot::stackGradientsPerSkeleton(
+    simulation::WorldPtr world,
+    WithRespectTo* wrt,
+    const std::function<Eigen::VectorXd(
+        dynamics::Skeleton* skel, std::size_t dofOffset)>& grad)
+{
+  // Lay out the offsets serially, like assemblePerSkeleton()
+  std::size_t numSkels = world->getNumSkeletons();
+  std::vector<std::size_t> dofOffsets(numSkels);
+  std::vector<std::size_t> wrtOffsets(numSkels);
+  std::vector<std::size_t> wrtDims(numSkels);
+  std::size_t dofCursor = 0;
+  std::size_t wrtCursor = 0;
+  for (std::size_t i = 0; i < numSkels; i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    dofOffsets[i] = dofCursor;
+    wrtOffsets[i] = wrtCursor;
+    wrtDims[i] = wrt->dim(skel);
+    dofCursor += skel->getNumDofs();
+    wrtCursor += wrtDims[i];
+  }
 
-  Eigen::VectorXd before = wrt->get(world.get());
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(wrtCursor);
 
-  const double EPS = 1e-7;
+  auto gradSkeleton = [&](std::size_t i) {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    if (skel->getNumDofs() == 0 || wrtDims[i] == 0)
+      return;
+    result.segment(wrtOffsets[i], wrtDims[i]) = grad(skel, dofOffsets[i]);
+  };
 
-  for (std::size_t i = 0; i < innerDim; i++)
+  std::shared_ptr<common::ThreadPool> pool = world->getGradientThreadPool();
+  if (pool)
   {
-    Eigen::VectorXd perturbed = before;
-    perturbed(i) += EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd tauPos = world->getCoriolisAndGravityAndExternalForces();
-    perturbed = before;
-    perturbed(i) -= EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd tauNeg = world->getCoriolisAndGravityAndExternalForces();
-    Eigen::VectorXd diff = tauPos - tauNeg;
-    result.col(i) = diff / (2 * EPS);
+    pool->parallelFor(numSkels, gradSkeleton);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < numSkels; i++)
+      gradSkeleton(i);
   }
-
-  wrt->set(world.get(), before);
 
   return result;
 }
 
 //==============================================================================
-/// This computes and returns the jacobian of M^{-1}(pos, inertia) * C(pos,
-/// inertia, vel) by finite differences. This is SUPER SLOW, and is only here
-/// for testing.
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceJacobianOfMinvC(
-    simulation::WorldPtr world, WithRespectTo* wrt)
+/// This returns lhs^T * d/dx (M^{-1}(x) * rhs) for `skel`
+Eigen::VectorXd BackpropSnapshot::getSkeletonJacobianOfMinvTransposeTimes(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXd& lhs,
+    const Eigen::VectorXd& rhs,
+    WithRespectTo* wrt)
 {
-  std::size_t innerDim = wrt->dim(world.get());
-
-  // These are predicted contact forces at the clamping contacts
-  Eigen::VectorXd original = implicitMultiplyByInvMassMatrix(
-      world, mPreStepTorques - world->getCoriolisAndGravityAndExternalForces());
-
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(original.size(), innerDim);
+  if (!skel->canComputeAnalyticalJacobianOfID(wrt))
+  {
+    return skel->getJacobianOfMinv(rhs, wrt).transpose() * lhs;
+  }
+  // d/dx (M^{-1} rhs) = -M^{-1} (d/dx M) M^{-1} rhs, see
+  // Skeleton::getJacobianOfMinv(), and M^{-1} is symmetric
+  Eigen::VectorXd Minv_rhs = skel->multiplyByImplicitInvMassMatrix(rhs);
+  Eigen::VectorXd Minv_lhs = skel->multiplyByImplicitInvMassMatrix(lhs);
+  return -skel->getJacobianOfID(Minv_rhs, false, wrt).transpose() * Minv_lhs;
+}
 
-  Eigen::VectorXd before = wrt->get(world.get());
+//==============================================================================
+/// This is the Jacobian-vector product version of
+/// finiteDifferencePerSkeleton(). It perturbs each skeleton's `wrt` values
+/// along its slice of `direction`, and central differences `fn(skel,
+/// dofOffset)`, which must return a (skel->getNumDofs() x cols) matrix. The
+/// result stacks the per-skeleton blocks into a (numDofs x cols) matrix.
+/// Skeletons that `direction` doesn't move are skipped.
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceDirectionalPerSkeleton(
+    simulation::WorldPtr world,
+    WithRespectTo* wrt,
+    double eps,
+    const Eigen::VectorXd& direction,
+    int cols,
+    const std::function<Eigen::MatrixXd(
+        dynamics::Skeleton* skel, std::size_t dofOffset)>& fn)
+{
+  // Lay out the offsets serially, like assemblePerSkeleton()
+  std::size_t numSkels = world->getNumSkeletons();
+  std::vector<std::size_t> dofOffsets(numSkels);
+  std::vector<std::size_t> wrtOffsets(numSkels);
+  std::vector<std::size_t> wrtDims(numSkels);
+  std::size_t dofCursor = 0;
+  std::size_t wrtCursor = 0;
+  for (std::size_t i = 0; i < numSkels; i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    dofOffsets[i] = dofCursor;
+    wrtOffsets[i] = wrtCursor;
+    wrtDims[i] = wrt->dim(skel);
+    dofCursor += skel->getNumDofs();
+    wrtCursor += wrtDims[i];
+  }
+  assert(direction.size() == wrtCursor);
 
-  const double EPS = 1e-7;
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dofCursor, cols);
 
-  for (std::size_t i = 0; i < innerDim; i++)
+  auto differenceSkeleton = [&](std::size_t i) {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    std::size_t dofs = skel->getNumDofs();
+    if (dofs == 0 || wrtDims[i] == 0)
+      return;
+    Eigen::VectorXd step = eps * direction.segment(wrtOffsets[i], wrtDims[i]);
+    if (step.isZero())
+      return;
+
+    Eigen::VectorXd before = wrt->get(skel);
+    wrt->set(skel, before + step);
+    Eigen::MatrixXd plus = fn(skel, dofOffsets[i]);
+    wrt->set(skel, before - step);
+    Eigen::MatrixXd minus = fn(skel, dofOffsets[i]);
+    wrt->set(skel, before);
+    result.middleRows(dofOffsets[i], dofs) = (plus - minus) / (2 * eps);
+  };
+
+  std::shared_ptr<common::ThreadPool> pool = world->getGradientThreadPool();
+  if (pool)
   {
-    Eigen::VectorXd perturbed = before;
-    perturbed(i) += EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd tauPos = implicitMultiplyByInvMassMatrix(
-        world,
-        mPreStepTorques - world->getCoriolisAndGravityAndExternalForces());
-    perturbed = before;
-    perturbed(i) -= EPS;
-    wrt->set(world.get(), perturbed);
-    Eigen::MatrixXd tauNeg = implicitMultiplyByInvMassMatrix(
-        world,
-        mPreStepTorques - world->getCoriolisAndGravityAndExternalForces());
-    Eigen::VectorXd diff = tauPos - tauNeg;
-    result.col(i) = diff / (2 * EPS);
+    pool->parallelFor(numSkels, differenceSkeleton);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < numSkels; i++)
+      differenceSkeleton(i);
   }
-
-  wrt->set(world.get(), before);
 
   return result;
 }
@@ -3926,6 +4817,43 @@ Eigen::MatrixXd BackpropSnapshot::assembleBlockDiagonalMatrix(
   return J;
 }
 
+//==============================================================================
+BlockDiagonalMassMatrix BackpropSnapshot::assembleBlockMassMatrix(
+    simulation::WorldPtr world,
+    BackpropSnapshot::BlockDiagonalMatrixToAssemble whichMatrix,
+    bool forFiniteDifferencing)
+{
+  assert(
+      whichMatrix == BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS
+      || whichMatrix
+             == BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS);
+
+  // If we're not finite differencing, then set the state of the world back to
+  // what it was during the forward pass, so that we get the mass matrix from
+  // the forward pass.
+
+  Eigen::VectorXd oldPositions = world->getPositions();
+  Eigen::VectorXd oldVelocities = world->getVelocities();
+  if (!forFiniteDifferencing)
+  {
+    world->setPositions(mPreStepPosition);
+    world->setVelocities(mPreStepVelocity);
+  }
+
+  BlockDiagonalMassMatrix M
+      = whichMatrix == BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS
+            ? world->getBlockMassMatrix()
+            : world->getBlockInvMassMatrix();
+
+  if (!forFiniteDifferencing)
+  {
+    world->setPositions(oldPositions);
+    world->setVelocities(oldVelocities);
+  }
+
+  return M;
+}
+
 //==============================================================================
 template <typename Vec>
 Vec BackpropSnapshot::assembleVector(VectorToAssemble whichVector)
@@ -1,12 +1,15 @@
 #ifndef DART_NEURAL_SNAPSHOT_HPP_
 #define DART_NEURAL_SNAPSHOT_HPP_
 
+#include <functional>
 #include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include "dart/neural/BlockDiagonalMassMatrix.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/LCPFactorization.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/WithRespectTo.hpp"
@@ -47,6 +50,39 @@ public:
       const LossGradient& nextTimestepLoss,
       PerformanceLog* perfLog = nullptr);
 
+  /// This computes the same thing as backprop(), but works in terms of
+  /// vector-Jacobian products wherever it can. Mass matrix products go through
+  /// the implicit (Featherstone) multiply, solves against the LCP matrix use
+  /// its cached factorization, and the derivatives of M^{-1} and C multiply
+  /// the transposes of the analytical per-skeleton Jacobians. That means it
+  /// never forms the full (world DOFs x world DOFs) position or velocity
+  /// Jacobians, or the world mass matrix or its inverse. It does still form the
+  /// per-skeleton integrator, inverse dynamics and dC/dx blocks, so the cost is
+  /// still O(n^2) in each skeleton's DOFs. It also forms the (clamping x
+  /// clamping) constraint matrix Q and its pseudo-inverse, and the bounce
+  /// approximation when there are bounces. backprop() calls this if
+  /// World::setUseVJPBackprop() was set when this snapshot was taken.
+  void backpropVJP(
+      simulation::WorldPtr world,
+      LossGradient& thisTimestepLoss,
+      const LossGradient& nextTimestepLoss,
+      PerformanceLog* perfLog = nullptr);
+
+  /// This is the forward-mode counterpart of backprop(). It pushes tangent
+  /// directions on this timestep's inputs forward to tangents on the next
+  /// position and velocity, without forming any Jacobians. Each column of the
+  /// inputs is one direction. `tangentPos`, `tangentVel` and `tangentForce`
+  /// are (numDofs x k), and `tangentMass` is either (massDims x k), or has no
+  /// rows if the directions don't move the masses. The cost scales with k,
+  /// rather than with the number of DOFs or masses.
+  StateTangent jvp(
+      simulation::WorldPtr world,
+      const Eigen::MatrixXd& tangentPos,
+      const Eigen::MatrixXd& tangentVel,
+      const Eigen::MatrixXd& tangentForce,
+      const Eigen::MatrixXd& tangentMass,
+      PerformanceLog* perfLog = nullptr);
+
   /// This computes and returns the whole vel-vel jacobian. For backprop, you
   /// don't actually need this matrix, you can compute backprop directly. This
   /// is here if you want access to the full Jacobian for some reason.
@@ -104,6 +140,10 @@ public:
   /// during the forward pass, BEFORE the timestep.
   Eigen::VectorXd getPreStepTorques();
 
+  /// Returns the World's cached LCP solution (used to warm start the LCP
+  /// solver) from BEFORE the timestep.
+  Eigen::VectorXd getPreStepLCPCache();
+
   /// Returns a concatenated vector of all the Skeletons' velocity()'s in the
   /// World, in order in which the Skeletons appear in the World's
   /// getSkeleton(i) returns them, AFTER integrating forward dynamics but BEFORE
@@ -163,6 +203,18 @@ public:
   Eigen::MatrixXd getInvMassMatrix(
       simulation::WorldPtr world, bool forFiniteDifferencing = false);
 
+  /// This returns the mass matrix for the whole world, storing only the
+  /// diagonal blocks (one per tree of each skeleton). Prefer this to
+  /// getMassMatrix() when you only need to multiply by M.
+  BlockDiagonalMassMatrix getBlockMassMatrix(
+      simulation::WorldPtr world, bool forFiniteDifferencing = false);
+
+  /// This returns the inverse mass matrix for the whole world, storing only
+  /// the diagonal blocks (one per tree of each skeleton). Prefer this to
+  /// getInvMassMatrix() when you only need to multiply by Minv.
+  BlockDiagonalMassMatrix getBlockInvMassMatrix(
+      simulation::WorldPtr world, bool forFiniteDifferencing = false);
+
   /// This is the subset of the A matrix from the original LCP that corresponds
   /// to clamping indices.
   Eigen::MatrixXd getClampingAMatrix();
@@ -249,6 +301,14 @@ public:
   /// This computes and returns the whole wrt-vel jacobian. For backprop, you
   /// don't actually need this matrix, you can compute backprop directly. This
   /// is here if you want access to the full Jacobian for some reason.
+  ///
+  /// Constrained groups can't affect each other, so this computes each
+  /// group's block separately (see
+  /// ConstrainedGroupGradientMatrices::getVelJacobianWrt()), along with a
+  /// block for each skeleton that isn't in any group, and assembles them. If
+  /// the world has a gradient thread pool, the blocks are computed in
+  /// parallel, after building every body's transform and Jacobian caches
+  /// serially, because groups can share a static skeleton through contacts.
   Eigen::MatrixXd getVelJacobianWrt(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
@@ -335,6 +395,12 @@ public:
   Eigen::MatrixXd getJacobianOfMinvC(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
+  /// This returns one skeleton's block of getJacobianOfC(), which is
+  /// Skeleton::getJacobianOfC() less the Jacobian of the skeleton's external
+  /// forces. This only touches the state of `skel`.
+  static Eigen::MatrixXd getSkeletonJacobianOfC(
+      dynamics::Skeleton* skel, WithRespectTo* wrt);
+
   /// This returns a fast approximation to A_c in the neighborhood of the
   /// original
   Eigen::MatrixXd estimateClampingConstraintMatrixAt(
@@ -526,6 +592,10 @@ public:
   /// instructions.
   void setSlowDebugResultsAgainstFD(bool slowDebug);
 
+  /// If this is true, backprop() only computes vector-Jacobian products (see
+  /// backpropVJP()), and never forms the full Jacobians.
+  void setUseVJPBackprop(bool vjpBackprop);
+
 protected:
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
@@ -538,6 +608,14 @@ protected:
   /// instructions.
   bool mSlowDebugResultsAgainstFD;
 
+  /// If this is true, backprop() only computes vector-Jacobian products, and
+  /// never forms the full Jacobians.
+  bool mUseVJPBackprop;
+
+  /// This caches factorizations of the clamping-subset LCP matrix Q, which
+  /// several of the Jacobian getters all need to solve against.
+  std::shared_ptr<LCPFactorizationCache> mFactorizationCache;
+
   /// This is the global timestep length. This is included here because it shows
   /// up as a constant in some of the matrices.
   double mTimeStep;
@@ -637,6 +715,79 @@ private:
       BlockDiagonalMatrixToAssemble whichMatrix,
       bool forFiniteDifferencing = false);
 
+  /// This assembles the mass matrix (or its inverse) without forming the
+  /// off-diagonal blocks. `whichMatrix` must be MASS or INV_MASS.
+  BlockDiagonalMassMatrix assembleBlockMassMatrix(
+      simulation::WorldPtr world,
+      BlockDiagonalMatrixToAssemble whichMatrix,
+      bool forFiniteDifferencing = false);
+
+  /// This returns the block of getVelJacobianWrt() for a skeleton that isn't
+  /// in any constrained group, so nothing couples it to the other skeletons.
+  /// This only touches the state of `skel`.
+  Eigen::MatrixXd getUnconstrainedVelJacobianWrt(
+      dynamics::Skeleton* skel, WithRespectTo* wrt);
+
+  /// This assembles a block diagonal Jacobian with respect to `wrt`, where
+  /// `block(skel, dofOffset)` returns the (skel->getNumDofs() x
+  /// wrt->dim(skel)) block for `skel`. Each block must only touch the state
+  /// of its own skeleton, so if the world has a gradient thread pool we
+  /// compute the blocks in parallel.
+  Eigen::MatrixXd assemblePerSkeleton(
+      simulation::WorldPtr world,
+      WithRespectTo* wrt,
+      const std::function<Eigen::MatrixXd(
+          dynamics::Skeleton* skel, std::size_t dofOffset)>& block);
+
+  /// This is the vector-Jacobian product version of assemblePerSkeleton().
+  /// `grad(skel, dofOffset)` returns the wrt->dim(skel) gradient for `skel`,
+  /// and this stacks them into one vector, computing them in parallel if the
+  /// world has a gradient thread pool.
+  Eigen::VectorXd stackGradientsPerSkeleton(
+      simulation::WorldPtr world,
+      WithRespectTo* wrt,
+      const std::function<Eigen::VectorXd(
+          dynamics::Skeleton* skel, std::size_t dofOffset)>& grad);
+
+  /// This returns lhs^T * d/dx (M^{-1}(x) * rhs) for `skel`, where lhs and
+  /// rhs are already sliced down to `skel`. When the analytical inverse
+  /// dynamics Jacobians support `skel` this is
+  /// -(d/dx (M * M^{-1} rhs))^T * (M^{-1} lhs), which never forms M^{-1}.
+  static Eigen::VectorXd getSkeletonJacobianOfMinvTransposeTimes(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXd& lhs,
+      const Eigen::VectorXd& rhs,
+      WithRespectTo* wrt);
+
+  /// This central-differences a per-skeleton function with respect to `wrt`.
+  /// `fn(skel, dofOffset)` must return a vector of skel->getNumDofs() that
+  /// only depends on the state of `skel`, which is true of anything built from
+  /// the skeleton's mass matrix and its Coriolis, gravity and external forces.
+  /// Perturbing one skeleton can't change another skeleton's output, so the
+  /// Jacobian is block diagonal, and we only ever evaluate the diagonal
+  /// blocks, see assemblePerSkeleton().
+  Eigen::MatrixXd finiteDifferencePerSkeleton(
+      simulation::WorldPtr world,
+      WithRespectTo* wrt,
+      double eps,
+      const std::function<Eigen::VectorXd(
+          dynamics::Skeleton* skel, std::size_t dofOffset)>& fn);
+
+  /// This is the Jacobian-vector product version of
+  /// finiteDifferencePerSkeleton(). It perturbs each skeleton's `wrt` values
+  /// along its slice of `direction`, and central differences `fn(skel,
+  /// dofOffset)`, which must return a (skel->getNumDofs() x cols) matrix. The
+  /// result stacks the per-skeleton blocks into a (numDofs x cols) matrix.
+  /// Skeletons that `direction` doesn't move are skipped.
+  Eigen::MatrixXd finiteDifferenceDirectionalPerSkeleton(
+      simulation::WorldPtr world,
+      WithRespectTo* wrt,
+      double eps,
+      const Eigen::VectorXd& direction,
+      int cols,
+      const std::function<Eigen::MatrixXd(
+          dynamics::Skeleton* skel, std::size_t dofOffset)>& fn);
+
   enum VectorToAssemble
   {
     CONTACT_CONSTRAINT_IMPULSES,
@@ -0,0 +1,222 @@
+#include "dart/neural/BatchedWorld.hpp"
+
+#include "dart/common/Console.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+std::vector<std::shared_ptr<BackpropSnapshot>> forwardPassBatch(
+    const std::vector<std::shared_ptr<simulation::World>>& worlds,
+    Eigen::Ref<const Eigen::MatrixXd> positions,
+    Eigen::Ref<const Eigen::MatrixXd> velocities,
+    Eigen::Ref<const Eigen::MatrixXd> torques,
+    bool idempotent,
+    common::ThreadPool* pool)
+{
+  const std::size_t batchSize = worlds.size();
+  assert(positions.cols() == batchSize);
+  assert(velocities.cols() == batchSize);
+  assert(torques.cols() == batchSize);
+
+  std::shared_ptr<common::ThreadPool> defaultPool;
+  if (pool == nullptr)
+  {
+    defaultPool = common::ThreadPool::getDefault();
+    pool = defaultPool.get();
+  }
+
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots(batchSize);
+  pool->parallelFor(batchSize, [&](std::size_t i) {
+    const std::shared_ptr<simulation::World>& world = worlds[i];
+    world->setPositions(positions.col(i));
+    world->setVelocities(velocities.col(i));
+    world->setExternalForces(torques.col(i));
+    snapshots[i] = neural::forwardPass(world, idempotent);
+  });
+  return snapshots;
+}
+
+//==============================================================================
+std::vector<LossGradient> backpropBatch(
+    const std::vector<std::shared_ptr<simulation::World>>& worlds,
+    const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+    const std::vector<LossGradient>& nextTimestepLosses,
+    common::ThreadPool* pool)
+{
+  const std::size_t batchSize = worlds.size();
+  assert(snapshots.size() == batchSize);
+  assert(nextTimestepLosses.size() == batchSize);
+
+  std::shared_ptr<common::ThreadPool> defaultPool;
+  if (pool == nullptr)
+  {
+    defaultPool = common::ThreadPool::getDefault();
+    pool = defaultPool.get();
+  }
+
+  std::vector<LossGradient> thisTimestepLosses(batchSize);
+  pool->parallelFor(batchSize, [&](std::size_t i) {
+    snapshots[i]->backprop(
+        worlds[i], thisTimestepLosses[i], nextTimestepLosses[i]);
+  });
+  return thisTimestepLosses;
+}
+
+//==============================================================================
+BatchedWorld::BatchedWorld(
+    std::shared_ptr<simulation::World> world, int batchSize, int numThreads)
+  : mOriginalWorld(world),
+    mPool(std::make_shared<common::ThreadPool>(numThreads))
+{
+  setBatchSize(batchSize);
+}
+
+//==============================================================================
+int BatchedWorld::getBatchSize() const
+{
+  return mWorlds.size();
+}
+
+//==============================================================================
+void BatchedWorld::setBatchSize(int batchSize)
+{
+  if (batchSize < 0)
+  {
+    dterr << "[BatchedWorld::setBatchSize] Batch size must be non-negative, "
+          << "but got " << batchSize << ". Ignoring.\n";
+    return;
+  }
+  while (mWorlds.size() > batchSize)
+    mWorlds.pop_back();
+  while (mWorlds.size() < batchSize)
+    mWorlds.push_back(mOriginalWorld->clone());
+}
+
+//==============================================================================
+std::shared_ptr<simulation::World> BatchedWorld::getWorld(int index)
+{
+  return mWorlds[index];
+}
+
+//==============================================================================
+const std::vector<std::shared_ptr<simulation::World>>&
+BatchedWorld::getWorlds()
+{
+  return mWorlds;
+}
+
+//==============================================================================
+int BatchedWorld::getNumDofs() const
+{
+  return mOriginalWorld->getNumDofs();
+}
+
+//==============================================================================
+std::shared_ptr<common::ThreadPool> BatchedWorld::getThreadPool()
+{
+  return mPool;
+}
+
+//==============================================================================
+Eigen::MatrixXd BatchedWorld::getPositions()
+{
+  Eigen::MatrixXd positions(getNumDofs(), mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+    positions.col(i) = mWorlds[i]->getPositions();
+  return positions;
+}
+
+//==============================================================================
+Eigen::MatrixXd BatchedWorld::getVelocities()
+{
+  Eigen::MatrixXd velocities(getNumDofs(), mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+    velocities.col(i) = mWorlds[i]->getVelocities();
+  return velocities;
+}
+
+//==============================================================================
+std::vector<std::shared_ptr<BackpropSnapshot>> BatchedWorld::forwardPass(
+    Eigen::Ref<const Eigen::MatrixXd> positions,
+    Eigen::Ref<const Eigen::MatrixXd> velocities,
+    Eigen::Ref<const Eigen::MatrixXd> torques,
+    bool idempotent)
+{
+  return forwardPassBatch(
+      mWorlds, positions, velocities, torques, idempotent, mPool.get());
+}
+
+//==============================================================================
+std::vector<LossGradient> BatchedWorld::backprop(
+    const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+    const std::vector<LossGradient>& nextTimestepLosses)
+{
+  return backpropBatch(mWorlds, snapshots, nextTimestepLosses, mPool.get());
+}
+
+//==============================================================================
+/// This is like forwardPass(), but it also gathers the state each world ends
+/// up in into matrices, inside the parallel loop.
+BatchedStep BatchedWorld::step(
+    Eigen::Ref<const Eigen::MatrixXd> positions,
+    Eigen::Ref<const Eigen::MatrixXd> velocities,
+    Eigen::Ref<const Eigen::MatrixXd> torques,
+    bool idempotent)
+{
+  const std::size_t batchSize = mWorlds.size();
+  assert(positions.cols() == batchSize);
+  assert(velocities.cols() == batchSize);
+  assert(torques.cols() == batchSize);
+
+  BatchedStep result;
+  result.snapshots.resize(batchSize);
+  result.nextPositions = Eigen::MatrixXd::Zero(getNumDofs(), batchSize);
+  result.nextVelocities = Eigen::MatrixXd::Zero(getNumDofs(), batchSize);
+  mPool->parallelFor(batchSize, [&](std::size_t i) {
+    const std::shared_ptr<simulation::World>& world = mWorlds[i];
+    world->setPositions(positions.col(i));
+    world->setVelocities(velocities.col(i));
+    world->setExternalForces(torques.col(i));
+    result.snapshots[i] = neural::forwardPass(world, idempotent);
+    result.nextPositions.col(i) = result.snapshots[i]->getPostStepPosition();
+    result.nextVelocities.col(i) = result.snapshots[i]->getPostStepVelocity();
+  });
+  return result;
+}
+
+//==============================================================================
+/// Backprops through a batch step returned by step(), in parallel
+BatchedLossGradient BatchedWorld::backpropStep(
+    const BatchedStep& step,
+    Eigen::Ref<const Eigen::MatrixXd> lossWrtNextPosition,
+    Eigen::Ref<const Eigen::MatrixXd> lossWrtNextVelocity)
+{
+  const std::size_t batchSize = mWorlds.size();
+  const int dofs = getNumDofs();
+  assert(step.snapshots.size() == batchSize);
+  assert(lossWrtNextPosition.cols() == batchSize);
+  assert(lossWrtNextVelocity.cols() == batchSize);
+
+  BatchedLossGradient result;
+  result.lossWrtPosition = Eigen::MatrixXd::Zero(dofs, batchSize);
+  result.lossWrtVelocity = Eigen::MatrixXd::Zero(dofs, batchSize);
+  result.lossWrtTorque = Eigen::MatrixXd::Zero(dofs, batchSize);
+  mPool->parallelFor(batchSize, [&](std::size_t i) {
+    LossGradient nextTimestepLoss;
+    nextTimestepLoss.lossWrtPosition = lossWrtNextPosition.col(i);
+    nextTimestepLoss.lossWrtVelocity = lossWrtNextVelocity.col(i);
+    nextTimestepLoss.lossWrtTorque = Eigen::VectorXd::Zero(dofs);
+    LossGradient thisTimestepLoss;
+    step.snapshots[i]->backprop(mWorlds[i], thisTimestepLoss, nextTimestepLoss);
+    result.lossWrtPosition.col(i) = thisTimestepLoss.lossWrtPosition;
+    result.lossWrtVelocity.col(i) = thisTimestepLoss.lossWrtVelocity;
+    result.lossWrtTorque.col(i) = thisTimestepLoss.lossWrtTorque;
+  });
+  return result;
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,145 @@
+#ifndef DART_NEURAL_BATCHED_WORLD_HPP_
+#define DART_NEURAL_BATCHED_WORLD_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+
+namespace dart {
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+class BackpropSnapshot;
+
+/// Takes a step in each of `worlds` in parallel, and returns a backprop
+/// snapshot for each of them. Before stepping, the i'th world is set to the
+/// i'th column of `positions`, `velocities` and `torques` (each is
+/// world DOFs x batch size). The worlds must all be distinct objects, since
+/// they're stepped concurrently. If `pool` is null, this uses
+/// common::ThreadPool::getDefault().
+std::vector<std::shared_ptr<BackpropSnapshot>> forwardPassBatch(
+    const std::vector<std::shared_ptr<simulation::World>>& worlds,
+    Eigen::Ref<const Eigen::MatrixXd> positions,
+    Eigen::Ref<const Eigen::MatrixXd> velocities,
+    Eigen::Ref<const Eigen::MatrixXd> torques,
+    bool idempotent = false,
+    common::ThreadPool* pool = nullptr);
+
+/// Runs BackpropSnapshot::backprop() on each of `snapshots` in parallel, using
+/// the corresponding world in `worlds`, and returns the loss with respect to
+/// the inputs of each step.
+std::vector<LossGradient> backpropBatch(
+    const std::vector<std::shared_ptr<simulation::World>>& worlds,
+    const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+    const std::vector<LossGradient>& nextTimestepLosses,
+    common::ThreadPool* pool = nullptr);
+
+/// The result of BatchedWorld::step(). This keeps the snapshots needed to
+/// backprop through the step, along with the state each world ended up in,
+/// with one column per world in the batch.
+struct BatchedStep
+{
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+  Eigen::MatrixXd nextPositions;
+  Eigen::MatrixXd nextVelocities;
+};
+
+/// The batched analog of LossGradient, with one column per world in the batch
+struct BatchedLossGradient
+{
+  Eigen::MatrixXd lossWrtPosition;
+  Eigen::MatrixXd lossWrtVelocity;
+  Eigen::MatrixXd lossWrtTorque;
+};
+
+/// This holds a batch of clones of a single world, along with a persistent
+/// thread pool to step them, so that a whole batch of rollouts (for example,
+/// a minibatch when training a policy) can be stepped and differentiated with
+/// a single call.
+class BatchedWorld
+{
+public:
+  /// This clones `world` `batchSize` times. If `numThreads` is 0, the pool
+  /// gets one thread per hardware thread.
+  BatchedWorld(
+      std::shared_ptr<simulation::World> world,
+      int batchSize,
+      int numThreads = 0);
+
+  /// Returns the number of worlds in the batch
+  int getBatchSize() const;
+
+  /// Changes the number of worlds in the batch, by cloning the original world
+  /// or dropping worlds off the end
+  void setBatchSize(int batchSize);
+
+  /// Returns the i'th world in the batch
+  std::shared_ptr<simulation::World> getWorld(int index);
+
+  /// Returns all the worlds in the batch
+  const std::vector<std::shared_ptr<simulation::World>>& getWorlds();
+
+  /// Returns the number of DOFs in each world
+  int getNumDofs() const;
+
+  /// Returns the thread pool used to step this batch
+  std::shared_ptr<common::ThreadPool> getThreadPool();
+
+  /// Returns the positions of all the worlds, as world DOFs x batch size
+  Eigen::MatrixXd getPositions();
+
+  /// Returns the velocities of all the worlds, as world DOFs x batch size
+  Eigen::MatrixXd getVelocities();
+
+  /// Sets the state of every world from the columns of the inputs, takes a
+  /// step in all of them in parallel, and returns the backprop snapshots.
+  std::vector<std::shared_ptr<BackpropSnapshot>> forwardPass(
+      Eigen::Ref<const Eigen::MatrixXd> positions,
+      Eigen::Ref<const Eigen::MatrixXd> velocities,
+      Eigen::Ref<const Eigen::MatrixXd> torques,
+      bool idempotent = false);
+
+  /// Backprops through a batch of snapshots returned by forwardPass(), in
+  /// parallel.
+  std::vector<LossGradient> backprop(
+      const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+      const std::vector<LossGradient>& nextTimestepLosses);
+
+  /// This is like forwardPass(), but it also gathers the state each world
+  /// ends up in into matrices, inside the parallel loop. Together with
+  /// backpropStep(), this lets callers (like BatchedDartLayer in Python) step
+  /// and differentiate a whole batch without touching any per-world objects.
+  /// The inputs are taken as Eigen::Ref, so from Python a float64 array in
+  /// column-major order (e.g. the transpose of a C-ordered batch x DOFs
+  /// array) is read in place rather than copied.
+  BatchedStep step(
+      Eigen::Ref<const Eigen::MatrixXd> positions,
+      Eigen::Ref<const Eigen::MatrixXd> velocities,
+      Eigen::Ref<const Eigen::MatrixXd> torques,
+      bool idempotent = false);
+
+  /// Backprops through a batch step returned by step(), in parallel. The
+  /// losses with respect to the next positions and velocities are world DOFs
+  /// x batch size, and so is each matrix in the result.
+  BatchedLossGradient backpropStep(
+      const BatchedStep& step,
+      Eigen::Ref<const Eigen::MatrixXd> lossWrtNextPosition,
+      Eigen::Ref<const Eigen::MatrixXd> lossWrtNextVelocity);
+
+protected:
+  std::shared_ptr<simulation::World> mOriginalWorld;
+  std::vector<std::shared_ptr<simulation::World>> mWorlds;
+  std::shared_ptr<common::ThreadPool> mPool;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -0,0 +1,265 @@
+#include "dart/neural/BlockDiagonalMassMatrix.hpp"
+
+#include <cassert>
+
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace neural {
+
+namespace {
+
+//==============================================================================
+BlockDiagonalMassMatrix createFromTrees(
+    const std::vector<dynamics::SkeletonPtr>& skeletons, bool inverse)
+{
+  std::size_t dim = 0;
+  for (const dynamics::SkeletonPtr& skel : skeletons)
+    dim += skel->getNumDofs();
+
+  BlockDiagonalMassMatrix matrix(dim);
+  std::size_t cursor = 0;
+  for (const dynamics::SkeletonPtr& skel : skeletons)
+  {
+    const dynamics::Skeleton* constSkel = skel.get();
+    for (std::size_t tree = 0; tree < skel->getNumTrees(); tree++)
+    {
+      const std::vector<const dynamics::DegreeOfFreedom*>& treeDofs
+          = constSkel->getTreeDofs(tree);
+      if (treeDofs.empty())
+        continue;
+
+      std::vector<std::size_t> indices;
+      indices.reserve(treeDofs.size());
+      for (const dynamics::DegreeOfFreedom* dof : treeDofs)
+        indices.push_back(cursor + dof->getIndexInSkeleton());
+
+      matrix.addBlock(
+          indices,
+          inverse ? skel->getInvMassMatrix(tree) : skel->getMassMatrix(tree));
+    }
+    cursor += skel->getNumDofs();
+  }
+  return matrix;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+BlockDiagonalMassMatrix::BlockDiagonalMassMatrix() : mDim(0)
+{
+}
+
+//==============================================================================
+BlockDiagonalMassMatrix::BlockDiagonalMassMatrix(std::size_t dim) : mDim(dim)
+{
+}
+
+//==============================================================================
+/// This creates the block diagonal concatenation of the skeletons' mass
+/// matrices, with one block per tree, in the order the skeletons are given
+BlockDiagonalMassMatrix BlockDiagonalMassMatrix::createMassMatrix(
+    const std::vector<dynamics::SkeletonPtr>& skeletons)
+{
+  return createFromTrees(skeletons, false);
+}
+
+//==============================================================================
+/// This creates the block diagonal concatenation of the skeletons' inverse
+/// mass matrices, with one block per tree, in the order the skeletons are
+/// given
+BlockDiagonalMassMatrix BlockDiagonalMassMatrix::createInvMassMatrix(
+    const std::vector<dynamics::SkeletonPtr>& skeletons)
+{
+  return createFromTrees(skeletons, true);
+}
+
+//==============================================================================
+/// This adds a block covering the square range [start, start + block.rows())
+void BlockDiagonalMassMatrix::addBlock(
+    std::size_t start, const Eigen::MatrixXd& block)
+{
+  std::vector<std::size_t> indices(block.rows());
+  for (std::size_t i = 0; i < indices.size(); i++)
+    indices[i] = start + i;
+  addBlock(indices, block);
+}
+
+//==============================================================================
+/// This adds a block covering the rows and columns in `indices`, which must
+/// be in ascending order and must not overlap any other block
+void BlockDiagonalMassMatrix::addBlock(
+    const std::vector<std::size_t>& indices, const Eigen::MatrixXd& block)
+{
+  assert(block.rows() == block.cols());
+  assert(static_cast<std::size_t>(block.rows()) == indices.size());
+  if (indices.empty())
+    return;
+  assert(indices.back() < mDim);
+
+  Block newBlock;
+  newBlock.start = indices[0];
+  newBlock.contiguous = (indices.back() - indices[0] + 1 == indices.size());
+  newBlock.indices = indices;
+  newBlock.matrix = block;
+  mBlocks.push_back(std::move(newBlock));
+}
+
+//==============================================================================
+/// Returns the number of rows (and columns) of the full matrix
+Eigen::Index BlockDiagonalMassMatrix::rows() const
+{
+  return static_cast<Eigen::Index>(mDim);
+}
+
+//==============================================================================
+/// Returns the number of columns (and rows) of the full matrix
+Eigen::Index BlockDiagonalMassMatrix::cols() const
+{
+  return static_cast<Eigen::Index>(mDim);
+}
+
+//==============================================================================
+/// Returns the number of diagonal blocks
+std::size_t BlockDiagonalMassMatrix::getNumBlocks() const
+{
+  return mBlocks.size();
+}
+
+//==============================================================================
+/// Returns the i'th diagonal block
+const Eigen::MatrixXd& BlockDiagonalMassMatrix::getBlock(std::size_t i) const
+{
+  return mBlocks[i].matrix;
+}
+
+//==============================================================================
+/// Returns the rows (and columns) of the full matrix that the i'th block
+/// covers
+const std::vector<std::size_t>& BlockDiagonalMassMatrix::getBlockIndices(
+    std::size_t i) const
+{
+  return mBlocks[i].indices;
+}
+
+//==============================================================================
+/// Returns the number of coefficients we actually store, which is the sum of
+/// the squares of the block sizes
+std::size_t BlockDiagonalMassMatrix::getNumStoredCoeffs() const
+{
+  std::size_t sum = 0;
+  for (const Block& block : mBlocks)
+    sum += block.matrix.size();
+  return sum;
+}
+
+//==============================================================================
+/// This returns a copy of this matrix with every block scaled by `scale`
+BlockDiagonalMassMatrix BlockDiagonalMassMatrix::scaled(double scale) const
+{
+  BlockDiagonalMassMatrix result(*this);
+  for (Block& block : result.mBlocks)
+    block.matrix *= scale;
+  return result;
+}
+
+//==============================================================================
+/// This forms the full dense matrix. This is expensive for big worlds, and
+/// is mostly useful for testing and for APIs that return dense matrices.
+Eigen::MatrixXd BlockDiagonalMassMatrix::toDense() const
+{
+  Eigen::MatrixXd dense = Eigen::MatrixXd::Zero(mDim, mDim);
+  for (const Block& block : mBlocks)
+  {
+    if (block.contiguous)
+    {
+      dense.block(
+          block.start, block.start, block.matrix.rows(), block.matrix.cols())
+          = block.matrix;
+      continue;
+    }
+    for (std::size_t j = 0; j < block.indices.size(); j++)
+      for (std::size_t i = 0; i < block.indices.size(); i++)
+        dense(block.indices[i], block.indices[j]) = block.matrix(i, j);
+  }
+  return dense;
+}
+
+//==============================================================================
+/// This computes out = this * rhs. `out` must already be the right size.
+void BlockDiagonalMassMatrix::multiply(
+    const Eigen::Ref<const Eigen::MatrixXd>& rhs,
+    Eigen::Ref<Eigen::MatrixXd> out) const
+{
+  assert(rhs.rows() == rows());
+  assert(out.rows() == rows() && out.cols() == rhs.cols());
+
+  out.setZero();
+  Eigen::MatrixXd gathered;
+  Eigen::MatrixXd product;
+  for (const Block& block : mBlocks)
+  {
+    const std::size_t size = block.indices.size();
+    if (block.contiguous)
+    {
+      out.middleRows(block.start, size).noalias()
+          = block.matrix * rhs.middleRows(block.start, size);
+      continue;
+    }
+    gathered.resize(size, rhs.cols());
+    for (std::size_t i = 0; i < size; i++)
+      gathered.row(i) = rhs.row(block.indices[i]);
+    product.noalias() = block.matrix * gathered;
+    for (std::size_t i = 0; i < size; i++)
+      out.row(block.indices[i]) = product.row(i);
+  }
+}
+
+//==============================================================================
+/// This computes out = lhs * this. `out` must already be the right size.
+void BlockDiagonalMassMatrix::leftMultiply(
+    const Eigen::Ref<const Eigen::MatrixXd>& lhs,
+    Eigen::Ref<Eigen::MatrixXd> out) const
+{
+  assert(lhs.cols() == cols());
+  assert(out.rows() == lhs.rows() && out.cols() == cols());
+
+  out.setZero();
+  Eigen::MatrixXd gathered;
+  Eigen::MatrixXd product;
+  for (const Block& block : mBlocks)
+  {
+    const std::size_t size = block.indices.size();
+    if (block.contiguous)
+    {
+      out.middleCols(block.start, size).noalias()
+          = lhs.middleCols(block.start, size) * block.matrix;
+      continue;
+    }
+    gathered.resize(lhs.rows(), size);
+    for (std::size_t i = 0; i < size; i++)
+      gathered.col(i) = lhs.col(block.indices[i]);
+    product.noalias() = gathered * block.matrix;
+    for (std::size_t i = 0; i < size; i++)
+      out.col(block.indices[i]) = product.col(i);
+  }
+}
+
+//==============================================================================
+/// This returns this * scale
+BlockDiagonalMassMatrix BlockDiagonalMassMatrix::operator*(double scale) const
+{
+  return scaled(scale);
+}
+
+//==============================================================================
+/// This returns scale * matrix
+BlockDiagonalMassMatrix operator*(
+    double scale, const BlockDiagonalMassMatrix& matrix)
+{
+  return matrix.scaled(scale);
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,140 @@
+#ifndef DART_NEURAL_BLOCK_DIAGONAL_MASS_MATRIX_HPP_
+#define DART_NEURAL_BLOCK_DIAGONAL_MASS_MATRIX_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/SmartPointer.hpp"
+
+namespace dart {
+namespace neural {
+
+/// This is a (possibly inverse) mass matrix for a collection of skeletons,
+/// stored as its diagonal blocks. Skeletons never share DOFs, and neither do
+/// the separate trees inside a skeleton, so the full mass matrix is block
+/// diagonal with one block per tree. Storing just the blocks costs
+/// O(sum of block DOF^2) memory rather than O(total DOF^2), and multiplying
+/// against it costs O(sum of block DOF^2) per column, which matters a great
+/// deal for worlds with lots of independent robots and objects.
+///
+/// A block covers an ascending (but not necessarily contiguous) set of rows
+/// and columns, because a tree's DOFs can be interleaved with the DOFs of
+/// other trees in the same skeleton. In practice almost all blocks are
+/// contiguous, and those take a fast path.
+class BlockDiagonalMassMatrix
+{
+public:
+  /// This creates an empty 0x0 matrix
+  BlockDiagonalMassMatrix();
+
+  /// This creates a dim x dim matrix with no blocks (so all zeros)
+  explicit BlockDiagonalMassMatrix(std::size_t dim);
+
+  /// This creates the block diagonal concatenation of the skeletons' mass
+  /// matrices, with one block per tree, in the order the skeletons are given
+  static BlockDiagonalMassMatrix createMassMatrix(
+      const std::vector<dynamics::SkeletonPtr>& skeletons);
+
+  /// This creates the block diagonal concatenation of the skeletons' inverse
+  /// mass matrices, with one block per tree, in the order the skeletons are
+  /// given
+  static BlockDiagonalMassMatrix createInvMassMatrix(
+      const std::vector<dynamics::SkeletonPtr>& skeletons);
+
+  /// This adds a block covering the square range [start, start + block.rows())
+  void addBlock(std::size_t start, const Eigen::MatrixXd& block);
+
+  /// This adds a block covering the rows and columns in `indices`, which must
+  /// be in ascending order and must not overlap any other block
+  void addBlock(
+      const std::vector<std::size_t>& indices, const Eigen::MatrixXd& block);
+
+  /// Returns the number of rows (and columns) of the full matrix
+  Eigen::Index rows() const;
+
+  /// Returns the number of columns (and rows) of the full matrix
+  Eigen::Index cols() const;
+
+  /// Returns the number of diagonal blocks
+  std::size_t getNumBlocks() const;
+
+  /// Returns the i'th diagonal block
+  const Eigen::MatrixXd& getBlock(std::size_t i) const;
+
+  /// Returns the rows (and columns) of the full matrix that the i'th block
+  /// covers
+  const std::vector<std::size_t>& getBlockIndices(std::size_t i) const;
+
+  /// Returns the number of coefficients we actually store, which is the sum of
+  /// the squares of the block sizes
+  std::size_t getNumStoredCoeffs() const;
+
+  /// This returns a copy of this matrix with every block scaled by `scale`
+  BlockDiagonalMassMatrix scaled(double scale) const;
+
+  /// This forms the full dense matrix. This is expensive for big worlds, and
+  /// is mostly useful for testing and for APIs that return dense matrices.
+  Eigen::MatrixXd toDense() const;
+
+  /// This computes out = this * rhs. `out` must already be the right size.
+  void multiply(
+      const Eigen::Ref<const Eigen::MatrixXd>& rhs,
+      Eigen::Ref<Eigen::MatrixXd> out) const;
+
+  /// This computes out = lhs * this. `out` must already be the right size.
+  void leftMultiply(
+      const Eigen::Ref<const Eigen::MatrixXd>& lhs,
+      Eigen::Ref<Eigen::MatrixXd> out) const;
+
+  /// This returns this * rhs, keeping vectors as vectors
+  template <typename Derived>
+  Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime> operator*(
+      const Eigen::MatrixBase<Derived>& rhs) const
+  {
+    Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime> out(
+        rows(), rhs.cols());
+    multiply(rhs, out);
+    return out;
+  }
+
+  /// This returns this * scale
+  BlockDiagonalMassMatrix operator*(double scale) const;
+
+protected:
+  struct Block
+  {
+    /// The first row (and column) this block covers
+    std::size_t start;
+    /// True if this block covers [start, start + matrix.rows()), so we can
+    /// skip the gather and scatter
+    bool contiguous;
+    /// The rows (and columns) this block covers
+    std::vector<std::size_t> indices;
+    Eigen::MatrixXd matrix;
+  };
+
+  std::size_t mDim;
+  std::vector<Block> mBlocks;
+};
+
+/// This returns lhs * rhs, keeping row vectors as row vectors
+template <typename Derived>
+Eigen::Matrix<double, Derived::RowsAtCompileTime, Eigen::Dynamic> operator*(
+    const Eigen::MatrixBase<Derived>& lhs, const BlockDiagonalMassMatrix& rhs)
+{
+  Eigen::Matrix<double, Derived::RowsAtCompileTime, Eigen::Dynamic> out(
+      lhs.rows(), rhs.cols());
+  rhs.leftMultiply(lhs, out);
+  return out;
+}
+
+/// This returns scale * matrix
+BlockDiagonalMassMatrix operator*(
+    double scale, const BlockDiagonalMassMatrix& matrix);
+
+} // namespace neural
+} // namespace dart
+
+#endif
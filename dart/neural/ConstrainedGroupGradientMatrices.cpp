@@ -9,6 +9,7 @@
 #include "dart/constraint/ConstraintBase.hpp"
 #include "dart/constraint/LCPUtils.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/simulation/World.hpp"
@@ -26,7 +27,9 @@ namespace neural {
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     constraint::ConstrainedGroup& group, double timeStep)
-  : mFinalized(false), mDeliberatelyIgnoreFriction(false)
+  : mFinalized(false),
+    mDeliberatelyIgnoreFriction(false),
+    mFactorizationCache(std::make_shared<LCPFactorizationCache>())
 {
   mTimeStep = timeStep;
   assert(mClampingConstraints.size() == 0);
@@ -63,7 +66,7 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   mMassedImpulseTests.reserve(mNumConstraintDim);
 
   // Cache an inverse mass matrix for later use
-  mMinv = Eigen::MatrixXd::Zero(mNumDOFs, mNumDOFs);
+  mMinv = BlockDiagonalMassMatrix::createInvMassMatrix(skeletons);
   mCoriolisAndGravityForces = Eigen::VectorXd::Zero(mNumDOFs);
   mPreStepTorques = Eigen::VectorXd::Zero(mNumDOFs);
   mPreStepVelocities = Eigen::VectorXd::Zero(mNumDOFs);
@@ -72,7 +75,6 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   for (auto skel : skeletons)
   {
     int dofs = skel->getNumDofs();
-    mMinv.block(cursor, cursor, dofs, dofs) = skel->getInvMassMatrix();
     // TODO: does this break everything?
     mCoriolisAndGravityForces.segment(cursor, dofs)
         = skel->getCoriolisAndGravityForces() - skel->getExternalForces();
@@ -87,6 +89,7 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     int numDofs, int numConstraintDim, double timeStep)
+  : mFactorizationCache(std::make_shared<LCPFactorizationCache>())
 {
   mNumDOFs = numDofs;
   mNumConstraintDim = numConstraintDim;
@@ -265,7 +268,7 @@ bool ConstrainedGroupGradientMatrices::opportunisticallyStandardizeResults(
     }
   */
 
-  Eigen::VectorXd f_c = Q.completeOrthogonalDecomposition().solve(b);
+  Eigen::VectorXd f_c = mFactorizationCache->factor(Q)->solve(b);
   Eigen::VectorXd originalF_c = getClampingConstraintImpulses();
 
   bool anyNewlyNotClamping = false;
@@ -847,7 +850,7 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getForceVelJacobian(
   Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix();
   Eigen::MatrixXd E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd P_c = getProjectionIntoClampsMatrix();
-  Eigen::MatrixXd Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
 
   if (A_ub.size() > 0 && E.size() > 0)
   {
@@ -863,7 +866,7 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getForceVelJacobian(
   }
   else
   {
-    return mTimeStep * Minv;
+    return mTimeStep * Minv.toDense();
   }
 }
 
@@ -879,9 +882,9 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getVelVelJacobian(
   }
   Eigen::MatrixXd E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd P_c = getProjectionIntoClampsMatrix();
-  Eigen::MatrixXd Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXd parts1 = A_c + A_ub * E;
-  Eigen::MatrixXd parts2 = mTimeStep * Minv * parts1 * P_c;
+  Eigen::MatrixXd parts2 = mTimeStep * (Minv * parts1) * P_c;
   /*
   std::cout << "A_c: " << std::endl << A_c << std::endl;
   std::cout << "A_ub: " << std::endl << A_ub << std::endl;
@@ -995,35 +998,32 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getVelCJacobian(
 //==============================================================================
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getMassMatrix(WorldPtr world)
 {
-  Eigen::MatrixXd massMatrix = Eigen::MatrixXd::Zero(mNumDOFs, mNumDOFs);
-  massMatrix.setZero();
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(mSkeletons[i]);
-    std::size_t skelDOF = skel->getNumDofs();
-    massMatrix.block(cursor, cursor, skelDOF, skelDOF) = skel->getMassMatrix();
-    cursor += skelDOF;
-  }
-  return massMatrix;
+  return getBlockMassMatrix(world).toDense();
 }
 
 //==============================================================================
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getInvMassMatrix(
     WorldPtr world)
 {
-  Eigen::MatrixXd invMassMatrix = Eigen::MatrixXd::Zero(mNumDOFs, mNumDOFs);
-  invMassMatrix.setZero();
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(mSkeletons[i]);
-    std::size_t skelDOF = skel->getNumDofs();
-    invMassMatrix.block(cursor, cursor, skelDOF, skelDOF)
-        = skel->getInvMassMatrix();
-    cursor += skelDOF;
-  }
-  return invMassMatrix;
+  return getBlockInvMassMatrix(world).toDense();
+}
+
+//==============================================================================
+/// This returns the mass matrix for the group, storing only the diagonal
+/// blocks (one per tree of each skeleton)
+BlockDiagonalMassMatrix ConstrainedGroupGradientMatrices::getBlockMassMatrix(
+    WorldPtr world)
+{
+  return BlockDiagonalMassMatrix::createMassMatrix(getSkeletons(world));
+}
+
+//==============================================================================
+/// This returns the inverse mass matrix for the group, storing only the
+/// diagonal blocks (one per tree of each skeleton)
+BlockDiagonalMassMatrix
+ConstrainedGroupGradientMatrices::getBlockInvMassMatrix(WorldPtr world)
+{
+  return BlockDiagonalMassMatrix::createInvMassMatrix(getSkeletons(world));
 }
 
 //==============================================================================
@@ -1045,35 +1045,55 @@ ConstrainedGroupGradientMatrices::getProjectionIntoClampsMatrix()
   Eigen::MatrixXd forceToVel
       = A_c.eval().transpose() * constraintForceToImpliedTorques;
   Eigen::MatrixXd velToForce
-      = forceToVel.completeOrthogonalDecomposition().pseudoInverse();
+      = mFactorizationCache->factor(forceToVel)->getPseudoInverse();
   Eigen::MatrixXd bounce = getBounceDiagonals().asDiagonal();
   return (1.0 / mTimeStep) * velToForce * bounce * A_c.transpose();
 }
 
 //==============================================================================
-/// This computes and returns the whole pos-vel jacobian. For backprop, you
-/// don't actually need this matrix, you can compute backprop directly. This
-/// is here if you want access to the full Jacobian for some reason.
+/// This computes this group's block of BackpropSnapshot::getVelJacobianWrt().
+/// The rows are the group's DOFs, and the columns are `wrt` over the group's
+/// skeletons, both in the order of getSkeletons(). The world must already be
+/// in its pre-step state. This only reads and writes the state of the group's
+/// own skeletons, so different groups can compute this concurrently.
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getVelJacobianWrt(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
+  std::size_t wrtDim = getWrtDim(world, wrt);
+  if (wrtDim == 0)
+  {
+    return Eigen::MatrixXd::Zero(mNumDOFs, 0);
+  }
+
   const Eigen::MatrixXd& A_c = getClampingConstraintMatrix();
   const Eigen::MatrixXd& A_ub = getUpperBoundConstraintMatrix();
   const Eigen::MatrixXd& E = getUpperBoundMappingMatrix();
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
 
   Eigen::VectorXd tau = mPreStepTorques;
-  Eigen::VectorXd C = mCoriolisAndGravityForces;
+  Eigen::VectorXd C = getCoriolisAndGravityLessExternalForces(world);
   Eigen::VectorXd f_c = getClampingConstraintImpulses();
   double dt = world->getTimeStep();
 
-  Eigen::MatrixXd dM
-      = getJacobianOfMinv(world, dt * (tau - C) + A_c_ub_E * f_c, wrt);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+
+  Eigen::MatrixXd dF_c = getBouncedJacobianOfConstraintForce(world, wrt);
+
+  if (wrt == WithRespectTo::FORCE)
+  {
+    return Minv * (A_c_ub_E * dF_c) + dt * Minv.toDense();
+  }
 
-  Eigen::MatrixXd Minv = world->getInvMassMatrix();
   Eigen::MatrixXd dC = getJacobianOfC(world, wrt);
 
-  Eigen::MatrixXd dF_c = getJacobianOfConstraintForce(world, wrt);
+  if (wrt == WithRespectTo::VELOCITY)
+  {
+    return Eigen::MatrixXd::Identity(mNumDOFs, mNumDOFs)
+           + Minv * (A_c_ub_E * dF_c - dt * dC);
+  }
+
+  Eigen::MatrixXd dM
+      = getJacobianOfMinv(world, dt * (tau - C) + A_c_ub_E * f_c, wrt);
 
   if (wrt == WithRespectTo::POSITION)
   {
@@ -1087,6 +1107,185 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getVelJacobianWrt(
   }
 }
 
+//==============================================================================
+/// This is the group's block of
+/// BackpropSnapshot::getJacobianOfConstraintForce()
+Eigen::MatrixXd
+ConstrainedGroupGradientMatrices::getBouncedJacobianOfConstraintForce(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  const Eigen::MatrixXd& A_c = getClampingConstraintMatrix();
+  if (A_c.cols() == 0)
+  {
+    int wrtDim = getWrtDim(world, wrt);
+    return Eigen::MatrixXd::Zero(0, wrtDim);
+  }
+  const Eigen::MatrixXd& A_ub = getUpperBoundConstraintMatrix();
+  const Eigen::MatrixXd& E = getUpperBoundMappingMatrix();
+
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+  Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
+  Eigen::MatrixXd Q = A_c.transpose() * Minv * A_c_ub_E;
+
+  std::shared_ptr<const LCPFactorization> Qfac
+      = mFactorizationCache->factor(Q);
+
+  Eigen::MatrixXd dB
+      = getBouncedJacobianOfLCPOffsetClampingSubset(world, wrt);
+
+  if (wrt == WithRespectTo::VELOCITY || wrt == WithRespectTo::FORCE)
+  {
+    // dQ_b is 0, so don't compute it
+    return Qfac->solve(dB);
+  }
+
+  Eigen::VectorXd b = getClampingConstraintRelativeVels();
+  Eigen::MatrixXd dQ_b
+      = getPseudoInverseJacobianOfLCPConstraintMatrixClampingSubset(
+          world, b, wrt);
+
+  return dQ_b + Qfac->solve(dB);
+}
+
+//==============================================================================
+/// This is the group's block of
+/// BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset()
+Eigen::MatrixXd ConstrainedGroupGradientMatrices::
+    getPseudoInverseJacobianOfLCPConstraintMatrixClampingSubset(
+        simulation::WorldPtr world, Eigen::VectorXd b, WithRespectTo* wrt)
+{
+  const Eigen::MatrixXd& A_c = mClampingConstraintMatrix;
+  if (A_c.cols() == 0)
+  {
+    return Eigen::MatrixXd::Zero(0, 0);
+  }
+  if (wrt == WithRespectTo::VELOCITY || wrt == WithRespectTo::FORCE)
+  {
+    return Eigen::MatrixXd::Zero(A_c.cols(), A_c.cols());
+  }
+  const Eigen::MatrixXd& A_ub = mUpperBoundConstraintMatrix;
+  const Eigen::MatrixXd& E = mUpperBoundMappingMatrix;
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+  Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
+
+  Eigen::MatrixXd Q = A_c.transpose() * Minv * A_c_ub_E;
+  std::shared_ptr<const LCPFactorization> Qfactored
+      = mFactorizationCache->factor(Q);
+
+  if (wrt == WithRespectTo::POSITION)
+  {
+    const Eigen::MatrixXd& Qinv = Qfactored->getPseudoInverse();
+    Eigen::MatrixXd I = Eigen::MatrixXd::Identity(Q.rows(), Q.cols());
+
+    // Position is the only term that affects A_c and A_ub. This is the same
+    // gradient of the pseudoinverse as in
+    // BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(), just
+    // restricted to this group.
+
+    if (A_ub.cols() > 0)
+    {
+
+#define dQ(rhs)                                                                \
+  (getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c_ub_E * rhs))   \
+   + (A_c.transpose()                                                          \
+      * (getJacobianOfMinv(world, A_c_ub_E * rhs, wrt)                         \
+         + (Minv                                                               \
+            * (getJacobianOfClampingConstraints(world, rhs)                    \
+               + getJacobianOfUpperBoundConstraints(world, E * rhs))))))
+
+#define dQT(rhs)                                                               \
+  ((getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c * rhs))       \
+    + (A_c.transpose()                                                         \
+       * (getJacobianOfMinv(world, A_c * rhs, wrt)                             \
+          + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))         \
+   + (E.transpose()                                                            \
+      * (getJacobianOfUpperBoundConstraintsTranspose(                          \
+            world, Minv * (A_c * rhs))                                         \
+         + A_ub.transpose()                                                    \
+               * (getJacobianOfMinv(world, A_c * rhs, wrt)                     \
+                  + (Minv                                                      \
+                     * (getJacobianOfClampingConstraints(world, rhs)))))))
+
+      return -Qinv * dQ(Qinv * b)
+             + Qinv * Qinv.transpose() * dQT((I - Q * Qinv) * b)
+             + (I - Qinv * Q) * dQT(Qinv.transpose() * Qinv * b);
+
+#undef dQ
+#undef dQT
+    }
+    else
+    {
+
+      // A_ub = 0 here
+
+#define dQ(rhs)                                                                \
+  (getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c * rhs))        \
+   + (A_c.transpose()                                                          \
+      * (getJacobianOfMinv(world, A_c * rhs, wrt)                              \
+         + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))
+
+#define dQT(rhs) dQ(rhs)
+
+      return -Qinv * dQ(Qinv * b)
+             + Qinv * Qinv.transpose() * dQT((I - Q * Qinv) * b)
+             + (I - Qinv * Q) * dQT(Qinv.transpose() * Qinv * b);
+
+#undef dQ
+#undef dQT
+    }
+  }
+  else
+  {
+    // All other terms get to treat A_c and A_ub as constant
+    Eigen::VectorXd Qinv_b = Qfactored->solve(b);
+    Eigen::MatrixXd innerTerms
+        = A_c.transpose() * getJacobianOfMinv(world, A_c * Qinv_b, wrt);
+    return -Qfactored->solve(innerTerms);
+  }
+}
+
+//==============================================================================
+/// This is the group's block of
+/// BackpropSnapshot::getJacobianOfLCPOffsetClampingSubset()
+Eigen::MatrixXd
+ConstrainedGroupGradientMatrices::getBouncedJacobianOfLCPOffsetClampingSubset(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  double dt = world->getTimeStep();
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
+  const Eigen::MatrixXd& A_c = mClampingConstraintMatrix;
+  Eigen::MatrixXd dC = getJacobianOfC(world, wrt);
+  if (wrt == WithRespectTo::VELOCITY)
+  {
+    return mBounceDiagonals.asDiagonal() * -A_c.transpose()
+           * (Eigen::MatrixXd::Identity(mNumDOFs, mNumDOFs)
+              - dt * (Minv * dC));
+  }
+  else if (wrt == WithRespectTo::FORCE)
+  {
+    return mBounceDiagonals.asDiagonal() * -A_c.transpose() * dt * Minv;
+  }
+
+  Eigen::VectorXd C = getCoriolisAndGravityLessExternalForces(world);
+  Eigen::VectorXd f = mPreStepTorques - C;
+  Eigen::MatrixXd dMinv_f = getJacobianOfMinv(world, f, wrt);
+  const Eigen::VectorXd& v_f = mPreLCPVelocities;
+
+  if (wrt == WithRespectTo::POSITION)
+  {
+    Eigen::MatrixXd dA_c_f
+        = getJacobianOfClampingConstraintsTranspose(world, v_f);
+
+    return mBounceDiagonals.asDiagonal()
+           * -(dA_c_f + A_c.transpose() * dt * (dMinv_f - Minv * dC));
+  }
+  else
+  {
+    return mBounceDiagonals.asDiagonal()
+           * -(A_c.transpose() * dt * (dMinv_f - Minv * dC));
+  }
+}
+
 //==============================================================================
 /// This returns the jacobian of constraint force, holding everyhing constant
 /// except the value of WithRespectTo
@@ -1106,12 +1305,12 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getJacobianOfConstraintForce(
   Eigen::MatrixXd dQ_b
       = getJacobianOfLCPConstraintMatrixClampingSubset(world, b, wrt);
 
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> Qfac
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const LCPFactorization> Qfac
+      = mFactorizationCache->factor(Q);
 
   Eigen::MatrixXd dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
-  return dQ_b + Qfac.solve(dB);
+  return dQ_b + Qfac->solve(dB);
 }
 
 //==============================================================================
@@ -1132,15 +1331,15 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::
   }
   const Eigen::MatrixXd& A_ub = mUpperBoundConstraintMatrix;
   const Eigen::MatrixXd& E = mUpperBoundMappingMatrix;
-  const Eigen::MatrixXd& Minv = getInvMassMatrix(world);
+  BlockDiagonalMassMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
 
   Eigen::MatrixXd Q = A_c.transpose() * Minv * A_c_ub_E;
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const LCPFactorization> Qfactored
+      = mFactorizationCache->factor(Q);
 
   // This is a proxy for f_c
-  Eigen::VectorXd Qinv_b = Qfactored.solve(b);
+  Eigen::VectorXd Qinv_b = Qfactored->solve(b);
 
   if (wrt == WithRespectTo::POSITION)
   {
@@ -1149,14 +1348,14 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::
     {
       Eigen::MatrixXd innerTerms
           = getJacobianOfClampingConstraintsTranspose(
-                world, mMinv * A_c_ub_E * Qinv_b)
+                world, mMinv * (A_c_ub_E * Qinv_b))
             + A_c.transpose()
                   * (getJacobianOfMinv(world, A_c_ub_E * Qinv_b, wrt)
                      + mMinv
                            * (getJacobianOfClampingConstraints(world, Qinv_b)
                               + getJacobianOfUpperBoundConstraints(
                                   world, E * Qinv_b)));
-      Eigen::MatrixXd result = -Qfactored.solve(innerTerms);
+      Eigen::MatrixXd result = -Qfactored->solve(innerTerms);
       return result;
     }
     else
@@ -1164,11 +1363,11 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::
       // If A_ub is empty, this doesn't matter
       Eigen::MatrixXd innerTerms
           = getJacobianOfClampingConstraintsTranspose(
-                world, mMinv * A_c * Qinv_b)
+                world, mMinv * (A_c * Qinv_b))
             + A_c.transpose()
                   * (getJacobianOfMinv(world, A_c * Qinv_b, wrt)
                      + mMinv * getJacobianOfClampingConstraints(world, Qinv_b));
-      Eigen::MatrixXd result = -Qfactored.solve(innerTerms);
+      Eigen::MatrixXd result = -Qfactored->solve(innerTerms);
       return result;
     }
   }
@@ -1177,7 +1376,7 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::
     // All other terms get to treat A_c and A_ub as constant
     Eigen::MatrixXd innerTerms
         = A_c.transpose() * getJacobianOfMinv(world, A_c * Qinv_b, wrt);
-    Eigen::MatrixXd result = -Qfactored.solve(innerTerms);
+    Eigen::MatrixXd result = -Qfactored->solve(innerTerms);
     return result;
   }
 }
@@ -1194,17 +1393,19 @@ ConstrainedGroupGradientMatrices::getJacobianOfLCPOffsetClampingSubset(
   if (wrt == WithRespectTo::VELOCITY)
   {
     return -A_c.transpose()
-           * (Eigen::MatrixXd::Identity(mNumDOFs, mNumDOFs) + dt * mMinv * dC);
+           * (Eigen::MatrixXd::Identity(mNumDOFs, mNumDOFs)
+              + dt * (mMinv * dC));
   }
   else if (wrt == WithRespectTo::FORCE)
   {
-    return -A_c.transpose() * dt * mMinv;
+    return -dt * (A_c.transpose() * mMinv);
   }
 
   const Eigen::VectorXd& C = mCoriolisAndGravityForces;
   Eigen::VectorXd f = mPreStepTorques - C;
   Eigen::MatrixXd dMinv_f = getJacobianOfMinv(world, f, wrt);
-  Eigen::VectorXd v_f = mPreStepVelocities + (world->getTimeStep() * mMinv * f);
+  Eigen::VectorXd v_f
+      = mPreStepVelocities + (world->getTimeStep() * (mMinv * f));
 
   if (wrt == WithRespectTo::POSITION)
   {
@@ -1277,7 +1478,24 @@ ConstrainedGroupGradientMatrices::estimateClampingConstraintImpulses(
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getJacobianOfMinv(
     simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt)
 {
-  return finiteDifferenceJacobianOfMinv(world, tau, wrt);
+  Eigen::MatrixXd result
+      = Eigen::MatrixXd::Zero(mNumDOFs, getWrtDim(world, wrt));
+  std::size_t dofCursor = 0;
+  std::size_t wrtCursor = 0;
+  for (std::string skelName : mSkeletons)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(skelName).get();
+    std::size_t dofs = skel->getNumDofs();
+    std::size_t wrtDim = wrt->dim(skel);
+    if (dofs > 0 && wrtDim > 0)
+    {
+      result.block(dofCursor, wrtCursor, dofs, wrtDim)
+          = skel->getJacobianOfMinv(tau.segment(dofCursor, dofs), wrt);
+    }
+    dofCursor += dofs;
+    wrtCursor += wrtDim;
+  }
+  return result;
 }
 
 //==============================================================================
@@ -1286,7 +1504,24 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::getJacobianOfMinv(
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getJacobianOfC(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
-  return finiteDifferenceJacobianOfC(world, wrt);
+  Eigen::MatrixXd result
+      = Eigen::MatrixXd::Zero(mNumDOFs, getWrtDim(world, wrt));
+  std::size_t dofCursor = 0;
+  std::size_t wrtCursor = 0;
+  for (std::string skelName : mSkeletons)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(skelName).get();
+    std::size_t dofs = skel->getNumDofs();
+    std::size_t wrtDim = wrt->dim(skel);
+    if (dofs > 0 && wrtDim > 0)
+    {
+      result.block(dofCursor, wrtCursor, dofs, wrtDim)
+          = BackpropSnapshot::getSkeletonJacobianOfC(skel, wrt);
+    }
+    dofCursor += dofs;
+    wrtCursor += wrtDim;
+  }
+  return result;
 }
 
 //==============================================================================
@@ -1304,7 +1539,8 @@ ConstrainedGroupGradientMatrices::getJacobianOfClampingConstraints(
   assert(constraints.size() == f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += f0(i) * constraints[i]->getConstraintForcesJacobian(skels);
+    constraints[i]->getConstraintForcesJacobianBlock(skels).addTo(
+        result, f0(i));
   }
 
   return result;
@@ -1324,8 +1560,9 @@ ConstrainedGroupGradientMatrices::getJacobianOfClampingConstraintsTranspose(
   Eigen::MatrixXd result = Eigen::MatrixXd::Zero(constraints.size(), mNumDOFs);
   for (int i = 0; i < constraints.size(); i++)
   {
-    result.row(i)
-        = constraints[i]->getConstraintForcesJacobian(world).transpose() * v0;
+    result.row(i) = constraints[i]
+                        ->getConstraintForcesJacobianBlock(skels)
+                        .transposeTimes(v0);
   }
 
   return result;
@@ -1346,11 +1583,34 @@ ConstrainedGroupGradientMatrices::getJacobianOfUpperBoundConstraints(
   assert(constraints.size() == f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += f0(i) * constraints[i]->getConstraintForcesJacobian(skels);
+    constraints[i]->getConstraintForcesJacobianBlock(skels).addTo(
+        result, f0(i));
   }
   return result;
 }
 
+//==============================================================================
+/// This computes the Jacobian of A_ub^T*v0 with respect to position using
+/// impulse tests.
+Eigen::MatrixXd ConstrainedGroupGradientMatrices::
+    getJacobianOfUpperBoundConstraintsTranspose(
+        simulation::WorldPtr world, Eigen::VectorXd v0)
+{
+  std::vector<std::shared_ptr<dynamics::Skeleton>> skels = getSkeletons(world);
+
+  std::vector<std::shared_ptr<DifferentiableContactConstraint>> constraints
+      = getUpperBoundConstraints();
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(constraints.size(), mNumDOFs);
+  for (int i = 0; i < constraints.size(); i++)
+  {
+    result.row(i) = constraints[i]
+                        ->getConstraintForcesJacobianBlock(skels)
+                        .transposeTimes(v0);
+  }
+
+  return result;
+}
+
 //==============================================================================
 /// This replaces x with the result of M*x in place, without explicitly forming
 /// M
@@ -1668,11 +1928,39 @@ const Eigen::VectorXd& ConstrainedGroupGradientMatrices::getPreLCPVelocity()
 
 //==============================================================================
 /// Returns the M^{-1} matrix from pre-step
-const Eigen::MatrixXd& ConstrainedGroupGradientMatrices::getMinv() const
+Eigen::MatrixXd ConstrainedGroupGradientMatrices::getMinv() const
+{
+  return mMinv.toDense();
+}
+
+//==============================================================================
+/// Returns the M^{-1} matrix from pre-step, storing only the diagonal blocks
+/// (one per tree of each skeleton)
+const BlockDiagonalMassMatrix& ConstrainedGroupGradientMatrices::getBlockMinv()
+    const
 {
   return mMinv;
 }
 
+//==============================================================================
+/// Returns the cache we use to share factorizations of Q between all the
+/// gradient computations for this group
+std::shared_ptr<LCPFactorizationCache>
+ConstrainedGroupGradientMatrices::getFactorizationCache() const
+{
+  return mFactorizationCache;
+}
+
+//==============================================================================
+/// This replaces the factorization cache. The ConstraintSolver uses this to
+/// warm-start our cache with the factorizations from this group's previous
+/// timestep.
+void ConstrainedGroupGradientMatrices::setFactorizationCache(
+    std::shared_ptr<LCPFactorizationCache> cache)
+{
+  mFactorizationCache = cache;
+}
+
 //==============================================================================
 /// Get the coriolis and gravity forces
 const Eigen::VectorXd
@@ -1691,6 +1979,27 @@ ConstrainedGroupGradientMatrices::getCoriolisAndGravityAndExternalForces(
   return result;
 }
 
+//==============================================================================
+/// Get the coriolis and gravity forces, less the external forces, in the
+/// world's current state. This is this group's segment of
+/// World::getCoriolisAndGravityAndExternalForces().
+Eigen::VectorXd
+ConstrainedGroupGradientMatrices::getCoriolisAndGravityLessExternalForces(
+    simulation::WorldPtr world) const
+{
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(mNumDOFs);
+  int cursor = 0;
+  for (std::string skelName : mSkeletons)
+  {
+    std::shared_ptr<dynamics::Skeleton> skel = world->getSkeleton(skelName);
+    int dofs = skel->getNumDofs();
+    result.segment(cursor, dofs)
+        = skel->getCoriolisAndGravityForces() - skel->getExternalForces();
+    cursor += dofs;
+  }
+  return result;
+}
+
 //==============================================================================
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getFullConstraintMatrix(
     simulation::World* world) const
@@ -1749,8 +2058,7 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::finiteDifferenceJacobianOfC(
 {
   std::size_t innerDim = getWrtDim(world, wrt);
 
-  // These are predicted contact forces at the clamping contacts
-  Eigen::VectorXd original = world->getCoriolisAndGravityAndExternalForces();
+  Eigen::VectorXd original = getCoriolisAndGravityLessExternalForces(world);
 
   Eigen::MatrixXd result = Eigen::MatrixXd::Zero(original.size(), innerDim);
 
@@ -1763,11 +2071,11 @@ Eigen::MatrixXd ConstrainedGroupGradientMatrices::finiteDifferenceJacobianOfC(
     Eigen::VectorXd perturbed = before;
     perturbed(i) += EPS;
     setWrt(world, wrt, perturbed);
-    Eigen::MatrixXd tauPos = world->getCoriolisAndGravityAndExternalForces();
+    Eigen::MatrixXd tauPos = getCoriolisAndGravityLessExternalForces(world);
     perturbed = before;
     perturbed(i) -= EPS;
     setWrt(world, wrt, perturbed);
-    Eigen::MatrixXd tauNeg = world->getCoriolisAndGravityAndExternalForces();
+    Eigen::MatrixXd tauNeg = getCoriolisAndGravityLessExternalForces(world);
     Eigen::VectorXd diff = tauPos - tauNeg;
     result.col(i) = diff / (2 * EPS);
   }
@@ -8,7 +8,9 @@
 
 #include <Eigen/Dense>
 
+#include "dart/neural/BlockDiagonalMassMatrix.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/LCPFactorization.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/simulation/World.hpp"
@@ -165,13 +167,24 @@ public:
   /// concatenation of the skeleton inverse mass matrices.
   Eigen::MatrixXd getInvMassMatrix(simulation::WorldPtr world);
 
+  /// This returns the mass matrix for the group, storing only the diagonal
+  /// blocks (one per tree of each skeleton)
+  BlockDiagonalMassMatrix getBlockMassMatrix(simulation::WorldPtr world);
+
+  /// This returns the inverse mass matrix for the group, storing only the
+  /// diagonal blocks (one per tree of each skeleton)
+  BlockDiagonalMassMatrix getBlockInvMassMatrix(simulation::WorldPtr world);
+
   /// This returns the P_c matrix. You shouldn't ever need this matrix, it's
   /// just here to enable testing.
   Eigen::MatrixXd getProjectionIntoClampsMatrix();
 
-  /// This computes and returns the whole pos-vel jacobian. For backprop, you
-  /// don't actually need this matrix, you can compute backprop directly. This
-  /// is here if you want access to the full Jacobian for some reason.
+  /// This computes this group's block of
+  /// BackpropSnapshot::getVelJacobianWrt(). The rows are the group's DOFs, and
+  /// the columns are `wrt` over the group's skeletons, both in the order of
+  /// getSkeletons(). The world must already be in its pre-step state. This
+  /// only reads and writes the state of the group's own skeletons, so
+  /// different groups can compute this concurrently.
   Eigen::MatrixXd getVelJacobianWrt(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
@@ -236,6 +249,11 @@ public:
   Eigen::MatrixXd getJacobianOfUpperBoundConstraints(
       simulation::WorldPtr world, Eigen::VectorXd f0);
 
+  /// This computes the Jacobian of A_ub^T*v0 with respect to position using
+  /// impulse tests.
+  Eigen::MatrixXd getJacobianOfUpperBoundConstraintsTranspose(
+      simulation::WorldPtr world, Eigen::VectorXd v0);
+
   /// This computes the implicit backprop without forming intermediate
   /// Jacobians. It takes a LossGradient with the position and velocity vectors
   /// filled it, though the loss with respect to torque is ignored and can be
@@ -312,7 +330,20 @@ public:
   const Eigen::VectorXd& getPreLCPVelocity() const;
 
   /// Returns the M^{-1} matrix from pre-step
-  const Eigen::MatrixXd& getMinv() const;
+  Eigen::MatrixXd getMinv() const;
+
+  /// Returns the M^{-1} matrix from pre-step, storing only the diagonal blocks
+  /// (one per tree of each skeleton)
+  const BlockDiagonalMassMatrix& getBlockMinv() const;
+
+  /// Returns the cache we use to share factorizations of Q between all the
+  /// gradient computations for this group
+  std::shared_ptr<LCPFactorizationCache> getFactorizationCache() const;
+
+  /// This replaces the factorization cache. The ConstraintSolver uses this to
+  /// warm-start our cache with the factorizations from this group's previous
+  /// timestep.
+  void setFactorizationCache(std::shared_ptr<LCPFactorizationCache> cache);
 
   /// Get the coriolis and gravity forces
   const Eigen::VectorXd getCoriolisAndGravityAndExternalForces(
@@ -364,6 +395,27 @@ private:
   std::vector<std::shared_ptr<dynamics::Skeleton>> getSkeletons(
       simulation::WorldPtr world);
 
+  /// These are the group's blocks of the BackpropSnapshot getters of the same
+  /// names, which getVelJacobianWrt() needs to match the world-level
+  /// Jacobians. Unlike the public getters above, they include the bounce
+  /// approximation in the LCP offset, measure the offset from the pre-LCP
+  /// velocities, and differentiate the pseudo-inverse of Q.
+
+  Eigen::MatrixXd getBouncedJacobianOfConstraintForce(
+      simulation::WorldPtr world, WithRespectTo* wrt);
+
+  Eigen::MatrixXd getPseudoInverseJacobianOfLCPConstraintMatrixClampingSubset(
+      simulation::WorldPtr world, Eigen::VectorXd b, WithRespectTo* wrt);
+
+  Eigen::MatrixXd getBouncedJacobianOfLCPOffsetClampingSubset(
+      simulation::WorldPtr world, WithRespectTo* wrt);
+
+  /// Get the coriolis and gravity forces, less the external forces, in the
+  /// world's current state. This is this group's segment of
+  /// World::getCoriolisAndGravityAndExternalForces().
+  Eigen::VectorXd getCoriolisAndGravityLessExternalForces(
+      simulation::WorldPtr world) const;
+
 public:
   /// This is only true after we've called constructMatrices(). It's a useful
   /// flag to ensure we don't call it twice.
@@ -426,7 +478,10 @@ public:
   Eigen::MatrixXd mClampingAMatrix;
 
   /// This is the inverse mass matrix computed in the constuctor
-  Eigen::MatrixXd mMinv;
+  BlockDiagonalMassMatrix mMinv;
+
+  /// This caches factorizations of Q, so we only factor it once
+  std::shared_ptr<LCPFactorizationCache> mFactorizationCache;
 
   /// These are the coriolis and gravity forces, computed in the constuctor
   Eigen::VectorXd mCoriolisAndGravityForces;
@@ -4,6 +4,7 @@
 #include "dart/constraint/ConstraintBase.hpp"
 #include "dart/constraint/ContactConstraint.hpp"
 #include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -17,6 +18,54 @@ namespace dart {
 using namespace constraint;
 namespace neural {
 
+//==============================================================================
+void DofBlockJacobian::addTo(Eigen::MatrixXd& out, double scale) const
+{
+  for (int col = 0; col < dofs.size(); col++)
+  {
+    for (int row = 0; row < dofs.size(); row++)
+    {
+      out(dofs[row], dofs[col]) += scale * block(row, col);
+    }
+  }
+}
+
+//==============================================================================
+Eigen::VectorXd DofBlockJacobian::times(const Eigen::VectorXd& v) const
+{
+  Eigen::VectorXd vBlock = Eigen::VectorXd(dofs.size());
+  for (int i = 0; i < dofs.size(); i++)
+    vBlock(i) = v(dofs[i]);
+  Eigen::VectorXd resultBlock = block * vBlock;
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(v.size());
+  for (int i = 0; i < dofs.size(); i++)
+    result(dofs[i]) = resultBlock(i);
+  return result;
+}
+
+//==============================================================================
+Eigen::VectorXd DofBlockJacobian::transposeTimes(const Eigen::VectorXd& v) const
+{
+  Eigen::VectorXd vBlock = Eigen::VectorXd(dofs.size());
+  for (int i = 0; i < dofs.size(); i++)
+    vBlock(i) = v(dofs[i]);
+  Eigen::VectorXd resultBlock = block.transpose() * vBlock;
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(v.size());
+  for (int i = 0; i < dofs.size(); i++)
+    result(dofs[i]) = resultBlock(i);
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXd DofBlockJacobian::toDense(int dim) const
+{
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dim, dim);
+  addTo(result);
+  return result;
+}
+
 //==============================================================================
 DifferentiableContactConstraint::DifferentiableContactConstraint(
     std::shared_ptr<constraint::ConstraintBase> constraint,
@@ -1381,29 +1430,116 @@ double DifferentiableContactConstraint::getConstraintForceDerivative(
 Eigen::MatrixXd DifferentiableContactConstraint::getConstraintForcesJacobian(
     std::shared_ptr<simulation::World> world)
 {
-  int dim = world->getNumDofs();
-  math::Jacobian forceJac = getContactForceJacobian(world);
+  return getConstraintForcesJacobianBlock(world).toDense(world->getNumDofs());
+}
+
+//==============================================================================
+DofBlockJacobian
+DifferentiableContactConstraint::getConstraintForcesJacobianBlock(
+    std::shared_ptr<simulation::World> world)
+{
+  std::vector<std::shared_ptr<dynamics::Skeleton>> skels;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    skels.push_back(world->getSkeleton(i));
+  return getConstraintForcesJacobianBlock(skels);
+}
+
+//==============================================================================
+DofBlockJacobian
+DifferentiableContactConstraint::getConstraintForcesJacobianBlock(
+    const std::vector<std::shared_ptr<dynamics::Skeleton>>& skels)
+{
+  DofBlockJacobian result;
+  result.dofs = getContactChainDofs(skels);
+
+  // Look up the DOF objects for each index in the chain
+  std::vector<dynamics::DegreeOfFreedom*> dofs;
+  dofs.reserve(result.dofs.size());
+  int offset = 0;
+  std::size_t cursor = 0;
+  for (auto skel : skels)
+  {
+    int skelDofs = skel->getNumDofs();
+    while (cursor < result.dofs.size()
+           && result.dofs[cursor] < offset + skelDofs)
+    {
+      dofs.push_back(skel->getDof(result.dofs[cursor] - offset));
+      cursor++;
+    }
+    offset += skelDofs;
+  }
+  assert(dofs.size() == result.dofs.size());
+
+  const int dim = dofs.size();
   Eigen::Vector6d force = getWorldForce();
+  // These are the columns of getContactForceJacobian(), just for the DOFs in
+  // the chain
+  math::Jacobian forceJac = math::Jacobian::Zero(6, dim);
+  for (int wrt = 0; wrt < dim; wrt++)
+  {
+    forceJac.col(wrt) = getContactWorldForceGradient(dofs[wrt]);
+  }
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dim, dim);
-  std::vector<dynamics::DegreeOfFreedom*> dofs = world->getDofs();
+  result.block = Eigen::MatrixXd::Zero(dim, dim);
   for (int row = 0; row < dim; row++)
   {
+    double multiple = getForceMultiple(dofs[row]);
+    // DOFs upstream of both bodies in a self-collision cancel out
+    if (multiple == 0)
+      continue;
     Eigen::Vector6d axis = getWorldScrewAxisForForce(dofs[row]);
     for (int wrt = 0; wrt < dim; wrt++)
     {
       Eigen::Vector6d screwAxisGradient
           = getScrewAxisForForceGradient(dofs[row], dofs[wrt]);
-      Eigen::Vector6d forceGradient = forceJac.col(wrt);
-      double multiple = getForceMultiple(dofs[row]);
-      result(row, wrt)
-          = multiple * (screwAxisGradient.dot(force) + axis.dot(forceGradient));
+      result.block(row, wrt)
+          = multiple
+            * (screwAxisGradient.dot(force) + axis.dot(forceJac.col(wrt)));
     }
   }
 
   return result;
 }
 
+//==============================================================================
+std::vector<int> DifferentiableContactConstraint::getContactChainDofs(
+    const std::vector<std::shared_ptr<dynamics::Skeleton>>& skels)
+{
+  std::vector<int> chain;
+  int offset = 0;
+  for (auto skel : skels)
+  {
+    if (!mConstraint->isContactConstraint())
+    {
+      // Without a contact we don't know which bodies are involved, so we
+      // conservatively include everything
+      for (int i = 0; i < skel->getNumDofs(); i++)
+        chain.push_back(offset + i);
+    }
+    else
+    {
+      std::vector<std::size_t> skelChain;
+      for (const dynamics::BodyNode* body :
+           {mContactConstraint->getBodyNodeA(),
+            mContactConstraint->getBodyNodeB()})
+      {
+        if (body->getSkeleton()->getName() != skel->getName())
+          continue;
+        const std::vector<std::size_t>& dependent
+            = body->getDependentGenCoordIndices();
+        skelChain.insert(skelChain.end(), dependent.begin(), dependent.end());
+      }
+      std::sort(skelChain.begin(), skelChain.end());
+      skelChain.erase(
+          std::unique(skelChain.begin(), skelChain.end()), skelChain.end());
+      for (std::size_t index : skelChain)
+        chain.push_back(offset + static_cast<int>(index));
+    }
+    offset += skel->getNumDofs();
+  }
+  return chain;
+}
+
 //==============================================================================
 /// This computes and returns the analytical Jacobian relating how changes in
 /// the positions of wrt's DOFs changes the constraint forces on skel.
@@ -1484,17 +1620,7 @@ Eigen::MatrixXd DifferentiableContactConstraint::getConstraintForcesJacobian(
   for (auto skel : skels)
     dofs += skel->getNumDofs();
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dofs, dofs);
-
-  int cursor = 0;
-  for (auto skel : skels)
-  {
-    result.block(0, cursor, dofs, skel->getNumDofs())
-        = getConstraintForcesJacobian(skels, skel);
-    cursor += skel->getNumDofs();
-  }
-
-  return result;
+  return getConstraintForcesJacobianBlock(skels).toDense(dofs);
 }
 
 //==============================================================================
@@ -69,6 +69,29 @@ struct EdgeData
   Eigen::Vector3d edgeBDir;
 };
 
+/// A contact only moves the DOFs on the kinematic chains of the two bodies in
+/// contact, so its Jacobians are zero outside of a (usually small) set of rows
+/// and columns. This stores just that dense block, along with the indices of
+/// the DOFs (into the concatenated DOFs of the skeletons it was computed over)
+/// that the rows and columns of the block correspond to.
+struct DofBlockJacobian
+{
+  std::vector<int> dofs;
+  Eigen::MatrixXd block;
+
+  /// This adds `scale` times this Jacobian into the full `out` matrix
+  void addTo(Eigen::MatrixXd& out, double scale = 1.0) const;
+
+  /// This returns (J * v), where J is the full Jacobian
+  Eigen::VectorXd times(const Eigen::VectorXd& v) const;
+
+  /// This returns (J^T * v), where J is the full Jacobian
+  Eigen::VectorXd transposeTimes(const Eigen::VectorXd& v) const;
+
+  /// This expands the block back out to a full dim x dim Jacobian
+  Eigen::MatrixXd toDense(int dim) const;
+};
+
 class DifferentiableContactConstraint
 {
 
@@ -204,6 +227,25 @@ public:
   Eigen::MatrixXd getConstraintForcesJacobian(
       std::vector<std::shared_ptr<dynamics::Skeleton>> skels);
 
+  /// This returns the same Jacobian as getConstraintForcesJacobian(world), but
+  /// only evaluates and stores the rows and columns for DOFs that are parents
+  /// of one of the bodies in contact, since all the others are zero. This
+  /// scales with the size of the contact's kinematic chains, rather than the
+  /// number of DOFs in the world.
+  DofBlockJacobian getConstraintForcesJacobianBlock(
+      std::shared_ptr<simulation::World> world);
+
+  /// This is the same as getConstraintForcesJacobianBlock(world), but the DOF
+  /// indices are into the concatenated DOFs of `skels`.
+  DofBlockJacobian getConstraintForcesJacobianBlock(
+      const std::vector<std::shared_ptr<dynamics::Skeleton>>& skels);
+
+  /// This returns the indices (into the concatenated DOFs of `skels`) of all
+  /// the DOFs that are parents of either of the bodies in this contact, in
+  /// ascending order.
+  std::vector<int> getContactChainDofs(
+      const std::vector<std::shared_ptr<dynamics::Skeleton>>& skels);
+
   /// This returns the skeletons that this contact constraint interacts with.
   const std::vector<std::shared_ptr<dynamics::Skeleton>>& getSkeletons();
 
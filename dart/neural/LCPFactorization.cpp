@@ -0,0 +1,162 @@
+#include "dart/neural/LCPFactorization.hpp"
+
+#include <algorithm>
+
+namespace dart {
+namespace neural {
+
+// Q must be this close to symmetric, relative to its largest entry, before we
+// try to factor it with LDLT
+#define LCP_FACTORIZATION_SYMMETRY_TOLERANCE 1e-10
+// The smallest pivot in D, relative to the largest, before we consider Q to be
+// rank-deficient and fall back to the complete orthogonal decomposition
+#define LCP_FACTORIZATION_RANK_TOLERANCE 1e-10
+
+//==============================================================================
+LCPFactorization::LCPFactorization(const Eigen::MatrixXd& Q)
+  : mQ(Q), mUseLDLT(false), mIsExactlySymmetric(false)
+{
+  if (Q.size() > 0 && Q.rows() == Q.cols())
+  {
+    Eigen::MatrixXd asymmetry = Q - Q.transpose();
+    double scale = Q.cwiseAbs().maxCoeff();
+    double maxAsymmetry = asymmetry.cwiseAbs().maxCoeff();
+    if (maxAsymmetry <= LCP_FACTORIZATION_SYMMETRY_TOLERANCE * scale)
+    {
+      mIsExactlySymmetric = (maxAsymmetry == 0);
+      if (mIsExactlySymmetric)
+      {
+        mLDLT.compute(Q);
+      }
+      else
+      {
+        mLDLT.compute(0.5 * (Q + Q.transpose()));
+      }
+      if (mLDLT.info() == Eigen::Success && mLDLT.isPositive())
+      {
+        Eigen::VectorXd D = mLDLT.vectorD();
+        mUseLDLT = D.minCoeff()
+                   > LCP_FACTORIZATION_RANK_TOLERANCE * D.maxCoeff();
+      }
+    }
+  }
+
+  if (!mUseLDLT)
+  {
+    mCOD.compute(Q);
+  }
+}
+
+//==============================================================================
+/// Returns true if this factorization was computed from exactly (bitwise) Q
+bool LCPFactorization::isFactorizationOf(const Eigen::MatrixXd& Q) const
+{
+  if (Q.rows() != mQ.rows() || Q.cols() != mQ.cols())
+    return false;
+  return std::equal(Q.data(), Q.data() + Q.size(), mQ.data());
+}
+
+//==============================================================================
+/// Returns the matrix we factored
+const Eigen::MatrixXd& LCPFactorization::getMatrix() const
+{
+  return mQ;
+}
+
+//==============================================================================
+/// Returns true if we were able to use LDLT, false if we fell back to the
+/// complete orthogonal decomposition
+bool LCPFactorization::isUsingLDLT() const
+{
+  return mUseLDLT;
+}
+
+//==============================================================================
+/// This returns the pseudo-inverse of Q. This is computed the first time it's
+/// asked for, and then cached.
+const Eigen::MatrixXd& LCPFactorization::getPseudoInverse() const
+{
+  std::call_once(mPseudoInverseOnce, [this]() {
+    if (mUseLDLT)
+    {
+      // Q has full rank, so the pseudo-inverse is just the inverse
+      mPseudoInverse
+          = solve(Eigen::MatrixXd::Identity(mQ.rows(), mQ.cols()).eval());
+    }
+    else
+    {
+      mPseudoInverse = mCOD.pseudoInverse();
+    }
+  });
+  return mPseudoInverse;
+}
+
+//==============================================================================
+LCPFactorizationCache::LCPFactorizationCache(std::size_t capacity)
+  : mCapacity(std::max<std::size_t>(capacity, 1)), mNumHits(0), mNumMisses(0)
+{
+}
+
+//==============================================================================
+LCPFactorizationCache::LCPFactorizationCache(
+    const LCPFactorizationCache& previous)
+  : mNumHits(0), mNumMisses(0)
+{
+  const std::lock_guard<std::mutex> lock(previous.mMutex);
+  mCapacity = previous.mCapacity;
+  mEntries = previous.mEntries;
+}
+
+//==============================================================================
+/// Returns a factorization of Q, reusing a cached one if we've already factored
+/// a bitwise identical matrix.
+std::shared_ptr<const LCPFactorization> LCPFactorizationCache::factor(
+    const Eigen::MatrixXd& Q)
+{
+  {
+    const std::lock_guard<std::mutex> lock(mMutex);
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+    {
+      if ((*it)->isFactorizationOf(Q))
+      {
+        std::shared_ptr<const LCPFactorization> hit = *it;
+        mEntries.erase(it);
+        mEntries.push_front(hit);
+        mNumHits++;
+        return hit;
+      }
+    }
+  }
+
+  // Factor outside the lock, since this is the expensive part
+  std::shared_ptr<const LCPFactorization> factored
+      = std::make_shared<LCPFactorization>(Q);
+
+  const std::lock_guard<std::mutex> lock(mMutex);
+  mNumMisses++;
+  mEntries.push_front(factored);
+  while (mEntries.size() > mCapacity)
+  {
+    mEntries.pop_back();
+  }
+  return factored;
+}
+
+//==============================================================================
+/// Returns the number of calls to factor() that found a cached factorization
+int LCPFactorizationCache::getNumHits() const
+{
+  const std::lock_guard<std::mutex> lock(mMutex);
+  return mNumHits;
+}
+
+//==============================================================================
+/// Returns the number of calls to factor() that had to factor from scratch
+int LCPFactorizationCache::getNumMisses() const
+{
+  const std::lock_guard<std::mutex> lock(mMutex);
+  return mNumMisses;
+}
+
+} // namespace neural
+} // namespace dart
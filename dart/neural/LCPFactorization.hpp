@@ -0,0 +1,154 @@
+#ifndef DART_NEURAL_LCP_FACTORIZATION_HPP_
+#define DART_NEURAL_LCP_FACTORIZATION_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace neural {
+
+/// This is a factorization of the clamping-subset LCP matrix Q (which relates
+/// clamping constraint forces to constraint velocities). All the gradient
+/// getters need to solve against Q, so we factor it once and share the result.
+///
+/// Q = A_c^T M^{-1} (A_c + A_ub E) is symmetric positive definite whenever
+/// there are no upper bound constraints and A_c has full column rank, which is
+/// by far the most common case. Then we use an LDLT factorization, which is
+/// much cheaper than the complete orthogonal decomposition. Otherwise (Q is
+/// non-symmetric, or numerically rank-deficient) we fall back to the complete
+/// orthogonal decomposition, which gives the least-squares minimal solution the
+/// rest of the code expects.
+class LCPFactorization
+{
+public:
+  /// This factors Q
+  explicit LCPFactorization(const Eigen::MatrixXd& Q);
+
+  LCPFactorization(const LCPFactorization&) = delete;
+  LCPFactorization& operator=(const LCPFactorization&) = delete;
+
+  /// Returns true if this factorization was computed from exactly (bitwise) Q
+  bool isFactorizationOf(const Eigen::MatrixXd& Q) const;
+
+  /// Returns the matrix we factored
+  const Eigen::MatrixXd& getMatrix() const;
+
+  /// Returns true if we were able to use LDLT, false if we fell back to the
+  /// complete orthogonal decomposition
+  bool isUsingLDLT() const;
+
+  /// This returns Q^{-1} * rhs, or the least-squares minimal solution if Q is
+  /// rank-deficient
+  template <typename Derived>
+  Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime> solve(
+      const Eigen::MatrixBase<Derived>& rhs) const
+  {
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime>
+        ResultType;
+    if (!mUseLDLT)
+    {
+      return mCOD.solve(rhs);
+    }
+    ResultType x = mLDLT.solve(rhs);
+    if (!mIsExactlySymmetric)
+    {
+      // We factored the symmetric part of Q, so take one step of iterative
+      // refinement to recover the accuracy we'd get from solving against Q
+      // itself.
+      ResultType residual = rhs - mQ * x;
+      x += mLDLT.solve(residual);
+    }
+    return x;
+  }
+
+  /// This returns Q^{-T} * rhs, or the least-squares minimal solution if Q is
+  /// rank-deficient. This is what backprop needs to push a gradient back
+  /// through a solve against Q, without ever forming Q^{-1}.
+  template <typename Derived>
+  Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime>
+  solveTranspose(const Eigen::MatrixBase<Derived>& rhs) const
+  {
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime>
+        ResultType;
+    if (!mUseLDLT)
+    {
+      // pinv(Q)^T == pinv(Q^T)
+      return getPseudoInverse().transpose() * rhs;
+    }
+    ResultType x = mLDLT.solve(rhs);
+    if (!mIsExactlySymmetric)
+    {
+      ResultType residual = rhs - mQ.transpose() * x;
+      x += mLDLT.solve(residual);
+    }
+    return x;
+  }
+
+  /// This returns the pseudo-inverse of Q. This is computed the first time
+  /// it's asked for, and then cached.
+  const Eigen::MatrixXd& getPseudoInverse() const;
+
+protected:
+  Eigen::MatrixXd mQ;
+  bool mUseLDLT;
+  bool mIsExactlySymmetric;
+  Eigen::LDLT<Eigen::MatrixXd> mLDLT;
+  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> mCOD;
+
+  mutable std::once_flag mPseudoInverseOnce;
+  mutable Eigen::MatrixXd mPseudoInverse;
+};
+
+/// This is a small cache of LCPFactorization objects, keyed on the exact
+/// contents of the matrix being factored. Each ConstrainedGroupGradientMatrices
+/// and BackpropSnapshot holds one of these, so that all the gradient getters on
+/// that object (which each rebuild Q from the same inputs) only pay for one
+/// factorization.
+///
+/// A cache can also be warm-started from the cache of the same constrained
+/// group on the previous timestep. If that timestep had the same clamping set,
+/// and nothing that Q depends on has changed (which happens, for example, when
+/// finite differencing with respect to velocity or force, or re-running
+/// rollouts from the same state), then we skip factoring entirely.
+class LCPFactorizationCache
+{
+public:
+  /// This creates an empty cache, holding up to `capacity` factorizations
+  explicit LCPFactorizationCache(std::size_t capacity = 4);
+
+  /// This creates a cache that starts with the factorizations held by
+  /// `previous`. The factorizations themselves are immutable, so they're
+  /// shared rather than copied, and later changes to either cache don't affect
+  /// the other.
+  LCPFactorizationCache(const LCPFactorizationCache& previous);
+
+  LCPFactorizationCache& operator=(const LCPFactorizationCache&) = delete;
+
+  /// Returns a factorization of Q, reusing a cached one if we've already
+  /// factored a bitwise identical matrix. This is safe to call from multiple
+  /// threads.
+  std::shared_ptr<const LCPFactorization> factor(const Eigen::MatrixXd& Q);
+
+  /// Returns the number of calls to factor() that found a cached factorization
+  int getNumHits() const;
+
+  /// Returns the number of calls to factor() that had to factor from scratch
+  int getNumMisses() const;
+
+protected:
+  std::size_t mCapacity;
+  /// Most recently used at the front
+  std::deque<std::shared_ptr<const LCPFactorization>> mEntries;
+  int mNumHits;
+  int mNumMisses;
+  mutable std::mutex mMutex;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
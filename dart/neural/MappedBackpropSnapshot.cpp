@@ -280,6 +280,57 @@ void MappedBackpropSnapshot::backprop(
 #endif
 }
 
+//==============================================================================
+/// This is the forward-mode counterpart of backprop(). It pushes tangents on
+/// this timestep's inputs, expressed in `mapBefore`, forward to tangents on
+/// the next position and velocity, expressed in `mapAfter`. Each column is
+/// one direction. Masses don't support mappings, so `tangentMass` is passed
+/// straight through to BackpropSnapshot::jvp().
+StateTangent MappedBackpropSnapshot::jvp(
+    simulation::WorldPtr world,
+    const std::string& mapBefore,
+    const std::string& mapAfter,
+    const Eigen::MatrixXd& tangentPos,
+    const Eigen::MatrixXd& tangentVel,
+    const Eigen::MatrixXd& tangentForce,
+    const Eigen::MatrixXd& tangentMass,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MAPPED_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("MappedBackpropSnapshot.jvp");
+  }
+#endif
+
+  const PreStepMapping& before = mPreStepMappings[mapBefore];
+  const PostStepMapping& after = mPostStepMappings[mapAfter];
+
+  StateTangent real = mBackpropSnapshot->jvp(
+      world,
+      before.posOutJac * tangentPos,
+      before.velOutJac * tangentVel,
+      before.forceOutJac * tangentForce,
+      tangentMass,
+      thisLog);
+
+  StateTangent mapped;
+  mapped.position = after.posInJacWrtPos * real.position
+                    + after.posInJacWrtVel * real.velocity;
+  mapped.velocity = after.velInJacWrtVel * real.velocity
+                    + after.velInJacWrtPos * real.position;
+
+#ifdef LOG_PERFORMANCE_MAPPED_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return mapped;
+}
+
 //==============================================================================
 /// Returns a concatenated vector of all the Skeletons' position()'s in the
 /// World, in order in which the Skeletons appear in the World's
@@ -146,6 +146,21 @@ public:
       const std::unordered_map<std::string, LossGradient> nextTimestepLosses,
       PerformanceLog* perfLog = nullptr);
 
+  /// This is the forward-mode counterpart of backprop(). It pushes tangents on
+  /// this timestep's inputs, expressed in `mapBefore`, forward to tangents on
+  /// the next position and velocity, expressed in `mapAfter`. Each column is
+  /// one direction. Masses don't support mappings, so `tangentMass` is passed
+  /// straight through to BackpropSnapshot::jvp().
+  StateTangent jvp(
+      simulation::WorldPtr world,
+      const std::string& mapBefore,
+      const std::string& mapAfter,
+      const Eigen::MatrixXd& tangentPos,
+      const Eigen::MatrixXd& tangentVel,
+      const Eigen::MatrixXd& tangentForce,
+      const Eigen::MatrixXd& tangentMass,
+      PerformanceLog* perfLog = nullptr);
+
   /// Returns a concatenated vector of all the Skeletons' position()'s in the
   /// World, in order in which the Skeletons appear in the World's
   /// getSkeleton(i) returns them, BEFORE the timestep.
@@ -29,6 +29,15 @@ struct LossGradient
   Eigen::VectorXd lossWrtMass;
 };
 
+/// This is the result of pushing tangent directions forward through a
+/// timestep (or a whole rollout). Each column is the tangent of the resulting
+/// position and velocity along one input direction.
+struct StateTangent
+{
+  Eigen::MatrixXd position;
+  Eigen::MatrixXd velocity;
+};
+
 // We don't issue a full import here, because we want this file to be safe to
 // import from anywhere else in DART
 class ConstrainedGroupGradientMatrices;
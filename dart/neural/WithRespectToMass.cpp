@@ -2,6 +2,7 @@
 
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/Geometry.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
@@ -21,7 +22,7 @@ WrtMassBodyNodyEntry::WrtMassBodyNodyEntry(
 }
 
 //==============================================================================
-int WrtMassBodyNodyEntry::dim()
+int WrtMassBodyNodyEntry::dim() const
 {
   if (type == INERTIA_MASS)
     return 1;
@@ -39,7 +40,7 @@ int WrtMassBodyNodyEntry::dim()
 
 //==============================================================================
 void WrtMassBodyNodyEntry::set(
-    dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXd>& value)
+    dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXd>& value) const
 {
   dynamics::BodyNode* node = skel->getBodyNode(linkName);
   if (type == INERTIA_MASS)
@@ -115,7 +116,7 @@ void WrtMassBodyNodyEntry::set(
 
 //==============================================================================
 void WrtMassBodyNodyEntry::get(
-    dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXd> out)
+    dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXd> out) const
 {
   dynamics::BodyNode* node = skel->getBodyNode(linkName);
   if (type == INERTIA_MASS)
@@ -156,6 +157,58 @@ void WrtMassBodyNodyEntry::get(
   }
 }
 
+//==============================================================================
+Eigen::Matrix6d WrtMassBodyNodyEntry::getSpatialInertiaGradient(
+    dynamics::Skeleton* skel, int index) const
+{
+  assert(index >= 0 && index < dim());
+  dynamics::BodyNode* node = skel->getBodyNode(linkName);
+  const double mass = node->getMass();
+  const Eigen::Matrix3d C
+      = math::makeSkewSymmetric(node->getInertia().getLocalCOM());
+
+  // Map the index onto the INERTIA_FULL layout, which is [mass, com (3),
+  // diagonal (3), off diagonal (3)]
+  int fullIndex = index;
+  if (type == INERTIA_COM)
+    fullIndex = 1 + index;
+  else if (type == INERTIA_DIAGONAL)
+    fullIndex = 4 + index;
+  else if (type == INERTIA_OFF_DIAGONAL)
+    fullIndex = 7 + index;
+
+  // This follows the layout of Inertia::computeSpatialTensor()
+  Eigen::Matrix6d grad = Eigen::Matrix6d::Zero();
+  if (fullIndex == 0)
+  {
+    grad.block<3, 3>(0, 0) = C * C.transpose();
+    grad.block<3, 3>(3, 0) = C.transpose();
+    grad.block<3, 3>(0, 3) = C;
+    grad.block<3, 3>(3, 3) = Eigen::Matrix3d::Identity();
+  }
+  else if (fullIndex < 4)
+  {
+    const Eigen::Matrix3d E = math::makeSkewSymmetric(
+        Eigen::Vector3d::Unit(fullIndex - 1));
+    grad.block<3, 3>(0, 0) = mass * (E * C.transpose() + C * E.transpose());
+    grad.block<3, 3>(3, 0) = mass * E.transpose();
+    grad.block<3, 3>(0, 3) = mass * E;
+  }
+  else if (fullIndex < 7)
+  {
+    grad(fullIndex - 4, fullIndex - 4) = 1.0;
+  }
+  else
+  {
+    // I_XY, I_XZ, I_YZ
+    const int rows[3] = {0, 0, 1};
+    const int cols[3] = {1, 2, 2};
+    grad(rows[fullIndex - 7], cols[fullIndex - 7]) = 1.0;
+    grad(cols[fullIndex - 7], rows[fullIndex - 7]) = 1.0;
+  }
+  return grad;
+}
+
 //==============================================================================
 /// This registers that we'd like to keep track of this node's mass in this
 /// way in this differentiation
@@ -165,6 +218,8 @@ WrtMassBodyNodyEntry& WithRespectToMass::registerNode(
     Eigen::VectorXd upperBound,
     Eigen::VectorXd lowerBound)
 {
+  // This is the only place we insert into mEntries. Everything else looks
+  // entries up with find(), so concurrent readers never mutate the map.
   std::string skelName = node->getSkeleton()->getName();
   std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skelName];
   skelEntries.emplace_back(node->getName(), type);
@@ -204,13 +259,15 @@ WrtMassBodyNodyEntry& WithRespectToMass::registerNode(
 /// This returns the entry object corresponding to this node
 WrtMassBodyNodyEntry& WithRespectToMass::getNode(dynamics::BodyNode* node)
 {
-  std::string skelName = node->getSkeleton()->getName();
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skelName];
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  auto skelEntries = mEntries.find(node->getSkeleton()->getName());
+  if (skelEntries != mEntries.end())
   {
-    if (entry.linkName == node->getName())
+    for (WrtMassBodyNodyEntry& entry : skelEntries->second)
     {
-      return entry;
+      if (entry.linkName == node->getName())
+      {
+        return entry;
+      }
     }
   }
   assert(false);
@@ -219,6 +276,21 @@ WrtMassBodyNodyEntry& WithRespectToMass::getNode(dynamics::BodyNode* node)
   throw std::runtime_error{"Execution should never reach this point"};
 }
 
+//==============================================================================
+const std::vector<WrtMassBodyNodyEntry>& WithRespectToMass::getNodes(
+    dynamics::Skeleton* skel) const
+{
+  auto skelEntries = mEntries.find(skel->getName());
+  if (skelEntries == mEntries.end())
+  {
+    // Skeletons without any registered nodes all share this empty list,
+    // which is const so nobody can add to it through here
+    static const std::vector<WrtMassBodyNodyEntry> noEntries;
+    return noEntries;
+  }
+  return skelEntries->second;
+}
+
 //==============================================================================
 /// This returns this WRT from the world as a vector
 Eigen::VectorXd WithRespectToMass::get(simulation::World* world)
@@ -241,13 +313,13 @@ Eigen::VectorXd WithRespectToMass::get(simulation::World* world)
 /// This returns this WRT from this skeleton as a vector
 Eigen::VectorXd WithRespectToMass::get(dynamics::Skeleton* skel)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
+  const std::vector<WrtMassBodyNodyEntry>& skelEntries = getNodes(skel);
   if (skelEntries.size() == 0)
     return Eigen::VectorXd::Zero(0);
   int cursor = 0;
   int skelDim = dim(skel);
   Eigen::VectorXd result = Eigen::VectorXd::Zero(skelDim);
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  for (const WrtMassBodyNodyEntry& entry : skelEntries)
   {
     entry.get(skel, result.segment(cursor, entry.dim()));
     cursor += entry.dim();
@@ -275,11 +347,11 @@ void WithRespectToMass::set(simulation::World* world, Eigen::VectorXd value)
 /// This sets the skeleton's state based on our WRT
 void WithRespectToMass::set(dynamics::Skeleton* skel, Eigen::VectorXd value)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
+  const std::vector<WrtMassBodyNodyEntry>& skelEntries = getNodes(skel);
   if (skelEntries.size() == 0)
     return;
   int cursor = 0;
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  for (const WrtMassBodyNodyEntry& entry : skelEntries)
   {
     entry.set(skel, value.segment(cursor, entry.dim()));
     cursor += entry.dim();
@@ -303,9 +375,9 @@ int WithRespectToMass::dim(simulation::World* world)
 /// This gives the dimensions of the WRT
 int WithRespectToMass::dim(dynamics::Skeleton* skel)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
+  const std::vector<WrtMassBodyNodyEntry>& skelEntries = getNodes(skel);
   int skelDim = 0;
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  for (const WrtMassBodyNodyEntry& entry : skelEntries)
   {
     skelDim += entry.dim();
   }
@@ -8,6 +8,8 @@
 
 #include <Eigen/Dense>
 
+#include "dart/math/MathTypes.hpp"
+
 #include "dart/neural/WithRespectTo.hpp"
 
 namespace dart {
@@ -38,11 +40,17 @@ struct WrtMassBodyNodyEntry
 
   WrtMassBodyNodyEntry(std::string linkName, WrtMassBodyNodeEntryType type);
 
-  int dim();
+  int dim() const;
+
+  void get(dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXd> out) const;
 
-  void get(dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXd> out);
+  void set(
+      dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXd>& val) const;
 
-  void set(dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXd>& val);
+  /// This returns the derivative of the node's spatial inertia tensor with
+  /// respect to the `index`'th value of this entry
+  Eigen::Matrix6d getSpatialInertiaGradient(
+      dynamics::Skeleton* skel, int index) const;
 };
 
 class WithRespectToMass : public WithRespectTo
@@ -62,6 +70,12 @@ public:
   /// assertion if this node doesn't exist
   WrtMassBodyNodyEntry& getNode(dynamics::BodyNode* node);
 
+  /// This returns all the entries registered for this skeleton, in the order
+  /// they appear in the WRT vector. This never inserts into our bookkeeping,
+  /// so the getters can be called from several threads at once.
+  const std::vector<WrtMassBodyNodyEntry>& getNodes(
+      dynamics::Skeleton* skel) const;
+
   //////////////////////////////////////////////////////////////
   // Implement all the methods we need
   //////////////////////////////////////////////////////////////
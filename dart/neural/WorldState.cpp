@@ -0,0 +1,137 @@
+#include "dart/neural/WorldState.hpp"
+
+#include <cassert>
+
+#include "dart/simulation/World.hpp"
+
+using namespace dart;
+using namespace simulation;
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+WorldState::WorldState() : mNumDofs(0), mMassDims(0), mLCPCacheSize(0)
+{
+}
+
+//==============================================================================
+/// This is the same as constructing an empty WorldState and calling save()
+WorldState::WorldState(std::shared_ptr<World> world) : WorldState()
+{
+  save(world);
+}
+
+//==============================================================================
+/// This copies the state of `world` into our buffer
+void WorldState::save(std::shared_ptr<World> world)
+{
+  // The LCP cache is the only piece whose size we don't know up front
+  Eigen::VectorXd lcpCache = world->getCachedLCPSolution();
+
+  mNumDofs = world->getNumDofs();
+  mMassDims = world->getMassDims();
+  mLCPCacheSize = lcpCache.size();
+
+  // This is a no-op if we're already the right size
+  mBuffer.resize(3 * mNumDofs + mMassDims + mLCPCacheSize);
+
+  mBuffer.segment(0, mNumDofs) = world->getPositions();
+  mBuffer.segment(mNumDofs, mNumDofs) = world->getVelocities();
+  mBuffer.segment(2 * mNumDofs, mNumDofs) = world->getExternalForces();
+  if (mMassDims > 0)
+  {
+    mBuffer.segment(3 * mNumDofs, mMassDims) = world->getMasses();
+  }
+  mBuffer.tail(mLCPCacheSize) = lcpCache;
+}
+
+//==============================================================================
+/// This copies our buffer into the state of `world`, which must have the
+/// same DOFs and mass dimensions as the world we saved from
+void WorldState::restore(std::shared_ptr<World> world) const
+{
+  assert(isCompatible(world));
+
+  world->setPositions(getPositions());
+  world->setVelocities(getVelocities());
+  world->setExternalForces(getExternalForces());
+  // Setting masses dirties the inertia of every tuned body, so don't bother
+  // if there's nothing to set
+  if (mMassDims > 0)
+  {
+    world->setMasses(getMasses());
+  }
+  world->setCachedLCPSolution(getCachedLCPSolution());
+}
+
+//==============================================================================
+/// Returns true if `world` has the same dimensions as the world we saved
+/// from, so restore() into it is valid
+bool WorldState::isCompatible(std::shared_ptr<World> world) const
+{
+  return static_cast<int>(world->getNumDofs()) == mNumDofs
+         && static_cast<int>(world->getMassDims()) == mMassDims;
+}
+
+//==============================================================================
+/// Returns the number of DOFs in the world we saved from
+int WorldState::getNumDofs() const
+{
+  return mNumDofs;
+}
+
+//==============================================================================
+/// Returns the number of mass dimensions in the world we saved from
+int WorldState::getMassDims() const
+{
+  return mMassDims;
+}
+
+//==============================================================================
+/// Returns the length of the cached LCP solution we saved, which can be 0
+int WorldState::getLCPCacheSize() const
+{
+  return mLCPCacheSize;
+}
+
+//==============================================================================
+/// Returns the whole flat buffer: positions, velocities, forces, masses and
+/// then the LCP cache
+const Eigen::VectorXd& WorldState::getBuffer() const
+{
+  return mBuffer;
+}
+
+//==============================================================================
+Eigen::Ref<const Eigen::VectorXd> WorldState::getPositions() const
+{
+  return mBuffer.segment(0, mNumDofs);
+}
+
+//==============================================================================
+Eigen::Ref<const Eigen::VectorXd> WorldState::getVelocities() const
+{
+  return mBuffer.segment(mNumDofs, mNumDofs);
+}
+
+//==============================================================================
+Eigen::Ref<const Eigen::VectorXd> WorldState::getExternalForces() const
+{
+  return mBuffer.segment(2 * mNumDofs, mNumDofs);
+}
+
+//==============================================================================
+Eigen::Ref<const Eigen::VectorXd> WorldState::getMasses() const
+{
+  return mBuffer.segment(3 * mNumDofs, mMassDims);
+}
+
+//==============================================================================
+Eigen::Ref<const Eigen::VectorXd> WorldState::getCachedLCPSolution() const
+{
+  return mBuffer.tail(mLCPCacheSize);
+}
+
+} // namespace neural
+} // namespace dart
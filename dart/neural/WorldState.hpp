@@ -0,0 +1,79 @@
+#ifndef DART_NEURAL_WORLD_STATE_HPP_
+#define DART_NEURAL_WORLD_STATE_HPP_
+
+#include <memory>
+
+#include <Eigen/Dense>
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+/// This is a compact, flat copy of the state of a World: positions,
+/// velocities, external forces, masses and the cached LCP solution, all in one
+/// contiguous buffer. Saving and restoring are both O(n) copies, and once the
+/// buffer has been sized, saving the same world again doesn't allocate.
+///
+/// The main use for this is keeping a pool of worker worlds (built once with
+/// World::clone()) in sync with a source world, which is much cheaper than
+/// cloning a fresh world every time we need one. Only state is copied, so the
+/// worlds must have been cloned from the same source, and any structural
+/// changes to the source (adding skeletons, changing gravity or the timestep,
+/// etc) after the clone are NOT carried over.
+///
+/// Unlike RestorableSnapshot, this doesn't hold onto a World, so one
+/// WorldState can be saved from one world and restored into many others.
+class WorldState
+{
+public:
+  WorldState();
+
+  /// This is the same as constructing an empty WorldState and calling save()
+  WorldState(std::shared_ptr<simulation::World> world);
+
+  /// This copies the state of `world` into our buffer
+  void save(std::shared_ptr<simulation::World> world);
+
+  /// This copies our buffer into the state of `world`, which must have the
+  /// same DOFs and mass dimensions as the world we saved from
+  void restore(std::shared_ptr<simulation::World> world) const;
+
+  /// Returns true if `world` has the same dimensions as the world we saved
+  /// from, so restore() into it is valid
+  bool isCompatible(std::shared_ptr<simulation::World> world) const;
+
+  /// Returns the number of DOFs in the world we saved from
+  int getNumDofs() const;
+
+  /// Returns the number of mass dimensions in the world we saved from
+  int getMassDims() const;
+
+  /// Returns the length of the cached LCP solution we saved, which can be 0
+  int getLCPCacheSize() const;
+
+  /// Returns the whole flat buffer: positions, velocities, forces, masses and
+  /// then the LCP cache
+  const Eigen::VectorXd& getBuffer() const;
+
+  Eigen::Ref<const Eigen::VectorXd> getPositions() const;
+  Eigen::Ref<const Eigen::VectorXd> getVelocities() const;
+  Eigen::Ref<const Eigen::VectorXd> getExternalForces() const;
+  Eigen::Ref<const Eigen::VectorXd> getMasses() const;
+  Eigen::Ref<const Eigen::VectorXd> getCachedLCPSolution() const;
+
+protected:
+  int mNumDofs;
+  int mMassDims;
+  int mLCPCacheSize;
+  Eigen::VectorXd mBuffer;
+};
+
+} // namespace neural
+
+} // namespace dart
+
+#endif
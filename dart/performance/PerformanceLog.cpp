@@ -1,11 +1,14 @@
 #include "dart/performance/PerformanceLog.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <ctime>
-#include <deque>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <mutex>
-#include <random>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -17,17 +20,123 @@ namespace dart {
 namespace performance {
 
 std::unordered_map<std::string, int> PerformanceLog::globalPerfStringIndex;
-std::deque<PerformanceLog*> PerformanceLog::globalPerfLogsList;
+std::vector<PerformanceLog*> PerformanceLog::globalPerfLogsList;
+std::unordered_map<int64_t, PerformanceLog*>
+    PerformanceLog::globalPerfLogsById;
 std::unordered_map<int, std::string>
     PerformanceLog::globalPerfStringReverseIndex;
+std::vector<std::unique_ptr<PerformanceLog::ThreadBuffer>>
+    PerformanceLog::globalPerfThreadBuffers;
 std::mutex PerformanceLog::globalPerfLogListMutex;
 
+//==============================================================================
+/// Each thread appends its runs to its own ThreadBuffer, so logging never
+/// takes a lock or allocates (beyond growing the buffer a block at a time)
+class PerformanceLog::ThreadBuffer
+{
+public:
+  /// How many PerformanceLogs we allocate at once
+  static constexpr long BLOCK_SIZE = 1024;
+
+  ThreadBuffer(long bufferIndex)
+    : mBufferIndex(bufferIndex),
+      mThreadId(0),
+      mInUse(false),
+      mSize(0),
+      mBegin(0)
+  {
+  }
+
+  /// This is where we live in globalPerfThreadBuffers
+  long mBufferIndex;
+
+  /// This is the logical id of the thread that currently owns us
+  int mThreadId;
+
+  /// This is true while a live thread owns us. Guarded by
+  /// globalPerfLogListMutex.
+  bool mInUse;
+
+  /// The runs we've logged, in blocks that never move once allocated, so the
+  /// pointers we hand out stay valid
+  std::vector<std::unique_ptr<PerformanceLog[]>> mBlocks;
+
+  /// How many runs we've logged. Only the owning thread writes this.
+  std::atomic<long> mSize;
+
+  /// Runs before this were cleared by initialize(). We keep their memory
+  /// around, since callers may still be holding pointers to them.
+  long mBegin;
+
+  /// This caches the results of mapStringToIndex() for this thread. Names
+  /// are almost always string literals, so we key by pointer, and check the
+  /// contents in case the pointer got reused for a different string.
+  std::unordered_map<const char*, std::pair<int, std::string>> mNameCache;
+};
+
+constexpr long PerformanceLog::ThreadBuffer::BLOCK_SIZE;
+
+//==============================================================================
+/// This hands a ThreadBuffer back when its thread exits, so that a later
+/// thread can adopt it rather than allocating a new one
+class PerformanceLog::ThreadBufferLease
+{
+public:
+  ThreadBufferLease() : mBuffer(nullptr)
+  {
+  }
+
+  ~ThreadBufferLease()
+  {
+    if (mBuffer != nullptr)
+    {
+      const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+      mBuffer->mInUse = false;
+    }
+  }
+
+  ThreadBuffer* mBuffer;
+};
+
+thread_local PerformanceLog::ThreadBufferLease
+    PerformanceLog::globalPerfThreadBufferLease;
+
+namespace {
+
+std::atomic<int> nextThreadId(0);
+
+//==============================================================================
+/// This escapes a string to go in a JSON string literal
+std::string escapeJson(const std::string& str)
+{
+  std::stringstream stream;
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+      stream << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      stream << ' ';
+    else
+      stream << c;
+  }
+  return stream.str();
+}
+
+} // namespace
+
 //==============================================================================
 void PerformanceLog::initialize()
 {
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
   globalPerfStringIndex = std::unordered_map<std::string, int>(30);
-  globalPerfLogsList = std::deque<PerformanceLog*>();
+  globalPerfLogsList.clear();
+  globalPerfLogsById.clear();
   globalPerfStringReverseIndex = std::unordered_map<int, std::string>(30);
+  for (std::unique_ptr<ThreadBuffer>& buffer : globalPerfThreadBuffers)
+  {
+    buffer->mBegin = buffer->mSize.load(std::memory_order_acquire);
+    buffer->mNameCache.clear();
+  }
 }
 
 //==============================================================================
@@ -56,38 +165,146 @@ inline uint64_t getClock()
 
 //==============================================================================
 /// Default constructor
-PerformanceLog::PerformanceLog(int nameIndex, int parentId)
+PerformanceLog::PerformanceLog(int nameIndex, int64_t parentId)
   : mNameIndex(nameIndex),
     mStartClock(getClock()),
     mEndClock(0),
-    mId(rand()),
-    mParentId(parentId)
+    mId(-2),
+    mParentId(parentId),
+    mThreadId(0)
 {
 }
 
 //==============================================================================
-PerformanceLog* PerformanceLog::startRoot(char const* name)
+/// This is used to allocate PerformanceLogs in blocks
+PerformanceLog::PerformanceLog()
+  : mNameIndex(0),
+    mStartClock(0),
+    mEndClock(0),
+    mId(-2),
+    mParentId(-1),
+    mThreadId(0)
 {
-  PerformanceLog* newRoot = new PerformanceLog(mapStringToIndex(name), -1);
-  // Serialize our access to the log list
+}
+
+//==============================================================================
+/// This returns the ThreadBuffer for the calling thread, creating one (or
+/// adopting one left behind by a thread that exited) the first time
+PerformanceLog::ThreadBuffer* PerformanceLog::getThreadBuffer()
+{
+  ThreadBuffer* buffer = globalPerfThreadBufferLease.mBuffer;
+  if (buffer != nullptr)
+    return buffer;
+
   const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(newRoot);
-  return newRoot;
+  for (std::unique_ptr<ThreadBuffer>& existing : globalPerfThreadBuffers)
+  {
+    if (!existing->mInUse)
+    {
+      buffer = existing.get();
+      break;
+    }
+  }
+  if (buffer == nullptr)
+  {
+    globalPerfThreadBuffers.emplace_back(
+        new ThreadBuffer(globalPerfThreadBuffers.size()));
+    buffer = globalPerfThreadBuffers.back().get();
+  }
+  buffer->mInUse = true;
+  buffer->mThreadId = nextThreadId++;
+
+  globalPerfThreadBufferLease.mBuffer = buffer;
+  return buffer;
 }
 
 //==============================================================================
-/// This looks through all the PerformanceLogs in the system and builds a
-/// report
-std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
-PerformanceLog::finalize()
+/// This allocates a new run on the calling thread's ThreadBuffer
+PerformanceLog* PerformanceLog::allocate(
+    char const* name, int64_t parentId)
+{
+  ThreadBuffer* buffer = getThreadBuffer();
+
+  int nameIndex;
+  auto cached = buffer->mNameCache.find(name);
+  if (cached != buffer->mNameCache.end() && cached->second.second == name)
+  {
+    nameIndex = cached->second.first;
+  }
+  else
+  {
+    // Only the first use of each name on each thread needs to serialize
+    const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+    nameIndex = mapStringToIndex(name);
+    buffer->mNameCache[name] = std::make_pair(nameIndex, std::string(name));
+  }
+
+  long index = buffer->mSize.load(std::memory_order_relaxed);
+  std::size_t block = index / ThreadBuffer::BLOCK_SIZE;
+  if (block >= buffer->mBlocks.size())
+  {
+    buffer->mBlocks.emplace_back(new PerformanceLog[ThreadBuffer::BLOCK_SIZE]);
+  }
+  PerformanceLog* log
+      = &buffer->mBlocks[block][index % ThreadBuffer::BLOCK_SIZE];
+  log->mNameIndex = nameIndex;
+  log->mEndClock = 0;
+  log->mId = (static_cast<int64_t>(buffer->mBufferIndex) << 32)
+              | static_cast<int64_t>(index);
+  log->mParentId = parentId;
+  log->mThreadId = buffer->mThreadId;
+  buffer->mSize.store(index + 1, std::memory_order_release);
+
+  // Read the clock last, so our own bookkeeping isn't counted in the run
+  log->mStartClock = getClock();
+  return log;
+}
+
+//==============================================================================
+PerformanceLog* PerformanceLog::startRoot(char const* name)
 {
-  // First we need to set up the reverse index so we can rapidly look up strings
+  return allocate(name, -1);
+}
+
+//==============================================================================
+/// This gathers the runs from every ThreadBuffer into globalPerfLogsList,
+/// and fills in globalPerfLogsById and globalPerfStringReverseIndex
+void PerformanceLog::collectLogs()
+{
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+
   globalPerfStringReverseIndex.clear();
   for (auto pair : globalPerfStringIndex)
   {
     globalPerfStringReverseIndex[pair.second] = pair.first;
   }
 
+  globalPerfLogsList.clear();
+  globalPerfLogsById.clear();
+  for (std::unique_ptr<ThreadBuffer>& buffer : globalPerfThreadBuffers)
+  {
+    long size = buffer->mSize.load(std::memory_order_acquire);
+    for (long i = buffer->mBegin; i < size; i++)
+    {
+      PerformanceLog* log
+          = &buffer->mBlocks[i / ThreadBuffer::BLOCK_SIZE]
+                            [i % ThreadBuffer::BLOCK_SIZE];
+      globalPerfLogsList.push_back(log);
+      globalPerfLogsById[log->mId] = log;
+    }
+  }
+}
+
+//==============================================================================
+/// This looks through all the PerformanceLogs in the system and builds a
+/// report
+std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+PerformanceLog::finalize()
+{
+  // First we need to gather up the logs from every thread, and set up the
+  // reverse index so we can rapidly look up strings
+  collectLogs();
+
   // Next we need to look through for all the root names:
   std::unordered_set<int> rootNameIds;
   for (PerformanceLog* log : globalPerfLogsList)
@@ -112,6 +329,106 @@ PerformanceLog::finalize()
   return rootLogs;
 }
 
+//==============================================================================
+/// This exports every run logged since initialize() in the Chrome
+/// trace-event JSON format, with one track per thread
+std::string PerformanceLog::toChromeTrace()
+{
+  collectLogs();
+
+  std::vector<PerformanceLog*> logs;
+  uint64_t firstClock = 0;
+  for (PerformanceLog* log : globalPerfLogsList)
+  {
+    // Skip runs that never ended
+    if (log->mEndClock == 0 || log->mEndClock < log->mStartClock)
+      continue;
+    if (logs.size() == 0 || log->mStartClock < firstClock)
+      firstClock = log->mStartClock;
+    logs.push_back(log);
+  }
+  std::sort(
+      logs.begin(), logs.end(), [](PerformanceLog* a, PerformanceLog* b) {
+        return a->mStartClock < b->mStartClock;
+      });
+
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  bool isFirst = true;
+  for (PerformanceLog* log : logs)
+  {
+    if (isFirst)
+      isFirst = false;
+    else
+      stream << ",";
+    double start
+        = PerfUtils::Cycles::toSeconds(log->mStartClock - firstClock) * 1e6;
+    double duration
+        = PerfUtils::Cycles::toSeconds(log->mEndClock - log->mStartClock)
+          * 1e6;
+    stream << "\n{\"name\":\""
+           << escapeJson(globalPerfStringReverseIndex[log->mNameIndex])
+           << "\",\"ph\":\"X\",\"ts\":" << start << ",\"dur\":" << duration
+           << ",\"pid\":0,\"tid\":" << log->mThreadId << "}";
+  }
+  stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return stream.str();
+}
+
+//==============================================================================
+/// This exports every run logged since initialize() in the "collapsed
+/// stacks" format that flamegraph.pl and speedscope read
+std::string PerformanceLog::toCollapsedStacks()
+{
+  collectLogs();
+
+  // Children can run in parallel on other threads, so this can overcount the
+  // time in children, in which case we just say the parent had no self time
+  std::unordered_map<int64_t, uint64_t> childCycles;
+  for (PerformanceLog* log : globalPerfLogsList)
+  {
+    if (log->mParentId != -1 && log->mEndClock != 0
+        && log->mEndClock >= log->mStartClock)
+      childCycles[log->mParentId] += log->mEndClock - log->mStartClock;
+  }
+
+  std::unordered_map<int64_t, std::string> stacks;
+  std::function<const std::string&(PerformanceLog*)> getStack
+      = [&](PerformanceLog* log) -> const std::string& {
+    auto cached = stacks.find(log->mId);
+    if (cached != stacks.end())
+      return cached->second;
+    std::string name = globalPerfStringReverseIndex[log->mNameIndex];
+    // ';' separates frames, and ' ' separates the stack from the count
+    std::replace(name.begin(), name.end(), ';', ':');
+    std::replace(name.begin(), name.end(), ' ', '_');
+    auto parent = globalPerfLogsById.find(log->mParentId);
+    if (parent != globalPerfLogsById.end())
+      name = getStack(parent->second) + ";" + name;
+    return stacks[log->mId] = name;
+  };
+
+  std::map<std::string, double> selfMicros;
+  for (PerformanceLog* log : globalPerfLogsList)
+  {
+    if (log->mEndClock == 0 || log->mEndClock < log->mStartClock)
+      continue;
+    uint64_t total = log->mEndClock - log->mStartClock;
+    uint64_t children = childCycles[log->mId];
+    uint64_t self = children < total ? total - children : 0;
+    selfMicros[getStack(log)] += PerfUtils::Cycles::toSeconds(self) * 1e6;
+  }
+
+  std::stringstream stream;
+  for (auto pair : selfMicros)
+  {
+    stream << pair.first << " "
+           << static_cast<uint64_t>(std::round(pair.second)) << "\n";
+  }
+  return stream.str();
+}
+
 //==============================================================================
 /// This checks if a given PerformanceLog object matches a stack of nameIds
 bool PerformanceLog::matches(std::vector<int> nameIdStack)
@@ -125,12 +442,10 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
   std::vector<int> subStack = nameIdStack;
   subStack.pop_back();
   // Find parent and recurse
-  for (PerformanceLog* log : globalPerfLogsList)
+  auto parent = globalPerfLogsById.find(mParentId);
+  if (parent != globalPerfLogsById.end())
   {
-    if (log->mId == mParentId)
-    {
-      return log->matches(subStack);
-    }
+    return parent->second->matches(subStack);
   }
 
   return false;
@@ -142,11 +457,7 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
 /// objects into something sensible.
 PerformanceLog* PerformanceLog::startRun(char const* name)
 {
-  PerformanceLog* log = new PerformanceLog(mapStringToIndex(name), mId);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(log);
-  return log;
+  return allocate(name, mId);
 }
 
 //==============================================================================
@@ -168,7 +479,7 @@ FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
           PerformanceLog::globalPerfStringReverseIndex
               [nameIdStack[nameIdStack.size() - 1]]);
 
-  std::unordered_set<int> selfIds;
+  std::unordered_set<int64_t> selfIds;
 
   // Scan through once looking for instances of us
 
@@ -219,10 +530,21 @@ FinalizedPerformanceLog::FinalizedPerformanceLog(const std::string& name)
 }
 
 //==============================================================================
+/// Returns the child with this name, or nullptr if there isn't one
 std::shared_ptr<FinalizedPerformanceLog> FinalizedPerformanceLog::getChild(
     const std::string& name)
 {
-  return mChildren[name];
+  auto child = mChildren.find(name);
+  if (child == mChildren.end())
+    return nullptr;
+  return child->second;
+}
+
+//==============================================================================
+/// Returns the number of distinct child names under this log
+int FinalizedPerformanceLog::getNumChildren()
+{
+  return mChildren.size();
 }
 
 //==============================================================================
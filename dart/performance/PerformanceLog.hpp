@@ -1,7 +1,7 @@
 #ifndef DART_PERFORMANCE_LOG_HPP_
 #define DART_PERFORMANCE_LOG_HPP_
 
-#include <deque>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -25,8 +25,12 @@ public:
 
   FinalizedPerformanceLog(const std::string& name);
 
+  /// Returns the child with this name, or nullptr if there isn't one
   std::shared_ptr<FinalizedPerformanceLog> getChild(const std::string& name);
 
+  /// Returns the number of distinct child names under this log
+  int getNumChildren();
+
   void setChild(
       const std::string& name, std::shared_ptr<FinalizedPerformanceLog> child);
 
@@ -64,7 +68,7 @@ class PerformanceLog
 
 public:
   /// Default constructor
-  PerformanceLog(int nameIndex, int parentId);
+  PerformanceLog(int nameIndex, int64_t parentId);
 
   /// Disable the copy constructor
   // PerformanceLog(const PerformanceLog&) = delete;
@@ -74,11 +78,26 @@ public:
 
   /// This looks through all the PerformanceLogs in the system and builds a
   /// report. This is not concerned about efficiency, and we attempt to offload
-  /// as much slowness from elsewhere into here as possible.
+  /// as much slowness from elsewhere into here as possible. This must not be
+  /// called while other threads are still logging.
   static std::
       unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       finalize();
 
+  /// This exports every run logged since initialize() in the Chrome
+  /// trace-event JSON format, with one track per thread, which you can load in
+  /// chrome://tracing or https://ui.perfetto.dev. Like finalize(), this must
+  /// not be called while other threads are still logging.
+  static std::string toChromeTrace();
+
+  /// This exports every run logged since initialize() in the "collapsed
+  /// stacks" format that flamegraph.pl and speedscope read: one line per
+  /// unique stack of run names, separated by ';', followed by the total time
+  /// spent in that run but not in its children, in microseconds. Like
+  /// finalize(), this must not be called while other threads are still
+  /// logging.
+  static std::string toCollapsedStacks();
+
   /// This checks if a given PerformanceLog object matches a stack of nameIds
   bool matches(std::vector<int> nameIdStack);
 
@@ -92,10 +111,33 @@ public:
   void end();
 
   /// This needs to be called once at the beginning of execution, and if it's
-  /// called multiple times will clear previous logs.
+  /// called multiple times will clear previous logs. This must not be called
+  /// while other threads are still logging.
   static void initialize();
 
 protected:
+  /// Each thread appends its runs to its own ThreadBuffer, so logging never
+  /// takes a lock or allocates (beyond growing the buffer a block at a time)
+  class ThreadBuffer;
+
+  /// This hands a ThreadBuffer back when its thread exits, so that a later
+  /// thread can adopt it rather than allocating a new one
+  class ThreadBufferLease;
+
+  /// This is used to allocate PerformanceLogs in blocks
+  PerformanceLog();
+
+  /// This allocates a new run on the calling thread's ThreadBuffer
+  static PerformanceLog* allocate(char const* name, int64_t parentId);
+
+  /// This returns the ThreadBuffer for the calling thread, creating one (or
+  /// adopting one left behind by a thread that exited) the first time
+  static ThreadBuffer* getThreadBuffer();
+
+  /// This gathers the runs from every ThreadBuffer into globalPerfLogsList,
+  /// and fills in globalPerfLogsById and globalPerfStringReverseIndex
+  static void collectLogs();
+
   /// Don't store a whole copy of the name, just a numerical key
   int mNameIndex;
 
@@ -105,18 +147,26 @@ protected:
   /// This is the clock when we called end()
   uint64_t mEndClock;
 
-  /// This is the ID which we'll use to reassemble the graph after the fact
-  int mId;
+  /// This is the ID which we'll use to reassemble the graph after the fact.
+  /// This is the index of our ThreadBuffer in the high 32 bits, and our index
+  /// within it in the low 32 bits, so it's unique without any coordination.
+  int64_t mId;
 
   /// This is the parent's ID
-  int mParentId;
+  int64_t mParentId;
+
+  /// This is the (logical) thread that started this run
+  int mThreadId;
 
   static int mapStringToIndex(const char* str);
 
   static std::unordered_map<std::string, int> globalPerfStringIndex;
-  static std::deque<PerformanceLog*> globalPerfLogsList;
+  static std::vector<PerformanceLog*> globalPerfLogsList;
+  static std::unordered_map<int64_t, PerformanceLog*> globalPerfLogsById;
   static std::unordered_map<int, std::string> globalPerfStringReverseIndex;
+  static std::vector<std::unique_ptr<ThreadBuffer>> globalPerfThreadBuffers;
   static std::mutex globalPerfLogListMutex;
+  static thread_local ThreadBufferLease globalPerfThreadBufferLease;
 };
 
 } // namespace performance
@@ -1,117 +1,131 @@
 #include "dart/realtime/ControlLog.hpp"
 
+#include <vector>
+
 namespace dart {
 namespace realtime {
 
-ControlLog::ControlLog(int dim, int millisPerStep)
-  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L)
+ControlLog::ControlLog(int dim, int millisPerStep, int capacity)
+  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L), mLog(dim, capacity)
 {
 }
 
+ControlLog::ControlLog(const ControlLog& other)
+  : mDim(other.mDim),
+    mMillisPerStep(other.mMillisPerStep),
+    mLogEnd(other.mLogEnd.load()),
+    mLog(other.mLog)
+{
+}
+
+ControlLog& ControlLog::operator=(const ControlLog& other)
+{
+  mDim = other.mDim;
+  mMillisPerStep = other.mMillisPerStep;
+  mLogEnd.store(other.mLogEnd.load());
+  mLog = other.mLog;
+  return *this;
+}
+
 void ControlLog::record(long time, Eigen::VectorXd control)
 {
-  if (time > mLogEnd)
-    mLogEnd = time;
-  if (mLog.size() == 0)
+  if (time > mLogEnd.load(std::memory_order_relaxed))
+    mLogEnd.store(time, std::memory_order_release);
+  if (mLog.empty())
   {
-    mLogStart = time;
-    mLog.push_back(control);
+    mLog.push(time, control);
+    return;
   }
-  else
+
+  // We're the producer, so the newest entry can't change under us
+  long logEnd;
+  mLog.readTime(mLog.end() - 1, logEnd);
+  int steps = (int)floor((double)(time - logEnd) / mMillisPerStep);
+  // This means we're recording backwards in time, which shouldn't be allowed.
+  if (steps < 0)
   {
-    long logEnd = mLogStart + ((mLog.size() - 1) * mMillisPerStep);
-    int steps = (int)floor((double)(time - logEnd) / mMillisPerStep);
-    // This means we're recording backwards in time, which shouldn't be allowed.
-    if (steps < 0)
-    {
-      assert(
-          false
-          && "ControlLog::record() expects time to monotonically increase");
-      return;
-    }
-    // This means we're overwriting the last element of the log, cause we
-    // haven't had time to run a full timestep since our last recorded value
-    if (steps == 0)
-    {
-      mLog[mLog.size() - 1] = control;
-      return;
-    }
-    // Otherwise, we need to extend the last recorded force until just before
-    // this timestep, on the assumption that the motors have been executing that
-    // command until they were updated.
-    Eigen::VectorXd last = mLog[mLog.size() - 1];
-    for (int i = 0; i < steps - 1; i++)
-    {
-      mLog.push_back(last);
-    }
-    mLog.push_back(control);
+    assert(
+        false && "ControlLog::record() expects time to monotonically increase");
+    return;
+  }
+  // This means we're overwriting the last element of the log, cause we
+  // haven't had time to run a full timestep since our last recorded value
+  if (steps == 0)
+  {
+    mLog.replaceBack(logEnd, control);
+    return;
   }
+  // Otherwise, the last recorded force holds until just before this timestep,
+  // on the assumption that the motors have been executing that command until
+  // they were updated, so we only need to record the new one.
+  mLog.push(logEnd + steps * mMillisPerStep, control);
 }
 
 long ControlLog::last()
 {
-  return mLogEnd;
+  return mLogEnd.load(std::memory_order_acquire);
 }
 
 Eigen::VectorXd ControlLog::get(long time)
 {
-  // If we haven't recorded anything yet, default to 0
-  if (mLog.size() == 0)
+  long entryTime;
+  Eigen::VectorXd control;
+  while (true)
   {
-    return Eigen::VectorXd::Zero(mDim);
+    // If we haven't recorded anything yet, default to 0
+    if (mLog.empty())
+    {
+      return Eigen::VectorXd::Zero(mDim);
+    }
+    long index = mLog.findLastAtOrBefore(time);
+    // If we're out of bounds in the past, extend our initial force
+    if (index == -1)
+      index = mLog.begin();
+    // This only fails if the producer lapped the whole buffer while we were
+    // looking, so try again
+    if (mLog.read(index, entryTime, control))
+      return control;
   }
-
-  int steps = (int)floor((double)(time - mLogStart) / mMillisPerStep);
-  // If we're out of bounds in the past, extend our initial force
-  if (steps <= 0)
-    return mLog[0];
-  // If we're out of bounds in the future, extend our last force
-  if (steps >= mLog.size())
-    return mLog[mLog.size() - 1];
-  // Otherwise return the recorded force
-  return mLog[steps];
 }
 
 void ControlLog::discardBefore(long time)
 {
-  if (time <= mLogStart || mLog.size() == 0)
+  // We only store one entry per change, so the newest entry at or before
+  // `time` is the control still in effect at `time`, and we have to keep it
+  long index = mLog.findLastAtOrBefore(time);
+  if (index == -1)
     return;
-  int discardSteps = (int)ceil((double)(time - mLogStart) / mMillisPerStep);
-  // This means we're throwing out the whole log, just extrapolate the last
-  // known force
-  if (discardSteps >= mLog.size())
-  {
-    Eigen::VectorXd last = mLog[mLog.size() - 1];
-    mLog.clear();
-    mLog.push_back(last);
-    mLogStart = time;
-    return;
-  }
-  // Otherwise we're just snipping part of the log, so copy just the bit we care
-  // about, and throw away the rest
-  std::vector<Eigen::VectorXd> trimmedLog;
-  for (int i = discardSteps; i < mLog.size(); i++)
-  {
-    trimmedLog.push_back(mLog[i]);
-  }
-  mLog = trimmedLog;
-  mLogStart += discardSteps * mMillisPerStep;
+  mLog.discardBefore(index);
 }
 
 void ControlLog::setMillisPerStep(int newMillisPerStep)
 {
-  int duration = mLog.size() * mMillisPerStep;
+  if (mLog.empty())
+  {
+    mMillisPerStep = newMillisPerStep;
+    return;
+  }
+
+  long logStart;
+  long logEnd;
+  mLog.readTime(mLog.begin(), logStart);
+  mLog.readTime(mLog.end() - 1, logEnd);
+  long duration = logEnd + mMillisPerStep - logStart;
   int newSteps = (int)ceil((double)duration / newMillisPerStep);
 
   std::vector<Eigen::VectorXd> newLog;
   for (int i = 0; i < newSteps; i++)
   {
-    newLog.push_back(get(mLogStart + i * newMillisPerStep));
+    newLog.push_back(get(logStart + i * newMillisPerStep));
   }
 
   mMillisPerStep = newMillisPerStep;
-  mLog = newLog;
+  mLog.clear();
+  for (int i = 0; i < newSteps; i++)
+  {
+    mLog.push(logStart + i * newMillisPerStep, newLog[i]);
+  }
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,37 +1,54 @@
 #ifndef DART_REALTIME_LOG
 #define DART_REALTIME_LOG
 
-#include <vector>
+#include <atomic>
 
 #include <Eigen/Dense>
 
+#include "dart/realtime/SPSCRingBuffer.hpp"
+
 namespace dart {
 namespace realtime {
 
+/// This is a log of the controls we've sent, on a fixed grid of timesteps.
+/// A control holds until the next one is recorded, so we only store one entry
+/// per change, in a bounded SPSCRingBuffer. One thread can record() while
+/// another calls get() and last() without locking.
 class ControlLog
 {
 public:
-  ControlLog(int dim, int millisPerStep);
+  ControlLog(
+      int dim,
+      int millisPerStep,
+      int capacity = SPSCRingBuffer::DEFAULT_CAPACITY);
+
+  ControlLog(const ControlLog& other);
+
+  ControlLog& operator=(const ControlLog& other);
 
+  /// PRODUCER ONLY: This records that `control` was applied at `time`
   void record(long time, Eigen::VectorXd control);
 
   long last();
 
   Eigen::VectorXd get(long time);
 
+  /// CONSUMER ONLY: This drops controls before `time`, though we always keep
+  /// the one still in effect at `time`
   void discardBefore(long time);
 
+  /// This resamples the log onto a new timestep size. This is NOT safe while
+  /// another thread is calling record().
   void setMillisPerStep(int millisPerStep);
 
 protected:
   int mDim;
   int mMillisPerStep;
-  long mLogStart;
-  long mLogEnd;
-  std::vector<Eigen::VectorXd> mLog;
+  std::atomic<long> mLogEnd;
+  SPSCRingBuffer mLog;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
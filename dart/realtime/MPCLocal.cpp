@@ -1,5 +1,8 @@
 #include "dart/realtime/MPCLocal.hpp"
 
+#include <algorithm>
+#include <limits>
+
 #include <google/protobuf/arena_impl.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 #include <grpcpp/grpcpp.h>
@@ -46,7 +49,9 @@ MPCLocal::MPCLocal(
     mMillisInAdvanceToPlan(0),
     mLastOptimizedTime(0L),
     mBuffer(RealTimeControlBuffer(world->getNumDofs(), mSteps, mMillisPerStep)),
-    mSilent(false)
+    mSilent(false),
+    mEnableAnytimeReplanning(false),
+    mAnytimeBufferFraction(0.5)
 {
 }
 
@@ -67,7 +72,9 @@ MPCLocal::MPCLocal(const MPCLocal& mpc)
     mMillisInAdvanceToPlan(mpc.mMillisInAdvanceToPlan),
     mLastOptimizedTime(mpc.mLastOptimizedTime),
     mBuffer(mpc.mBuffer),
-    mSilent(mpc.mSilent)
+    mSilent(mpc.mSilent),
+    mEnableAnytimeReplanning(mpc.mEnableAnytimeReplanning),
+    mAnytimeBufferFraction(mpc.mAnytimeBufferFraction)
 {
 }
 
@@ -167,6 +174,27 @@ void MPCLocal::setMaxIterations(int maxIters)
   mMaxIterations = maxIters;
 }
 
+/// This enables "anytime" replanning. Defaults to false. Every replan still
+/// warm starts from the previous plan shifted forward, but IPOPT stops as soon
+/// as it hits a deadline, and we publish the best plan found so far. The
+/// deadline is a fraction (see setAnytimeBufferFraction()) of the plan buffer
+/// we have left when the replan starts, so the new plan lands before the old
+/// one runs out, no matter how loaded the machine is. This turns on
+/// optimization guards for the default optimizer, so the published plan is
+/// the best one explored. This only works with IPOptOptimizer, and should be
+/// called before start().
+void MPCLocal::setEnableAnytimeReplanning(bool enabled)
+{
+  mEnableAnytimeReplanning = enabled;
+}
+
+/// This sets the fraction of the remaining plan buffer that an anytime replan
+/// is allowed to spend optimizing. Defaults to 0.5.
+void MPCLocal::setAnytimeBufferFraction(double fraction)
+{
+  mAnytimeBufferFraction = fraction;
+}
+
 /// This records the current state of the world based on some external sensing
 /// and inference. This resets the error in our model just assuming the world
 /// is exactly following our simulation.
@@ -208,7 +236,8 @@ void MPCLocal::optimizePlan(long startTime)
           = std::make_shared<IPOptOptimizer>();
       ipoptOptimizer->setCheckDerivatives(false);
       ipoptOptimizer->setSuppressOutput(true);
-      ipoptOptimizer->setRecoverBest(mEnableOptimizationGuards);
+      ipoptOptimizer->setRecoverBest(
+          mEnableOptimizationGuards || mEnableAnytimeReplanning);
       ipoptOptimizer->setTolerance(1e-3);
       ipoptOptimizer->setIterationLimit(mMaxIterations);
       ipoptOptimizer->setDisableLinesearch(!mEnableLinesearch);
@@ -223,6 +252,14 @@ void MPCLocal::optimizePlan(long startTime)
       createOpt->end();
     }
 
+    // There's no plan to fall back on yet, so the first solve has no deadline
+    std::shared_ptr<IPOptOptimizer> ipoptOptimizer
+        = std::dynamic_pointer_cast<IPOptOptimizer>(mOptimizer);
+    if (ipoptOptimizer)
+    {
+      ipoptOptimizer->clearDeadline();
+    }
+
     if (!mProblem)
     {
       std::shared_ptr<MultiShot> multishot = std::make_shared<MultiShot>(
@@ -250,7 +287,7 @@ void MPCLocal::optimizePlan(long startTime)
   }
   else
   {
-    std::shared_ptr<simulation::World> worldClone = mWorld->clone();
+    std::shared_ptr<simulation::World> worldClone = getWorkerWorld();
 
     int diff = startTime - mLastOptimizedTime;
     int steps = floor((double)diff / mMillisPerStep);
@@ -268,6 +305,23 @@ void MPCLocal::optimizePlan(long startTime)
 
     long startComputeWallTime = timeSinceEpochMillis();
 
+    // We need to publish the new plan before the old one runs out
+    long bufferMillis = 0;
+    long replanDeadline = std::numeric_limits<long>::max();
+    if (mEnableAnytimeReplanning)
+    {
+      bufferMillis = std::max(
+          0L, mBuffer.getPlanBufferMillisAfter(startComputeWallTime));
+      replanDeadline = startComputeWallTime
+                       + (long)(mAnytimeBufferFraction * bufferMillis);
+    }
+    std::shared_ptr<IPOptOptimizer> ipoptOptimizer
+        = std::dynamic_pointer_cast<IPOptOptimizer>(mOptimizer);
+    if (ipoptOptimizer)
+    {
+      ipoptOptimizer->setDeadline(replanDeadline);
+    }
+
     mBuffer.estimateWorldStateAt(
         worldClone, &mObservationLog, roundedStartTime);
 
@@ -299,7 +353,16 @@ void MPCLocal::optimizePlan(long startTime)
           computeDurationWallTime);
     }
 
-    if (!mSilent)
+    if (!mSilent && mEnableAnytimeReplanning)
+    {
+      std::cout << " -> We were allowed "
+                << (replanDeadline - startComputeWallTime)
+                << "ms to solve this problem (" << bufferMillis
+                << "ms plan buffer * " << mAnytimeBufferFraction
+                << " buffer fraction), and it took us "
+                << computeDurationWallTime << "ms" << std::endl;
+    }
+    else if (!mSilent)
     {
       double factorOfSafety = 0.5;
       std::cout << " -> We were allowed "
@@ -488,6 +551,22 @@ grpc::Status RPCWrapperMPCLocal::ObserveForce(
   return grpc::Status::OK;
 }
 
+/// This returns a world in the same state as mWorld, which we're free to
+/// mutate while replanning. Only the first call clones mWorld. After that we
+/// just copy the state across with a WorldState, which is much cheaper than
+/// World::clone() on every replan.
+std::shared_ptr<simulation::World> MPCLocal::getWorkerWorld()
+{
+  if (!mWorkerWorld)
+  {
+    mWorkerWorld = mWorld->clone();
+    return mWorkerWorld;
+  }
+  mWorkerWorldState.save(mWorld);
+  mWorkerWorldState.restore(mWorkerWorld);
+  return mWorkerWorld;
+}
+
 /// This is the function for the optimization thread to run when we're live
 void MPCLocal::optimizationThreadLoop()
 {
@@ -6,6 +6,7 @@
 
 #include <Eigen/Dense>
 
+#include "dart/neural/WorldState.hpp"
 #include "dart/proto/MPC.grpc.pb.h"
 #include "dart/realtime/MPC.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
@@ -98,6 +99,21 @@ public:
   /// values observed during running.
   void setMaxIterations(int maxIters);
 
+  /// This enables "anytime" replanning. Defaults to false. Every replan still
+  /// warm starts from the previous plan shifted forward, but IPOPT stops as
+  /// soon as it hits a deadline, and we publish the best plan found so far.
+  /// The deadline is a fraction (see setAnytimeBufferFraction()) of the plan
+  /// buffer we have left when the replan starts, so the new plan lands before
+  /// the old one runs out, no matter how loaded the machine is. This turns on
+  /// optimization guards for the default optimizer, so the published plan is
+  /// the best one explored. This only works with IPOptOptimizer, and should be
+  /// called before start().
+  void setEnableAnytimeReplanning(bool enabled);
+
+  /// This sets the fraction of the remaining plan buffer that an anytime
+  /// replan is allowed to spend optimizing. Defaults to 0.5.
+  void setAnytimeBufferFraction(double fraction);
+
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
   /// is exactly following our simulation.
@@ -141,6 +157,12 @@ protected:
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
+  /// This returns a world in the same state as mWorld, which we're free to
+  /// mutate while replanning. Only the first call clones mWorld. After that
+  /// we just copy the state across with a WorldState, which is much cheaper
+  /// than World::clone() on every replan.
+  std::shared_ptr<simulation::World> getWorkerWorld();
+
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
   std::shared_ptr<trajectory::LossFn> mLoss;
@@ -166,6 +188,15 @@ protected:
   std::shared_ptr<trajectory::Solution> mSolution;
   std::shared_ptr<trajectory::Problem> mProblem;
 
+  // Anytime replanning, see setEnableAnytimeReplanning(). We set the deadline
+  // on the IPOptOptimizer before each replan.
+  bool mEnableAnytimeReplanning;
+  double mAnytimeBufferFraction;
+
+  // This is the world we replan in, see getWorkerWorld()
+  std::shared_ptr<simulation::World> mWorkerWorld;
+  neural::WorldState mWorkerWorldState;
+
   // These are listeners that get called when we finish replanning
   std::vector<
       std::function<void(long, const trajectory::TrajectoryRollout*, long)>>
@@ -1,5 +1,6 @@
 #include "dart/realtime/ObservationLog.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 namespace dart {
@@ -14,10 +15,14 @@ ObservationLog::ObservationLog(
     long startTime,
     Eigen::VectorXd initialPos,
     Eigen::VectorXd initialVel,
-    Eigen::VectorXd initialMass)
-  : mDofs(initialPos.size()), mMassDim(initialMass.size()), mMass(initialMass)
+    Eigen::VectorXd initialMass,
+    int capacity)
+  : mDofs(initialPos.size()),
+    mMassDim(initialMass.size()),
+    mObservations(2 * initialPos.size(), capacity),
+    mMass(initialMass)
 {
-  mObservations.emplace_back(startTime, initialPos, initialVel);
+  observe(startTime, initialPos, initialVel, initialMass);
 }
 
 void ObservationLog::observe(
@@ -27,20 +32,32 @@ void ObservationLog::observe(
     // TODO(keenon): Support mass observations
     Eigen::VectorXd /* mass */)
 {
-  mObservations.emplace_back(time, pos, vel);
+  Eigen::VectorXd state = Eigen::VectorXd(2 * mDofs);
+  state.head(mDofs) = pos;
+  state.tail(mDofs) = vel;
+  mObservations.push(time, state);
 }
 
 Observation ObservationLog::getClosestObservationBefore(long time)
 {
-  for (int i = mObservations.size() - 1; i >= 0; i--)
+  long obsTime;
+  Eigen::VectorXd state;
+  while (true)
   {
-    if (mObservations[i].time <= time)
-      return mObservations[i];
+    long index = mObservations.findLastAtOrBefore(time);
+    if (index == -1)
+    {
+      std::cout
+          << "WARNING: Asked for an observation before our initialization. "
+             "Returning our initialization"
+          << std::endl;
+      index = mObservations.begin();
+    }
+    // This only fails if the producer lapped the whole buffer while we were
+    // looking, so try again
+    if (mObservations.read(index, obsTime, state))
+      return Observation(obsTime, state.head(mDofs), state.tail(mDofs));
   }
-  std::cout << "WARNING: Asked for an observation before our initialization. "
-               "Returning our initialization"
-            << std::endl;
-  return mObservations[0];
 }
 
 Eigen::VectorXd ObservationLog::getMass()
@@ -50,25 +67,13 @@ Eigen::VectorXd ObservationLog::getMass()
 
 void ObservationLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
+  // Timestamps are whole millis, so this is the newest entry before `time`
+  long index = mObservations.findLastAtOrBefore(time - 1);
+  if (index == -1)
     return;
-
-  std::vector<Observation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+  // Never throw away our most recent observation
+  mObservations.discardBefore(std::min(index + 1, mObservations.end() - 1));
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,10 +1,10 @@
 #ifndef DART_REALTIME_OBS_LOG
 #define DART_REALTIME_OBS_LOG
 
-#include <vector>
-
 #include <Eigen/Dense>
 
+#include "dart/realtime/SPSCRingBuffer.hpp"
+
 namespace dart {
 namespace realtime {
 
@@ -17,6 +17,9 @@ struct Observation
   Observation(long time, Eigen::VectorXd pos, Eigen::VectorXd vel);
 };
 
+/// This is a log of the observed states of the world, kept in a bounded
+/// SPSCRingBuffer. One thread (the sensors) can observe() while another (the
+/// optimizer) calls getClosestObservationBefore(), without locking.
 class ObservationLog
 {
 public:
@@ -24,28 +27,35 @@ public:
       long startTime,
       Eigen::VectorXd initialPos,
       Eigen::VectorXd initialVel,
-      Eigen::VectorXd initialMass);
+      Eigen::VectorXd initialMass,
+      int capacity = SPSCRingBuffer::DEFAULT_CAPACITY);
 
+  /// PRODUCER ONLY: This records an observation of the state at `time`
   void observe(
       long time,
       Eigen::VectorXd pos,
       Eigen::VectorXd vel,
       Eigen::VectorXd mass);
 
+  /// This finds the most recent observation at or before `time`, in
+  /// O(log n)
   Observation getClosestObservationBefore(long time);
 
   Eigen::VectorXd getMass();
 
+  /// CONSUMER ONLY: This drops observations before `time`, though we always
+  /// keep the most recent one
   void discardBefore(long time);
 
 protected:
   int mDofs;
   int mMassDim;
-  std::vector<Observation> mObservations;
+  /// Each entry is the position and velocity, stacked
+  SPSCRingBuffer mObservations;
   Eigen::VectorXd mMass;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,239 @@
+#include "dart/realtime/SPSCRingBuffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dart {
+namespace realtime {
+
+constexpr int SPSCRingBuffer::DEFAULT_CAPACITY;
+
+SPSCRingBuffer::SPSCRingBuffer(int dim, int capacity)
+  : mDim(dim),
+    mCapacity(capacity),
+    mVersions(new std::atomic<unsigned long>[capacity]),
+    mIndices(new std::atomic<long>[capacity]),
+    mTimes(new std::atomic<long>[capacity]),
+    mValues(new std::atomic<double>[capacity * dim]),
+    mEnd(0L),
+    mDiscardedBefore(0L)
+{
+  assert(capacity > 0);
+  for (int i = 0; i < mCapacity; i++)
+  {
+    mVersions[i].store(0UL, std::memory_order_relaxed);
+    mIndices[i].store(-1L, std::memory_order_relaxed);
+    mTimes[i].store(0L, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < mCapacity * mDim; i++)
+  {
+    mValues[i].store(0.0, std::memory_order_relaxed);
+  }
+}
+
+SPSCRingBuffer::SPSCRingBuffer(const SPSCRingBuffer& other)
+  : SPSCRingBuffer(other.mDim, other.mCapacity)
+{
+  *this = other;
+}
+
+SPSCRingBuffer& SPSCRingBuffer::operator=(const SPSCRingBuffer& other)
+{
+  if (this == &other)
+    return *this;
+
+  if (mDim != other.mDim || mCapacity != other.mCapacity)
+  {
+    mDim = other.mDim;
+    mCapacity = other.mCapacity;
+    mVersions.reset(new std::atomic<unsigned long>[mCapacity]);
+    mIndices.reset(new std::atomic<long>[mCapacity]);
+    mTimes.reset(new std::atomic<long>[mCapacity]);
+    mValues.reset(new std::atomic<double>[mCapacity * mDim]);
+  }
+  for (int i = 0; i < mCapacity; i++)
+  {
+    mVersions[i].store(0UL, std::memory_order_relaxed);
+    mIndices[i].store(
+        other.mIndices[i].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    mTimes[i].store(
+        other.mTimes[i].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+  for (int i = 0; i < mCapacity * mDim; i++)
+  {
+    mValues[i].store(
+        other.mValues[i].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+  mDiscardedBefore.store(
+      other.mDiscardedBefore.load(std::memory_order_acquire),
+      std::memory_order_release);
+  mEnd.store(
+      other.mEnd.load(std::memory_order_acquire), std::memory_order_release);
+  return *this;
+}
+
+/// Returns the size of each vector we store
+int SPSCRingBuffer::getDim() const
+{
+  return mDim;
+}
+
+/// Returns the maximum number of entries we keep before we start overwriting
+/// the oldest
+int SPSCRingBuffer::getCapacity() const
+{
+  return mCapacity;
+}
+
+/// PRODUCER ONLY: This appends an entry, overwriting the oldest entry if
+/// we're full
+void SPSCRingBuffer::push(long time, const Eigen::VectorXd& value)
+{
+  long index = mEnd.load(std::memory_order_relaxed);
+  write(index, time, value);
+  mEnd.store(index + 1, std::memory_order_release);
+}
+
+/// PRODUCER ONLY: This overwrites the newest entry. Must not be called when
+/// empty.
+void SPSCRingBuffer::replaceBack(long time, const Eigen::VectorXd& value)
+{
+  long index = mEnd.load(std::memory_order_relaxed) - 1;
+  assert(index >= 0);
+  write(index, time, value);
+}
+
+/// This returns the index of the oldest entry still available
+long SPSCRingBuffer::begin() const
+{
+  return std::max(
+      mDiscardedBefore.load(std::memory_order_acquire),
+      mEnd.load(std::memory_order_acquire) - mCapacity);
+}
+
+/// This returns one past the index of the newest entry
+long SPSCRingBuffer::end() const
+{
+  return mEnd.load(std::memory_order_acquire);
+}
+
+/// Returns true if there are no entries available
+bool SPSCRingBuffer::empty() const
+{
+  return begin() >= end();
+}
+
+/// This reads the entry at `index`. This returns false if that entry has
+/// been overwritten (or hasn't been written yet), in which case `time` and
+/// `value` are garbage.
+bool SPSCRingBuffer::read(long index, long& time, Eigen::VectorXd& value) const
+{
+  if (index < 0)
+    return false;
+  int slot = index % mCapacity;
+  value.resize(mDim);
+  while (true)
+  {
+    unsigned long before = mVersions[slot].load(std::memory_order_acquire);
+    // The producer is halfway through writing this slot, which only takes a
+    // few stores, so just spin
+    if (before & 1UL)
+      continue;
+    long storedIndex = mIndices[slot].load(std::memory_order_relaxed);
+    time = mTimes[slot].load(std::memory_order_relaxed);
+    for (int i = 0; i < mDim; i++)
+    {
+      value(i) = mValues[slot * mDim + i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mVersions[slot].load(std::memory_order_relaxed) == before)
+      return storedIndex == index;
+  }
+}
+
+/// This reads just the timestamp of the entry at `index`. This returns false
+/// if that entry has been overwritten (or hasn't been written yet).
+bool SPSCRingBuffer::readTime(long index, long& time) const
+{
+  if (index < 0)
+    return false;
+  int slot = index % mCapacity;
+  while (true)
+  {
+    unsigned long before = mVersions[slot].load(std::memory_order_acquire);
+    if (before & 1UL)
+      continue;
+    long storedIndex = mIndices[slot].load(std::memory_order_relaxed);
+    time = mTimes[slot].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mVersions[slot].load(std::memory_order_relaxed) == before)
+      return storedIndex == index;
+  }
+}
+
+/// This binary searches for the index of the newest entry with a timestamp
+/// at or before `time`. This returns -1 if there are no entries that old.
+long SPSCRingBuffer::findLastAtOrBefore(long time) const
+{
+  long lo = begin();
+  long hi = end();
+  long found = -1;
+  while (lo < hi)
+  {
+    long mid = lo + (hi - lo) / 2;
+    long midTime;
+    // If the producer overwrote this entry while we were searching, it was
+    // older than anything still in the buffer, so it counts as being before
+    // `time`
+    if (!readTime(mid, midTime) || midTime <= time)
+    {
+      found = mid;
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  if (found != -1 && found < begin())
+    return -1;
+  return found;
+}
+
+/// CONSUMER ONLY: This drops every entry before `index`
+void SPSCRingBuffer::discardBefore(long index)
+{
+  index = std::min(index, mEnd.load(std::memory_order_acquire));
+  if (index > mDiscardedBefore.load(std::memory_order_relaxed))
+    mDiscardedBefore.store(index, std::memory_order_release);
+}
+
+/// This drops every entry. This is NOT safe while the producer is pushing.
+void SPSCRingBuffer::clear()
+{
+  mDiscardedBefore.store(
+      mEnd.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+/// This writes an entry into the slot for `index`, with the seqlock protocol
+void SPSCRingBuffer::write(long index, long time, const Eigen::VectorXd& value)
+{
+  assert(value.size() == mDim);
+  int slot = index % mCapacity;
+  unsigned long version = mVersions[slot].load(std::memory_order_relaxed);
+  mVersions[slot].store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  mIndices[slot].store(index, std::memory_order_relaxed);
+  mTimes[slot].store(time, std::memory_order_relaxed);
+  for (int i = 0; i < mDim; i++)
+  {
+    mValues[slot * mDim + i].store(value(i), std::memory_order_relaxed);
+  }
+  mVersions[slot].store(version + 2, std::memory_order_release);
+}
+
+} // namespace realtime
+} // namespace dart
@@ -0,0 +1,108 @@
+#ifndef DART_REALTIME_SPSC_RING_BUFFER
+#define DART_REALTIME_SPSC_RING_BUFFER
+
+#include <atomic>
+#include <memory>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace realtime {
+
+/// This is a fixed-capacity ring buffer of timestamped vectors, which is safe
+/// to share between exactly one producer thread (which calls push() and
+/// replaceBack()) and one consumer thread (which calls everything else),
+/// without any locks.
+///
+/// Entries are addressed by a monotonically increasing index, so the first
+/// entry ever pushed is index 0, the next is 1, and so on. Once more than
+/// getCapacity() entries have been pushed, each push overwrites the oldest
+/// entry, so memory stays bounded and the producer never waits on the
+/// consumer. Each slot carries a version counter (a seqlock), so if the
+/// producer overwrites a slot while the consumer is reading it, the consumer
+/// notices and gets a `false` back from read(), rather than a torn value.
+///
+/// Timestamps are expected to be pushed in non-decreasing order, which is what
+/// lets findLastAtOrBefore() binary search.
+class SPSCRingBuffer
+{
+public:
+  /// The capacity the realtime logs use, unless they're told otherwise
+  static constexpr int DEFAULT_CAPACITY = 8192;
+
+  SPSCRingBuffer(int dim, int capacity = DEFAULT_CAPACITY);
+
+  /// Copying is NOT safe while the producer is pushing to `other`
+  SPSCRingBuffer(const SPSCRingBuffer& other);
+
+  /// Copying is NOT safe while either producer is pushing
+  SPSCRingBuffer& operator=(const SPSCRingBuffer& other);
+
+  /// Returns the size of each vector we store
+  int getDim() const;
+
+  /// Returns the maximum number of entries we keep before we start overwriting
+  /// the oldest
+  int getCapacity() const;
+
+  /// PRODUCER ONLY: This appends an entry, overwriting the oldest entry if
+  /// we're full
+  void push(long time, const Eigen::VectorXd& value);
+
+  /// PRODUCER ONLY: This overwrites the newest entry. Must not be called when
+  /// empty.
+  void replaceBack(long time, const Eigen::VectorXd& value);
+
+  /// This returns the index of the oldest entry still available
+  long begin() const;
+
+  /// This returns one past the index of the newest entry
+  long end() const;
+
+  /// Returns true if there are no entries available
+  bool empty() const;
+
+  /// This reads the entry at `index`. This returns false if that entry has
+  /// been overwritten (or hasn't been written yet), in which case `time` and
+  /// `value` are garbage.
+  bool read(long index, long& time, Eigen::VectorXd& value) const;
+
+  /// This reads just the timestamp of the entry at `index`. This returns false
+  /// if that entry has been overwritten (or hasn't been written yet).
+  bool readTime(long index, long& time) const;
+
+  /// This binary searches for the index of the newest entry with a timestamp
+  /// at or before `time`. This returns -1 if there are no entries that old.
+  long findLastAtOrBefore(long time) const;
+
+  /// CONSUMER ONLY: This drops every entry before `index`
+  void discardBefore(long index);
+
+  /// This drops every entry. This is NOT safe while the producer is pushing.
+  void clear();
+
+protected:
+  /// This writes an entry into the slot for `index`, with the seqlock protocol
+  void write(long index, long time, const Eigen::VectorXd& value);
+
+  int mDim;
+  int mCapacity;
+
+  /// The version of each slot. This is odd while the slot is being written.
+  std::unique_ptr<std::atomic<unsigned long>[]> mVersions;
+  /// The index of the entry currently held in each slot
+  std::unique_ptr<std::atomic<long>[]> mIndices;
+  std::unique_ptr<std::atomic<long>[]> mTimes;
+  /// This is mCapacity x mDim values, one row of mDim per slot
+  std::unique_ptr<std::atomic<double>[]> mValues;
+
+  /// One past the newest entry. Only the producer writes this.
+  std::atomic<long> mEnd;
+  /// Entries before this were discarded. Only the consumer writes this.
+  std::atomic<long> mDiscardedBefore;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
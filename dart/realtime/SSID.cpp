@@ -1,11 +1,14 @@
 #include "dart/realtime/SSID.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <thread>
 
 #include "dart/realtime/Millis.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/Solution.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
 
 #include "signal.h"
@@ -27,7 +30,10 @@ SSID::SSID(
     mPlanningHistoryMillis(planningHistoryMillis),
     mSensorDim(sensorDim),
     mSensorLog(VectorLog(sensorDim)),
-    mControlLog(VectorLog(world->getNumDofs()))
+    mControlLog(VectorLog(world->getNumDofs())),
+    mSlidingWindowEnabled(false),
+    mMillisBetweenInferences(0),
+    mWindowStart(0L)
 {
   int dofs = world->getNumDofs();
   mInitialPosEstimator
@@ -134,6 +140,40 @@ void SSID::stop()
   mOptimizationThread.join();
 }
 
+/// If this is true, every call to runInference() after the first slides the
+/// window from the last call forward to the new time, rather than solving
+/// from scratch. The previous solution is shifted over by the elapsed steps,
+/// only the new sensor and control columns are read from the logs, and the
+/// optimizer is warm started with Solution::reoptimize(). This is off by
+/// default.
+void SSID::setSlidingWindowEnabled(bool enabled)
+{
+  mSlidingWindowEnabled = enabled;
+}
+
+/// Returns true if we're using a sliding window, see
+/// setSlidingWindowEnabled()
+bool SSID::getSlidingWindowEnabled()
+{
+  return mSlidingWindowEnabled;
+}
+
+/// This sets the minimum time between the starts of two inference runs on the
+/// optimization thread. If inference finishes early, the thread sleeps for the
+/// rest of the interval instead of immediately starting another run. The
+/// default, 0, runs inference back to back.
+void SSID::setMillisBetweenInferences(int millis)
+{
+  mMillisBetweenInferences = millis;
+}
+
+/// Returns the minimum time between inference runs, see
+/// setMillisBetweenInferences()
+int SSID::getMillisBetweenInferences()
+{
+  return mMillisBetweenInferences;
+}
+
 /// This runs inference to find mutable values, starting at `startTime`
 void SSID::runInference(long startTime)
 {
@@ -150,27 +190,77 @@ void SSID::runInference(long startTime)
     mProblem = multishot;
   }
 
+  // If we can, we slide the last window forward on the timestep grid, so the
+  // columns we've already sampled still line up. We don't allow the window to
+  // go backwards in time.
+  int shift = 0;
+  bool warmStart = mSlidingWindowEnabled && mSolution != nullptr;
+  if (warmStart)
+  {
+    long diff = startTime - mPlanningHistoryMillis - mWindowStart;
+    shift = std::max(0L, diff / millisPerStep);
+    // If the whole window has gone by, there's nothing left to warm start from
+    if (shift >= steps)
+    {
+      warmStart = false;
+    }
+  }
+
+  if (warmStart)
+  {
+    mWindowStart += shift * millisPerStep;
+    startTime = mWindowStart + mPlanningHistoryMillis;
+
+    if (shift > 0)
+    {
+      // Shift the histories over, and only read the new columns from the logs
+      int kept = steps - shift;
+      long newColumnsStart = mWindowStart + kept * millisPerStep;
+      mForceHistory.leftCols(kept) = mForceHistory.rightCols(kept).eval();
+      mForceHistory.rightCols(shift)
+          = mControlLog.getValues(newColumnsStart, shift, millisPerStep);
+      mSensorHistory.leftCols(kept) = mSensorHistory.rightCols(kept).eval();
+      mSensorHistory.rightCols(shift)
+          = mSensorLog.getValues(newColumnsStart, shift, millisPerStep);
+
+      // The new start state is where our last solution thought we'd be
+      const trajectory::TrajectoryRollout* lastRollout
+          = mProblem->getRolloutCache(mWorld);
+      Eigen::VectorXd startPos = lastRollout->getPosesConst().col(shift);
+      Eigen::VectorXd startVel = lastRollout->getVelsConst().col(shift);
+      mProblem->advanceSteps(mWorld, startPos, startVel, shift);
+    }
+  }
+  else
+  {
+    mWindowStart = startTime - mPlanningHistoryMillis;
+    mForceHistory = mControlLog.getValues(mWindowStart, steps, millisPerStep);
+    mSensorHistory = mSensorLog.getValues(mWindowStart, steps, millisPerStep);
+  }
+
   // Every turn, we need to pin all the forces
 
-  Eigen::MatrixXd forceHistory = mControlLog.getValues(
-      startTime - mPlanningHistoryMillis, steps, millisPerStep);
   for (int i = 0; i < steps; i++)
   {
-    mProblem->pinForce(i, forceHistory.col(i));
+    mProblem->pinForce(i, mForceHistory.col(i));
   }
 
   // We also need to set all the sensor history into metadata
 
-  Eigen::MatrixXd sensorHistory = mSensorLog.getValues(
-      startTime - mPlanningHistoryMillis, steps, millisPerStep);
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", sensorHistory);
-
-  mProblem->setStartPos(mInitialPosEstimator(sensorHistory, startTime));
+  mProblem->setMetadata("forces", mForceHistory);
+  mProblem->setMetadata("sensors", mSensorHistory);
 
   // Then actually run the optimization
 
-  mSolution = mOptimizer->optimize(mProblem.get());
+  if (warmStart)
+  {
+    mSolution->reoptimize();
+  }
+  else
+  {
+    mProblem->setStartPos(mInitialPosEstimator(mSensorHistory, startTime));
+    mSolution = mOptimizer->optimize(mProblem.get());
+  }
 
   long computeDurationWallTime = timeSinceEpochMillis() - startComputeWallTime;
 
@@ -215,7 +305,12 @@ void SSID::optimizationThreadLoop()
       std::cout << "Running inference" << std::endl;
       runInference(startTime);
     }
-    // long endTime = timeSinceEpochMillis();
+    long elapsed = timeSinceEpochMillis() - startTime;
+    if (elapsed < mMillisBetweenInferences)
+    {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(mMillisBetweenInferences - elapsed));
+    }
   }
 }
 
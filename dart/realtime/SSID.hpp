@@ -1,8 +1,10 @@
 #ifndef DART_REALTIME_SSID
 #define DART_REALTIME_SSID
 
+#include <functional>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -77,6 +79,28 @@ public:
   /// This stops our main thread, waits for it to finish, and then returns
   void stop();
 
+  /// If this is true, every call to runInference() after the first slides the
+  /// window from the last call forward to the new time, rather than solving
+  /// from scratch. The previous solution is shifted over by the elapsed
+  /// steps, only the new sensor and control columns are read from the logs,
+  /// and the optimizer is warm started with Solution::reoptimize(). This is
+  /// off by default.
+  void setSlidingWindowEnabled(bool enabled);
+
+  /// Returns true if we're using a sliding window, see
+  /// setSlidingWindowEnabled()
+  bool getSlidingWindowEnabled();
+
+  /// This sets the minimum time between the starts of two inference runs on
+  /// the optimization thread. If inference finishes early, the thread sleeps
+  /// for the rest of the interval instead of immediately starting another
+  /// run. The default, 0, runs inference back to back.
+  void setMillisBetweenInferences(int millis);
+
+  /// Returns the minimum time between inference runs, see
+  /// setMillisBetweenInferences()
+  int getMillisBetweenInferences();
+
   /// This runs inference to find mutable values, starting at `startTime`
   void runInference(long startTime);
 
@@ -97,6 +121,15 @@ protected:
   int mSensorDim;
   VectorLog mSensorLog;
   VectorLog mControlLog;
+  bool mSlidingWindowEnabled;
+  int mMillisBetweenInferences;
+
+  // This is the window we ran inference over last time, which the sliding
+  // window shifts forward from. The histories are sampled onto the timestep
+  // grid, one column per step, starting at mWindowStart.
+  long mWindowStart;
+  Eigen::MatrixXd mForceHistory;
+  Eigen::MatrixXd mSensorHistory;
 
   std::shared_ptr<trajectory::Optimizer> mOptimizer;
   std::shared_ptr<trajectory::Problem> mProblem;
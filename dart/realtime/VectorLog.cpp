@@ -1,5 +1,7 @@
 #include "dart/realtime/VectorLog.hpp"
 
+#include <algorithm>
+
 namespace dart {
 namespace realtime {
 
@@ -8,27 +10,39 @@ VectorObservation::VectorObservation(long time, Eigen::VectorXd value)
 {
 }
 
-VectorLog::VectorLog(int dim) : mDim(dim), mStartTime(0L)
+VectorLog::VectorLog(int dim, int capacity)
+  : mDim(dim), mObservations(dim, capacity)
 {
 }
 
 void VectorLog::record(long time, Eigen::VectorXd val)
 {
-  if (mObservations.size() == 0)
-    mStartTime = time;
   assert(val.size() == mDim);
-  mObservations.emplace_back(time, val);
+  mObservations.push(time, val);
 }
 
 Eigen::MatrixXd VectorLog::getValues(long start, int steps, long millisPerStep)
 {
   Eigen::MatrixXd observations = Eigen::MatrixXd::Zero(mDim, steps);
 
+  // Anything at or before `start - millisPerStep` lands before the first step,
+  // and only the last of those matters, so we can skip straight to it
+  long firstIndex = mObservations.findLastAtOrBefore(start - millisPerStep);
+  if (firstIndex == -1)
+    firstIndex = mObservations.begin();
+  long endIndex = mObservations.end();
+
   Eigen::VectorXd cursorValue = Eigen::VectorXd::Zero(mDim);
   int cursorStep = 0;
-  for (const VectorObservation& obs : mObservations)
+  long time;
+  Eigen::VectorXd value;
+  for (long i = firstIndex; i < endIndex; i++)
   {
-    int step = ceil((double)(obs.time - start) / millisPerStep);
+    // This entry was overwritten while we were reading, so it's older than
+    // anything we care about
+    if (!mObservations.read(i, time, value))
+      continue;
+    int step = ceil((double)(time - start) / millisPerStep);
     if (step > steps - 1)
       break;
     if (step >= cursorStep)
@@ -40,13 +54,13 @@ Eigen::MatrixXd VectorLog::getValues(long start, int steps, long millisPerStep)
         cursorStep++;
       }
       // Set the current value to the current state
-      cursorValue = obs.value;
+      cursorValue = value;
       observations.col(step) = cursorValue;
       assert(cursorStep == step);
     }
     else
     {
-      cursorValue = obs.value;
+      cursorValue = value;
     }
   }
   // Sweep the last cursor value forward to the end of the block
@@ -61,30 +75,21 @@ Eigen::MatrixXd VectorLog::getValues(long start, int steps, long millisPerStep)
 
 long VectorLog::availableHistoryBefore(long time)
 {
-  return time - mStartTime;
+  long startTime = 0L;
+  if (!mObservations.empty())
+    mObservations.readTime(mObservations.begin(), startTime);
+  return time - startTime;
 }
 
 void VectorLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
+  // Timestamps are whole millis, so this is the newest entry before `time`
+  long index = mObservations.findLastAtOrBefore(time - 1);
+  if (index == -1)
     return;
-
-  std::vector<VectorObservation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+  // Never throw away our most recent observation
+  mObservations.discardBefore(std::min(index + 1, mObservations.end() - 1));
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,10 +1,10 @@
 #ifndef DART_REALTIME_VECTOR_LOG
 #define DART_REALTIME_VECTOR_LOG
 
-#include <vector>
-
 #include <Eigen/Dense>
 
+#include "dart/realtime/SPSCRingBuffer.hpp"
+
 namespace dart {
 namespace realtime {
 
@@ -16,26 +16,33 @@ struct VectorObservation
   VectorObservation(long time, Eigen::VectorXd value);
 };
 
+/// This is a log of timestamped vectors, kept in a bounded SPSCRingBuffer.
+/// One thread can record() while another reads, without locking.
 class VectorLog
 {
 public:
-  VectorLog(int dim);
+  VectorLog(int dim, int capacity = SPSCRingBuffer::DEFAULT_CAPACITY);
 
+  /// PRODUCER ONLY: This records `val` at `time`
   void record(long time, Eigen::VectorXd val);
 
+  /// This samples the log onto a grid of `steps` timesteps starting at
+  /// `start`. This only visits the observations in (and just before) that
+  /// window, so it doesn't slow down as the log gets longer.
   Eigen::MatrixXd getValues(long start, int steps, long millisPerStep);
 
+  /// CONSUMER ONLY: This drops observations before `time`, though we always
+  /// keep the most recent one
   void discardBefore(long time);
 
   long availableHistoryBefore(long time);
 
 protected:
   int mDim;
-  long mStartTime;
-  std::vector<VectorObservation> mObservations;
+  SPSCRingBuffer mObservations;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
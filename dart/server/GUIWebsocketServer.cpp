@@ -33,7 +33,9 @@ GUIWebsocketServer::GUIWebsocketServer()
     mStartingServer(false),
     mScreenSize(Eigen::Vector2i(680, 420)),
     mAutoflush(true),
-    mMessagesQueued(0)
+    mMessagesQueued(0),
+    mNextBinaryId(0),
+    mBinaryProtocolEnabled(true)
 {
   mJson << "[";
 }
@@ -178,6 +180,14 @@ void GUIWebsocketServer::serve(int port)
         json << ",";
       encodeEnableMouseInteraction(json, key);
     }
+    for (auto pair : mBinaryIds)
+    {
+      if (isFirst)
+        isFirst = false;
+      else
+        json << ",";
+      encodeSetBinaryId(json, pair.first, pair.second);
+    }
 
     json << "]";
 
@@ -205,14 +215,22 @@ void GUIWebsocketServer::serve(int port)
     }
   });
 
-  mServer->disconnect([this](ClientConnection /* conn */) {
+  mServer->disconnect([this](ClientConnection conn) {
+    {
+      const std::lock_guard<std::mutex> lock(this->mBinaryClientsMutex);
+      this->mBinaryClients.erase(conn);
+    }
     std::clog << "Connection closed." << std::endl;
     std::clog << "There are now " << mServer->numConnections()
               << " open connections." << std::endl;
   });
-  mServer->message([this](
-                       ClientConnection /* conn */, const Json::Value& args) {
-    if (args["type"].asString() == "keydown")
+  mServer->message([this](ClientConnection conn, const Json::Value& args) {
+    if (args["type"].asString() == "enable_binary_protocol")
+    {
+      const std::lock_guard<std::mutex> lock(this->mBinaryClientsMutex);
+      this->mBinaryClients.insert(conn);
+    }
+    else if (args["type"].asString() == "keydown")
     {
       std::string key = args["key"].asString();
       {
@@ -465,20 +483,54 @@ void GUIWebsocketServer::setAutoflush(bool autoflush)
 /// This sends the current list of commands to the web GUI
 void GUIWebsocketServer::flush()
 {
+  // Encoding binary updates can register new ids in mBinaryIds, which the
+  // connection handler reads under globalMutex, so we need that lock too.
+  // It's always taken before mJsonMutex, so the two can't deadlock.
+  const std::lock_guard<std::recursive_mutex> globalLock(this->globalMutex);
   const std::lock_guard<std::recursive_mutex> lock(mJsonMutex);
 
+  // The pending updates go last, and the JSON goes out before the binary
+  // frame, so any objects they refer to are already created (and any new ids
+  // already registered) by the time the client sees them
+  std::string binary;
+  if (!mPendingUpdates.empty())
+  {
+    if (shouldSendBinary())
+      binary = encodePendingUpdatesBinary();
+    else
+      encodePendingUpdatesJson();
+    mPendingUpdates.clear();
+    mPendingUpdateIndex.clear();
+  }
+
   mJson << "]";
   std::string json = mJson.str();
   if (mServing)
   {
-    try
+    if (mMessagesQueued > 0 || binary.empty())
     {
-      mServer->broadcast(json);
+      try
+      {
+        mServer->broadcast(json);
+      }
+      catch (...)
+      {
+        dterr << "GUIWebsocketServer caught an error broadcasting message \""
+              << json << "\"" << std::endl;
+      }
     }
-    catch (...)
+    if (!binary.empty())
     {
-      dterr << "GUIWebsocketServer caught an error broadcasting message \""
-            << json << "\"" << std::endl;
+      try
+      {
+        mServer->broadcastBinary(binary);
+      }
+      catch (...)
+      {
+        dterr << "GUIWebsocketServer caught an error broadcasting a binary "
+                 "message of "
+              << binary.size() << " bytes" << std::endl;
+      }
     }
   }
 
@@ -492,6 +544,13 @@ void GUIWebsocketServer::flush()
   mJson << "[";
 }
 
+/// Position, rotation and color changes are batched up until the next flush(),
+/// and sent as a binary frame if every connected client has asked for it
+void GUIWebsocketServer::setBinaryProtocolEnabled(bool enabled)
+{
+  mBinaryProtocolEnabled = enabled;
+}
+
 /// This is a high-level command that creates/updates all the shapes in a
 /// world by calling the lower-level commands
 GUIWebsocketServer& GUIWebsocketServer::renderWorld(
@@ -597,14 +656,8 @@ GUIWebsocketServer& GUIWebsocketServer::renderSkeleton(
       dynamics::ShapeNode* shapeNode = node->getShapeNode(k);
       dynamics::Shape* shape = shapeNode->getShape().get();
 
-      std::stringstream shapeNameStream;
-      shapeNameStream << prefix << "_";
-      shapeNameStream << skel->getName();
-      shapeNameStream << "_";
-      shapeNameStream << node->getName();
-      shapeNameStream << "_";
-      shapeNameStream << k;
-      std::string shapeName = shapeNameStream.str();
+      std::string shapeName = prefix + "_" + skel->getName() + "_"
+                              + node->getName() + "_" + std::to_string(k);
 
       if (!shapeNode->hasVisualAspect())
         continue;
@@ -807,6 +860,10 @@ GUIWebsocketServer& GUIWebsocketServer::clear()
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  mPendingUpdates.clear();
+  mPendingUpdateIndex.clear();
+  // We keep counting up from mNextBinaryId, so old ids never come back
+  mBinaryIds.clear();
   queueCommand(
       [&](std::stringstream& json) { json << "{ \"type\": \"clear_all\" }"; });
   mBoxes.clear();
@@ -836,6 +893,7 @@ GUIWebsocketServer& GUIWebsocketServer::createBox(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  dropPendingUpdate(key);
   Box& box = mBoxes[key];
   box.key = key;
   box.size = size;
@@ -863,6 +921,7 @@ GUIWebsocketServer& GUIWebsocketServer::createSphere(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  dropPendingUpdate(key);
   Sphere& sphere = mSpheres[key];
   sphere.key = key;
   sphere.radius = radius;
@@ -891,6 +950,7 @@ GUIWebsocketServer& GUIWebsocketServer::createCapsule(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  dropPendingUpdate(key);
   Capsule& capsule = mCapsules[key];
   capsule.key = key;
   capsule.radius = radius;
@@ -916,6 +976,7 @@ GUIWebsocketServer& GUIWebsocketServer::createLine(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  dropPendingUpdate(key);
   Line& line = mLines[key];
   line.key = key;
   line.points = points;
@@ -947,6 +1008,7 @@ GUIWebsocketServer& GUIWebsocketServer::createMesh(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  dropPendingUpdate(key);
   Mesh& mesh = mMeshes[key];
   mesh.key = key;
   mesh.vertices = vertices;
@@ -1198,12 +1260,13 @@ GUIWebsocketServer& GUIWebsocketServer::setObjectPosition(
     mMeshes[key].pos = pos;
   }
 
-  queueCommand([&](std::stringstream& json) {
-    json << "{ \"type\": \"set_object_pos\", \"key\": \"" << key
-         << "\", \"pos\": ";
-    vec3ToJson(json, pos);
-    json << "}";
-  });
+  ObjectTransformUpdate& update = getPendingUpdate(key);
+  update.fields |= TRANSFORM_POS;
+  update.pos = pos;
+  if (mAutoflush)
+  {
+    flush();
+  }
 
   return *this;
 }
@@ -1227,12 +1290,13 @@ GUIWebsocketServer& GUIWebsocketServer::setObjectRotation(
     mMeshes[key].euler = euler;
   }
 
-  queueCommand([&](std::stringstream& json) {
-    json << "{ \"type\": \"set_object_rotation\", \"key\": \"" << key
-         << "\", \"euler\": ";
-    vec3ToJson(json, euler);
-    json << "}";
-  });
+  ObjectTransformUpdate& update = getPendingUpdate(key);
+  update.fields |= TRANSFORM_EULER;
+  update.euler = euler;
+  if (mAutoflush)
+  {
+    flush();
+  }
 
   return *this;
 }
@@ -1264,12 +1328,13 @@ GUIWebsocketServer& GUIWebsocketServer::setObjectColor(
     mCapsules[key].color = color;
   }
 
-  queueCommand([&](std::stringstream& json) {
-    json << "{ \"type\": \"set_object_color\", \"key\": \"" << key
-         << "\", \"color\": ";
-    vec3ToJson(json, color);
-    json << "}";
-  });
+  ObjectTransformUpdate& update = getPendingUpdate(key);
+  update.fields |= TRANSFORM_COLOR;
+  update.color = color;
+  if (mAutoflush)
+  {
+    flush();
+  }
 
   return *this;
 }
@@ -1300,6 +1365,8 @@ GUIWebsocketServer& GUIWebsocketServer::deleteObject(const std::string& key)
   mLines.erase(key);
   mMeshes.erase(key);
   mCapsules.erase(key);
+  mBinaryIds.erase(key);
+  dropPendingUpdate(key);
 
   queueCommand([&](std::stringstream& json) {
     json << "{ \"type\": \"delete_object\", \"key\": \"" << key << "\" }";
@@ -1790,6 +1857,7 @@ GUIWebsocketServer& GUIWebsocketServer::deleteUIElement(const std::string& key)
 void GUIWebsocketServer::queueCommand(
     std::function<void(std::stringstream&)> writeCommand)
 {
+  const std::lock_guard<std::recursive_mutex> globalLock(this->globalMutex);
   const std::lock_guard<std::recursive_mutex> lock(mJsonMutex);
 
   if (mMessagesQueued > 0)
@@ -1807,6 +1875,121 @@ void GUIWebsocketServer::queueCommand(
   }
 }
 
+ObjectTransformUpdate& GUIWebsocketServer::getPendingUpdate(
+    const std::string& key)
+{
+  const std::lock_guard<std::recursive_mutex> globalLock(this->globalMutex);
+  const std::lock_guard<std::recursive_mutex> lock(mJsonMutex);
+
+  auto existing = mPendingUpdateIndex.find(key);
+  if (existing != mPendingUpdateIndex.end())
+  {
+    return mPendingUpdates[existing->second].update;
+  }
+
+  mPendingUpdateIndex[key] = mPendingUpdates.size();
+  mPendingUpdates.emplace_back();
+  PendingUpdate& pending = mPendingUpdates.back();
+  pending.key = key;
+  pending.update.id = 0;
+  pending.update.fields = 0;
+  pending.update.pos.setZero();
+  pending.update.euler.setZero();
+  pending.update.color.setZero();
+  return pending.update;
+}
+
+void GUIWebsocketServer::dropPendingUpdate(const std::string& key)
+{
+  const std::lock_guard<std::recursive_mutex> globalLock(this->globalMutex);
+  const std::lock_guard<std::recursive_mutex> lock(mJsonMutex);
+
+  auto existing = mPendingUpdateIndex.find(key);
+  if (existing != mPendingUpdateIndex.end())
+  {
+    // Leave the entry in place, so the indices of the others stay valid, but
+    // make sure it won't send anything
+    mPendingUpdates[existing->second].update.fields = 0;
+  }
+}
+
+bool GUIWebsocketServer::shouldSendBinary()
+{
+  if (!mBinaryProtocolEnabled || !mServing)
+    return false;
+
+  // We broadcast every frame to every client, so they all need to be able to
+  // read it
+  std::size_t numConnections = mServer->numConnections();
+  const std::lock_guard<std::mutex> lock(mBinaryClientsMutex);
+  return numConnections > 0 && mBinaryClients.size() >= numConnections;
+}
+
+void GUIWebsocketServer::encodePendingUpdatesJson()
+{
+  for (const PendingUpdate& pending : mPendingUpdates)
+  {
+    const ObjectTransformUpdate& update = pending.update;
+    if (update.fields & TRANSFORM_POS)
+    {
+      if (mMessagesQueued++ > 0)
+        mJson << ",";
+      mJson << "{ \"type\": \"set_object_pos\", \"key\": \"" << pending.key
+            << "\", \"pos\": ";
+      vec3ToJson(mJson, update.pos);
+      mJson << "}";
+    }
+    if (update.fields & TRANSFORM_EULER)
+    {
+      if (mMessagesQueued++ > 0)
+        mJson << ",";
+      mJson << "{ \"type\": \"set_object_rotation\", \"key\": \""
+            << pending.key << "\", \"euler\": ";
+      vec3ToJson(mJson, update.euler);
+      mJson << "}";
+    }
+    if (update.fields & TRANSFORM_COLOR)
+    {
+      if (mMessagesQueued++ > 0)
+        mJson << ",";
+      mJson << "{ \"type\": \"set_object_color\", \"key\": \""
+            << pending.key << "\", \"color\": ";
+      vec3ToJson(mJson, update.color);
+      mJson << "}";
+    }
+  }
+}
+
+std::string GUIWebsocketServer::encodePendingUpdatesBinary()
+{
+  std::vector<ObjectTransformUpdate> updates;
+  updates.reserve(mPendingUpdates.size());
+  for (PendingUpdate& pending : mPendingUpdates)
+  {
+    if (pending.update.fields == 0)
+      continue;
+
+    auto existing = mBinaryIds.find(pending.key);
+    if (existing == mBinaryIds.end())
+    {
+      std::uint32_t id = mNextBinaryId++;
+      mBinaryIds[pending.key] = id;
+      pending.update.id = id;
+      if (mMessagesQueued++ > 0)
+        mJson << ",";
+      encodeSetBinaryId(mJson, pending.key, id);
+    }
+    else
+    {
+      pending.update.id = existing->second;
+    }
+    updates.push_back(pending.update);
+  }
+  if (updates.empty())
+    return "";
+  return encodeObjectTransformsBinary(updates);
+}
+
 void GUIWebsocketServer::encodeCreateBox(std::stringstream& json, Box& box)
 {
   json << "{ \"type\": \"create_box\", \"key\": \"" << box.key
@@ -2012,5 +2195,12 @@ void GUIWebsocketServer::encodeCreatePlot(std::stringstream& json, Plot& plot)
   json << "\" }";
 }
 
+void GUIWebsocketServer::encodeSetBinaryId(
+    std::stringstream& json, const std::string& key, std::uint32_t id)
+{
+  json << "{ \"type\": \"set_binary_id\", \"key\": \"" << key
+       << "\", \"id\": " << id << " }";
+}
+
 } // namespace server
-} // namespace dart
\ No newline at end of file
+} // namespace dart
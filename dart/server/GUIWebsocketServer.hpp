@@ -2,9 +2,11 @@
 #define DART_GUI_SERVER
 
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -18,6 +20,7 @@
 #include <assimp/cimport.h>
 #include <assimp/postprocess.h>
 
+#include "dart/server/RawBinaryUtils.hpp"
 #include "dart/server/WebsocketServer.hpp"
 
 namespace dart {
@@ -85,6 +88,13 @@ public:
   /// This sends the current list of commands to the web GUI
   void flush();
 
+  /// Position, rotation and color changes are batched up until the next
+  /// flush(), and only the latest value for each object gets sent. If every
+  /// connected client has asked for it, the batch goes out as a single binary
+  /// frame of float32s (see RawBinaryUtils.hpp) instead of JSON commands. This
+  /// is on by default, and turning it off always sends JSON.
+  void setBinaryProtocolEnabled(bool enabled);
+
   /// This is a high-level command that creates/updates all the shapes in a
   /// world by calling the lower-level commands
   GUIWebsocketServer& renderWorld(
@@ -330,7 +340,8 @@ protected:
   std::condition_variable mServingConditionValue;
 
   // protects the buffered JSON message (mJson) from getting
-  // corrupted if we queue messages while trying to flush()
+  // corrupted if we queue messages while trying to flush(). Anything that
+  // takes this also takes globalMutex first, so the order is always the same.
   std::recursive_mutex mJsonMutex;
   bool mAutoflush;
   int mMessagesQueued;
@@ -465,8 +476,50 @@ protected:
   };
   std::unordered_map<std::string, Plot> mPlots;
 
+  // Transform and color changes since the last flush(), in the order the
+  // objects first changed, with an index to find each object's entry
+  struct PendingUpdate
+  {
+    std::string key;
+    ObjectTransformUpdate update;
+  };
+  std::vector<PendingUpdate> mPendingUpdates;
+  std::unordered_map<std::string, std::size_t> mPendingUpdateIndex;
+
+  // The binary protocol refers to objects by number rather than by key. Ids
+  // are never reused, so a client can't apply an update to the wrong object.
+  // Guarded by globalMutex, since new connections replay these.
+  std::unordered_map<std::string, std::uint32_t> mBinaryIds;
+  std::uint32_t mNextBinaryId;
+  bool mBinaryProtocolEnabled;
+
+  // The clients that have told us they can decode binary frames. This is
+  // touched from the networking thread, so it has its own lock.
+  std::set<ClientConnection, std::owner_less<ClientConnection>> mBinaryClients;
+  std::mutex mBinaryClientsMutex;
+
   void queueCommand(std::function<void(std::stringstream&)> writeCommand);
 
+  /// This gets the pending update for `key`, creating an empty one if there
+  /// isn't one yet
+  ObjectTransformUpdate& getPendingUpdate(const std::string& key);
+
+  /// This throws away any pending update for `key`. Creating or deleting an
+  /// object does this, so an update queued before never lands on the new
+  /// object.
+  void dropPendingUpdate(const std::string& key);
+
+  /// This returns true if we should send pending updates as a binary frame
+  bool shouldSendBinary();
+
+  /// This writes all the pending updates into mJson as JSON commands
+  void encodePendingUpdatesJson();
+
+  /// This encodes all the pending updates as a binary frame. Objects that
+  /// don't have an id yet get one, and a JSON command telling the client
+  /// about it gets written into mJson.
+  std::string encodePendingUpdatesBinary();
+
   void encodeCreateBox(std::stringstream& json, Box& box);
   void encodeCreateSphere(std::stringstream& json, Sphere& sphere);
   void encodeCreateCapsule(std::stringstream& json, Capsule& capsule);
@@ -479,6 +532,8 @@ protected:
   void encodeCreateButton(std::stringstream& json, Button& button);
   void encodeCreateSlider(std::stringstream& json, Slider& slider);
   void encodeCreatePlot(std::stringstream& json, Plot& plot);
+  void encodeSetBinaryId(
+      std::stringstream& json, const std::string& key, std::uint32_t id);
 };
 
 } // namespace server
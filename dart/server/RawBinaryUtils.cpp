@@ -0,0 +1,62 @@
+#include "dart/server/RawBinaryUtils.hpp"
+
+#include <cstring>
+
+namespace dart {
+
+namespace {
+
+//==============================================================================
+/// Writes `value` into `out` as 4 little-endian bytes, regardless of the byte
+/// order of the host
+void writeUint32(char* out, std::uint32_t value)
+{
+  out[0] = static_cast<char>(value & 0xFF);
+  out[1] = static_cast<char>((value >> 8) & 0xFF);
+  out[2] = static_cast<char>((value >> 16) & 0xFF);
+  out[3] = static_cast<char>((value >> 24) & 0xFF);
+}
+
+//==============================================================================
+/// Writes `vec` into `out` as 3 little-endian float32s
+void writeVec3f(char* out, const Eigen::Vector3d& vec)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    float value = static_cast<float>(vec(i));
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUint32(out + 4 * i, bits);
+  }
+}
+
+} // namespace
+
+//==============================================================================
+std::string encodeObjectTransformsBinary(
+    const std::vector<ObjectTransformUpdate>& updates)
+{
+  std::string frame(
+      BINARY_TRANSFORMS_HEADER_SIZE
+          + BINARY_TRANSFORM_RECORD_SIZE * updates.size(),
+      '\0');
+  char* cursor = &frame[0];
+
+  writeUint32(cursor, BINARY_SET_OBJECT_TRANSFORMS);
+  writeUint32(cursor + 4, static_cast<std::uint32_t>(updates.size()));
+  cursor += BINARY_TRANSFORMS_HEADER_SIZE;
+
+  for (const ObjectTransformUpdate& update : updates)
+  {
+    writeUint32(cursor, update.id);
+    writeUint32(cursor + 4, update.fields);
+    writeVec3f(cursor + 8, update.pos);
+    writeVec3f(cursor + 20, update.euler);
+    writeVec3f(cursor + 32, update.color);
+    cursor += BINARY_TRANSFORM_RECORD_SIZE;
+  }
+
+  return frame;
+}
+
+} // namespace dart
@@ -0,0 +1,56 @@
+#ifndef DART_BINARY_UTILS
+#define DART_BINARY_UTILS
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace dart {
+
+/// This is the first uint32 of a binary frame of object transforms, so the web
+/// client can tell it apart from any other binary frames we add later
+constexpr std::uint32_t BINARY_SET_OBJECT_TRANSFORMS = 1;
+
+/// These flag which fields of an ObjectTransformUpdate changed
+constexpr std::uint32_t TRANSFORM_POS = 1;
+constexpr std::uint32_t TRANSFORM_EULER = 2;
+constexpr std::uint32_t TRANSFORM_COLOR = 4;
+
+/// This is a change to the position, rotation and/or color of a single object
+/// in the web GUI. Only the fields flagged in `fields` are meaningful.
+struct ObjectTransformUpdate
+{
+  std::uint32_t id;
+  std::uint32_t fields;
+  Eigen::Vector3d pos;
+  Eigen::Vector3d euler;
+  Eigen::Vector3d color;
+};
+
+/// The size in bytes of the header of a binary frame of object transforms
+constexpr std::size_t BINARY_TRANSFORMS_HEADER_SIZE = 8;
+
+/// The size in bytes of each object record in a binary frame
+constexpr std::size_t BINARY_TRANSFORM_RECORD_SIZE = 44;
+
+/// This encodes a batch of object updates as a little-endian binary frame:
+///
+///   uint32 BINARY_SET_OBJECT_TRANSFORMS
+///   uint32 number of records
+///   for each record:
+///     uint32 object id
+///     uint32 fields (TRANSFORM_POS | TRANSFORM_EULER | TRANSFORM_COLOR)
+///     float32[3] pos
+///     float32[3] euler
+///     float32[3] color
+///
+/// Every field is 4 bytes, so the client can read the whole frame through a
+/// single Uint32Array and Float32Array over the same buffer.
+std::string encodeObjectTransformsBinary(
+    const std::vector<ObjectTransformUpdate>& updates);
+
+} // namespace dart
+
+#endif
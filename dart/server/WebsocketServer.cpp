@@ -174,6 +174,39 @@ void WebsocketServer::broadcast(const string& message)
   }
 }
 
+// Sends a raw binary message to a specific client
+void WebsocketServer::sendBinary(ClientConnection conn, const string& message)
+{
+  // Send the message data to the client (will happen on the networking thread's
+  // event loop)
+  try
+  {
+    this->endpoint.send(conn, message, websocketpp::frame::opcode::binary);
+  }
+  catch (websocketpp::exception const& e)
+  {
+    dterr << e.what() << std::endl;
+    dterr << "Exception thrown from endpoint.send(). Continuing." << std::endl;
+  }
+  catch (...)
+  {
+    dterr << "Hit unknown error in endpoint.send(). Continuing." << std::endl;
+  }
+}
+
+// Broadcast a raw binary message to all clients
+void WebsocketServer::broadcastBinary(const string& message)
+{
+  // Prevent concurrent access to the list of open connections from multiple
+  // threads
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  for (auto conn : this->openConnections)
+  {
+    this->sendBinary(conn, message);
+  }
+}
+
 void WebsocketServer::onOpen(ClientConnection conn)
 {
   {
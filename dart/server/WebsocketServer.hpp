@@ -77,6 +77,12 @@ public:
   // Broadcast a raw text message to all clients
   void broadcast(const string& message);
 
+  // Sends a raw binary message to a specific client
+  void sendBinary(ClientConnection conn, const string& message);
+
+  // Broadcast a raw binary message to all clients
+  void broadcastBinary(const string& message);
+
 protected:
   static Json::Value parseJson(const string& json);
   static string stringifyJson(const Json::Value& val);
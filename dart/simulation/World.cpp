@@ -85,7 +85,9 @@ World::World(const std::string& _name)
     mPenetrationCorrectionEnabled(false),
     mWrtMass(std::make_shared<neural::WithRespectToMass>()),
     mUseFDOverride(false),
-    mSlowDebugResultsAgainstFD(false)
+    mSlowDebugResultsAgainstFD(false),
+    mUseVJPBackprop(false),
+    mGradientThreadPool(nullptr)
 {
   mIndices.push_back(0);
 
@@ -121,6 +123,9 @@ WorldPtr World::clone() const
   // Copy the WithRespectToMass pointer, so we have the same object
   worldClone->mWrtMass = mWrtMass;
 
+  // Share the gradient thread pool, so clones don't each spin up threads
+  worldClone->mGradientThreadPool = mGradientThreadPool;
+
   auto cd = getConstraintSolver()->getCollisionDetector();
   worldClone->getConstraintSolver()->setCollisionDetector(
       cd->cloneWithoutCollisionObjects());
@@ -575,6 +580,40 @@ bool World::getSlowDebugResultsAgainstFD()
   return mSlowDebugResultsAgainstFD;
 }
 
+//==============================================================================
+/// If this is true, BackpropSnapshot::backprop() only ever computes
+/// vector-Jacobian products, and never forms the full Jacobians. This is
+/// much cheaper for big worlds when all you need is the gradient of a scalar
+/// loss, which is the usual case. The Jacobian getters are unaffected.
+void World::setUseVJPBackprop(bool vjpBackprop)
+{
+  mUseVJPBackprop = vjpBackprop;
+}
+
+//==============================================================================
+bool World::getUseVJPBackprop()
+{
+  return mUseVJPBackprop;
+}
+
+//==============================================================================
+/// This sets a thread pool that BackpropSnapshot can use to compute the
+/// Jacobians in parallel. Constrained groups (and skeletons that aren't in
+/// any group) can't affect each other, so each one's block of the Jacobians
+/// is computed as a separate task, and the blocks are assembled afterwards.
+/// If this is null (the default), all the gradient work happens on the
+/// calling thread.
+void World::setGradientThreadPool(std::shared_ptr<common::ThreadPool> pool)
+{
+  mGradientThreadPool = pool;
+}
+
+//==============================================================================
+std::shared_ptr<common::ThreadPool> World::getGradientThreadPool()
+{
+  return mGradientThreadPool;
+}
+
 //==============================================================================
 int World::getSimFrames() const
 {
@@ -1369,6 +1408,18 @@ Eigen::MatrixXd World::getInvMassMatrix()
   return invMassMatrix;
 }
 
+//==============================================================================
+neural::BlockDiagonalMassMatrix World::getBlockMassMatrix()
+{
+  return neural::BlockDiagonalMassMatrix::createMassMatrix(mSkeletons);
+}
+
+//==============================================================================
+neural::BlockDiagonalMassMatrix World::getBlockInvMassMatrix()
+{
+  return neural::BlockDiagonalMassMatrix::createInvMassMatrix(mSkeletons);
+}
+
 //==============================================================================
 bool World::checkCollision(bool checkAllCollisions)
 {
@@ -39,6 +39,7 @@
 #ifndef DART_SIMULATION_WORLD_HPP_
 #define DART_SIMULATION_WORLD_HPP_
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -53,12 +54,17 @@
 #include "dart/constraint/SmartPointer.hpp"
 #include "dart/dynamics/SimpleFrame.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/BlockDiagonalMassMatrix.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/Recording.hpp"
 #include "dart/simulation/SmartPointer.hpp"
 
 namespace dart {
 
+namespace common {
+class ThreadPool;
+} // namespace common
+
 namespace integration {
 class Integrator;
 } // namespace integration
@@ -343,6 +349,17 @@ public:
   /// block-diagonal concatenation of each skeleton's inverse mass matrix.
   Eigen::MatrixXd getInvMassMatrix();
 
+  /// This constructs a mass matrix for the whole world that only stores the
+  /// diagonal blocks, one per tree of each skeleton. Prefer this to
+  /// getMassMatrix() when you only need to multiply by the mass matrix.
+  neural::BlockDiagonalMassMatrix getBlockMassMatrix();
+
+  /// This constructs an inverse mass matrix for the whole world that only
+  /// stores the diagonal blocks, one per tree of each skeleton. Prefer this to
+  /// getInvMassMatrix() when you only need to multiply by the inverse mass
+  /// matrix.
+  neural::BlockDiagonalMassMatrix getBlockInvMassMatrix();
+
   //--------------------------------------------------------------------------
   // Collision checking
   //--------------------------------------------------------------------------
@@ -510,6 +527,26 @@ public:
 
   bool getSlowDebugResultsAgainstFD();
 
+  /// If this is true, BackpropSnapshot::backprop() only ever computes
+  /// vector-Jacobian products, and never forms the full Jacobians. This is
+  /// much cheaper for big worlds when all you need is the gradient of a scalar
+  /// loss, which is the usual case. The Jacobian getters are unaffected.
+  void setUseVJPBackprop(bool vjpBackprop);
+
+  bool getUseVJPBackprop();
+
+  /// This sets a thread pool that BackpropSnapshot can use to compute the
+  /// Jacobians in parallel. Constrained groups (and skeletons that aren't in
+  /// any group) can't affect each other, so each one's block of the Jacobians
+  /// is computed as a separate task, and the blocks are assembled afterwards.
+  /// If this is null (the default), all the gradient work happens on the
+  /// calling thread.
+  void setGradientThreadPool(std::shared_ptr<common::ThreadPool> pool);
+
+  /// This returns the thread pool used to compute Jacobians, or null if we
+  /// compute them serially
+  std::shared_ptr<common::ThreadPool> getGradientThreadPool();
+
 protected:
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
@@ -522,6 +559,14 @@ protected:
   /// instructions.
   bool mSlowDebugResultsAgainstFD;
 
+  /// If this is true, BackpropSnapshot::backprop() only ever computes
+  /// vector-Jacobian products, and never forms the full Jacobians.
+  bool mUseVJPBackprop;
+
+  /// If this isn't null, BackpropSnapshot fans the independent constrained
+  /// groups' parts of the Jacobians out across this pool
+  std::shared_ptr<common::ThreadPool> mGradientThreadPool;
+
   /// Register when a Skeleton's name is changed
   void handleSkeletonNameChange(
       const dynamics::ConstMetaSkeletonPtr& _skeleton);
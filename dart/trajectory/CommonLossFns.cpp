@@ -0,0 +1,303 @@
+#include "dart/trajectory/CommonLossFns.hpp"
+
+#include <mutex>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/neural/Mapping.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace trajectory {
+
+namespace {
+
+//==============================================================================
+/// The losses below only touch a few entries of the gradient, so they start
+/// by clearing the whole thing
+void zeroGradient(TrajectoryRollout* gradWrtRollout)
+{
+  for (const std::string& key : gradWrtRollout->getMappings())
+  {
+    gradWrtRollout->getPoses(key).setZero();
+    gradWrtRollout->getVels(key).setZero();
+    gradWrtRollout->getForces(key).setZero();
+  }
+  gradWrtRollout->getMasses().setZero();
+}
+
+} // namespace
+
+//==============================================================================
+/// This is the squared distance of the final state of the rollout (in
+/// `mapping`) from a target state
+LossFn finalStateDistanceLoss(
+    const Eigen::VectorXd& targetPos,
+    const Eigen::VectorXd& targetVel,
+    double posWeight,
+    double velWeight,
+    const std::string& mapping)
+{
+  TrajectoryLossFn loss = [targetPos, targetVel, posWeight, velWeight, mapping](
+                              const TrajectoryRollout* rollout) {
+    int last = rollout->getPosesConst(mapping).cols() - 1;
+    return posWeight
+               * (rollout->getPosesConst(mapping).col(last) - targetPos)
+                     .squaredNorm()
+           + velWeight
+                 * (rollout->getVelsConst(mapping).col(last) - targetVel)
+                       .squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossAndGrad
+      = [targetPos, targetVel, posWeight, velWeight, mapping](
+            const TrajectoryRollout* rollout,
+            /* OUT */ TrajectoryRollout* gradWrtRollout) {
+          zeroGradient(gradWrtRollout);
+          int last = rollout->getPosesConst(mapping).cols() - 1;
+          Eigen::VectorXd posDiff
+              = rollout->getPosesConst(mapping).col(last) - targetPos;
+          Eigen::VectorXd velDiff
+              = rollout->getVelsConst(mapping).col(last) - targetVel;
+          gradWrtRollout->getPoses(mapping).col(last)
+              = 2 * posWeight * posDiff;
+          gradWrtRollout->getVels(mapping).col(last)
+              = 2 * velWeight * velDiff;
+          return posWeight * posDiff.squaredNorm()
+                 + velWeight * velDiff.squaredNorm();
+        };
+  return LossFn(loss, lossAndGrad);
+}
+
+//==============================================================================
+/// This is the control effort over the whole rollout, weight * |F|^2
+LossFn controlEffortLoss(double weight, const std::string& mapping)
+{
+  TrajectoryLossFn loss = [weight, mapping](const TrajectoryRollout* rollout) {
+    return weight * rollout->getForcesConst(mapping).squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossAndGrad
+      = [weight, mapping](
+            const TrajectoryRollout* rollout,
+            /* OUT */ TrajectoryRollout* gradWrtRollout) {
+          zeroGradient(gradWrtRollout);
+          gradWrtRollout->getForces(mapping)
+              = 2 * weight * rollout->getForcesConst(mapping);
+          return weight * rollout->getForcesConst(mapping).squaredNorm();
+        };
+  return LossFn(loss, lossAndGrad);
+}
+
+//==============================================================================
+/// This is the squared distance of the world space positions of `nodes` from
+/// `targets`, summed over the rollout
+LossFn worldSpaceBodyTrackingLoss(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<dynamics::BodyNode*>& nodes,
+    const Eigen::MatrixXd& targets,
+    double weight,
+    const std::string& mapping,
+    std::shared_ptr<neural::Mapping> mappingImpl)
+{
+  assert(targets.rows() == 3 * static_cast<int>(nodes.size()));
+  assert(mapping == "identity" || mappingImpl != nullptr);
+
+  // Every evaluation moves `world` around, so they have to take turns
+  std::shared_ptr<std::mutex> worldMutex = std::make_shared<std::mutex>();
+
+  // This gets the poses we're tracking, which are either the whole rollout or
+  // just the last timestep
+  auto getTrackedPoses = [targets, mapping](const TrajectoryRollout* rollout) {
+    const Eigen::Ref<const Eigen::MatrixXd> poses
+        = rollout->getPosesConst(mapping);
+    assert(targets.cols() == 1 || targets.cols() == poses.cols());
+    return Eigen::MatrixXd(poses.rightCols(targets.cols()));
+  };
+
+  // This sets one column of tracked poses onto `world`
+  auto setPositions = [world, mappingImpl](Eigen::VectorXd pos) {
+    if (mappingImpl)
+      mappingImpl->setPositions(world, pos);
+    else
+      world->setPositions(pos);
+  };
+
+  // This returns the world space positions of `nodes`, one column per column
+  // of `poses`
+  auto getBodyPoses = [world, nodes, mappingImpl, setPositions](
+                          const Eigen::MatrixXd& poses) {
+    if (!mappingImpl)
+    {
+      return neural::convertJointSpaceToWorldSpace(
+          world, poses, nodes, neural::ConvertToSpace::POS_LINEAR);
+    }
+    Eigen::MatrixXd bodyPoses(3 * nodes.size(), poses.cols());
+    for (int t = 0; t < poses.cols(); t++)
+    {
+      setPositions(poses.col(t));
+      bodyPoses.col(t) = neural::convertJointSpaceToWorldSpace(
+          world,
+          world->getPositions(),
+          nodes,
+          neural::ConvertToSpace::POS_LINEAR);
+    }
+    return bodyPoses;
+  };
+
+  TrajectoryLossFn loss
+      = [world, targets, weight, worldMutex, getTrackedPoses, getBodyPoses](
+            const TrajectoryRollout* rollout) {
+          const std::lock_guard<std::mutex> lock(*worldMutex);
+          neural::RestorableSnapshot snapshot(world);
+          Eigen::MatrixXd bodyPoses = getBodyPoses(getTrackedPoses(rollout));
+          snapshot.restore();
+          return weight * (bodyPoses - targets).squaredNorm();
+        };
+  TrajectoryLossFnAndGrad lossAndGrad
+      = [world,
+         nodes,
+         targets,
+         weight,
+         mapping,
+         mappingImpl,
+         worldMutex,
+         getTrackedPoses,
+         getBodyPoses,
+         setPositions](
+            const TrajectoryRollout* rollout,
+            /* OUT */ TrajectoryRollout* gradWrtRollout) {
+          zeroGradient(gradWrtRollout);
+          const std::lock_guard<std::mutex> lock(*worldMutex);
+          neural::RestorableSnapshot snapshot(world);
+          Eigen::MatrixXd poses = getTrackedPoses(rollout);
+          Eigen::MatrixXd bodyDiff = getBodyPoses(poses) - targets;
+
+          // The body Jacobians depend on the joint positions, so we need to
+          // map the gradient back to joint space one timestep at a time
+          int offset = gradWrtRollout->getPoses(mapping).cols() - poses.cols();
+          for (int t = 0; t < poses.cols(); t++)
+          {
+            setPositions(poses.col(t));
+            Eigen::VectorXd jointGrad = neural::convertJointSpaceToWorldSpace(
+                world,
+                2 * weight * bodyDiff.col(t),
+                nodes,
+                neural::ConvertToSpace::POS_LINEAR,
+                true,
+                false);
+            if (mappingImpl)
+            {
+              gradWrtRollout->getPoses(mapping).col(offset + t)
+                  = mappingImpl->getMappedPosToRealPosJac(world).transpose()
+                    * jointGrad;
+            }
+            else
+            {
+              gradWrtRollout->getPoses(mapping).col(offset + t) = jointGrad;
+            }
+          }
+          snapshot.restore();
+          return weight * bodyDiff.squaredNorm();
+        };
+  return LossFn(loss, lossAndGrad);
+}
+
+//==============================================================================
+WeightedLossBuilder::WeightedLossBuilder()
+{
+}
+
+//==============================================================================
+/// This adds `weight` * `loss` to the sum, and returns this builder so calls
+/// can be chained
+WeightedLossBuilder& WeightedLossBuilder::add(LossFn loss, double weight)
+{
+  mTerms.push_back(loss);
+  mWeights.push_back(weight);
+  return *this;
+}
+
+//==============================================================================
+/// Returns the number of terms added so far
+int WeightedLossBuilder::getNumTerms() const
+{
+  return mTerms.size();
+}
+
+//==============================================================================
+/// This returns a LossFn that evaluates the weighted sum of all the terms
+/// added so far
+LossFn WeightedLossBuilder::build() const
+{
+  // LossFn's methods aren't const, so the terms live behind a shared_ptr that
+  // all copies of the returned LossFn use
+  std::shared_ptr<std::vector<LossFn>> terms
+      = std::make_shared<std::vector<LossFn>>(mTerms);
+  std::vector<double> weights = mWeights;
+
+  TrajectoryLossFn loss = [terms, weights](const TrajectoryRollout* rollout) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < terms->size(); i++)
+    {
+      sum += weights[i] * (*terms)[i].getLoss(rollout);
+    }
+    return sum;
+  };
+  TrajectoryLossFnAndGrad lossAndGrad
+      = [terms, weights](
+            const TrajectoryRollout* rollout,
+            /* OUT */ TrajectoryRollout* gradWrtRollout) {
+          if (terms->size() == 0)
+          {
+            zeroGradient(gradWrtRollout);
+            return 0.0;
+          }
+
+          // The first term writes straight into the output, and the rest go
+          // through a scratch rollout of the same shape. Terms with a custom
+          // gradient may only fill in the blocks they care about, so we zero
+          // the buffer before handing it to each term.
+          zeroGradient(gradWrtRollout);
+          double sum
+              = weights[0]
+                * (*terms)[0].getLossAndGradient(rollout, gradWrtRollout);
+          if (weights[0] != 1.0)
+          {
+            for (const std::string& key : gradWrtRollout->getMappings())
+            {
+              gradWrtRollout->getPoses(key) *= weights[0];
+              gradWrtRollout->getVels(key) *= weights[0];
+              gradWrtRollout->getForces(key) *= weights[0];
+            }
+            gradWrtRollout->getMasses() *= weights[0];
+          }
+          if (terms->size() == 1)
+          {
+            return sum;
+          }
+
+          TrajectoryRolloutReal scratch(gradWrtRollout);
+          for (std::size_t i = 1; i < terms->size(); i++)
+          {
+            zeroGradient(&scratch);
+            sum += weights[i]
+                   * (*terms)[i].getLossAndGradient(rollout, &scratch);
+            for (const std::string& key : gradWrtRollout->getMappings())
+            {
+              gradWrtRollout->getPoses(key)
+                  += weights[i] * scratch.getPosesConst(key);
+              gradWrtRollout->getVels(key)
+                  += weights[i] * scratch.getVelsConst(key);
+              gradWrtRollout->getForces(key)
+                  += weights[i] * scratch.getForcesConst(key);
+            }
+            gradWrtRollout->getMasses()
+                += weights[i] * scratch.getMassesConst();
+          }
+          return sum;
+        };
+  return LossFn(loss, lossAndGrad);
+}
+
+} // namespace trajectory
+} // namespace dart
@@ -0,0 +1,99 @@
+#ifndef DART_TRAJECTORY_COMMON_LOSS_FNS_HPP_
+#define DART_TRAJECTORY_COMMON_LOSS_FNS_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/trajectory/LossFn.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace dynamics {
+class BodyNode;
+}
+
+namespace neural {
+class Mapping;
+}
+
+namespace trajectory {
+
+/// This is the squared distance of the final state of the rollout (in
+/// `mapping`) from a target state: posWeight * |p_T - targetPos|^2 +
+/// velWeight * |v_T - targetVel|^2. This comes with an analytical gradient.
+LossFn finalStateDistanceLoss(
+    const Eigen::VectorXd& targetPos,
+    const Eigen::VectorXd& targetVel,
+    double posWeight = 1.0,
+    double velWeight = 1.0,
+    const std::string& mapping = "identity");
+
+/// This is the control effort over the whole rollout, weight * |F|^2, where F
+/// is the matrix of forces in `mapping`. This comes with an analytical
+/// gradient.
+LossFn controlEffortLoss(
+    double weight = 1.0, const std::string& mapping = "identity");
+
+/// This is the squared distance of the world space positions of `nodes` from
+/// `targets`, summed over the rollout. The world space positions are what you
+/// get from neural::convertJointSpaceToWorldSpace() with
+/// ConvertToSpace::POS_LINEAR on the poses in `mapping`, so each column of
+/// `targets` stacks 3 values per node. If `targets` has a column per
+/// timestep, every timestep is tracked. If it has a single column, only the
+/// final timestep is. The gradient is computed analytically with the body
+/// Jacobians on each timestep.
+///
+/// Any mapping other than "identity" needs `mappingImpl`, which should be the
+/// same Mapping registered under that name on the Problem. It's used to set
+/// the mapped positions onto `world`, and to carry the gradient back to them.
+///
+/// Evaluating this sets the positions of `world`, and restores its state
+/// before returning. Concurrent evaluations of the same loss are serialized
+/// on a mutex, so this is safe to use from MultiShot's parallel workers, but
+/// nothing else may use `world` while the loss is being evaluated.
+LossFn worldSpaceBodyTrackingLoss(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<dynamics::BodyNode*>& nodes,
+    const Eigen::MatrixXd& targets,
+    double weight = 1.0,
+    const std::string& mapping = "identity",
+    std::shared_ptr<neural::Mapping> mappingImpl = nullptr);
+
+/// This builds a LossFn that is a weighted sum of other LossFns. The
+/// gradient of each term is accumulated in C++, so summing native losses
+/// (like the ones above) never leaves C++. Terms that don't have an
+/// analytical gradient fall back to LossFn's finite differencing, just for
+/// that term.
+class WeightedLossBuilder
+{
+public:
+  WeightedLossBuilder();
+
+  /// This adds `weight` * `loss` to the sum, and returns this builder so calls
+  /// can be chained
+  WeightedLossBuilder& add(LossFn loss, double weight = 1.0);
+
+  /// Returns the number of terms added so far
+  int getNumTerms() const;
+
+  /// This returns a LossFn that evaluates the weighted sum of all the terms
+  /// added so far. Adding more terms afterwards doesn't change the returned
+  /// LossFn.
+  LossFn build() const;
+
+protected:
+  std::vector<LossFn> mTerms;
+  std::vector<double> mWeights;
+};
+
+} // namespace trajectory
+} // namespace dart
+
+#endif
@@ -0,0 +1,664 @@
+#include "dart/trajectory/ILQROptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/performance/PerformanceLog.hpp"
+#include "dart/realtime/Millis.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/SingleShot.hpp"
+
+#define LOG_PERFORMANCE_ILQR
+
+using namespace dart;
+using namespace simulation;
+using namespace performance;
+using namespace neural;
+
+namespace dart {
+namespace trajectory {
+
+//==============================================================================
+ILQROptimizer::ILQROptimizer()
+  : mIterationLimit(100),
+    mTolerance(1e-7),
+    mBoxConstrained(false),
+    mRegularization(1e-6),
+    mRecordPerfLog(false),
+    mRecordIterations(true),
+    mSilenceOutput(false)
+{
+}
+
+//==============================================================================
+/// This optimizes the forces of `shot`, which must be a SingleShot, and
+/// leaves the optimized forces in `shot` when it's done.
+std::shared_ptr<Solution> ILQROptimizer::optimize(
+    Problem* shot, std::shared_ptr<Solution> reuseRecord)
+{
+  std::shared_ptr<Solution> record
+      = reuseRecord ? reuseRecord : std::make_shared<Solution>();
+
+  if (dynamic_cast<SingleShot*>(shot) == nullptr)
+  {
+    std::cout << "ILQROptimizer only supports SingleShot problems. Doing "
+                 "nothing."
+              << std::endl;
+    record->setSuccess(false);
+    return record;
+  }
+
+  if (mRecordPerfLog)
+    record->startPerfLog();
+
+  record->setSuccess(runIterations(shot, record.get()));
+
+  // This copies the optimizer settings, so the Solution can be re-optimized
+  // (for example by MPCLocal) even after this optimizer is gone. Like with
+  // IPOPT, the shot needs to outlive the Solution.
+  ILQROptimizer settings = *this;
+  Solution* rawRecord = record.get();
+  record->registerForReoptimization([settings, shot, rawRecord]() mutable {
+    return settings.runIterations(shot, rawRecord);
+  });
+
+  return record;
+}
+
+//==============================================================================
+void ILQROptimizer::setIterationLimit(int iterationLimit)
+{
+  mIterationLimit = iterationLimit;
+}
+
+//==============================================================================
+/// We stop once an iteration improves the loss by less than `tolerance`
+/// times the loss
+void ILQROptimizer::setTolerance(double tolerance)
+{
+  mTolerance = tolerance;
+}
+
+//==============================================================================
+/// If this is true, the backward pass solves a box-constrained QP for the
+/// controls on each timestep, so the forces respect the upper and lower
+/// bounds of the shot (which includes pinned forces). Otherwise the controls
+/// are unconstrained.
+void ILQROptimizer::setBoxConstrainedControls(bool boxConstrained)
+{
+  mBoxConstrained = boxConstrained;
+}
+
+//==============================================================================
+/// This sets the initial Levenberg-Marquardt regularization added to the
+/// Hessian of the controls during the backward pass
+void ILQROptimizer::setRegularization(double regularization)
+{
+  mRegularization = regularization;
+}
+
+//==============================================================================
+void ILQROptimizer::setRecordPerformanceLog(bool recordPerfLog)
+{
+  mRecordPerfLog = recordPerfLog;
+}
+
+//==============================================================================
+void ILQROptimizer::setRecordIterations(bool recordIterations)
+{
+  mRecordIterations = recordIterations;
+}
+
+//==============================================================================
+void ILQROptimizer::setSilenceOutput(bool silenceOutput)
+{
+  mSilenceOutput = silenceOutput;
+}
+
+//==============================================================================
+/// This runs iterations of iLQR on the shot, starting from its current
+/// forces. This returns true if we converged before hitting the iteration
+/// limit.
+bool ILQROptimizer::runIterations(Problem* shot, Solution* record)
+{
+  std::shared_ptr<simulation::World> world = shot->mWorld;
+
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_ILQR
+  if (record->getPerfLog() != nullptr)
+  {
+    thisLog = record->getPerfLog()->startRun("ILQROptimizer.runIterations");
+  }
+#endif
+
+  int posDim = shot->getRepresentation()->getPosDim();
+  int velDim = shot->getRepresentation()->getVelDim();
+  int forceDim = shot->getRepresentation()->getForceDim();
+  int steps = shot->getNumSteps();
+
+  // The forces are the last (forceDim * steps) entries of the flat dynamic
+  // problem, after the starting state if we're tuning it
+  int staticDim = shot->getFlatStaticProblemDim(world);
+  int dynamicDim = shot->getFlatDynamicProblemDim(world);
+  int forceStart = dynamicDim - forceDim * steps;
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Zero(dynamicDim);
+
+  shot->getUpperBounds(world, flatStatic, flatDynamic, thisLog);
+  Eigen::MatrixXd upperBounds = Eigen::Map<Eigen::MatrixXd>(
+      flatDynamic.data() + forceStart, forceDim, steps);
+  shot->getLowerBounds(world, flatStatic, flatDynamic, thisLog);
+  Eigen::MatrixXd lowerBounds = Eigen::Map<Eigen::MatrixXd>(
+      flatDynamic.data() + forceStart, forceDim, steps);
+  shot->flatten(world, flatStatic, flatDynamic, thisLog);
+
+  Trajectory initial;
+  initial.states = Eigen::MatrixXd::Zero(posDim + velDim, steps + 1);
+  initial.states.col(0).head(posDim) = shot->getStartPos();
+  initial.states.col(0).tail(velDim) = shot->getStartVel();
+  initial.forces = Eigen::Map<Eigen::MatrixXd>(
+      flatDynamic.data() + forceStart, forceDim, steps);
+  if (mBoxConstrained)
+  {
+    initial.forces
+        = initial.forces.cwiseMax(lowerBounds).cwiseMin(upperBounds);
+  }
+  Trajectory nominal = forwardPass(
+      shot, initial, nullptr, 0.0, lowerBounds, upperBounds, thisLog);
+
+  const double maxRegularization = 1e10;
+  const double minRegularization = 1e-6;
+  const int maxLineSearchSteps = 10;
+
+  double regularization = mRegularization;
+  bool converged = false;
+  for (int iter = 0; iter < mIterationLimit; iter++)
+  {
+    long startTime = timeSinceEpochMillis();
+
+    LossExpansion expansion = expandLoss(shot, nominal, thisLog);
+
+    // Keep increasing the regularization until the control Hessian is
+    // positive definite
+    FeedbackPolicy policy;
+    bool backwardPassSucceeded = false;
+    while (!backwardPassSucceeded && regularization <= maxRegularization)
+    {
+      backwardPassSucceeded = backwardPass(
+          shot,
+          nominal,
+          expansion,
+          regularization,
+          lowerBounds,
+          upperBounds,
+          policy,
+          thisLog);
+      if (!backwardPassSucceeded)
+      {
+        regularization = std::max(regularization * 10, minRegularization);
+      }
+    }
+    if (!backwardPassSucceeded)
+    {
+      break;
+    }
+
+    // If the quadratic model doesn't expect any meaningful improvement, we're
+    // at a local minimum
+    double tolerance = mTolerance * std::max(std::abs(nominal.loss), 1.0);
+    if (-(policy.expectedLinear + policy.expectedQuadratic) < tolerance)
+    {
+      converged = true;
+      break;
+    }
+
+    // Backtracking line search on the step size
+    bool accepted = false;
+    double improvement = 0.0;
+    double alpha = 1.0;
+    for (int i = 0; i < maxLineSearchSteps; i++)
+    {
+      Trajectory candidate = forwardPass(
+          shot, nominal, &policy, alpha, lowerBounds, upperBounds, thisLog);
+      double expectedImprovement
+          = -(alpha * policy.expectedLinear
+              + alpha * alpha * policy.expectedQuadratic);
+      improvement = nominal.loss - candidate.loss;
+      if (improvement > 0 && improvement > 1e-4 * expectedImprovement)
+      {
+        nominal = candidate;
+        accepted = true;
+        break;
+      }
+      alpha *= 0.5;
+    }
+
+    long durationMillis = timeSinceEpochMillis() - startTime;
+
+    if (!accepted)
+    {
+      // The step was no good, so fall back towards gradient descent
+      regularization = std::max(regularization * 10, minRegularization);
+      if (regularization > maxRegularization)
+      {
+        break;
+      }
+      continue;
+    }
+    regularization = std::max(regularization / 10, mRegularization);
+
+    if (mRecordIterations)
+    {
+      record->registerIteration(
+          iter, nominal.rollout.get(), nominal.loss, 0.0, durationMillis);
+    }
+    if (!mSilenceOutput)
+    {
+      std::cout << "(" << durationMillis << "ms) Loss:  " << nominal.loss
+                << "  Step:  " << alpha << "  Reg:  " << regularization
+                << std::endl;
+    }
+
+    if (improvement < tolerance)
+    {
+      converged = true;
+      break;
+    }
+  }
+
+  shot->setForcesRaw(nominal.forces, thisLog);
+
+#ifdef LOG_PERFORMANCE_ILQR
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return converged;
+}
+
+//==============================================================================
+/// This rolls out the shot from the start state in `nominal`. If `policy` is
+/// null, this uses the forces in `nominal` as is. Otherwise it applies the
+/// policy with a step size of `alpha`, relative to `nominal`.
+ILQROptimizer::Trajectory ILQROptimizer::forwardPass(
+    Problem* shot,
+    const Trajectory& nominal,
+    const FeedbackPolicy* policy,
+    double alpha,
+    const Eigen::MatrixXd& lowerBounds,
+    const Eigen::MatrixXd& upperBounds,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_ILQR
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("ILQROptimizer.forwardPass");
+  }
+#endif
+
+  std::shared_ptr<simulation::World> world = shot->mWorld;
+  const std::shared_ptr<Mapping> representation = shot->getRepresentation();
+  const std::string& representationName = shot->getRepresentationName();
+  int posDim = representation->getPosDim();
+  int velDim = representation->getVelDim();
+  int steps = shot->getNumSteps();
+
+  Trajectory result;
+  result.states = Eigen::MatrixXd::Zero(posDim + velDim, steps + 1);
+  result.states.col(0) = nominal.states.col(0);
+  result.forces = nominal.forces;
+  result.snapshots.reserve(steps);
+
+  RestorableSnapshot snapshot(world);
+  representation->setPositions(world, result.states.col(0).head(posDim));
+  representation->setVelocities(world, result.states.col(0).tail(velDim));
+  for (int t = 0; t < steps; t++)
+  {
+    if (policy != nullptr)
+    {
+      result.forces.col(t)
+          += alpha * policy->k[t]
+             + policy->K[t] * (result.states.col(t) - nominal.states.col(t));
+      if (mBoxConstrained)
+      {
+        result.forces.col(t) = result.forces.col(t)
+                                   .cwiseMax(lowerBounds.col(t))
+                                   .cwiseMin(upperBounds.col(t));
+      }
+    }
+    representation->setForces(world, result.forces.col(t));
+    MappedBackpropSnapshotPtr stepSnapshot = mappedForwardPass(
+        world, representationName, shot->getMappings());
+    result.states.col(t + 1).head(posDim)
+        = stepSnapshot->getPostStepPosition(representationName);
+    result.states.col(t + 1).tail(velDim)
+        = stepSnapshot->getPostStepVelocity(representationName);
+    result.snapshots.push_back(stepSnapshot);
+  }
+  snapshot.restore();
+
+  // Lay the rollout out the same way SingleShot::getStates() would, so we can
+  // hand it to the loss
+  result.rollout = std::make_shared<TrajectoryRolloutReal>(shot);
+  for (std::string key : result.rollout->getMappings())
+  {
+    for (int t = 0; t < steps; t++)
+    {
+      result.rollout->getPoses(key).col(t)
+          = result.snapshots[t]->getPostStepPosition(key);
+      result.rollout->getVels(key).col(t)
+          = result.snapshots[t]->getPostStepVelocity(key);
+      result.rollout->getForces(key).col(t)
+          = result.snapshots[t]->getPreStepTorques(key);
+    }
+  }
+  result.rollout->getMasses() = world->getMasses();
+  result.loss = shot->mLoss.getLoss(result.rollout.get(), thisLog);
+
+#ifdef LOG_PERFORMANCE_ILQR
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return result;
+}
+
+//==============================================================================
+/// This computes the gradient and block-diagonal Hessian of the loss around
+/// `nominal`
+ILQROptimizer::LossExpansion ILQROptimizer::expandLoss(
+    Problem* shot, const Trajectory& nominal, PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_ILQR
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("ILQROptimizer.expandLoss");
+  }
+#endif
+
+  const std::string& rep = shot->getRepresentationName();
+  int posDim = shot->getRepresentation()->getPosDim();
+  int velDim = shot->getRepresentation()->getVelDim();
+  int forceDim = shot->getRepresentation()->getForceDim();
+  int stateDim = posDim + velDim;
+  int steps = shot->getNumSteps();
+
+  LossExpansion expansion;
+  TrajectoryRolloutReal grad(shot);
+  shot->mLoss.getLossAndGradient(nominal.rollout.get(), &grad, thisLog);
+  expansion.gradState = Eigen::MatrixXd::Zero(stateDim, steps);
+  expansion.gradState.topRows(posDim) = grad.getPosesConst(rep);
+  expansion.gradState.bottomRows(velDim) = grad.getVelsConst(rep);
+  expansion.gradForce = grad.getForcesConst(rep);
+
+  // iLQR only has room for the state and force blocks on each timestep, so we
+  // drop the terms relating the state to the force. Losses without an
+  // analytical gradient get zero blocks here, which leaves only the
+  // regularization on the force block.
+  std::vector<Eigen::MatrixXd> blocks
+      = shot->mLoss.getHessianBlocks(nominal.rollout.get(), {rep}, thisLog);
+  expansion.hessState.reserve(steps);
+  expansion.hessForce.reserve(steps);
+  for (int t = 0; t < steps; t++)
+  {
+    expansion.hessState.push_back(blocks[t].topLeftCorner(stateDim, stateDim));
+    expansion.hessForce.push_back(
+        blocks[t].bottomRightCorner(forceDim, forceDim));
+  }
+
+#ifdef LOG_PERFORMANCE_ILQR
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return expansion;
+}
+
+//==============================================================================
+/// This runs the Riccati backward pass. This returns false if the Hessian
+/// of the controls wasn't positive definite, which means we need more
+/// regularization.
+bool ILQROptimizer::backwardPass(
+    Problem* shot,
+    const Trajectory& nominal,
+    const LossExpansion& expansion,
+    double regularization,
+    const Eigen::MatrixXd& lowerBounds,
+    const Eigen::MatrixXd& upperBounds,
+    /* OUT */ FeedbackPolicy& policy,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_ILQR
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("ILQROptimizer.backwardPass");
+  }
+#endif
+
+  std::shared_ptr<simulation::World> world = shot->mWorld;
+  const std::string& rep = shot->getRepresentationName();
+  int posDim = shot->getRepresentation()->getPosDim();
+  int velDim = shot->getRepresentation()->getVelDim();
+  int forceDim = shot->getRepresentation()->getForceDim();
+  int stateDim = posDim + velDim;
+  int steps = shot->getNumSteps();
+
+  policy.k.resize(steps);
+  policy.K.resize(steps);
+  policy.expectedLinear = 0.0;
+  policy.expectedQuadratic = 0.0;
+
+  // The value function at the end of the trajectory is just the loss on the
+  // final state
+  Eigen::VectorXd Vx = expansion.gradState.col(steps - 1);
+  Eigen::MatrixXd Vxx = expansion.hessState[steps - 1];
+
+  Eigen::MatrixXd A = Eigen::MatrixXd::Zero(stateDim, stateDim);
+  Eigen::MatrixXd B = Eigen::MatrixXd::Zero(stateDim, forceDim);
+  bool succeeded = true;
+  for (int t = steps - 1; t >= 0; t--)
+  {
+    // Linearize the dynamics. Positions update with the old velocity, so the
+    // forces only reach the new velocity.
+    MappedBackpropSnapshotPtr snapshot = nominal.snapshots[t];
+    A.block(0, 0, posDim, posDim)
+        = snapshot->getPosPosJacobian(world, rep, rep, thisLog);
+    A.block(0, posDim, posDim, velDim)
+        = snapshot->getVelPosJacobian(world, rep, rep, thisLog);
+    A.block(posDim, 0, velDim, posDim)
+        = snapshot->getPosVelJacobian(world, rep, rep, thisLog);
+    A.block(posDim, posDim, velDim, velDim)
+        = snapshot->getVelVelJacobian(world, rep, rep, thisLog);
+    B.block(posDim, 0, velDim, forceDim)
+        = snapshot->getForceVelJacobian(world, rep, rep, thisLog);
+
+    Eigen::VectorXd Qx = A.transpose() * Vx;
+    Eigen::VectorXd Qu = expansion.gradForce.col(t) + B.transpose() * Vx;
+    Eigen::MatrixXd Qxx = A.transpose() * Vxx * A;
+    Eigen::MatrixXd Quu = expansion.hessForce[t] + B.transpose() * Vxx * B;
+    Eigen::MatrixXd Qux = B.transpose() * Vxx * A;
+    Eigen::MatrixXd QuuReg
+        = Quu + regularization * Eigen::MatrixXd::Identity(forceDim, forceDim);
+
+    Eigen::VectorXd k = Eigen::VectorXd::Zero(forceDim);
+    Eigen::MatrixXd K = Eigen::MatrixXd::Zero(forceDim, stateDim);
+    if (mBoxConstrained)
+    {
+      std::vector<int> freeIndices;
+      if (!solveBoxQP(
+              QuuReg,
+              Qu,
+              lowerBounds.col(t) - nominal.forces.col(t),
+              upperBounds.col(t) - nominal.forces.col(t),
+              k,
+              freeIndices))
+      {
+        succeeded = false;
+        break;
+      }
+      // Controls that are up against a bound get no feedback
+      if (freeIndices.size() > 0)
+      {
+        int numFree = freeIndices.size();
+        Eigen::MatrixXd QuuFree = Eigen::MatrixXd::Zero(numFree, numFree);
+        Eigen::MatrixXd QuxFree = Eigen::MatrixXd::Zero(numFree, stateDim);
+        for (int i = 0; i < numFree; i++)
+        {
+          for (int j = 0; j < numFree; j++)
+          {
+            QuuFree(i, j) = QuuReg(freeIndices[i], freeIndices[j]);
+          }
+          QuxFree.row(i) = Qux.row(freeIndices[i]);
+        }
+        Eigen::MatrixXd KFree = -QuuFree.llt().solve(QuxFree);
+        for (int i = 0; i < numFree; i++)
+        {
+          K.row(freeIndices[i]) = KFree.row(i);
+        }
+      }
+    }
+    else
+    {
+      Eigen::LLT<Eigen::MatrixXd> QuuFactor(QuuReg);
+      if (QuuFactor.info() != Eigen::Success)
+      {
+        succeeded = false;
+        break;
+      }
+      k = -QuuFactor.solve(Qu);
+      K = -QuuFactor.solve(Qux);
+    }
+
+    policy.k[t] = k;
+    policy.K[t] = K;
+    policy.expectedLinear += k.dot(Qu);
+    policy.expectedQuadratic += 0.5 * k.dot(Quu * k);
+
+    Vx = Qx + K.transpose() * Quu * k + K.transpose() * Qu
+         + Qux.transpose() * k;
+    Vxx = Qxx + K.transpose() * Quu * K + K.transpose() * Qux
+          + Qux.transpose() * K;
+    Vxx = 0.5 * (Vxx + Vxx.transpose());
+
+    // Add the loss on the state at the start of this timestep, which is the
+    // state at the end of the previous one
+    if (t > 0)
+    {
+      Vx += expansion.gradState.col(t - 1);
+      Vxx += expansion.hessState[t - 1];
+    }
+  }
+
+#ifdef LOG_PERFORMANCE_ILQR
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return succeeded;
+}
+
+//==============================================================================
+/// This minimizes 0.5 x^T H x + g^T x subject to lower <= x <= upper, with
+/// a projected Newton method. It fills `freeIndices` with the dimensions of
+/// x that aren't up against a bound at the solution. This returns false if
+/// the Hessian wasn't positive definite on the free dimensions.
+bool ILQROptimizer::solveBoxQP(
+    const Eigen::MatrixXd& H,
+    const Eigen::VectorXd& g,
+    const Eigen::VectorXd& lower,
+    const Eigen::VectorXd& upper,
+    /* OUT */ Eigen::VectorXd& x,
+    /* OUT */ std::vector<int>& freeIndices)
+{
+  const int maxIterations = 100;
+  const double minImprovement = 1e-12;
+  const double armijo = 0.1;
+
+  int n = g.size();
+  x = Eigen::VectorXd::Zero(n).cwiseMax(lower).cwiseMin(upper);
+  double value = 0.5 * x.dot(H * x) + g.dot(x);
+
+  for (int iter = 0; iter <= maxIterations; iter++)
+  {
+    // A dimension is clamped if it's on a bound, and the gradient is pushing
+    // it further into that bound
+    Eigen::VectorXd grad = g + H * x;
+    freeIndices.clear();
+    for (int i = 0; i < n; i++)
+    {
+      bool clampedLower = x(i) <= lower(i) && grad(i) > 0;
+      bool clampedUpper = x(i) >= upper(i) && grad(i) < 0;
+      if (!clampedLower && !clampedUpper)
+        freeIndices.push_back(i);
+    }
+    int numFree = freeIndices.size();
+    if (numFree == 0 || iter == maxIterations)
+      break;
+
+    // Take a Newton step on the free dimensions, holding the rest fixed
+    Eigen::MatrixXd HFree = Eigen::MatrixXd::Zero(numFree, numFree);
+    Eigen::VectorXd gradFree = Eigen::VectorXd::Zero(numFree);
+    for (int i = 0; i < numFree; i++)
+    {
+      for (int j = 0; j < numFree; j++)
+      {
+        HFree(i, j) = H(freeIndices[i], freeIndices[j]);
+      }
+      gradFree(i) = grad(freeIndices[i]);
+    }
+    Eigen::LLT<Eigen::MatrixXd> HFreeFactor(HFree);
+    if (HFreeFactor.info() != Eigen::Success)
+      return false;
+    Eigen::VectorXd stepFree = -HFreeFactor.solve(gradFree);
+    Eigen::VectorXd search = Eigen::VectorXd::Zero(n);
+    for (int i = 0; i < numFree; i++)
+    {
+      search(freeIndices[i]) = stepFree(i);
+    }
+
+    // Projected backtracking line search
+    double step = 1.0;
+    bool accepted = false;
+    Eigen::VectorXd candidate;
+    double candidateValue = value;
+    while (step > 1e-10)
+    {
+      candidate = (x + step * search).cwiseMax(lower).cwiseMin(upper);
+      candidateValue = 0.5 * candidate.dot(H * candidate) + g.dot(candidate);
+      if (candidateValue - value <= armijo * grad.dot(candidate - x))
+      {
+        accepted = true;
+        break;
+      }
+      step *= 0.5;
+    }
+    if (!accepted)
+      break;
+
+    double improvement = value - candidateValue;
+    x = candidate;
+    value = candidateValue;
+    if (improvement < minImprovement * std::max(std::abs(value), 1.0))
+      break;
+  }
+
+  return true;
+}
+
+} // namespace trajectory
+} // namespace dart
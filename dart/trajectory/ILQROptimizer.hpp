@@ -0,0 +1,171 @@
+#ifndef DART_TRAJECTORY_ILQR_OPTIMIZER_HPP_
+#define DART_TRAJECTORY_ILQR_OPTIMIZER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/neural/MappedBackpropSnapshot.hpp"
+#include "dart/trajectory/Optimizer.hpp"
+#include "dart/trajectory/Problem.hpp"
+#include "dart/trajectory/Solution.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace trajectory {
+
+/*
+ * This is an iterative LQR optimizer. Each iteration linearizes the dynamics
+ * around the current trajectory, using the per-timestep Jacobians that the
+ * MappedBackpropSnapshots already compute, and runs a Riccati backward pass to
+ * get a time-varying feedback policy. It then rolls that policy out with a
+ * line search. Because it exploits the timestep structure of the problem, it
+ * typically needs far fewer iterations than IPOPT with a limited memory
+ * Hessian, which makes it a good fit for replanning in MPC.
+ *
+ * This only optimizes the forces of a SingleShot. The starting state and the
+ * masses stay fixed, and any constraints on the Problem are ignored. The loss
+ * is differentiated in the shot's representation mapping, so gradients with
+ * respect to other mappings are ignored. The Hessian of the loss is estimated
+ * by finite differencing its gradient, keeping only the blocks that relate
+ * values on the same timestep. That's exact for losses that are a sum of
+ * per-timestep terms.
+ */
+class ILQROptimizer : public Optimizer
+{
+public:
+  ILQROptimizer();
+
+  virtual ~ILQROptimizer() = default;
+
+  /// This optimizes the forces of `shot`, which must be a SingleShot, and
+  /// leaves the optimized forces in `shot` when it's done.
+  std::shared_ptr<Solution> optimize(
+      Problem* shot, std::shared_ptr<Solution> reuseRecord = nullptr) override;
+
+  void setIterationLimit(int iterationLimit);
+
+  /// We stop once an iteration improves the loss by less than `tolerance`
+  /// times the loss
+  void setTolerance(double tolerance);
+
+  /// If this is true, the backward pass solves a box-constrained QP for the
+  /// controls on each timestep, so the forces respect the upper and lower
+  /// bounds of the shot (which includes pinned forces). Otherwise the controls
+  /// are unconstrained.
+  void setBoxConstrainedControls(bool boxConstrained);
+
+  /// This sets the initial Levenberg-Marquardt regularization added to the
+  /// Hessian of the controls during the backward pass
+  void setRegularization(double regularization);
+
+  void setRecordPerformanceLog(bool recordPerfLog);
+
+  void setRecordIterations(bool recordIterations);
+
+  void setSilenceOutput(bool silenceOutput);
+
+protected:
+  /// A rollout of the shot, along with the snapshots we need to linearize the
+  /// dynamics around it
+  struct Trajectory
+  {
+    // The (pos, vel) state in the representation mapping at the start of each
+    // timestep, followed by the final state, so this has (steps + 1) columns
+    Eigen::MatrixXd states;
+    // The forces in the representation mapping on each timestep
+    Eigen::MatrixXd forces;
+    std::vector<neural::MappedBackpropSnapshotPtr> snapshots;
+    std::shared_ptr<TrajectoryRolloutReal> rollout;
+    double loss;
+  };
+
+  /// The quadratic expansion of the loss around a Trajectory
+  struct LossExpansion
+  {
+    // Column t is the gradient wrt the state at the end of timestep t
+    Eigen::MatrixXd gradState;
+    // Column t is the gradient wrt the force on timestep t
+    Eigen::MatrixXd gradForce;
+    std::vector<Eigen::MatrixXd> hessState;
+    std::vector<Eigen::MatrixXd> hessForce;
+  };
+
+  /// The affine feedback policy produced by the backward pass, where the
+  /// change in force on timestep t is k[t] + K[t] * (change in state)
+  struct FeedbackPolicy
+  {
+    std::vector<Eigen::VectorXd> k;
+    std::vector<Eigen::MatrixXd> K;
+    // The change in loss we expect from taking a step of size alpha is
+    // alpha * expectedLinear + alpha^2 * expectedQuadratic
+    double expectedLinear;
+    double expectedQuadratic;
+  };
+
+  /// This runs iterations of iLQR on the shot, starting from its current
+  /// forces. This returns true if we converged before hitting the iteration
+  /// limit.
+  bool runIterations(Problem* shot, Solution* record);
+
+  /// This rolls out the shot from the start state in `nominal`. If `policy` is
+  /// null, this uses the forces in `nominal` as is. Otherwise it applies the
+  /// policy with a step size of `alpha`, relative to `nominal`.
+  Trajectory forwardPass(
+      Problem* shot,
+      const Trajectory& nominal,
+      const FeedbackPolicy* policy,
+      double alpha,
+      const Eigen::MatrixXd& lowerBounds,
+      const Eigen::MatrixXd& upperBounds,
+      PerformanceLog* log = nullptr);
+
+  /// This computes the gradient and block-diagonal Hessian of the loss around
+  /// `nominal`
+  LossExpansion expandLoss(
+      Problem* shot, const Trajectory& nominal, PerformanceLog* log = nullptr);
+
+  /// This runs the Riccati backward pass. This returns false if the Hessian
+  /// of the controls wasn't positive definite, which means we need more
+  /// regularization.
+  bool backwardPass(
+      Problem* shot,
+      const Trajectory& nominal,
+      const LossExpansion& expansion,
+      double regularization,
+      const Eigen::MatrixXd& lowerBounds,
+      const Eigen::MatrixXd& upperBounds,
+      /* OUT */ FeedbackPolicy& policy,
+      PerformanceLog* log = nullptr);
+
+  /// This minimizes 0.5 x^T H x + g^T x subject to lower <= x <= upper, with
+  /// a projected Newton method. It fills `freeIndices` with the dimensions of
+  /// x that aren't up against a bound at the solution. This returns false if
+  /// the Hessian wasn't positive definite on the free dimensions.
+  static bool solveBoxQP(
+      const Eigen::MatrixXd& H,
+      const Eigen::VectorXd& g,
+      const Eigen::VectorXd& lower,
+      const Eigen::VectorXd& upper,
+      /* OUT */ Eigen::VectorXd& x,
+      /* OUT */ std::vector<int>& freeIndices);
+
+  int mIterationLimit;
+  double mTolerance;
+  bool mBoxConstrained;
+  double mRegularization;
+  bool mRecordPerfLog;
+  bool mRecordIterations;
+  bool mSilenceOutput;
+};
+
+} // namespace trajectory
+} // namespace dart
+
+#endif
@@ -1,5 +1,6 @@
 #include "dart/trajectory/IPOptOptimizer.hpp"
 
+#include <limits>
 #include <vector>
 
 #include <coin/IpIpoptApplication.hpp>
@@ -33,7 +34,10 @@ IPOptOptimizer::IPOptOptimizer()
     mSuppressOutput(false),
     mSilenceOutput(false),
     mDisableLinesearch(false),
-    mRecordIterations(true)
+    mRecordIterations(true),
+    mGaussNewtonHessian(false),
+    mDeadline(std::make_shared<std::atomic<long>>(
+        std::numeric_limits<long>::max()))
 {
 }
 
@@ -55,8 +59,11 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       "linear_solver",
       "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
 
+  // The Gauss-Newton Hessian finite differences the gradient of the loss,
+  // which is only accurate (and cheap enough) if that gradient is analytical
+  bool gaussNewton = mGaussNewtonHessian && shot->hasAnalyticalLossGradient();
   app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
+      "hessian_approximation", gaussNewton ? "exact" : "limited-memory");
 
   /*
   app->Options()->SetStringValue(
@@ -128,6 +135,7 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
   {
     problem->registerIntermediateCallback(callback);
   }
+  problem->setDeadline(mDeadline);
   SmartPtr<IPOptShotWrapper> problemPtr(problem);
   status = app->OptimizeTNLP(problemPtr);
 
@@ -225,6 +233,15 @@ void IPOptOptimizer::setRecordIterations(bool recordIterations)
   mRecordIterations = recordIterations;
 }
 
+//==============================================================================
+/// If this is true, IPOPT uses a Gauss-Newton approximation to the Hessian
+/// of the loss (see Problem::getGaussNewtonHessian()) instead of L-BFGS,
+/// as long as the loss has an analytical gradient
+void IPOptOptimizer::setGaussNewtonHessian(bool gaussNewtonHessian)
+{
+  mGaussNewtonHessian = gaussNewtonHessian;
+}
+
 //==============================================================================
 void IPOptOptimizer::registerIntermediateCallback(
     std::function<bool(Problem* problem, int, double primal, double dual)>
@@ -233,5 +250,28 @@ void IPOptOptimizer::registerIntermediateCallback(
   mIntermediateCallbacks.push_back(callback);
 }
 
+//==============================================================================
+/// This sets a wall clock deadline, in millis since the epoch (see
+/// timeSinceEpochMillis()). Once it passes, IPOPT stops after its current
+/// iteration, though it always takes at least one step.
+void IPOptOptimizer::setDeadline(long deadlineMillis)
+{
+  mDeadline->store(deadlineMillis);
+}
+
+//==============================================================================
+/// This removes any deadline set with setDeadline()
+void IPOptOptimizer::clearDeadline()
+{
+  mDeadline->store(std::numeric_limits<long>::max());
+}
+
+//==============================================================================
+/// This returns the current deadline, in millis since the epoch
+long IPOptOptimizer::getDeadline() const
+{
+  return mDeadline->load();
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_IPOPT_OPTIMIZER_HPP_
 #define DART_NEURAL_IPOPT_OPTIMIZER_HPP_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -61,6 +62,15 @@ public:
 
   void setRecordIterations(bool recordIterations);
 
+  /// If this is true, IPOPT uses a Gauss-Newton approximation to the Hessian
+  /// of the loss (see Problem::getGaussNewtonHessian()) instead of L-BFGS. That
+  /// costs more per iteration, but usually takes far fewer iterations on
+  /// losses that are close to least-squares. Each evaluation grows with the
+  /// square of the number of steps per shot, so keep shots short. This only
+  /// takes effect if the loss has an analytical gradient (see
+  /// LossFn::hasAnalyticalGradient()), otherwise IPOPT stays on L-BFGS.
+  void setGaussNewtonHessian(bool gaussNewtonHessian);
+
   /// This registers an intermediate callback, to get called by IPOPT after each
   /// step of optimization. If any callback returns false on a given step, then
   /// the optimizer will terminate early.
@@ -68,6 +78,19 @@ public:
       std::function<bool(Problem* problem, int, double primal, double dual)>
           callback);
 
+  /// This sets a wall clock deadline, in millis since the epoch (see
+  /// timeSinceEpochMillis()). Once it passes, IPOPT stops after its current
+  /// iteration, though it always takes at least one step. Solutions from this
+  /// optimizer check the latest deadline when they reoptimize(), so this can
+  /// be moved between solves. Defaults to no deadline.
+  void setDeadline(long deadlineMillis);
+
+  /// This removes any deadline set with setDeadline()
+  void clearDeadline();
+
+  /// This returns the current deadline, in millis since the epoch
+  long getDeadline() const;
+
 protected:
   int mIterationLimit;
   double mTolerance;
@@ -81,9 +104,13 @@ protected:
   bool mSilenceOutput;
   bool mDisableLinesearch;
   bool mRecordIterations;
+  bool mGaussNewtonHessian;
   std::vector<
       std::function<bool(Problem* problem, int, double primal, double dual)>>
       mIntermediateCallbacks;
+  // This is shared with every IPOptShotWrapper we create, so a new deadline
+  // reaches Solutions that are reoptimized later
+  std::shared_ptr<std::atomic<long>> mDeadline;
 };
 
 } // namespace trajectory
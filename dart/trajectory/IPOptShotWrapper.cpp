@@ -79,8 +79,10 @@ bool IPOptShotWrapper::get_nlp_info(
   // Set the number of entries in the constraint Jacobian
   nnz_jac_g = mWrapped->getNumberNonZeroJacobian(mWrapped->mWorld);
 
-  // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  // Set the number of entries in the lower triangle of the Hessian. This is
+  // only used if we're asking IPOPT for an exact Hessian, otherwise it builds
+  // its own limited-memory approximation.
+  nnz_h_lag = mWrapped->getNumberNonZeroHessian(mWrapped->mWorld);
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -465,36 +467,64 @@ bool IPOptShotWrapper::eval_jac_g(
 
 //==============================================================================
 bool IPOptShotWrapper::eval_h(
-    Ipopt::Index /* _n */,
-    const Ipopt::Number* /* _x */,
-    bool /* _new_x */,
-    Ipopt::Number /* _obj_factor */,
+    Ipopt::Index _n,
+    const Ipopt::Number* _x,
+    bool _new_x,
+    Ipopt::Number _obj_factor,
     Ipopt::Index /* _m */,
     const Ipopt::Number* /* _lambda */,
     bool /* _new_lambda */,
-    Ipopt::Index /* _nele_hess */,
-    Ipopt::Index* /* _iRow */,
-    Ipopt::Index* /* _jCol */,
-    Ipopt::Number* /* _values */)
+    Ipopt::Index _nele_hess,
+    Ipopt::Index* _iRow,
+    Ipopt::Index* _jCol,
+    Ipopt::Number* _values)
 {
-  // TODO(JS): Not implemented yet.
-  std::cout << "[IPOptShotWrapper::eval_h] Not implemented yet.\n";
+  PerformanceLog* perflog = nullptr;
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (mRecord->getPerfLog() != nullptr)
+  {
+    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_h");
+  }
+#endif
 
-  /*
-  return TNLP::eval_h(
-      _n,
-      _x,
-      _new_x,
-      _obj_factor,
-      _m,
-      _lambda,
-      _new_lambda,
-      _nele_hess,
-      _iRow,
-      _jCol,
-      _values);
-      */
-  return false;
+  // Like eval_jac_g(), IPOPT first asks for the sparsity structure of the
+  // lower triangle of the Hessian (with x and values set to nullptr), and then
+  // for the values on later calls.
+
+  if (nullptr == _values)
+  {
+    assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
+    assert(_nele_hess == mWrapped->getNumberNonZeroHessian(mWrapped->mWorld));
+    _unused(_n);
+
+    Eigen::Map<Eigen::VectorXi> rows(_iRow, _nele_hess);
+    Eigen::Map<Eigen::VectorXi> cols(_jCol, _nele_hess);
+
+    mWrapped->getHessianSparsityStructure(
+        mWrapped->mWorld, rows, cols, perflog);
+  }
+  else
+  {
+    if (_new_x && _n > 0)
+    {
+      Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
+      mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
+    }
+
+    // This is a Gauss-Newton approximation, so we ignore the curvature of the
+    // constraints, and only scale the loss term by _obj_factor
+    Eigen::Map<Eigen::VectorXd> sparse(_values, _nele_hess);
+    mWrapped->getGaussNewtonHessian(mWrapped->mWorld, sparse, perflog);
+    sparse *= _obj_factor;
+  }
+
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (perflog != nullptr)
+  {
+    perflog->end();
+  }
+#endif
+  return true;
 }
 
 //==============================================================================
@@ -582,6 +612,10 @@ bool IPOptShotWrapper::intermediate_callback(
   }
 #endif
 
+  long now = timeSinceEpochMillis();
+  long durationMillis = now - mLastTimestep;
+  mLastTimestep = now;
+
   // Always record the iteration
   if (mRecordIterations)
   {
@@ -589,17 +623,14 @@ bool IPOptShotWrapper::intermediate_callback(
         iter,
         mWrapped->getRolloutCache(mWrapped->mWorld, perflog),
         obj_value,
-        inf_pr);
+        inf_pr,
+        durationMillis);
   }
 
   if (mPrintIterations)
   {
-    uint64_t now = timeSinceEpochMillis();
-
-    std::cout << "(" << (now - mLastTimestep) << "ms) Loss:  " << obj_value
+    std::cout << "(" << durationMillis << "ms) Loss:  " << obj_value
               << "  Viol:  " << inf_pr << std::endl;
-
-    mLastTimestep = now;
   }
 
   if (mRecoverBest && obj_value < mBestFeasibleObjectiveValue && inf_pr < 5e-4)
@@ -628,6 +659,11 @@ bool IPOptShotWrapper::intermediate_callback(
       allCallbacksReturnedTrue = false;
     }
   }
+  // Always take at least one step before checking the deadline
+  if (mDeadline && iter >= 1 && timeSinceEpochMillis() >= mDeadline->load())
+  {
+    allCallbacksReturnedTrue = false;
+  }
 
 #ifdef LOG_PERFORMANCE_IPOPT
   if (childPerflog != nullptr)
@@ -721,5 +757,15 @@ void IPOptShotWrapper::registerIntermediateCallback(
   mIntermediateCallbacks.push_back(callback);
 }
 
+//==============================================================================
+/// This sets the wall clock deadline (in millis since the epoch) that we stop
+/// at, after taking at least one step. It's shared with the IPOptOptimizer
+/// that created us, so it can change between solves.
+void IPOptShotWrapper::setDeadline(
+    std::shared_ptr<const std::atomic<long>> deadline)
+{
+  mDeadline = deadline;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
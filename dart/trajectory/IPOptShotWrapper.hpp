@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_IPOPT_SHOT_WRAPPER_HPP_
 #define DART_NEURAL_IPOPT_SHOT_WRAPPER_HPP_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -187,6 +188,11 @@ public:
       std::function<bool(Problem* problem, int, double primal, double dual)>
           callback);
 
+  /// This sets the wall clock deadline (in millis since the epoch) that we
+  /// stop at, after taking at least one step. It's shared with the
+  /// IPOptOptimizer that created us, so it can change between solves.
+  void setDeadline(std::shared_ptr<const std::atomic<long>> deadline);
+
 private:
   Problem* mWrapped;
   std::shared_ptr<Solution> mRecord;
@@ -212,6 +218,7 @@ private:
   std::vector<
       std::function<bool(Problem* problem, int, double primal, double dual)>>
       mIntermediateCallbacks;
+  std::shared_ptr<const std::atomic<long>> mDeadline;
 };
 
 } // namespace trajectory
@@ -186,6 +186,131 @@ double LossFn::getLossAndGradient(
   return loss;
 }
 
+//==============================================================================
+/// Returns true if this loss was given an analytical gradient, rather than
+/// finite differencing the loss to get one
+bool LossFn::hasAnalyticalGradient() const
+{
+  return mLossAndGrad.has_value();
+}
+
+//==============================================================================
+/// This estimates the blocks on the diagonal of the Hessian of the loss with
+/// respect to the rollout, by finite differencing the gradient. There's one
+/// block per timestep, covering the poses, velocities and forces of each of
+/// `mappings` on that timestep, in that order. The terms relating different
+/// timesteps are left out. This needs an analytical gradient, and returns
+/// all-zero blocks without one.
+std::vector<Eigen::MatrixXd> LossFn::getHessianBlocks(
+    const TrajectoryRollout* rollout,
+    const std::vector<std::string>& mappings,
+    PerformanceLog* perflog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (perflog != nullptr)
+  {
+    thisLog = perflog->startRun("LossFn.getHessianBlocks");
+  }
+#endif
+
+  int steps = 0;
+  int blockDim = 0;
+  for (const std::string& key : mappings)
+  {
+    steps = rollout->getPosesConst(key).cols();
+    blockDim += rollout->getPosesConst(key).rows()
+                + rollout->getVelsConst(key).rows()
+                + rollout->getForcesConst(key).rows();
+  }
+
+  // This reads a timestep of a rollout out as a single column
+  auto getColumn = [&mappings, blockDim](
+                       const TrajectoryRollout* values, int t) {
+    Eigen::VectorXd column = Eigen::VectorXd::Zero(blockDim);
+    int cursor = 0;
+    for (const std::string& key : mappings)
+    {
+      int posDim = values->getPosesConst(key).rows();
+      int velDim = values->getVelsConst(key).rows();
+      int forceDim = values->getForcesConst(key).rows();
+      column.segment(cursor, posDim) = values->getPosesConst(key).col(t);
+      cursor += posDim;
+      column.segment(cursor, velDim) = values->getVelsConst(key).col(t);
+      cursor += velDim;
+      column.segment(cursor, forceDim) = values->getForcesConst(key).col(t);
+      cursor += forceDim;
+    }
+    return column;
+  };
+
+  std::vector<Eigen::MatrixXd> blocks(
+      steps, Eigen::MatrixXd::Zero(blockDim, blockDim));
+  if (!hasAnalyticalGradient())
+  {
+#ifdef LOG_PERFORMANCE_LOSS_FN
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    return blocks;
+  }
+
+  // The gradients start out as copies of the rollout, so we zero them in case
+  // the loss doesn't write to every entry
+  TrajectoryRolloutReal perturbed(rollout);
+  TrajectoryRolloutReal grad(rollout);
+  for (const std::string& key : grad.getMappings())
+  {
+    grad.getPoses(key).setZero();
+    grad.getVels(key).setZero();
+    grad.getForces(key).setZero();
+  }
+  grad.getMasses().setZero();
+  TrajectoryRolloutReal perturbedGrad(&grad);
+  getLossAndGradient(&perturbed, &grad, thisLog);
+
+  // Perturbing several timesteps at once would be cheaper, but then any term
+  // relating two of them (like a smoothness penalty) would get credited to
+  // the diagonal blocks, so we only ever perturb a single timestep.
+  const double EPS = 1e-5;
+  for (int t = 0; t < steps; t++)
+  {
+    Eigen::VectorXd gradColumn = getColumn(&grad, t);
+    int col = 0;
+    auto perturbRows = [&](Eigen::Ref<Eigen::MatrixXd> values) {
+      for (int i = 0; i < values.rows(); i++)
+      {
+        double original = values(i, t);
+        values(i, t) += EPS;
+        getLossAndGradient(&perturbed, &perturbedGrad, thisLog);
+        values(i, t) = original;
+        blocks[t].col(col)
+            = (getColumn(&perturbedGrad, t) - gradColumn) / EPS;
+        col++;
+      }
+    };
+    for (const std::string& key : mappings)
+    {
+      perturbRows(perturbed.getPoses(key));
+      perturbRows(perturbed.getVels(key));
+      perturbRows(perturbed.getForces(key));
+    }
+    assert(col == blockDim);
+    blocks[t] = 0.5 * (blocks[t] + blocks[t].transpose());
+  }
+
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return blocks;
+}
+
 //==============================================================================
 /// If this LossFn is being used as a constraint, this gets the lower bound
 /// it's allowed to reach
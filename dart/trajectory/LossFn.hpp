@@ -2,6 +2,8 @@
 #define DART_TRAJECTORY_LOSS_FUNCTION_HPP_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -43,6 +45,25 @@ public:
       /* OUT */ TrajectoryRollout* gradWrtRollout,
       PerformanceLog* perflog = nullptr);
 
+  /// Returns true if this loss was given an analytical gradient, rather than
+  /// finite differencing the loss to get one
+  bool hasAnalyticalGradient() const;
+
+  /// This estimates the blocks on the diagonal of the Hessian of the loss with
+  /// respect to the rollout, by finite differencing the gradient. There's one
+  /// block per timestep, covering the poses, velocities and forces of each of
+  /// `mappings` on that timestep, in that order. The terms relating different
+  /// timesteps are left out. We perturb one timestep at a time, so that those
+  /// terms never leak into the blocks, which costs one gradient evaluation per
+  /// row of the rollout on every timestep. This needs an analytical gradient
+  /// (see hasAnalyticalGradient()), since differencing a finite-differenced
+  /// gradient is both inaccurate and quadratic in the size of the rollout.
+  /// Without one, this returns all-zero blocks.
+  std::vector<Eigen::MatrixXd> getHessianBlocks(
+      const TrajectoryRollout* rollout,
+      const std::vector<std::string>& mappings,
+      PerformanceLog* perflog = nullptr);
+
   /// If this LossFn is being used as a constraint, this gets the lower bound
   /// it's allowed to reach
   double getLowerBound() const;
@@ -1,12 +1,15 @@
 #include "dart/trajectory/MultiShot.hpp"
 
+#include <algorithm>
 #include <future>
+#include <thread>
 #include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/WorldState.hpp"
 #include "dart/simulation/World.hpp"
 
 // Make production builds happy with asserts
@@ -29,7 +32,9 @@ MultiShot::MultiShot(
     int steps,
     int shotLength,
     bool tuneStartingState)
-  : Problem(world, loss, steps), mParallelOperationsEnabled(false)
+  : Problem(world, loss, steps),
+    mParallelOperationsEnabled(false),
+    mNumThreads(0)
 {
   mShotLength = shotLength;
   mTuneStartingState = tuneStartingState;
@@ -63,14 +68,106 @@ void MultiShot::setParallelOperationsEnabled(bool enabled)
     // call this (at least prior to Eigen 3.3)
     Eigen::initParallel();
 
-    mParallelWorlds.clear();
+    // Cloning is expensive, so we keep the worlds from the last time we were
+    // enabled, and only clone the ones we're missing. The ones we keep just
+    // get their state synced to mWorld, which is a cheap O(n) copy.
+    neural::WorldState state(mWorld);
+    int numExisting = mParallelWorlds.size();
     for (int i = 0; i < mShots.size(); i++)
     {
-      mParallelWorlds.push_back(mWorld->clone());
+      if (i < numExisting && state.isCompatible(mParallelWorlds[i]))
+      {
+        state.restore(mParallelWorlds[i]);
+      }
+      else if (i < numExisting)
+      {
+        mParallelWorlds[i] = mWorld->clone();
+      }
+      else
+      {
+        mParallelWorlds.push_back(mWorld->clone());
+      }
     }
+    mParallelWorlds.resize(mShots.size());
+    createThreadPool();
+  }
+  else
+  {
+    mThreadPool.reset();
+  }
+}
+
+//==============================================================================
+/// This sets the number of worker threads used when parallel operations are
+/// enabled. 0 (the default) means one per hardware thread. We never use more
+/// threads than we have shots.
+void MultiShot::setNumThreads(int numThreads)
+{
+  assert(numThreads >= 0);
+  mNumThreads = numThreads;
+  if (mParallelOperationsEnabled)
+  {
+    createThreadPool();
   }
 }
 
+//==============================================================================
+/// This returns the number of worker threads we're currently using for
+/// parallel operations, or 0 if parallel operations are disabled.
+int MultiShot::getNumThreads() const
+{
+  if (!mThreadPool)
+    return 0;
+  return mThreadPool->getNumThreads();
+}
+
+//==============================================================================
+void MultiShot::createThreadPool()
+{
+  int numThreads = mNumThreads;
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)mShots.size()));
+
+  // Let the old pool finish anything it's still running before we replace it
+  mThreadPool.reset();
+  mThreadPool = std::make_shared<common::ThreadPool>(numThreads);
+
+  mWorkerLogNames.clear();
+  for (int i = 0; i < numThreads; i++)
+  {
+    mWorkerLogNames.push_back("MultiShot.worker" + std::to_string(i));
+  }
+}
+
+//==============================================================================
+std::future<void> MultiShot::submitShotTask(
+    int index, std::function<void(PerformanceLog*)> task, PerformanceLog* log)
+{
+  int worker = index % mThreadPool->getNumThreads();
+  const char* logName = mWorkerLogNames[worker].c_str();
+  return mThreadPool->submitToWorker(worker, [task, log, logName]() {
+    PerformanceLog* workerLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+    if (log != nullptr)
+    {
+      workerLog = log->startRun(logName);
+    }
+#endif
+
+    task(workerLog);
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+    if (workerLog != nullptr)
+    {
+      workerLog->end();
+    }
+#endif
+  });
+}
+
 //==============================================================================
 /// This sets the mapping we're using to store the representation of the Shot.
 /// WARNING: THIS IS A POTENTIALLY DESTRUCTIVE OPERATION! This will rewrite
@@ -227,19 +324,18 @@ void MultiShot::computeConstraints(
     std::vector<std::future<void>> futures;
     for (int i = 1; i < mShots.size(); i++)
     {
-      futures.push_back(std::async(
-          &MultiShot::asyncPartComputeConstraints,
-          this,
+      futures.push_back(submitShotTask(
           i,
-          mParallelWorlds[i],
-          constraints,
-          cursor,
+          [this, i, constraints, cursor](PerformanceLog* workerLog) {
+            asyncPartComputeConstraints(
+                i, mParallelWorlds[i], constraints, cursor, workerLog);
+          },
           thisLog));
       cursor += getRepresentationStateSize();
     }
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
     }
   }
   else
@@ -558,19 +654,27 @@ void MultiShot::backpropJacobian(
     for (int i = 1; i < mShots.size(); i++)
     {
       int dynamicDim = mShots[i - 1]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropJacobian,
-          this,
+      futures.push_back(submitShotTask(
           i,
-          mParallelWorlds[i],
-          jacStatic,
-          jacDynamic,
-          rowCursor,
-          colCursor,
+          [this, i, jacStatic, jacDynamic, rowCursor, colCursor](
+              PerformanceLog* workerLog) {
+            asyncPartBackpropJacobian(
+                i,
+                mParallelWorlds[i],
+                jacStatic,
+                jacDynamic,
+                rowCursor,
+                colCursor,
+                workerLog);
+          },
           thisLog));
       colCursor += dynamicDim;
       rowCursor += stateDim;
     }
+    for (int i = 0; i < futures.size(); i++)
+    {
+      futures[i].get();
+    }
   }
   else
   {
@@ -815,15 +919,19 @@ void MultiShot::getSparseJacobian(
       int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
       int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
 
-      futures.push_back(std::async(
-          &MultiShot::asyncPartGetSparseJacobian,
-          this,
+      futures.push_back(submitShotTask(
           i,
-          mParallelWorlds[i],
-          sparseStatic,
-          sparseDynamic,
-          cursorStatic,
-          cursorDynamic,
+          [this, i, sparseStatic, sparseDynamic, cursorStatic, cursorDynamic](
+              PerformanceLog* workerLog) {
+            asyncPartGetSparseJacobian(
+                i,
+                mParallelWorlds[i],
+                sparseStatic,
+                sparseDynamic,
+                cursorStatic,
+                cursorDynamic,
+                workerLog);
+          },
           thisLog));
 
       cursorDynamic += (dimDynamic + 1) * stateDim;
@@ -831,7 +939,7 @@ void MultiShot::getSparseJacobian(
     }
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
     }
   }
   else
@@ -923,6 +1031,132 @@ void MultiShot::asyncPartGetSparseJacobian(
   cursorDynamic += stateDim;
 }
 
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton Hessian of the loss. Each shot only affects its own slice of
+/// the rollout, so the Hessian is block diagonal, with one dense block per
+/// shot.
+int MultiShot::getNumberNonZeroHessian(std::shared_ptr<simulation::World> world)
+{
+  int nnzh = 0;
+  for (int i = 0; i < mShots.size(); i++)
+  {
+    nnzh += mShots[i]->getNumberNonZeroHessian(world);
+  }
+  return nnzh;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian of the loss
+void MultiShot::getHessianSparsityStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* log)
+{
+  assert(rows.size() == getNumberNonZeroHessian(world));
+  assert(cols.size() == getNumberNonZeroHessian(world));
+
+  int staticDim = getFlatStaticProblemDim(world);
+  int cursor = 0;
+  int offset = 0;
+  for (int i = 0; i < mShots.size(); i++)
+  {
+    // The shot reports its block as though its dynamic problem came right
+    // after the static problem, so we shift it over to where it lives in ours
+    int nnzh = mShots[i]->getNumberNonZeroHessian(world);
+    mShots[i]->getHessianSparsityStructure(
+        world, rows.segment(cursor, nnzh), cols.segment(cursor, nnzh), log);
+    rows.segment(cursor, nnzh).array() += offset;
+    cols.segment(cursor, nnzh).array() += offset;
+    assert(rows.segment(cursor, nnzh).minCoeff() >= staticDim + offset);
+    _unused(staticDim);
+    cursor += nnzh;
+    offset += mShots[i]->getFlatDynamicProblemDim(world);
+  }
+}
+
+//==============================================================================
+/// This writes the lower triangle of a Gauss-Newton approximation to the
+/// Hessian of the loss to a sparse vector. See
+/// Problem::getGaussNewtonHessian().
+void MultiShot::getGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ Eigen::Ref<Eigen::VectorXd> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("MultiShot.getGaussNewtonHessian");
+  }
+#endif
+
+  assert(sparse.size() == getNumberNonZeroHessian(world));
+
+  // The loss sees the whole trajectory, so we estimate its Hessian once and
+  // share it between the shots
+  std::vector<Eigen::MatrixXd> blocks = getLossHessianBlocks(world, thisLog);
+
+  auto writeShotHessian = [this, &blocks, sparse](
+                              int index,
+                              std::shared_ptr<simulation::World> shotWorld,
+                              int cursorSparse,
+                              int cursorSteps,
+                              PerformanceLog* shotLog) mutable {
+    Eigen::MatrixXd hessian = mShots[index]->getGaussNewtonHessianDynamic(
+        shotWorld, blocks, cursorSteps, shotLog);
+    int dim = hessian.rows();
+    for (int col = 0; col < dim; col++)
+    {
+      sparse.segment(cursorSparse, dim - col) = hessian.col(col).tail(dim - col);
+      cursorSparse += dim - col;
+    }
+  };
+
+  int cursorSparse = 0;
+  int cursorSteps = 0;
+  if (mParallelOperationsEnabled)
+  {
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < mShots.size(); i++)
+    {
+      futures.push_back(submitShotTask(
+          i,
+          [this, i, writeShotHessian, cursorSparse, cursorSteps](
+              PerformanceLog* workerLog) mutable {
+            writeShotHessian(
+                i, mParallelWorlds[i], cursorSparse, cursorSteps, workerLog);
+          },
+          thisLog));
+      cursorSparse += mShots[i]->getNumberNonZeroHessian(world);
+      cursorSteps += mShots[i]->getNumSteps();
+    }
+    for (int i = 0; i < futures.size(); i++)
+    {
+      futures[i].get();
+    }
+  }
+  else
+  {
+    for (int i = 0; i < mShots.size(); i++)
+    {
+      writeShotHessian(i, world, cursorSparse, cursorSteps, thisLog);
+      cursorSparse += mShots[i]->getNumberNonZeroHessian(world);
+      cursorSteps += mShots[i]->getNumSteps();
+    }
+  }
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This returns the snapshots from a fresh unroll
 std::vector<neural::MappedBackpropSnapshotPtr> MultiShot::getSnapshots(
@@ -976,20 +1210,18 @@ void MultiShot::getStates(
       for (int i = 0; i < mShots.size(); i++)
       {
         int steps = mShots[i]->getNumSteps();
-        futures.push_back(std::async(
-            &MultiShot::asyncPartGetStates,
-            this,
+        futures.push_back(submitShotTask(
             i,
-            mParallelWorlds[i],
-            rollout,
-            cursor,
-            steps,
+            [this, i, rollout, cursor, steps](PerformanceLog* workerLog) {
+              asyncPartGetStates(
+                  i, mParallelWorlds[i], rollout, cursor, steps, workerLog);
+            },
             thisLog));
         cursor += steps;
       }
       for (int i = 0; i < futures.size(); i++)
       {
-        futures[i].wait();
+        futures[i].get();
       }
     }
     else
@@ -1293,16 +1525,27 @@ void MultiShot::backpropGradientWrt(
     {
       int steps = mShots[i]->getNumSteps();
       int dynamicDim = mShots[i]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropGradientWrt,
-          this,
+      Eigen::Ref<Eigen::VectorXd> gradStaticSlice
+          = gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size());
+      futures.push_back(submitShotTask(
           i,
-          mParallelWorlds[i],
-          gradWrtRollout,
-          gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size()),
-          gradDynamic,
-          cursorDynamicDims,
-          cursorSteps,
+          [this,
+           i,
+           gradWrtRollout,
+           gradStaticSlice,
+           gradDynamic,
+           cursorDynamicDims,
+           cursorSteps](PerformanceLog* workerLog) {
+            asyncPartBackpropGradientWrt(
+                i,
+                mParallelWorlds[i],
+                gradWrtRollout,
+                gradStaticSlice,
+                gradDynamic,
+                cursorDynamicDims,
+                cursorSteps,
+                workerLog);
+          },
           thisLog));
       cursorSteps += steps;
       cursorDynamicDims += dynamicDim;
@@ -1310,7 +1553,7 @@ void MultiShot::backpropGradientWrt(
     gradStatic.setZero();
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
       gradStatic += gradStaticScratch.segment(
           i * gradStatic.size(), gradStatic.size());
     }
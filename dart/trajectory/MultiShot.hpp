@@ -1,11 +1,15 @@
 #ifndef DART_NEURAL_MULTI_SHOT_HPP_
 #define DART_NEURAL_MULTI_SHOT_HPP_
 
+#include <functional>
+#include <future>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -39,6 +43,15 @@ public:
   /// be considered EXPERIMENTAL! Expect bugs.
   void setParallelOperationsEnabled(bool enabled);
 
+  /// This sets the number of worker threads used when parallel operations are
+  /// enabled. 0 (the default) means one per hardware thread. We never use more
+  /// threads than we have shots.
+  void setNumThreads(int numThreads);
+
+  /// This returns the number of worker threads we're currently using for
+  /// parallel operations, or 0 if parallel operations are disabled.
+  int getNumThreads() const;
+
   /// This sets the mapping we're using to store the representation of the Shot.
   /// WARNING: THIS IS A POTENTIALLY DESTRUCTIVE OPERATION! This will rewrite
   /// the internal representation of the Shot to use the new mapping, and if the
@@ -277,6 +290,29 @@ public:
       Eigen::Ref<Eigen::VectorXd> sparseDynamic,
       PerformanceLog* log = nullptr) override;
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian of the loss. Each shot only affects its own slice of
+  /// the rollout, so the Hessian is block diagonal, with one dense block per
+  /// shot.
+  int getNumberNonZeroHessian(
+      std::shared_ptr<simulation::World> world) override;
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian of the loss
+  void getHessianSparsityStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr) override;
+
+  /// This writes the lower triangle of a Gauss-Newton approximation to the
+  /// Hessian of the loss to a sparse vector. See
+  /// Problem::getGaussNewtonHessian().
+  void getGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::VectorXd> sparse,
+      PerformanceLog* log = nullptr) override;
+
   /// This writes the Jacobian to a sparse vector
   void asyncPartGetSparseJacobian(
       int index,
@@ -297,10 +333,25 @@ public:
   //////////////////////////////////////////////////////////////////////////////
 
 private:
+  /// This (re)creates the worker pool, sized from mNumThreads. It doesn't
+  /// touch the per-shot worlds, which setParallelOperationsEnabled() owns.
+  void createThreadPool();
+
+  /// This queues `task` on the worker that owns shot `index` (and so
+  /// mParallelWorlds[index]). The task gets a PerformanceLog for that worker,
+  /// nested under `log`, so we can see how evenly work is spread.
+  std::future<void> submitShotTask(
+      int index,
+      std::function<void(PerformanceLog*)> task,
+      PerformanceLog* log);
+
   std::vector<std::shared_ptr<SingleShot>> mShots;
   std::vector<simulation::WorldPtr> mParallelWorlds;
   int mShotLength;
   bool mParallelOperationsEnabled;
+  int mNumThreads;
+  std::shared_ptr<common::ThreadPool> mThreadPool;
+  std::vector<std::string> mWorkerLogNames;
 };
 
 } // namespace trajectory
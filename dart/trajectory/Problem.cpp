@@ -1,5 +1,6 @@
 #include "dart/trajectory/Problem.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <coin/IpIpoptApplication.hpp>
@@ -758,6 +759,70 @@ void Problem::getSparseJacobian(
       log);
 }
 
+//==============================================================================
+/// This returns the order that the mappings appear in the blocks from
+/// getLossHessianBlocks()
+std::vector<std::string> Problem::getHessianMappingOrder() const
+{
+  std::vector<std::string> order;
+  for (auto pair : mMappings)
+  {
+    order.push_back(pair.first);
+  }
+  std::sort(order.begin(), order.end());
+  return order;
+}
+
+//==============================================================================
+/// Returns true if the loss has an analytical gradient, which
+/// getLossHessianBlocks() and getGaussNewtonHessian() need
+bool Problem::hasAnalyticalLossGradient() const
+{
+  return mLoss.hasAnalyticalGradient();
+}
+
+//==============================================================================
+/// This estimates the Hessian of the loss with respect to the rollout, by
+/// finite differencing the gradient of the loss. We only keep the blocks
+/// that relate values on the same timestep, so there's one block per
+/// timestep, and any terms of the loss relating different timesteps are
+/// dropped. See LossFn::getHessianBlocks(). Each block covers the poses,
+/// velocities and forces of every mapping on that timestep, in the order of
+/// getHessianMappingOrder(). Each block is projected to be positive
+/// semidefinite.
+std::vector<Eigen::MatrixXd> Problem::getLossHessianBlocks(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("Problem.getLossHessianBlocks");
+  }
+#endif
+
+  const TrajectoryRollout* rollout = getRolloutCache(world, thisLog);
+  std::vector<Eigen::MatrixXd> blocks
+      = mLoss.getHessianBlocks(rollout, getHessianMappingOrder(), thisLog);
+
+  for (int t = 0; t < blocks.size(); t++)
+  {
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(blocks[t]);
+    blocks[t] = eigen.eigenvectors()
+                * eigen.eigenvalues().cwiseMax(0.0).asDiagonal()
+                * eigen.eigenvectors().transpose();
+  }
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return blocks;
+}
+
 //==============================================================================
 /// This computes the gradient in the flat problem space, automatically
 /// computing the gradients of the loss function as part of the call
@@ -29,6 +29,7 @@ class Problem
 {
 public:
   friend class IPOptShotWrapper;
+  friend class ILQROptimizer;
 
   /// Default constructor
   Problem(std::shared_ptr<simulation::World> world, LossFn loss, int steps);
@@ -302,6 +303,53 @@ public:
       Eigen::Ref<Eigen::VectorXd> sparse,
       PerformanceLog* log = nullptr);
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian of the loss. This has to agree with what
+  /// getGaussNewtonHessian() writes, so each subclass reports its own.
+  virtual int getNumberNonZeroHessian(std::shared_ptr<simulation::World> world)
+      = 0;
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian of the loss
+  virtual void getHessianSparsityStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr)
+      = 0;
+
+  /// Returns true if the loss has an analytical gradient, which
+  /// getLossHessianBlocks() and getGaussNewtonHessian() need
+  bool hasAnalyticalLossGradient() const;
+
+  /// This returns the order that the mappings appear in the blocks from
+  /// getLossHessianBlocks()
+  std::vector<std::string> getHessianMappingOrder() const;
+
+  /// This estimates the Hessian of the loss with respect to the rollout, by
+  /// finite differencing the gradient of the loss. We only keep the blocks
+  /// that relate values on the same timestep, so there's one block per
+  /// timestep, and any terms of the loss relating different timesteps are
+  /// dropped. See LossFn::getHessianBlocks(). Each block covers the poses,
+  /// velocities and forces of every mapping on that timestep, in the order of
+  /// getHessianMappingOrder(). Each block is projected to be positive
+  /// semidefinite.
+  std::vector<Eigen::MatrixXd> getLossHessianBlocks(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr);
+
+  /// This writes the lower triangle of a Gauss-Newton approximation to the
+  /// Hessian of the loss to a sparse vector, in the order given by
+  /// getHessianSparsityStructure(). That's J^T H J, where J is the Jacobian of
+  /// the rollout with respect to the flat problem, and H is the Hessian of the
+  /// loss with respect to the rollout. The curvature of the dynamics and of
+  /// the constraints is left out, which keeps the approximation positive
+  /// semidefinite. It's exact for tracking losses on linear dynamics.
+  virtual void getGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::VectorXd> sparse,
+      PerformanceLog* log = nullptr)
+      = 0;
+
   /// This returns the snapshots from a fresh unroll
   virtual std::vector<neural::MappedBackpropSnapshotPtr> getSnapshots(
       std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr)
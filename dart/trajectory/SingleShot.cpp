@@ -1,5 +1,6 @@
 #include "dart/trajectory/SingleShot.hpp"
 
+#include <algorithm>
 #include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
@@ -34,7 +35,10 @@ SingleShot::SingleShot(
   mStartVel = world->getVelocities();
   assert(steps > 0);
   mForces = Eigen::MatrixXd::Zero(world->getNumDofs(), steps);
-  mSnapshotsCacheDirty = true;
+  mSnapshotsCacheDirtyFrom = 0;
+  mNumSnapshotsRecomputed = 0;
+  mCheckpointInterval = 0;
+  mCheckpointsDirtyFrom = 0;
   mPinnedForces = Eigen::MatrixXd::Zero(world->getNumDofs(), steps);
   for (int i = 0; i < steps; i++)
   {
@@ -112,7 +116,7 @@ void SingleShot::switchRepresentationMapping(
   mStartPos = mMappings[mapping]->getPositions(world);
   mStartVel = mMappings[mapping]->getVelocities(world);
 
-  mSnapshotsCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
   Problem::switchRepresentationMapping(world, mapping, thisLog);
   snapshot.restore();
 
@@ -234,7 +238,9 @@ void SingleShot::unflatten(
 #endif
 
   mRolloutCacheDirty = true;
-  mSnapshotsCacheDirty = true;
+
+  // IPOPT and line searches often only change part of the trajectory, so we
+  // only throw away the snapshots from the first timestep that changed
 
   int cursorDynamic = Problem::getFlatDynamicProblemDim(world);
   int cursorStatic = Problem::getFlatStaticProblemDim(world);
@@ -243,19 +249,38 @@ void SingleShot::unflatten(
       flatStatic.segment(0, cursorStatic),
       flatDynamic.segment(0, cursorDynamic),
       thisLog);
+  // Compare against the masses this shot last ran with, rather than whatever
+  // was in the world before we unflattened, because a sequential MultiShot
+  // has already written the new masses into the shared world by the time we
+  // get here.
+  Eigen::VectorXd masses = world->getMasses();
+  if (masses.size() != mSnapshotMasses.size() || masses != mSnapshotMasses)
+  {
+    markSnapshotsDirtyFrom(0);
+    mSnapshotMasses = masses;
+  }
 
   if (mTuneStartingState)
   {
-    mStartPos = flatDynamic.segment(0, getRepresentation()->getPosDim());
+    Eigen::VectorXd startPos
+        = flatDynamic.segment(0, getRepresentation()->getPosDim());
     cursorDynamic += getRepresentation()->getPosDim();
-    mStartVel
+    Eigen::VectorXd startVel
         = flatDynamic.segment(cursorDynamic, getRepresentation()->getVelDim());
     cursorDynamic += getRepresentation()->getVelDim();
+    if (startPos != mStartPos || startVel != mStartVel)
+      markSnapshotsDirtyFrom(0);
+    mStartPos = startPos;
+    mStartVel = startVel;
   }
   int forceDim = getRepresentation()->getForceDim();
   for (int i = 0; i < mSteps; i++)
   {
-    mForces.col(i) = flatDynamic.segment(cursorDynamic, forceDim);
+    if (mForces.col(i) != flatDynamic.segment(cursorDynamic, forceDim))
+    {
+      markSnapshotsDirtyFrom(i);
+      mForces.col(i) = flatDynamic.segment(cursorDynamic, forceDim);
+    }
     cursorDynamic += forceDim;
   }
 
@@ -554,6 +579,283 @@ void SingleShot::backpropJacobianOfFinalState(
 #endif
 }
 
+//==============================================================================
+/// This is the forward-mode counterpart of backpropJacobianOfFinalState().
+/// Each column of (tangentStatic, tangentDynamic) is a direction in the flat
+/// problem space, and this returns the Jacobian of the final state times
+/// those directions, as a (posDim + velDim, k) matrix. It pushes the
+/// directions forward through the rollout one timestep at a time, so it never
+/// forms the Jacobian, and its cost scales with k instead of with
+/// getFlatProblemDim().
+Eigen::MatrixXd SingleShot::jvpOfFinalState(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::Ref<const Eigen::MatrixXd>& tangentStatic,
+    const Eigen::Ref<const Eigen::MatrixXd>& tangentDynamic,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.jvpOfFinalState");
+  }
+#endif
+
+  assert(tangentStatic.rows() == getFlatStaticProblemDim(world));
+  assert(tangentDynamic.rows() == getFlatDynamicProblemDim(world));
+  assert(tangentStatic.cols() == tangentDynamic.cols());
+
+  std::vector<MappedBackpropSnapshotPtr> snapshots
+      = getSnapshots(world, thisLog);
+
+  int posDim = getRepresentation()->getPosDim();
+  int velDim = getRepresentation()->getVelDim();
+  int forceDim = getRepresentation()->getForceDim();
+  int k = tangentDynamic.cols();
+
+  // The static problem is just the masses, which are the same every timestep
+  Eigen::MatrixXd tangentMass = tangentStatic.topRows(world->getMassDims());
+
+  neural::StateTangent state;
+  state.position = Eigen::MatrixXd::Zero(posDim, k);
+  state.velocity = Eigen::MatrixXd::Zero(velDim, k);
+
+  int cursorDynamic = 0;
+  if (mTuneStartingState)
+  {
+    state.position = tangentDynamic.middleRows(cursorDynamic, posDim);
+    cursorDynamic += posDim;
+    state.velocity = tangentDynamic.middleRows(cursorDynamic, velDim);
+    cursorDynamic += velDim;
+  }
+
+  for (int i = 0; i < mSteps; i++)
+  {
+    state = snapshots[i]->jvp(
+        world,
+        mRepresentationMapping,
+        mRepresentationMapping,
+        state.position,
+        state.velocity,
+        tangentDynamic.middleRows(cursorDynamic, forceDim),
+        tangentMass,
+        thisLog);
+    cursorDynamic += forceDim;
+  }
+  assert(cursorDynamic == tangentDynamic.rows());
+
+  Eigen::MatrixXd result(posDim + velDim, k);
+  result.topRows(posDim) = state.position;
+  result.bottomRows(velDim) = state.velocity;
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return result;
+}
+
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton Hessian of the loss. Every timestep of the rollout depends on
+/// the starting state and on every force before it, so even with
+/// block-diagonal loss Hessians the result is dense over the dynamic problem,
+/// and we report its whole lower triangle.
+int SingleShot::getNumberNonZeroHessian(
+    std::shared_ptr<simulation::World> world)
+{
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  return dynamicDim * (dynamicDim + 1) / 2;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian of the loss, column by column
+void SingleShot::getHessianSparsityStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* /* log */)
+{
+  assert(rows.size() == SingleShot::getNumberNonZeroHessian(world));
+  assert(cols.size() == SingleShot::getNumberNonZeroHessian(world));
+
+  // The masses come first in the flat problem, and we don't have any
+  // curvature for them
+  int staticDim = getFlatStaticProblemDim(world);
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  int cursor = 0;
+  for (int col = 0; col < dynamicDim; col++)
+  {
+    for (int row = col; row < dynamicDim; row++)
+    {
+      rows(cursor) = staticDim + row;
+      cols(cursor) = staticDim + col;
+      cursor++;
+    }
+  }
+}
+
+//==============================================================================
+/// This writes the lower triangle of a Gauss-Newton approximation to the
+/// Hessian of the loss to a sparse vector. See
+/// Problem::getGaussNewtonHessian().
+void SingleShot::getGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ Eigen::Ref<Eigen::VectorXd> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.getGaussNewtonHessian");
+  }
+#endif
+
+  assert(sparse.size() == getNumberNonZeroHessian(world));
+
+  Eigen::MatrixXd hessian = getGaussNewtonHessianDynamic(
+      world, getLossHessianBlocks(world, thisLog), 0, thisLog);
+
+  // This matches the column-major order of getHessianSparsityStructure()
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  int cursor = 0;
+  for (int col = 0; col < dynamicDim; col++)
+  {
+    sparse.segment(cursor, dynamicDim - col)
+        = hessian.col(col).tail(dynamicDim - col);
+    cursor += dynamicDim - col;
+  }
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This returns the dense Gauss-Newton Hessian of the loss with respect to
+/// the dynamic part of this shot, given the blocks of the Hessian of the loss
+/// with respect to the rollout from getLossHessianBlocks(). This shot's first
+/// timestep is `lossHessianBlocks[firstTimestep]`, which lets a MultiShot
+/// share one set of blocks between all its shots. This pushes the identity
+/// forward through the rollout with jvp(), to get the Jacobian of each
+/// timestep of the rollout.
+///
+/// Timestep i has to push forward every column up to its own force, so a
+/// shot of T steps costs about T^2 * forceDim / 2 JVP columns per call, on
+/// top of the dense (dynamicDim x dynamicDim) result. For long horizons,
+/// prefer a MultiShot with short shots, which keeps T small.
+Eigen::MatrixXd SingleShot::getGaussNewtonHessianDynamic(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<Eigen::MatrixXd>& lossHessianBlocks,
+    int firstTimestep,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.getGaussNewtonHessianDynamic");
+  }
+#endif
+
+  assert(firstTimestep + mSteps <= lossHessianBlocks.size());
+
+  std::vector<MappedBackpropSnapshotPtr> snapshots
+      = getSnapshots(world, thisLog);
+  std::vector<std::string> order = getHessianMappingOrder();
+
+  int posDim = getRepresentation()->getPosDim();
+  int velDim = getRepresentation()->getVelDim();
+  int forceDim = getRepresentation()->getForceDim();
+  int dynamicDim = getFlatDynamicProblemDim(world);
+
+  Eigen::MatrixXd hessian = Eigen::MatrixXd::Zero(dynamicDim, dynamicDim);
+
+  // The tangent of the state in the representation mapping, with one column
+  // per dimension of the dynamic problem
+  neural::StateTangent state;
+  state.position = Eigen::MatrixXd::Zero(posDim, dynamicDim);
+  state.velocity = Eigen::MatrixXd::Zero(velDim, dynamicDim);
+
+  int cursorDynamic = 0;
+  if (mTuneStartingState)
+  {
+    state.position.leftCols(posDim).setIdentity();
+    state.velocity.middleCols(posDim, velDim).setIdentity();
+    cursorDynamic += posDim + velDim;
+  }
+
+  // Masses are in the static problem, which we don't have curvature for
+  Eigen::MatrixXd tangentMass = Eigen::MatrixXd::Zero(0, 0);
+  for (int i = 0; i < mSteps; i++)
+  {
+    // Forces later in the trajectory can't affect this timestep, so we only
+    // need to push forward the columns up to this timestep's force
+    int active = cursorDynamic + forceDim;
+    Eigen::MatrixXd tangentForce = Eigen::MatrixXd::Zero(forceDim, active);
+    tangentForce.rightCols(forceDim).setIdentity();
+    tangentMass.resize(0, active);
+
+    const Eigen::MatrixXd& block = lossHessianBlocks[firstTimestep + i];
+    Eigen::MatrixXd rolloutJac = Eigen::MatrixXd::Zero(block.rows(), active);
+    neural::StateTangent next;
+    int row = 0;
+    for (const std::string& key : order)
+    {
+      neural::StateTangent mapped = snapshots[i]->jvp(
+          world,
+          mRepresentationMapping,
+          key,
+          state.position.leftCols(active),
+          state.velocity.leftCols(active),
+          tangentForce,
+          tangentMass,
+          thisLog);
+      int mappedPosDim = mMappings[key]->getPosDim();
+      int mappedVelDim = mMappings[key]->getVelDim();
+      rolloutJac.middleRows(row, mappedPosDim) = mapped.position;
+      row += mappedPosDim;
+      rolloutJac.middleRows(row, mappedVelDim) = mapped.velocity;
+      row += mappedVelDim;
+      // Like backpropGradientWrt(), we only relate the forces in the
+      // representation mapping to the flat problem
+      if (key == mRepresentationMapping)
+      {
+        rolloutJac.block(row, cursorDynamic, forceDim, forceDim)
+            .setIdentity();
+        next = mapped;
+      }
+      row += mMappings[key]->getForceDim();
+    }
+    assert(row == block.rows());
+
+    hessian.topLeftCorner(active, active)
+        += rolloutJac.transpose() * block * rolloutJac;
+
+    state.position.leftCols(active) = next.position;
+    state.velocity.leftCols(active) = next.velocity;
+    cursorDynamic += forceDim;
+  }
+  assert(cursorDynamic == dynamicDim);
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return hessian;
+}
+
 //==============================================================================
 /// This computes finite difference Jacobians analagous to backpropJacobians()
 void SingleShot::finiteDifferenceJacobianOfFinalState(
@@ -633,10 +935,6 @@ void SingleShot::backpropGradientWrt(
   _unused(staticDims);
   assert(gradDynamic.size() == dynamicDims);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-  assert(snapshots.size() == mSteps);
-
   LossGradient nextTimestep;
   nextTimestep.lossWrtPosition
       = Eigen::VectorXd::Zero(mMappings[mRepresentationMapping]->getPosDim());
@@ -646,58 +944,67 @@ void SingleShot::backpropGradientWrt(
       = Eigen::VectorXd::Zero(mMappings[mRepresentationMapping]->getForceDim());
 
   int cursorDynamic = dynamicDims;
-  int forceDim = mMappings[mRepresentationMapping]->getForceDim();
-  for (int i = mSteps - 1; i >= 0; i--)
+  if (mCheckpointInterval > 0)
   {
-    std::unordered_map<std::string, LossGradient> mappedLosses;
-    for (auto pair : mMappings)
+    refreshCheckpoints(world, thisLog);
+
+    // Re-simulate one segment at a time from its checkpoint, starting at the
+    // end of the trajectory, so we only ever hold one segment of snapshots
+    RestorableSnapshot snapshot(world);
+    std::vector<MappedBackpropSnapshotPtr> segmentSnapshots;
+    segmentSnapshots.reserve(mCheckpointInterval);
+    for (int segment = mCheckpoints.size() - 1; segment >= 0; segment--)
     {
-      LossGradient mappedGrad;
-      mappedGrad.lossWrtPosition
-          = gradWrtRollout->getPosesConst(pair.first).col(i);
-      mappedGrad.lossWrtVelocity
-          = gradWrtRollout->getVelsConst(pair.first).col(i);
-
-      // Both these values are currently ignored
-      mappedGrad.lossWrtTorque
-          = gradWrtRollout->getForcesConst(pair.first).col(i);
-      mappedGrad.lossWrtMass = gradWrtRollout->getMassesConst();
-
-      mappedLosses[pair.first] = mappedGrad;
+      int segmentStart = segment * mCheckpointInterval;
+      int segmentEnd = std::min(segmentStart + mCheckpointInterval, mSteps);
+
+      world->setPositions(mCheckpoints[segment].position);
+      world->setVelocities(mCheckpoints[segment].velocity);
+      world->setCachedLCPSolution(mCheckpoints[segment].lcpCache);
+      segmentSnapshots.clear();
+      for (int i = segmentStart; i < segmentEnd; i++)
+      {
+        getRepresentation()->setForces(world, mForces.col(i));
+        segmentSnapshots.push_back(
+            mappedForwardPass(world, mRepresentationMapping, mMappings));
+      }
+      mNumSnapshotsRecomputed += segmentEnd - segmentStart;
+      snapshot.restore();
+
+      for (int i = segmentEnd - 1; i >= segmentStart; i--)
+      {
+        backpropTimestep(
+            world,
+            i,
+            segmentSnapshots[i - segmentStart],
+            gradWrtRollout,
+            nextTimestep,
+            gradStatic,
+            gradDynamic,
+            cursorDynamic,
+            thisLog);
+      }
     }
-    mappedLosses[mRepresentationMapping].lossWrtPosition
-        += nextTimestep.lossWrtPosition;
-    mappedLosses[mRepresentationMapping].lossWrtVelocity
-        += nextTimestep.lossWrtVelocity;
-
-    LossGradient thisTimestep;
-    snapshots[i]->backprop(world, thisTimestep, mappedLosses, thisLog);
-
-    Problem::accumulateStaticGradient(world, gradStatic, thisTimestep, thisLog);
+  }
+  else
+  {
+    std::vector<MappedBackpropSnapshotPtr> snapshots
+        = getSnapshots(world, thisLog);
+    assert(snapshots.size() == mSteps);
 
-    cursorDynamic -= forceDim;
-    gradDynamic.segment(cursorDynamic, forceDim) = thisTimestep.lossWrtTorque;
-    if (i == 0 && mTuneStartingState)
+    for (int i = mSteps - 1; i >= 0; i--)
     {
-      assert(
-          cursorDynamic
-          == mMappings[mRepresentationMapping]->getPosDim()
-                 + mMappings[mRepresentationMapping]->getVelDim());
-      cursorDynamic -= mMappings[mRepresentationMapping]->getVelDim();
-      gradDynamic.segment(
-          cursorDynamic, mMappings[mRepresentationMapping]->getVelDim())
-          = thisTimestep.lossWrtVelocity;
-      cursorDynamic -= mMappings[mRepresentationMapping]->getPosDim();
-      gradDynamic.segment(
-          cursorDynamic, mMappings[mRepresentationMapping]->getPosDim())
-          = thisTimestep.lossWrtPosition;
+      backpropTimestep(
+          world,
+          i,
+          snapshots[i],
+          gradWrtRollout,
+          nextTimestep,
+          gradStatic,
+          gradDynamic,
+          cursorDynamic,
+          thisLog);
     }
-    thisTimestep.lossWrtTorque
-        += gradWrtRollout
-               ->getForcesConst(gradWrtRollout->getRepresentationMapping())
-               .col(i);
-
-    nextTimestep = thisTimestep;
   }
   assert(cursorDynamic == 0);
 
@@ -709,6 +1016,75 @@ void SingleShot::backpropGradientWrt(
 #endif
 }
 
+//==============================================================================
+/// This backprops the loss through the snapshot for timestep `i`, writing
+/// that timestep's gradients into `gradStatic` and `gradDynamic`, and
+/// replacing `nextTimestep` with the loss at the start of timestep `i`.
+/// `cursorDynamic` walks backwards through `gradDynamic`.
+void SingleShot::backpropTimestep(
+    std::shared_ptr<simulation::World> world,
+    int i,
+    MappedBackpropSnapshotPtr snapshot,
+    const TrajectoryRollout* gradWrtRollout,
+    /* IN/OUT */ LossGradient& nextTimestep,
+    /* OUT */ Eigen::Ref<Eigen::VectorXd> gradStatic,
+    /* OUT */ Eigen::Ref<Eigen::VectorXd> gradDynamic,
+    /* IN/OUT */ int& cursorDynamic,
+    PerformanceLog* log)
+{
+  int forceDim = mMappings[mRepresentationMapping]->getForceDim();
+  std::unordered_map<std::string, LossGradient> mappedLosses;
+  for (auto pair : mMappings)
+  {
+    LossGradient mappedGrad;
+    mappedGrad.lossWrtPosition
+        = gradWrtRollout->getPosesConst(pair.first).col(i);
+    mappedGrad.lossWrtVelocity
+        = gradWrtRollout->getVelsConst(pair.first).col(i);
+
+    // Both these values are currently ignored
+    mappedGrad.lossWrtTorque
+        = gradWrtRollout->getForcesConst(pair.first).col(i);
+    mappedGrad.lossWrtMass = gradWrtRollout->getMassesConst();
+
+    mappedLosses[pair.first] = mappedGrad;
+  }
+  mappedLosses[mRepresentationMapping].lossWrtPosition
+      += nextTimestep.lossWrtPosition;
+  mappedLosses[mRepresentationMapping].lossWrtVelocity
+      += nextTimestep.lossWrtVelocity;
+
+  LossGradient thisTimestep;
+  snapshot->backprop(world, thisTimestep, mappedLosses, log);
+
+  Problem::accumulateStaticGradient(world, gradStatic, thisTimestep, log);
+
+  // The loss can also depend directly on the forces in the representation
+  thisTimestep.lossWrtTorque
+      += gradWrtRollout
+             ->getForcesConst(gradWrtRollout->getRepresentationMapping())
+             .col(i);
+
+  cursorDynamic -= forceDim;
+  gradDynamic.segment(cursorDynamic, forceDim) = thisTimestep.lossWrtTorque;
+  if (i == 0 && mTuneStartingState)
+  {
+    assert(
+        cursorDynamic
+        == mMappings[mRepresentationMapping]->getPosDim()
+               + mMappings[mRepresentationMapping]->getVelDim());
+    cursorDynamic -= mMappings[mRepresentationMapping]->getVelDim();
+    gradDynamic.segment(
+        cursorDynamic, mMappings[mRepresentationMapping]->getVelDim())
+        = thisTimestep.lossWrtVelocity;
+    cursorDynamic -= mMappings[mRepresentationMapping]->getPosDim();
+    gradDynamic.segment(
+        cursorDynamic, mMappings[mRepresentationMapping]->getPosDim())
+        = thisTimestep.lossWrtPosition;
+  }
+  nextTimestep = thisTimestep;
+}
+
 //==============================================================================
 /// This returns the snapshots from a fresh unroll
 std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
@@ -722,7 +1098,7 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
   }
 #endif
 
-  if (mSnapshotsCacheDirty)
+  if (mSnapshotsCacheDirtyFrom < mSteps)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
@@ -733,21 +1109,38 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
 #endif
     RestorableSnapshot snapshot(world);
 
-    mSnapshotsCache.clear();
-    mSnapshotsCache.reserve(mSteps);
+    int start = mSnapshotsCacheDirtyFrom;
+    if (start > 0 && start < mSnapshotsCache.size())
+    {
+      // Nothing before `start` changed, so the first stale snapshot still
+      // records exactly the state (and LCP warm start) that the unchanged
+      // prefix of the rollout hands to timestep `start`
+      std::shared_ptr<BackpropSnapshot> firstStale
+          = mSnapshotsCache[start]->getUnderlyingSnapshot();
+      world->setPositions(firstStale->getPreStepPosition());
+      world->setVelocities(firstStale->getPreStepVelocity());
+      world->setCachedLCPSolution(firstStale->getPreStepLCPCache());
+    }
+    else
+    {
+      start = 0;
+      getRepresentation()->setPositions(world, mStartPos);
+      getRepresentation()->setVelocities(world, mStartVel);
+    }
 
-    getRepresentation()->setPositions(world, mStartPos);
-    getRepresentation()->setVelocities(world, mStartVel);
+    mSnapshotsCache.resize(start);
+    mSnapshotsCache.reserve(mSteps);
 
-    for (int i = 0; i < mSteps; i++)
+    for (int i = start; i < mSteps; i++)
     {
       getRepresentation()->setForces(world, mForces.col(i));
       mSnapshotsCache.push_back(
           mappedForwardPass(world, mRepresentationMapping, mMappings));
     }
+    mNumSnapshotsRecomputed += mSteps - start;
 
     snapshot.restore();
-    mSnapshotsCacheDirty = false;
+    mSnapshotsCacheDirtyFrom = mSteps;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
     if (refreshLog != nullptr)
     {
@@ -765,6 +1158,197 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
   return mSnapshotsCache;
 }
 
+//==============================================================================
+/// This returns the total number of timesteps that getSnapshots() has had to
+/// simulate over the life of this shot. getSnapshots() only re-simulates from
+/// the earliest timestep that changed since its last call, so this is useful
+/// for measuring how much work that saves.
+int SingleShot::getNumSnapshotsRecomputed() const
+{
+  return mNumSnapshotsRecomputed;
+}
+
+//==============================================================================
+/// This marks every cached snapshot from `timestep` onwards as stale, along
+/// with the cached rollout
+void SingleShot::markSnapshotsDirtyFrom(int timestep)
+{
+  mRolloutCacheDirty = true;
+  mSnapshotsCacheDirtyFrom = std::min(mSnapshotsCacheDirtyFrom, timestep);
+  mCheckpointsDirtyFrom = std::min(mCheckpointsDirtyFrom, timestep);
+}
+
+//==============================================================================
+/// This re-simulates the trajectory from the earliest stale timestep,
+/// recording a Checkpoint at the start of every segment and the states of
+/// every mapping, but without keeping any snapshots
+void SingleShot::refreshCheckpoints(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  assert(mCheckpointInterval > 0);
+
+  // If a mapping was added or removed, none of the recorded states are usable
+  bool mappingsChanged = mCheckpointPoses.size() != mMappings.size();
+  for (auto pair : mMappings)
+  {
+    if (mCheckpointPoses.find(pair.first) == mCheckpointPoses.end())
+      mappingsChanged = true;
+  }
+  if (mappingsChanged)
+    mCheckpointsDirtyFrom = 0;
+
+  if (mCheckpointsDirtyFrom >= mSteps)
+    return;
+
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.refreshCheckpoints");
+  }
+#endif
+
+  RestorableSnapshot snapshot(world);
+
+  int segment = mCheckpointsDirtyFrom / mCheckpointInterval;
+  if (segment > 0 && segment < mCheckpoints.size())
+  {
+    world->setPositions(mCheckpoints[segment].position);
+    world->setVelocities(mCheckpoints[segment].velocity);
+    world->setCachedLCPSolution(mCheckpoints[segment].lcpCache);
+  }
+  else
+  {
+    segment = 0;
+    getRepresentation()->setPositions(world, mStartPos);
+    getRepresentation()->setVelocities(world, mStartVel);
+
+    mCheckpointPoses.clear();
+    mCheckpointVels.clear();
+    mCheckpointForces.clear();
+    for (auto pair : mMappings)
+    {
+      mCheckpointPoses[pair.first]
+          = Eigen::MatrixXd::Zero(pair.second->getPosDim(), mSteps);
+      mCheckpointVels[pair.first]
+          = Eigen::MatrixXd::Zero(pair.second->getVelDim(), mSteps);
+      mCheckpointForces[pair.first]
+          = Eigen::MatrixXd::Zero(pair.second->getForceDim(), mSteps);
+    }
+  }
+  mCheckpoints.resize(segment);
+
+  int start = segment * mCheckpointInterval;
+  for (int i = start; i < mSteps; i++)
+  {
+    if (i % mCheckpointInterval == 0)
+    {
+      Checkpoint checkpoint;
+      checkpoint.position = world->getPositions();
+      checkpoint.velocity = world->getVelocities();
+      checkpoint.lcpCache = world->getCachedLCPSolution();
+      mCheckpoints.push_back(checkpoint);
+    }
+
+    // We take the same step that getSnapshots() would, so that the snapshots
+    // we re-simulate from these checkpoints during backprop match exactly, but
+    // we let go of each snapshot as soon as we've read the states out of it
+    getRepresentation()->setForces(world, mForces.col(i));
+    MappedBackpropSnapshotPtr stepSnapshot
+        = mappedForwardPass(world, mRepresentationMapping, mMappings);
+    for (auto pair : mMappings)
+    {
+      mCheckpointPoses[pair.first].col(i)
+          = stepSnapshot->getPostStepPosition(pair.first);
+      mCheckpointVels[pair.first].col(i)
+          = stepSnapshot->getPostStepVelocity(pair.first);
+      mCheckpointForces[pair.first].col(i)
+          = stepSnapshot->getPreStepTorques(pair.first);
+    }
+  }
+  mNumSnapshotsRecomputed += mSteps - start;
+
+  snapshot.restore();
+  mCheckpointsDirtyFrom = mSteps;
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This turns on checkpointed backprop, for trajectories too long to keep a
+/// snapshot of every timestep in memory. Passing 0 turns checkpointing off.
+void SingleShot::setCheckpointInterval(int interval)
+{
+  assert(interval >= 0);
+  if (interval == mCheckpointInterval)
+    return;
+  mCheckpointInterval = interval;
+  mCheckpoints.clear();
+  mCheckpointsDirtyFrom = 0;
+  if (mCheckpointInterval > 0)
+  {
+    // The whole point is to not hold on to these
+    mSnapshotsCache.clear();
+    mSnapshotsCacheDirtyFrom = 0;
+  }
+}
+
+//==============================================================================
+/// This returns the number of timesteps between checkpoints, or 0 if
+/// checkpointing is off.
+int SingleShot::getCheckpointInterval() const
+{
+  return mCheckpointInterval;
+}
+
+//==============================================================================
+/// This picks a checkpoint interval so that the snapshots kept alive during
+/// backpropGradientWrt() fit in roughly `bytes`, based on
+/// estimateSnapshotBytes(). If the whole trajectory fits in the budget, this
+/// turns checkpointing off.
+void SingleShot::setSnapshotMemoryBudget(
+    std::shared_ptr<simulation::World> world, std::size_t bytes)
+{
+  std::size_t snapshotBytes
+      = std::max<std::size_t>(estimateSnapshotBytes(world), 1);
+  std::size_t snapshotsInBudget = bytes / snapshotBytes;
+  if (snapshotsInBudget >= static_cast<std::size_t>(mSteps))
+  {
+    setCheckpointInterval(0);
+  }
+  else
+  {
+    setCheckpointInterval(std::max(static_cast<int>(snapshotsInBudget), 1));
+  }
+}
+
+//==============================================================================
+/// This returns a rough lower bound on the memory held by a single snapshot
+/// of this shot
+std::size_t SingleShot::estimateSnapshotBytes(
+    std::shared_ptr<simulation::World> world)
+{
+  std::size_t dofs = world->getNumDofs();
+  // BackpropSnapshot caches 8 DOF x DOF Jacobians
+  std::size_t doubles = 8 * dofs * dofs;
+  for (auto pair : mMappings)
+  {
+    std::size_t posDim = pair.second->getPosDim();
+    std::size_t velDim = pair.second->getVelDim();
+    std::size_t forceDim = pair.second->getForceDim();
+    // PreStepMapping holds pos, vel and force Jacobians out of the mapping
+    doubles += dofs * (posDim + velDim + forceDim);
+    // PostStepMapping holds pos and vel Jacobians (wrt pos and vel) into it
+    doubles += 2 * dofs * (posDim + velDim);
+  }
+  return doubles * sizeof(double);
+}
+
 //==============================================================================
 /// This populates the passed in matrices with the values from this trajectory
 void SingleShot::getStates(
@@ -781,6 +1365,31 @@ void SingleShot::getStates(
   }
 #endif
 
+  if (mCheckpointInterval > 0)
+  {
+    refreshCheckpoints(world, thisLog);
+    for (std::string key : rollout->getMappings())
+    {
+      rollout->getPoses(key) = mCheckpointPoses[key];
+      rollout->getVels(key) = mCheckpointVels[key];
+      rollout->getForces(key) = mCheckpointForces[key];
+    }
+    assert(rollout->getMasses().size() == world->getMassDims());
+    rollout->getMasses() = world->getMasses();
+    for (auto pair : mMetadata)
+    {
+      rollout->setMetadata(pair.first, pair.second);
+    }
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    return;
+  }
+
   std::vector<MappedBackpropSnapshotPtr> snapshots
       = getSnapshots(world, thisLog);
 
@@ -833,6 +1442,7 @@ void SingleShot::setStates(
   mStartVel = rollout->getVelsConst(mRepresentationMapping).col(0);
   mForces = rollout->getForcesConst(mRepresentationMapping);
   world->setMasses(rollout->getMassesConst());
+  markSnapshotsDirtyFrom(0);
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -854,6 +1464,16 @@ void SingleShot::setForcesRaw(Eigen::MatrixXd forces, PerformanceLog* log)
   }
 #endif
 
+  int firstChanged = 0;
+  if (forces.rows() == mForces.rows())
+  {
+    while (firstChanged < mSteps && firstChanged < forces.cols()
+           && mForces.col(firstChanged) == forces.col(firstChanged))
+    {
+      firstChanged++;
+    }
+  }
+  markSnapshotsDirtyFrom(firstChanged);
   mForces = forces;
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
@@ -886,6 +1506,7 @@ Eigen::VectorXi SingleShot::advanceSteps(
         = mForces.block(0, steps, mForces.rows(), mSteps - steps);
   }
   mForces = newForces;
+  markSnapshotsDirtyFrom(0);
 
   return mapping;
 }
@@ -921,6 +1542,7 @@ Eigen::VectorXd SingleShot::getStartVel()
 void SingleShot::setStartPos(Eigen::VectorXd startPos)
 {
   mStartPos = startPos;
+  markSnapshotsDirtyFrom(0);
 }
 
 //==============================================================================
@@ -928,6 +1550,7 @@ void SingleShot::setStartPos(Eigen::VectorXd startPos)
 void SingleShot::setStartVel(Eigen::VectorXd startVel)
 {
   mStartVel = startVel;
+  markSnapshotsDirtyFrom(0);
 }
 
 //==============================================================================
@@ -944,17 +1567,28 @@ Eigen::VectorXd SingleShot::getFinalState(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-
   Eigen::VectorXd state = Eigen::VectorXd::Zero(getRepresentationStateSize());
-  state.segment(0, getRepresentation()->getPosDim())
-      = snapshots[snapshots.size() - 1]->getPostStepPosition(
-          mRepresentationMapping);
-  state.segment(
-      getRepresentation()->getPosDim(), getRepresentation()->getVelDim())
-      = snapshots[snapshots.size() - 1]->getPostStepVelocity(
-          mRepresentationMapping);
+  if (mCheckpointInterval > 0)
+  {
+    refreshCheckpoints(world, thisLog);
+    state.segment(0, getRepresentation()->getPosDim())
+        = mCheckpointPoses[mRepresentationMapping].col(mSteps - 1);
+    state.segment(
+        getRepresentation()->getPosDim(), getRepresentation()->getVelDim())
+        = mCheckpointVels[mRepresentationMapping].col(mSteps - 1);
+  }
+  else
+  {
+    std::vector<MappedBackpropSnapshotPtr> snapshots
+        = getSnapshots(world, thisLog);
+    state.segment(0, getRepresentation()->getPosDim())
+        = snapshots[snapshots.size() - 1]->getPostStepPosition(
+            mRepresentationMapping);
+    state.segment(
+        getRepresentation()->getPosDim(), getRepresentation()->getVelDim())
+        = snapshots[snapshots.size() - 1]->getPostStepVelocity(
+            mRepresentationMapping);
+  }
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
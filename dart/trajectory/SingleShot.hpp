@@ -1,7 +1,10 @@
 #ifndef DART_NEURAL_SINGLE_SHOT_HPP_
 #define DART_NEURAL_SINGLE_SHOT_HPP_
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -120,6 +123,61 @@ public:
       /* OUT */ Eigen::Ref<Eigen::MatrixXd> jacDynamic,
       PerformanceLog* log = nullptr);
 
+  /// This is the forward-mode counterpart of backpropJacobianOfFinalState().
+  /// Each column of (tangentStatic, tangentDynamic) is a direction in the flat
+  /// problem space, and this returns the Jacobian of the final state times
+  /// those directions, as a (posDim + velDim, k) matrix. It pushes the
+  /// directions forward through the rollout one timestep at a time, so it
+  /// never forms the Jacobian, and its cost scales with k instead of with
+  /// getFlatProblemDim().
+  Eigen::MatrixXd jvpOfFinalState(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::Ref<const Eigen::MatrixXd>& tangentStatic,
+      const Eigen::Ref<const Eigen::MatrixXd>& tangentDynamic,
+      PerformanceLog* log = nullptr);
+
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian of the loss. Every timestep of the rollout depends
+  /// on the starting state and on every force before it, so even with
+  /// block-diagonal loss Hessians the result is dense over the dynamic problem,
+  /// and we report its whole lower triangle.
+  int getNumberNonZeroHessian(
+      std::shared_ptr<simulation::World> world) override;
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian of the loss, column by column
+  void getHessianSparsityStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr) override;
+
+  /// This writes the lower triangle of a Gauss-Newton approximation to the
+  /// Hessian of the loss to a sparse vector. See
+  /// Problem::getGaussNewtonHessian().
+  void getGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::VectorXd> sparse,
+      PerformanceLog* log = nullptr) override;
+
+  /// This returns the dense Gauss-Newton Hessian of the loss with respect to
+  /// the dynamic part of this shot, given the blocks of the Hessian of the loss
+  /// with respect to the rollout from getLossHessianBlocks(). This shot's first
+  /// timestep is `lossHessianBlocks[firstTimestep]`, which lets a MultiShot
+  /// share one set of blocks between all its shots. This pushes the identity
+  /// forward through the rollout with jvp(), to get the Jacobian of each
+  /// timestep of the rollout.
+  ///
+  /// Timestep i has to push forward every column up to its own force, so a
+  /// shot of T steps costs about T^2 * forceDim / 2 JVP columns per call, on
+  /// top of the dense (dynamicDim x dynamicDim) result. For long horizons,
+  /// prefer a MultiShot with short shots, which keeps T small.
+  Eigen::MatrixXd getGaussNewtonHessianDynamic(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXd>& lossHessianBlocks,
+      int firstTimestep = 0,
+      PerformanceLog* log = nullptr);
+
   /// This computes the gradient in the flat problem space, taking into accounts
   /// incoming gradients with respect to any of the shot's values.
   void backpropGradientWrt(
@@ -181,6 +239,41 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// This returns the total number of timesteps that this shot has had to
+  /// simulate to produce snapshots or checkpoints over its life. Those are only
+  /// re-simulated from the earliest timestep that changed since they were
+  /// last computed, so this is useful for measuring how much work that saves.
+  int getNumSnapshotsRecomputed() const;
+
+  /// This turns on checkpointed backprop, for trajectories too long to keep a
+  /// snapshot of every timestep in memory. Instead, this shot only keeps the
+  /// World state (and LCP warm start) at the beginning of every `interval`
+  /// timesteps, and backpropGradientWrt() re-simulates the snapshots for one
+  /// segment at a time, walking backwards from the end of the trajectory. That
+  /// keeps at most `interval` snapshots alive, at the cost of simulating the
+  /// trajectory twice per gradient. getStates() and getFinalState() are served
+  /// from a light rollout in this mode, but getSnapshots() and the Jacobian
+  /// methods still cache every snapshot. Passing 0 (the default) turns
+  /// checkpointing off.
+  void setCheckpointInterval(int interval);
+
+  /// This returns the number of timesteps between checkpoints, or 0 if
+  /// checkpointing is off.
+  int getCheckpointInterval() const;
+
+  /// This picks a checkpoint interval so that the snapshots kept alive during
+  /// backpropGradientWrt() fit in roughly `bytes`, based on
+  /// estimateSnapshotBytes(). If the whole trajectory fits in the budget, this
+  /// turns checkpointing off.
+  void setSnapshotMemoryBudget(
+      std::shared_ptr<simulation::World> world, std::size_t bytes);
+
+  /// This returns a rough lower bound on the memory held by a single snapshot
+  /// of this shot: the DOF x DOF Jacobians that BackpropSnapshot caches, plus
+  /// the Jacobians in and out of each of our mappings. The per-group gradient
+  /// matrices depend on the contacts, so they aren't counted.
+  std::size_t estimateSnapshotBytes(std::shared_ptr<simulation::World> world);
+
   /// This returns the debugging name of a given DOF
   std::string getFlatDimName(
       std::shared_ptr<simulation::World> world, int dim) override;
@@ -206,14 +299,63 @@ public:
       std::shared_ptr<simulation::World> world, double EPS);
 
 private:
+  /// The World state at the beginning of a checkpointed segment, which is
+  /// enough to re-simulate that segment exactly
+  struct Checkpoint
+  {
+    Eigen::VectorXd position;
+    Eigen::VectorXd velocity;
+    Eigen::VectorXd lcpCache;
+  };
+
+  /// This marks every cached snapshot from `timestep` onwards as stale, along
+  /// with the cached rollout
+  void markSnapshotsDirtyFrom(int timestep);
+
+  /// This re-simulates the trajectory from the earliest stale timestep,
+  /// recording a Checkpoint at the start of every segment and the states of
+  /// every mapping, but without keeping any snapshots
+  void refreshCheckpoints(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr);
+
+  /// This backprops the loss through the snapshot for timestep `i`, writing
+  /// that timestep's gradients into `gradStatic` and `gradDynamic`, and
+  /// replacing `nextTimestep` with the loss at the start of timestep `i`.
+  /// `cursorDynamic` walks backwards through `gradDynamic`.
+  void backpropTimestep(
+      std::shared_ptr<simulation::World> world,
+      int i,
+      neural::MappedBackpropSnapshotPtr snapshot,
+      const TrajectoryRollout* gradWrtRollout,
+      /* IN/OUT */ neural::LossGradient& nextTimestep,
+      /* OUT */ Eigen::Ref<Eigen::VectorXd> gradStatic,
+      /* OUT */ Eigen::Ref<Eigen::VectorXd> gradDynamic,
+      /* IN/OUT */ int& cursorDynamic,
+      PerformanceLog* log = nullptr);
+
   Eigen::VectorXd mStartPos;
   Eigen::VectorXd mStartVel;
   Eigen::MatrixXd mForces;
   std::vector<bool> mForcesPinned;
   Eigen::MatrixXd mPinnedForces;
 
-  bool mSnapshotsCacheDirty;
+  /// The earliest timestep whose cached snapshot is stale, or mSteps if the
+  /// whole cache is valid
+  int mSnapshotsCacheDirtyFrom;
   std::vector<neural::MappedBackpropSnapshotPtr> mSnapshotsCache;
+  int mNumSnapshotsRecomputed;
+  /// The masses the cached snapshots were computed with
+  Eigen::VectorXd mSnapshotMasses;
+
+  /// The number of timesteps between checkpoints, or 0 if checkpointing is off
+  int mCheckpointInterval;
+  /// The earliest timestep whose checkpointed state is stale, or mSteps if
+  /// it's all valid
+  int mCheckpointsDirtyFrom;
+  std::vector<Checkpoint> mCheckpoints;
+  std::unordered_map<std::string, Eigen::MatrixXd> mCheckpointPoses;
+  std::unordered_map<std::string, Eigen::MatrixXd> mCheckpointVels;
+  std::unordered_map<std::string, Eigen::MatrixXd> mCheckpointForces;
 };
 
 } // namespace trajectory
@@ -88,10 +88,25 @@ void Solution::registerForReoptimization(
   mIpoptProblem = ipoptProblem;
 }
 
+//==============================================================================
+/// This registers a function that runs another round of optimization, for
+/// optimizers other than IPOPT. reoptimize() will call it, and it returns
+/// whether the optimization was a success.
+void Solution::registerForReoptimization(std::function<bool()> reoptimize)
+{
+  mReoptimize = reoptimize;
+}
+
 //==============================================================================
 /// This will attempt to run another round of optimization.
 void Solution::reoptimize()
 {
+  if (mReoptimize)
+  {
+    this->setSuccess(mReoptimize());
+    return;
+  }
+
   std::string oldWarmStart;
   mIpoptProblem->prep_for_reoptimize();
   // mIpopt->Options()->GetStringValue("warm_start_init_point", oldWarmStart,
@@ -127,9 +142,10 @@ void Solution::registerIteration(
     int index,
     const TrajectoryRollout* rollout,
     double loss,
-    double constraintViolation)
+    double constraintViolation,
+    long durationMillis)
 {
-  mSteps.emplace_back(index, rollout, loss, constraintViolation);
+  mSteps.emplace_back(index, rollout, loss, constraintViolation, durationMillis);
 }
 
 //==============================================================================
@@ -1,6 +1,7 @@
 #ifndef DART_TRAJECTORY_OPTIMIZATION_RECORD_HPP_
 #define DART_TRAJECTORY_OPTIMIZATION_RECORD_HPP_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,16 +31,20 @@ struct OptimizationStep
   std::shared_ptr<TrajectoryRollout> rollout;
   double loss;
   double constraintViolation;
+  // The wall time this iteration of the optimizer took
+  long durationMillis;
 
   OptimizationStep(
       int index,
       const TrajectoryRollout* rollout,
       double loss,
-      double constraintViolation)
+      double constraintViolation,
+      long durationMillis = 0)
     : index(index),
       rollout(std::make_shared<TrajectoryRolloutReal>(rollout)),
       loss(loss),
-      constraintViolation(constraintViolation)
+      constraintViolation(constraintViolation),
+      durationMillis(durationMillis)
   {
   }
 };
@@ -52,12 +57,14 @@ public:
   /// After optimization, register whether IPOPT thought it was a success
   void setSuccess(bool success);
 
-  /// During optimization, register a single iteration of gradient descent
+  /// During optimization, register a single iteration of gradient descent,
+  /// along with the wall time it took
   void registerIteration(
       int index,
       const TrajectoryRollout* rollout,
       double loss,
-      double constraintViolation);
+      double constraintViolation,
+      long durationMillis = 0);
 
   /// This only gets called if we're saving full debug info, but it stores every
   /// x that we receive during optimization
@@ -122,6 +129,11 @@ public:
       SmartPtr<Ipopt::IpoptApplication> ipopt,
       SmartPtr<trajectory::IPOptShotWrapper> ipoptProblem);
 
+  /// This registers a function that runs another round of optimization, for
+  /// optimizers other than IPOPT. reoptimize() will call it, and it returns
+  /// whether the optimization was a success.
+  void registerForReoptimization(std::function<bool()> reoptimize);
+
   /// This will attempt to run another round of optimization.
   void reoptimize();
 
@@ -137,6 +149,8 @@ protected:
   // In order to re-optimize
   SmartPtr<Ipopt::IpoptApplication> mIpopt;
   SmartPtr<trajectory::IPOptShotWrapper> mIpoptProblem;
+  // In order to re-optimize without IPOPT
+  std::function<bool()> mReoptimize;
 };
 
 } // namespace trajectory
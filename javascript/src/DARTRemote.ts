@@ -74,6 +74,12 @@ type SetObjectRotationCommand = {
   euler: number[];
 };
 
+type SetBinaryIdCommand = {
+  type: "set_binary_id";
+  key: string;
+  id: number;
+};
+
 type DeleteObjectCommand = {
   type: "delete_object";
   key: string;
@@ -205,6 +211,7 @@ type Command =
   | SetObjectPosCommand
   | SetObjectRotationCommand
   | SetObjectColorCommand
+  | SetBinaryIdCommand
   | DeleteObjectCommand
   | EnableMouseInteractionCommand
   | DisableMouseInteractionCommand
@@ -324,6 +331,8 @@ class DARTRemote {
       this.view.setObjectRotation(command.key, command.euler);
     } else if (command.type === "set_object_color") {
       this.view.setObjectColor(command.key, command.color);
+    } else if (command.type === "set_binary_id") {
+      this.view.setBinaryId(command.key, command.id);
     } else if (command.type === "enable_mouse") {
       this.view.enableMouseInteraction(command.key);
     } else if (command.type === "disable_mouse") {
@@ -421,6 +430,8 @@ class DARTRemote {
    */
   trySocket = () => {
     this.socket = new WebSocket(this.url);
+    // Binary transform frames come through as raw bytes, see handleBinaryFrame()
+    this.socket.binaryType = "arraybuffer";
 
     // Connection opened
     this.socket.addEventListener("open", (event) => {
@@ -428,10 +439,22 @@ class DARTRemote {
       // Clear the view on a reconnect, the socket will broadcast us new data
       this.view.setConnected(true);
       this.view.clear();
+      // Ask the backend to send transform updates as binary frames. Backends
+      // that don't know this message ignore it and keep sending JSON.
+      this.socket.send(JSON.stringify({ type: "enable_binary_protocol" }));
     });
 
     // Listen for messages
     this.socket.addEventListener("message", (event) => {
+      if (event.data instanceof ArrayBuffer) {
+        try {
+          this.view.handleBinaryFrame(event.data);
+          this.view.render();
+        } catch (e) {
+          console.error("Something went wrong on a binary frame", e);
+        }
+        return;
+      }
       try {
         const data: Command[] = JSON.parse(event.data);
         data.forEach(this.handleCommand);
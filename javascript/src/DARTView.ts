@@ -9,6 +9,14 @@ import VERSION_NUM from "../../VERSION.txt";
 
 const SCALE_FACTOR = 100;
 
+// These must match dart/server/RawBinaryUtils.hpp
+const BINARY_SET_OBJECT_TRANSFORMS = 1;
+const TRANSFORM_POS = 1;
+const TRANSFORM_EULER = 2;
+const TRANSFORM_COLOR = 4;
+const BINARY_TRANSFORMS_HEADER_SIZE = 8;
+const BINARY_TRANSFORM_RECORD_SIZE = 44;
+
 type Text = {
   type: "text";
   container: HTMLElement;
@@ -39,6 +47,7 @@ class DARTView {
   objects: Map<string, THREE.Group | THREE.Mesh | THREE.Line>;
   keys: Map<THREE.Object3D, string>;
   textures: Map<string, THREE.Texture>;
+  binaryIds: Map<number, string>;
 
   uiElements: Map<string, Text | Button | Slider | Plot>;
 
@@ -60,6 +69,7 @@ class DARTView {
     this.objects = new Map();
     this.keys = new Map();
     this.textures = new Map();
+    this.binaryIds = new Map();
     this.uiElements = new Map();
     this.dragListeners = [];
 
@@ -495,6 +505,60 @@ class DARTView {
     }
   };
 
+  /**
+   * This records the numeric id that the backend will use to refer to `key`
+   * in binary transform frames.
+   */
+  setBinaryId = (key: string, id: number) => {
+    this.binaryIds.set(id, key);
+  };
+
+  /**
+   * This applies a binary transform frame from the backend. The layout is
+   * documented in dart/server/RawBinaryUtils.hpp: a header of two uint32s
+   * (message type, record count), then one 44 byte record per object (uint32
+   * id, uint32 field flags, and float32[3] each for pos, euler and color), all
+   * little-endian. Only the fields whose flags are set get applied.
+   *
+   * Must call render() to see results!
+   */
+  handleBinaryFrame = (buffer: ArrayBuffer) => {
+    const data = new DataView(buffer);
+    if (data.byteLength < BINARY_TRANSFORMS_HEADER_SIZE) return;
+    if (data.getUint32(0, true) !== BINARY_SET_OBJECT_TRANSFORMS) return;
+    const count = data.getUint32(4, true);
+    if (
+      data.byteLength <
+      BINARY_TRANSFORMS_HEADER_SIZE + count * BINARY_TRANSFORM_RECORD_SIZE
+    ) {
+      console.error("Truncated binary transform frame, ignoring it");
+      return;
+    }
+
+    const readVec3 = (offset: number) => [
+      data.getFloat32(offset, true),
+      data.getFloat32(offset + 4, true),
+      data.getFloat32(offset + 8, true),
+    ];
+
+    for (let i = 0; i < count; i++) {
+      const offset =
+        BINARY_TRANSFORMS_HEADER_SIZE + i * BINARY_TRANSFORM_RECORD_SIZE;
+      const key = this.binaryIds.get(data.getUint32(offset, true));
+      if (key == null) continue;
+      const fields = data.getUint32(offset + 4, true);
+      if (fields & TRANSFORM_POS) {
+        this.setObjectPos(key, readVec3(offset + 8));
+      }
+      if (fields & TRANSFORM_EULER) {
+        this.setObjectRotation(key, readVec3(offset + 20));
+      }
+      if (fields & TRANSFORM_COLOR) {
+        this.setObjectColor(key, readVec3(offset + 32));
+      }
+    }
+  };
+
   /**
    * Removes an object from the scene, if it exists.
    *
@@ -506,6 +570,11 @@ class DARTView {
       this.scene.remove(obj);
       this.objects.delete(key);
     }
+    this.binaryIds.forEach((binaryKey, id) => {
+      if (binaryKey === key) {
+        this.binaryIds.delete(id);
+      }
+    });
   };
 
   _createUIElementContainer = (
@@ -750,6 +819,7 @@ class DARTView {
     });
     this.objects.clear();
     this.keys.clear();
+    this.binaryIds.clear();
 
     this.view.render();
   }
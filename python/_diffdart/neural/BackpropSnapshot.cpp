@@ -64,37 +64,54 @@ void BackpropSnapshot(py::module& m)
           ::py::arg("world"),
           ::py::arg("thisTimestepLoss"),
           ::py::arg("nextTimestepLoss"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
+      // The Jacobian getters release the GIL, and they fill the snapshot's
+      // caches lazily, which isn't thread safe. Don't ask the same snapshot
+      // for Jacobians from two Python threads at once. The returned arrays
+      // are read-only views of those caches, and keep the snapshot alive.
       .def(
           "getVelVelJacobian",
           &dart::neural::BackpropSnapshot::getVelVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getForceVelJacobian",
           &dart::neural::BackpropSnapshot::getForceVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosPosJacobian",
           &dart::neural::BackpropSnapshot::getPosPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelPosJacobian",
           &dart::neural::BackpropSnapshot::getVelPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosVelJacobian",
           &dart::neural::BackpropSnapshot::getPosVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getMassVelJacobian",
           &dart::neural::BackpropSnapshot::getMassVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPreStepPosition",
           &dart::neural::BackpropSnapshot::getPreStepPosition)
@@ -119,21 +136,25 @@ void BackpropSnapshot(py::module& m)
       .def(
           "finiteDifferenceVelVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelVelJacobian,
-          ::py::arg("world"))
+          ::py::arg("world"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceForceVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceForceVelJacobian,
-          ::py::arg("world"))
+          ::py::arg("world"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferencePosPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferencePosPosJacobian,
           ::py::arg("world"),
-          ::py::arg("subdivisions"))
+          ::py::arg("subdivisions"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceVelPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelPosJacobian,
           ::py::arg("world"),
-          ::py::arg("subdivisions"));
+          ::py::arg("subdivisions"),
+          ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
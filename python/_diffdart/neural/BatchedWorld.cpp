@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/BatchedWorld.hpp>
+#include <dart/simulation/World.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void BatchedWorld(py::module& m)
+{
+  // The snapshots stay on the C++ side, so stepping a batch doesn't create a
+  // Python object per world. The matrices come back as writable NumPy views,
+  // so they can be handed to torch.from_numpy() without copying.
+  ::py::class_<dart::neural::BatchedStep>(m, "BatchedStep")
+      .def_property_readonly(
+          "nextPositions",
+          +[](dart::neural::BatchedStep* self) -> Eigen::MatrixXd& {
+            return self->nextPositions;
+          })
+      .def_property_readonly(
+          "nextVelocities",
+          +[](dart::neural::BatchedStep* self) -> Eigen::MatrixXd& {
+            return self->nextVelocities;
+          })
+      .def(
+          "getSnapshot",
+          +[](const dart::neural::BatchedStep* self, int index)
+              -> std::shared_ptr<dart::neural::BackpropSnapshot> {
+            return self->snapshots[index];
+          },
+          ::py::arg("index"));
+
+  ::py::class_<dart::neural::BatchedLossGradient>(m, "BatchedLossGradient")
+      .def_property_readonly(
+          "lossWrtPosition",
+          +[](dart::neural::BatchedLossGradient* self) -> Eigen::MatrixXd& {
+            return self->lossWrtPosition;
+          })
+      .def_property_readonly(
+          "lossWrtVelocity",
+          +[](dart::neural::BatchedLossGradient* self) -> Eigen::MatrixXd& {
+            return self->lossWrtVelocity;
+          })
+      .def_property_readonly(
+          "lossWrtTorque",
+          +[](dart::neural::BatchedLossGradient* self) -> Eigen::MatrixXd& {
+            return self->lossWrtTorque;
+          });
+
+  ::py::class_<
+      dart::neural::BatchedWorld,
+      std::shared_ptr<dart::neural::BatchedWorld>>(m, "BatchedWorld")
+      .def(
+          ::py::init<std::shared_ptr<simulation::World>, int, int>(),
+          ::py::arg("world"),
+          ::py::arg("batchSize"),
+          ::py::arg("numThreads") = 0)
+      .def("getBatchSize", &dart::neural::BatchedWorld::getBatchSize)
+      .def(
+          "setBatchSize",
+          &dart::neural::BatchedWorld::setBatchSize,
+          ::py::arg("batchSize"))
+      .def(
+          "getWorld",
+          &dart::neural::BatchedWorld::getWorld,
+          ::py::arg("index"))
+      .def("getWorlds", &dart::neural::BatchedWorld::getWorlds)
+      .def("getNumDofs", &dart::neural::BatchedWorld::getNumDofs)
+      .def("getPositions", &dart::neural::BatchedWorld::getPositions)
+      .def("getVelocities", &dart::neural::BatchedWorld::getVelocities)
+      // These release the GIL while the batch runs on the thread pool. The
+      // batch's worlds are shared, so don't run two passes on the same
+      // BatchedWorld from different Python threads at once.
+      .def(
+          "forwardPass",
+          &dart::neural::BatchedWorld::forwardPass,
+          ::py::arg("positions"),
+          ::py::arg("velocities"),
+          ::py::arg("torques"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backprop",
+          &dart::neural::BatchedWorld::backprop,
+          ::py::arg("snapshots"),
+          ::py::arg("nextTimestepLosses"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "step",
+          &dart::neural::BatchedWorld::step,
+          ::py::arg("positions"),
+          ::py::arg("velocities"),
+          ::py::arg("torques"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backpropStep",
+          &dart::neural::BatchedWorld::backpropStep,
+          ::py::arg("step"),
+          ::py::arg("lossWrtNextPosition"),
+          ::py::arg("lossWrtNextVelocity"),
+          ::py::call_guard<py::gil_scoped_release>());
+
+  m.def(
+      "forwardPassBatch",
+      [](const std::vector<std::shared_ptr<simulation::World>>& worlds,
+         Eigen::Ref<const Eigen::MatrixXd> positions,
+         Eigen::Ref<const Eigen::MatrixXd> velocities,
+         Eigen::Ref<const Eigen::MatrixXd> torques,
+         bool idempotent) {
+        return dart::neural::forwardPassBatch(
+            worlds, positions, velocities, torques, idempotent);
+      },
+      ::py::arg("worlds"),
+      ::py::arg("positions"),
+      ::py::arg("velocities"),
+      ::py::arg("torques"),
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
+  m.def(
+      "backpropBatch",
+      [](const std::vector<std::shared_ptr<simulation::World>>& worlds,
+         const std::vector<std::shared_ptr<dart::neural::BackpropSnapshot>>&
+             snapshots,
+         const std::vector<dart::neural::LossGradient>& nextTimestepLosses) {
+        return dart::neural::backpropBatch(
+            worlds, snapshots, nextTimestepLosses);
+      },
+      ::py::arg("worlds"),
+      ::py::arg("snapshots"),
+      ::py::arg("nextTimestepLosses"),
+      ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
@@ -51,7 +51,8 @@ void MappedBackpropSnapshot(py::module& m)
           ::py::arg("world"),
           ::py::arg("thisTimestepLoss"),
           ::py::arg("nextTimestepLosses"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getRepresentation",
           &dart::neural::MappedBackpropSnapshot::getRepresentation)
@@ -62,66 +63,78 @@ void MappedBackpropSnapshot(py::module& m)
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getForceVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getForceVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosPosJacobian",
           &dart::neural::MappedBackpropSnapshot::getPosPosJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelPosJacobian",
           &dart::neural::MappedBackpropSnapshot::getVelPosJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getPosVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getMassVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getMassVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPreStepPosition",
           &dart::neural::MappedBackpropSnapshot::getPreStepPosition,
-          ::py::arg("mapping"))
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal)
       .def(
           "getPreStepVelocity",
           &dart::neural::MappedBackpropSnapshot::getPreStepVelocity,
-          ::py::arg("mapping"))
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal)
       .def(
           "getPreStepTorques",
           &dart::neural::MappedBackpropSnapshot::getPreStepTorques,
-          ::py::arg("mapping"))
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal)
       .def(
           "getPostStepPosition",
           &dart::neural::MappedBackpropSnapshot::getPostStepPosition,
-          ::py::arg("mapping"))
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal)
       .def(
           "getPostStepVelocity",
           &dart::neural::MappedBackpropSnapshot::getPostStepVelocity,
-          ::py::arg("mapping"))
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal)
       .def(
           "getPostStepTorques",
           &dart::neural::MappedBackpropSnapshot::getPostStepTorques,
-          ::py::arg("mapping"));
+          ::py::arg("mapping"),
+          ::py::return_value_policy::reference_internal);
 }
 
 } // namespace python
@@ -84,14 +84,16 @@ void NeuralUtils(py::module& m)
       "forwardPass",
       &dart::neural::forwardPass,
       ::py::arg("world"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "mappedForwardPass",
       &dart::neural::mappedForwardPass,
       ::py::arg("world"),
       ::py::arg("representation") = "identity",
       ::py::arg("mappings"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "convertJointSpaceToWorldSpace",
       &dart::neural::convertJointSpaceToWorldSpace,
@@ -100,7 +102,8 @@ void NeuralUtils(py::module& m)
       ::py::arg("nodes"),
       ::py::arg("space"),
       ::py::arg("backprop") = false,
-      ::py::arg("useIK") = true);
+      ::py::arg("useIK") = true,
+      ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
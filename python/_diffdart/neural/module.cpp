@@ -46,6 +46,7 @@ void IdentityMapping(py::module& sm);
 void BackpropSnapshot(py::module& sm);
 void MappedBackpropSnapshot(py::module& sm);
 void WithRespectToMass(py::module& sm);
+void BatchedWorld(py::module& sm);
 
 void dart_neural(py::module& m)
 {
@@ -62,6 +63,7 @@ void dart_neural(py::module& m)
   BackpropSnapshot(sm);
   MappedBackpropSnapshot(sm);
   WithRespectToMass(sm);
+  BatchedWorld(sm);
 }
 
 } // namespace python
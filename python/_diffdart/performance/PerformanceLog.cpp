@@ -58,7 +58,14 @@ void PerformanceLog(py::module& m)
                   std::string,
                   std::shared_ptr<dart::performance::FinalizedPerformanceLog>> {
             return self->finalize();
-          });
+          })
+      .def_static(
+          "initialize", &dart::performance::PerformanceLog::initialize)
+      .def_static(
+          "toChromeTrace", &dart::performance::PerformanceLog::toChromeTrace)
+      .def_static(
+          "toCollapsedStacks",
+          &dart::performance::PerformanceLog::toCollapsedStacks);
 }
 
 } // namespace python
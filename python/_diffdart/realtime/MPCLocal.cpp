@@ -94,6 +94,14 @@ void MPCLocal(py::module& m)
           "setMaxIterations",
           &dart::realtime::MPCLocal::setMaxIterations,
           ::py::arg("maxIterations"))
+      .def(
+          "setEnableAnytimeReplanning",
+          &dart::realtime::MPCLocal::setEnableAnytimeReplanning,
+          ::py::arg("enabled"))
+      .def(
+          "setAnytimeBufferFraction",
+          &dart::realtime::MPCLocal::setAnytimeBufferFraction,
+          ::py::arg("fraction"))
       .def(
           "recordGroundTruthState",
           &dart::realtime::MPCLocal::recordGroundTruthState,
@@ -93,6 +93,20 @@ void SSID(py::module& m)
           &dart::realtime::SSID::start,
           ::py::call_guard<py::gil_scoped_release>())
       .def("stop", &dart::realtime::SSID::stop)
+      .def(
+          "setSlidingWindowEnabled",
+          &dart::realtime::SSID::setSlidingWindowEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getSlidingWindowEnabled",
+          &dart::realtime::SSID::getSlidingWindowEnabled)
+      .def(
+          "setMillisBetweenInferences",
+          &dart::realtime::SSID::setMillisBetweenInferences,
+          ::py::arg("millis"))
+      .def(
+          "getMillisBetweenInferences",
+          &dart::realtime::SSID::getMillisBetweenInferences)
       .def(
           "runInference",
           &dart::realtime::SSID::runInference,
@@ -78,6 +78,10 @@ void GUIWebsocketServer(py::module& m)
           "isKeyDown",
           &dart::server::GUIWebsocketServer::isKeyDown,
           ::py::arg("key"))
+      .def(
+          "setBinaryProtocolEnabled",
+          &dart::server::GUIWebsocketServer::setBinaryProtocolEnabled,
+          ::py::arg("enabled"))
       .def("clear", &dart::server::GUIWebsocketServer::clear)
       .def(
           "createBox",
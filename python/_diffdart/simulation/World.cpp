@@ -238,15 +238,20 @@ void World(py::module& m)
       .def(
           "reset",
           +[](dart::simulation::World* self) -> void { return self->reset(); })
+      // Stepping releases the GIL so other Python threads can run, but a World
+      // still isn't thread safe. Don't use this World from another thread
+      // until step() returns.
       .def(
           "step",
-          +[](dart::simulation::World* self) -> void { return self->step(); })
+          +[](dart::simulation::World* self) -> void { return self->step(); },
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "step",
           +[](dart::simulation::World* self, bool _resetCommand) -> void {
             return self->step(_resetCommand);
           },
-          ::py::arg("resetCommand"))
+          ::py::arg("resetCommand"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setTime",
           +[](dart::simulation::World* self, double _time) -> void {
@@ -348,50 +353,60 @@ void World(py::module& m)
           })
       .def(
           "setPositions",
-          +[](dart::simulation::World* self, Eigen::VectorXd positions)
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> positions)
               -> void { self->setPositions(positions); })
       .def(
           "setVelocities",
-          +[](dart::simulation::World* self, Eigen::VectorXd velocities)
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> velocities)
               -> void { self->setVelocities(velocities); })
       .def(
           "setExternalForces",
-          +[](dart::simulation::World* self, Eigen::VectorXd forces) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> forces) -> void {
             self->setExternalForces(forces);
           })
       .def(
           "setMasses",
-          +[](dart::simulation::World* self, Eigen::VectorXd forces) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> forces) -> void {
             self->setMasses(forces);
           })
       .def(
           "setExternalForcesUpperLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setExternalForceUpperLimits(limits);
           })
       .def(
           "setExternalForcesLowerLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setExternalForceLowerLimits(limits);
           })
       .def(
           "setPositionUpperLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setPositionUpperLimits(limits);
           })
       .def(
           "setPositionLowerLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setPositionLowerLimits(limits);
           })
       .def(
           "setVelocityUpperLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setVelocityUpperLimits(limits);
           })
       .def(
           "setVelocityLowerLimits",
-          +[](dart::simulation::World* self, Eigen::VectorXd limits) -> void {
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXd> limits) -> void {
             self->setVelocityLowerLimits(limits);
           })
       .def(
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <dart/dynamics/BodyNode.hpp>
+#include <dart/neural/Mapping.hpp>
+#include <dart/simulation/World.hpp>
+#include <dart/trajectory/CommonLossFns.hpp>
+#include <dart/trajectory/LossFn.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void CommonLossFns(py::module& m)
+{
+  m.def(
+      "finalStateDistanceLoss",
+      &dart::trajectory::finalStateDistanceLoss,
+      ::py::arg("targetPos"),
+      ::py::arg("targetVel"),
+      ::py::arg("posWeight") = 1.0,
+      ::py::arg("velWeight") = 1.0,
+      ::py::arg("mapping") = "identity");
+  m.def(
+      "controlEffortLoss",
+      &dart::trajectory::controlEffortLoss,
+      ::py::arg("weight") = 1.0,
+      ::py::arg("mapping") = "identity");
+  m.def(
+      "worldSpaceBodyTrackingLoss",
+      &dart::trajectory::worldSpaceBodyTrackingLoss,
+      ::py::arg("world"),
+      ::py::arg("nodes"),
+      ::py::arg("targets"),
+      ::py::arg("weight") = 1.0,
+      ::py::arg("mapping") = "identity",
+      ::py::arg("mappingImpl") = nullptr);
+
+  ::py::class_<
+      dart::trajectory::WeightedLossBuilder,
+      std::shared_ptr<dart::trajectory::WeightedLossBuilder>>(
+      m, "WeightedLossBuilder")
+      .def(::py::init<>())
+      .def(
+          "add",
+          &dart::trajectory::WeightedLossBuilder::add,
+          ::py::arg("loss"),
+          ::py::arg("weight") = 1.0,
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "getNumTerms", &dart::trajectory::WeightedLossBuilder::getNumTerms)
+      .def("build", &dart::trajectory::WeightedLossBuilder::build);
+}
+
+} // namespace python
+} // namespace dart
@@ -100,6 +100,16 @@ void IPOptOptimizer(py::module& m)
           "setRecordIterations",
           &dart::trajectory::IPOptOptimizer::setRecordIterations,
           ::py::arg("recordIterations") = true)
+      .def(
+          "setGaussNewtonHessian",
+          &dart::trajectory::IPOptOptimizer::setGaussNewtonHessian,
+          ::py::arg("gaussNewtonHessian") = true)
+      .def(
+          "setDeadline",
+          &dart::trajectory::IPOptOptimizer::setDeadline,
+          ::py::arg("deadlineMillis"))
+      .def("clearDeadline", &dart::trajectory::IPOptOptimizer::clearDeadline)
+      .def("getDeadline", &dart::trajectory::IPOptOptimizer::getDeadline)
       .def(
           "registerIntermediateCallback",
           +[](dart::trajectory::IPOptOptimizer* self,
@@ -60,7 +60,12 @@ void MultiShot(py::module& m)
       .def(
           "setParallelOperationsEnabled",
           &dart::trajectory::MultiShot::setParallelOperationsEnabled,
-          ::py::arg("enabled"));
+          ::py::arg("enabled"))
+      .def(
+          "setNumThreads",
+          &dart::trajectory::MultiShot::setNumThreads,
+          ::py::arg("numThreads"))
+      .def("getNumThreads", &dart::trajectory::MultiShot::getNumThreads);
 }
 
 } // namespace python
@@ -281,7 +281,8 @@ void Problem(py::module& m)
           "getFinalState",
           &dart::trajectory::Problem::getFinalState,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def("getNumSteps", &dart::trajectory::Problem::getNumSteps)
       .def(
           "getFlatDimName",
@@ -292,14 +293,23 @@ void Problem(py::module& m)
           "getLoss",
           &dart::trajectory::Problem::getLoss,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getRolloutCache",
-          &dart::trajectory::Problem::getRolloutCache,
+          // The cache gets replaced whenever the problem changes, so we hand
+          // Python its own copy. Otherwise any views onto it would dangle.
+          +[](dart::trajectory::Problem* self,
+              std::shared_ptr<simulation::World> world,
+              performance::PerformanceLog* perfLog,
+              bool useKnots) -> dart::trajectory::TrajectoryRollout* {
+            return self->getRolloutCache(world, perfLog, useKnots)->copy();
+          },
           ::py::arg("world"),
           ::py::arg("perfLog") = nullptr,
           ::py::arg("useKnots") = true,
-          ::py::return_value_policy::reference);
+          ::py::return_value_policy::take_ownership,
+          ::py::call_guard<py::gil_scoped_release>());
   /*
 .def(
   "getRepresentation",
@@ -54,7 +54,23 @@ void SingleShot(py::module& m)
           ::py::arg("world"),
           ::py::arg("loss"),
           ::py::arg("steps"),
-          ::py::arg("tuneStartingState") = false);
+          ::py::arg("tuneStartingState") = false)
+      .def(
+          "setCheckpointInterval",
+          &dart::trajectory::SingleShot::setCheckpointInterval,
+          ::py::arg("interval"))
+      .def(
+          "getCheckpointInterval",
+          &dart::trajectory::SingleShot::getCheckpointInterval)
+      .def(
+          "setSnapshotMemoryBudget",
+          &dart::trajectory::SingleShot::setSnapshotMemoryBudget,
+          ::py::arg("world"),
+          ::py::arg("bytes"))
+      .def(
+          "estimateSnapshotBytes",
+          &dart::trajectory::SingleShot::estimateSnapshotBytes,
+          ::py::arg("world"));
 }
 
 } // namespace python
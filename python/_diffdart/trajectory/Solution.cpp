@@ -56,7 +56,10 @@ void Solution(py::module& m)
           "getPerfLog",
           &dart::trajectory::Solution::getPerfLog,
           ::py::return_value_policy::reference)
-      .def("reoptimize", &dart::trajectory::Solution::reoptimize);
+      .def(
+          "reoptimize",
+          &dart::trajectory::Solution::reoptimize,
+          ::py::call_guard<py::gil_scoped_release>());
 
   ::py::class_<dart::trajectory::OptimizationStep>(m, "OptimizationStep")
       .def_readonly("index", &dart::trajectory::OptimizationStep::index)
@@ -64,7 +67,10 @@ void Solution(py::module& m)
       .def_readonly("loss", &dart::trajectory::OptimizationStep::loss)
       .def_readonly(
           "constraintViolation",
-          &dart::trajectory::OptimizationStep::constraintViolation);
+          &dart::trajectory::OptimizationStep::constraintViolation)
+      .def_readonly(
+          "durationMillis",
+          &dart::trajectory::OptimizationStep::durationMillis);
 }
 
 } // namespace python
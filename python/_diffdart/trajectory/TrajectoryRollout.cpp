@@ -52,7 +52,17 @@ namespace python {
 
 void TrajectoryRollout(py::module& m)
 {
-  ::py::class_<dart::trajectory::TrajectoryRollout>(m, "TrajectoryRollout")
+  // The getters return writable NumPy views onto the rollout's own storage,
+  // rather than copies, so editing them in place edits the rollout. Each view
+  // keeps its Python rollout object alive, which is enough when Python owns
+  // the rollout (Problem.getRolloutCache(), copy() and OptimizationStep all
+  // hand out rollouts Python owns). Rollouts passed into a Python loss
+  // function belong to C++ and only live for the duration of the call, so
+  // copy anything you want to keep past it.
+  ::py::class_<
+      dart::trajectory::TrajectoryRollout,
+      std::shared_ptr<dart::trajectory::TrajectoryRollout>>(
+      m, "TrajectoryRollout")
       .def(
           "getRepresentationMapping",
           &dart::trajectory::TrajectoryRollout::getRepresentationMapping)
@@ -60,16 +70,22 @@ void TrajectoryRollout(py::module& m)
       .def(
           "getPoses",
           &dart::trajectory::TrajectoryRollout::getPoses,
-          ::py::arg("mapping") = "identity")
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
       .def(
           "getVels",
           &dart::trajectory::TrajectoryRollout::getVels,
-          ::py::arg("mapping") = "identity")
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
       .def(
           "getForces",
           &dart::trajectory::TrajectoryRollout::getForces,
-          ::py::arg("mapping") = "identity")
-      .def("getMasses", &dart::trajectory::TrajectoryRollout::getMasses)
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "getMasses",
+          &dart::trajectory::TrajectoryRollout::getMasses,
+          ::py::return_value_policy::reference_internal)
       .def(
           "toJson",
           &dart::trajectory::TrajectoryRollout::toJson,
@@ -40,7 +40,9 @@ namespace dart {
 namespace python {
 
 void IPOptOptimizer(py::module& sm);
+void ILQROptimizer(py::module& sm);
 void LossFn(py::module& sm);
+void CommonLossFns(py::module& sm);
 void Problem(py::module& sm);
 void MultiShot(py::module& sm);
 void SingleShot(py::module& sm);
@@ -56,7 +58,9 @@ void dart_trajectory(py::module& m)
         "transcribing DART trajectory problems into IPOPT for solutions.";
 
   IPOptOptimizer(sm);
+  ILQROptimizer(sm);
   LossFn(sm);
+  CommonLossFns(sm);
   Problem(sm);
   MultiShot(sm);
   SingleShot(sm);
@@ -0,0 +1,70 @@
+import diffdart_libs._diffdart as dart
+import torch
+from typing import Tuple
+
+
+class BatchedDartLayer(torch.autograd.Function):
+    """
+    This implements a single, differentiable timestep of a whole batch of DART
+    worlds as a PyTorch layer. The batch is stepped (and differentiated) by a
+    single native call on a dart.neural.BatchedWorld, which runs the worlds in
+    parallel on its own thread pool with the GIL released, so there's no
+    per-sample Python overhead.
+    """
+
+    @staticmethod
+    def forward(ctx, batched_world, pos, vel, torque):
+        """
+        We can't put type annotations on this declaration, because the supertype
+        doesn't have any type annotations and otherwise mypy will complain, so here
+        are the types:
+
+        batched_world: dart.neural.BatchedWorld
+        pos: torch.Tensor, (batch size x world DOFs)
+        vel: torch.Tensor, (batch size x world DOFs)
+        torque: torch.Tensor, (batch size x world DOFs)
+        -> [torch.Tensor, torch.Tensor]
+        """
+
+        # The native side wants one column per world, so we hand it the
+        # transpose. For a contiguous float64 tensor that's a column-major view,
+        # which the binding reads in place. Anything else gets converted first.
+        step: dart.neural.BatchedStep = batched_world.step(
+            pos.detach().numpy().T, vel.detach().numpy().T, torque.detach().numpy().T)
+        ctx.batched_world = batched_world
+        ctx.step = step
+
+        # nextPositions and nextVelocities are views onto the step, so this
+        # doesn't copy either
+        return (torch.from_numpy(step.nextPositions.T), torch.from_numpy(step.nextVelocities.T))
+
+    @staticmethod
+    def backward(ctx, grad_pos, grad_vel):
+        """
+        In the backward pass we receive a Tensor containing the gradient of the loss
+        with respect to the output, and we need to compute the gradient of the loss
+        with respect to the input.
+        """
+        batched_world: dart.neural.BatchedWorld = ctx.batched_world
+        step: dart.neural.BatchedStep = ctx.step
+
+        grads: dart.neural.BatchedLossGradient = batched_world.backpropStep(
+            step, grad_pos.detach().numpy().T, grad_vel.detach().numpy().T)
+
+        return (
+            None,
+            torch.from_numpy(grads.lossWrtPosition.T),
+            torch.from_numpy(grads.lossWrtVelocity.T),
+            torch.from_numpy(grads.lossWrtTorque.T)
+        )
+
+
+def batched_dart_layer(batched_world: dart.neural.BatchedWorld, pos: torch.Tensor,
+                       vel: torch.Tensor, torque: torch.Tensor) -> Tuple[torch.Tensor,
+                                                                          torch.Tensor]:
+    """
+    This does a forward pass on every world in `batched_world`, where row i of
+    `pos`, `vel` and `torque` is the state of world i. The batch size of the
+    inputs must match batched_world.getBatchSize().
+    """
+    return BatchedDartLayer.apply(batched_world, pos, vel, torque)  # type: ignore
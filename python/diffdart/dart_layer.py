@@ -30,9 +30,12 @@ class DartLayer(torch.autograd.Function):
         -> [torch.Tensor, torch.Tensor]
         """
 
+        # The setters read straight out of the tensors' storage, and forwardPass
+        # releases the GIL while it simulates, so other Python threads (like
+        # data loaders) can run at the same time.
         world.setPositions(pos.detach().numpy())
         world.setVelocities(vel.detach().numpy())
-        world.setForces(torque.detach().numpy())
+        world.setExternalForces(torque.detach().numpy())
         backprop_snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(world)
         ctx.backprop_snapshot = backprop_snapshot
         ctx.world = world
@@ -40,7 +43,9 @@ class DartLayer(torch.autograd.Function):
         if snapshot_pointer is not None:
             snapshot_pointer.backprop_snapshot = backprop_snapshot
 
-        return (torch.tensor(world.getPositions()), torch.tensor(world.getVelocities()))
+        # getPositions() and getVelocities() return freshly allocated arrays, so
+        # we can wrap them without copying
+        return (torch.from_numpy(world.getPositions()), torch.from_numpy(world.getVelocities()))
 
     @staticmethod
     def backward(ctx, grad_pos, grad_vel):
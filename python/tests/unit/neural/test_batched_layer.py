@@ -0,0 +1,80 @@
+import numpy as np
+import pytest
+import torch
+import diffdart as dart
+from diffdart import batched_dart_layer
+
+BATCH_SIZE = 4
+
+
+def create_cartpole_world():
+    world = dart.simulation.World()
+    world.setGravity([0, -9.81, 0])
+
+    cartpole = dart.dynamics.Skeleton()
+    cartRail, cart = cartpole.createPrismaticJointAndBodyNodePair()
+    cartRail.setAxis([1, 0, 0])
+    cart.createShapeNode(dart.dynamics.BoxShape([.5, .1, .1]))
+
+    poleJoint, pole = cartpole.createRevoluteJointAndBodyNodePair(cart)
+    poleJoint.setAxis([0, 0, 1])
+    pole.createShapeNode(dart.dynamics.BoxShape([.1, 1.0, .1]))
+    poleOffset = dart.math.Isometry3()
+    poleOffset.set_translation([0, -0.5, 0])
+    poleJoint.setTransformFromChildBodyNode(poleOffset)
+
+    world.addSkeleton(cartpole)
+    return world
+
+
+def create_batch_inputs(dofs):
+    torch.manual_seed(1234)
+    pos = torch.rand(BATCH_SIZE, dofs, dtype=torch.float64, requires_grad=True)
+    vel = torch.rand(BATCH_SIZE, dofs, dtype=torch.float64, requires_grad=True)
+    torque = torch.rand(BATCH_SIZE, dofs, dtype=torch.float64,
+                        requires_grad=True)
+    return pos, vel, torque
+
+
+def test_batched_layer_forward_matches_serial_step():
+    world = create_cartpole_world()
+    batched_world = dart.neural.BatchedWorld(world, BATCH_SIZE, 2)
+    pos, vel, torque = create_batch_inputs(world.getNumDofs())
+
+    next_pos, next_vel = batched_dart_layer(batched_world, pos, vel, torque)
+    assert next_pos.shape == (BATCH_SIZE, world.getNumDofs())
+    assert next_vel.shape == (BATCH_SIZE, world.getNumDofs())
+
+    # The layer output is the state the batched worlds ended up in
+    np.testing.assert_array_equal(
+        next_pos.detach().numpy(), batched_world.getPositions().T)
+    np.testing.assert_array_equal(
+        next_vel.detach().numpy(), batched_world.getVelocities().T)
+
+    # And each row matches stepping a copy of the world on its own
+    for i in range(BATCH_SIZE):
+        serial_world = world.clone()
+        serial_world.setPositions(pos[i].detach().numpy())
+        serial_world.setVelocities(vel[i].detach().numpy())
+        serial_world.setExternalForces(torque[i].detach().numpy())
+        dart.neural.forwardPass(serial_world)
+        np.testing.assert_allclose(
+            next_pos[i].detach().numpy(), serial_world.getPositions())
+        np.testing.assert_allclose(
+            next_vel[i].detach().numpy(), serial_world.getVelocities())
+
+
+def test_batched_layer_gradient_matches_finite_differences():
+    world = create_cartpole_world()
+    batched_world = dart.neural.BatchedWorld(world, BATCH_SIZE, 2)
+    pos, vel, torque = create_batch_inputs(world.getNumDofs())
+
+    def layer(pos, vel, torque):
+        return batched_dart_layer(batched_world, pos, vel, torque)
+
+    assert torch.autograd.gradcheck(
+        layer, (pos, vel, torque), eps=1e-6, atol=1e-5, rtol=1e-3)
+
+
+if __name__ == "__main__":
+    pytest.main()
@@ -2367,11 +2367,78 @@ std::cout << "v_t --> p_t+1:" << std::endl
     return false;
   }
 
+  // The VJP-only backprop should agree with the Jacobian-based backprop
+  LossGradient vjpTimeStep;
+  classicPtr->backpropVJP(world, vjpTimeStep, nextTimeStep);
+  if (!equals(vjpTimeStep.lossWrtPosition, thisTimeStep.lossWrtPosition, 1e-5)
+      || !equals(
+          vjpTimeStep.lossWrtVelocity, thisTimeStep.lossWrtVelocity, 1e-5)
+      || !equals(vjpTimeStep.lossWrtTorque, thisTimeStep.lossWrtTorque, 1e-5)
+      || !equals(vjpTimeStep.lossWrtMass, thisTimeStep.lossWrtMass, 1e-5))
+  {
+    std::cout << "VJP backprop disagrees with Jacobian backprop" << std::endl;
+    std::cout << "Input: loss wrt position at time t + 1:" << std::endl
+              << nextTimeStep.lossWrtPosition << std::endl;
+    std::cout << "Input: loss wrt velocity at time t + 1:" << std::endl
+              << nextTimeStep.lossWrtVelocity << std::endl;
+    std::cout << "Position diff (VJP - Jacobian):" << std::endl
+              << vjpTimeStep.lossWrtPosition - thisTimeStep.lossWrtPosition
+              << std::endl;
+    std::cout << "Velocity diff (VJP - Jacobian):" << std::endl
+              << vjpTimeStep.lossWrtVelocity - thisTimeStep.lossWrtVelocity
+              << std::endl;
+    std::cout << "Torque diff (VJP - Jacobian):" << std::endl
+              << vjpTimeStep.lossWrtTorque - thisTimeStep.lossWrtTorque
+              << std::endl;
+    std::cout << "Mass diff (VJP - Jacobian):" << std::endl
+              << vjpTimeStep.lossWrtMass - thisTimeStep.lossWrtMass
+              << std::endl;
+    return false;
+  }
+
   snapshot.restore();
 
   return true;
 }
 
+bool verifyAnalyticalJVP(
+    WorldPtr world, const neural::BackpropSnapshotPtr& classicPtr)
+{
+  int n = world->getNumDofs();
+  int massDim = world->getMassDims();
+  int k = 3;
+  srand(42);
+  Eigen::MatrixXd tangentPos = Eigen::MatrixXd::Random(n, k);
+  Eigen::MatrixXd tangentVel = Eigen::MatrixXd::Random(n, k);
+  Eigen::MatrixXd tangentForce = Eigen::MatrixXd::Random(n, k);
+  Eigen::MatrixXd tangentMass = Eigen::MatrixXd::Random(massDim, k);
+
+  neural::StateTangent jvp = classicPtr->jvp(
+      world, tangentPos, tangentVel, tangentForce, tangentMass);
+
+  Eigen::MatrixXd bruteForcePos
+      = classicPtr->getPosPosJacobian(world) * tangentPos
+        + classicPtr->getVelPosJacobian(world) * tangentVel;
+  Eigen::MatrixXd bruteForceVel
+      = classicPtr->getPosVelJacobian(world) * tangentPos
+        + classicPtr->getVelVelJacobian(world) * tangentVel
+        + classicPtr->getForceVelJacobian(world) * tangentForce;
+  if (massDim > 0)
+    bruteForceVel += classicPtr->getMassVelJacobian(world) * tangentMass;
+
+  if (!equals(jvp.position, bruteForcePos, 1e-7)
+      || !equals(jvp.velocity, bruteForceVel, 1e-7))
+  {
+    std::cout << "JVP disagrees with the Jacobians" << std::endl;
+    std::cout << "Position diff (JVP - Jacobian):" << std::endl
+              << jvp.position - bruteForcePos << std::endl;
+    std::cout << "Velocity diff (JVP - Jacobian):" << std::endl
+              << jvp.velocity - bruteForceVel << std::endl;
+    return false;
+  }
+  return true;
+}
+
 bool verifyAnalyticalBackprop(WorldPtr world)
 {
   neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
@@ -2406,6 +2473,10 @@ bool verifyAnalyticalBackprop(WorldPtr world)
   if (!verifyAnalyticalBackpropInstance(world, classicPtr, phaseSpace))
     return false;
 
+  // The forward-mode JVP should agree with the Jacobians too
+  if (!verifyAnalyticalJVP(world, classicPtr))
+    return false;
+
   return true;
 }
 
@@ -5324,6 +5395,22 @@ bool verifyAnalyticalA_cJacobian(WorldPtr world)
       std::cout << "Analytical constraint forces Jac skel-by-skel:" << std::endl
                 << skelAnalytical << std::endl;
     }
+
+    // Check that the chain-restricted block multiplies like the full Jacobian
+
+    DofBlockJacobian block
+        = constraints[i]->getConstraintForcesJacobianBlock(world);
+    Eigen::VectorXd v = Eigen::VectorXd::Random(world->getNumDofs());
+    Eigen::VectorXd blockProduct = block.transposeTimes(v);
+    Eigen::VectorXd denseProduct = analytical.transpose() * v;
+    if (!equals(blockProduct, denseProduct, 1e-9))
+    {
+      std::cout << "Constraint forces Jac block transpose product incorrect!"
+                << std::endl;
+      std::cout << "Block:" << std::endl << blockProduct << std::endl;
+      std::cout << "Dense:" << std::endl << denseProduct << std::endl;
+      return false;
+    }
   }
 
   return true;
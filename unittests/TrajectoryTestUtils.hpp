@@ -270,6 +270,24 @@ bool verifyShotJacobian(
               << (analyticalJacobian - bruteForceJacobian) << std::endl;
     return false;
   }
+
+  // Pushing a few directions forward should match the Jacobian times them
+  int staticDim = shot.getFlatStaticProblemDim(world);
+  Eigen::MatrixXd tangents = Eigen::MatrixXd::Random(dim, 3);
+  Eigen::MatrixXd jvp = shot.jvpOfFinalState(
+      world,
+      tangents.topRows(staticDim),
+      tangents.bottomRows(dim - staticDim));
+  Eigen::MatrixXd expectedJvp = analyticalJacobian * tangents;
+  if (!equals(jvp, expectedJvp, 1e-8))
+  {
+    std::cout << "JVP doesn't match the Jacobian!" << std::endl;
+    std::cout << "JVP:" << std::endl << jvp << std::endl;
+    std::cout << "Jacobian * tangents:" << std::endl
+              << expectedJvp << std::endl;
+    std::cout << "Diff:" << std::endl << (jvp - expectedJvp) << std::endl;
+    return false;
+  }
   return true;
 }
 
@@ -0,0 +1,99 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/collision/dart/DARTCollisionGroup.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Geometry.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace collision;
+
+/// This scatters `state.range(0)` boxes and spheres through a volume that grows
+/// with the number of objects, so each object touches a handful of neighbors
+/// no matter how big the scene is. Then it times collide() on the whole group,
+/// nudging the objects between iterations so the broadphase has to keep up
+/// with motion.
+void benchmarkCollide(benchmark::State& state, bool broadphase)
+{
+  const int numObjects = state.range(0);
+  const double spread = std::cbrt(static_cast<double>(numObjects)) * 0.6;
+
+  srand(42);
+  auto detector = DARTCollisionDetector::create();
+  auto group = detector->createCollisionGroup();
+  static_cast<DARTCollisionGroup*>(group.get())
+      ->setBroadphaseEnabled(broadphase);
+
+  std::vector<SimpleFramePtr> frames;
+  for (int i = 0; i < numObjects; i++)
+  {
+    SimpleFramePtr frame = std::make_shared<SimpleFrame>(
+        Frame::World(), "frame_" + std::to_string(i));
+    if (i % 2 == 0)
+    {
+      frame->setShape(
+          std::make_shared<BoxShape>(Eigen::Vector3d::Constant(0.5)));
+    }
+    else
+    {
+      frame->setShape(std::make_shared<SphereShape>(0.3));
+    }
+    Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+    transform.translation() = Eigen::Vector3d::Random() * spread;
+    transform.linear() = math::expMapRot(Eigen::Vector3d::Random());
+    frame->setRelativeTransform(transform);
+    group->addShapeFrame(frame.get());
+    frames.push_back(frame);
+  }
+
+  CollisionOption option(true, 10000u);
+  CollisionResult result;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    for (SimpleFramePtr& frame : frames)
+    {
+      Eigen::Isometry3d transform = frame->getRelativeTransform();
+      transform.translation() += Eigen::Vector3d::Random() * 0.01;
+      frame->setRelativeTransform(transform);
+    }
+    state.ResumeTiming();
+
+    group->collide(option, &result);
+  }
+
+  state.counters["contacts"] = result.getNumContacts();
+}
+
+static void BM_Collide_BruteForce(benchmark::State& state)
+{
+  benchmarkCollide(state, false);
+}
+BENCHMARK(BM_Collide_BruteForce)
+    ->Arg(10)
+    ->Arg(50)
+    ->Arg(200)
+    ->Arg(500)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_Collide_Broadphase(benchmark::State& state)
+{
+  benchmarkCollide(state, true);
+}
+BENCHMARK(BM_Collide_Broadphase)
+    ->Arg(10)
+    ->Arg(50)
+    ->Arg(200)
+    ->Arg(500)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
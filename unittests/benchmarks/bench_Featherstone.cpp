@@ -7,6 +7,7 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/dynamics/BatchedSimpleFeatherstone.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -53,6 +54,8 @@ static void BM_Cartpole_DART_Featherstone(benchmark::State& state)
     cartpole->integrateVelocities(dt);
     cartpole->integratePositions(dt);
   }
+  state.counters["env_steps_per_second"]
+      = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
 }
 BENCHMARK(BM_Cartpole_DART_Featherstone);
 
@@ -84,6 +87,8 @@ static void BM_Cartpole_Simple_Featherstone(benchmark::State& state)
       vel[i] += accel[i] * dt;
     }
   }
+  state.counters["env_steps_per_second"]
+      = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
 
   free(pos);
   free(vel);
@@ -103,6 +108,8 @@ static void BM_20_Joint_DART_Featherstone(benchmark::State& state)
     arm->integrateVelocities(dt);
     arm->integratePositions(dt);
   }
+  state.counters["env_steps_per_second"]
+      = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
 }
 BENCHMARK(BM_20_Joint_DART_Featherstone);
 
@@ -134,6 +141,8 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
       vel[i] += accel[i] * dt;
     }
   }
+  state.counters["env_steps_per_second"]
+      = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
 
   free(pos);
   free(vel);
@@ -142,4 +151,49 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
 }
 BENCHMARK(BM_20_Joint_Simple_Featherstone);
 
+// This steps state.range(0) copies of `skel` at once, each starting from a
+// different random state
+static void runBatchedSimpleFeatherstone(
+    benchmark::State& state, SkeletonPtr skel)
+{
+  int batchSize = state.range(0);
+  BatchedSimpleFeatherstone batched(batchSize);
+  batched.populateFromSkeleton(skel);
+
+  Eigen::MatrixXd pos
+      = Eigen::MatrixXd::Random(batched.getNumDofs(), batchSize);
+  Eigen::MatrixXd vel
+      = Eigen::MatrixXd::Random(batched.getNumDofs(), batchSize);
+  Eigen::MatrixXd force
+      = Eigen::MatrixXd::Random(batched.getNumDofs(), batchSize);
+  Eigen::MatrixXd accel
+      = Eigen::MatrixXd::Zero(batched.getNumDofs(), batchSize);
+
+  double dt = 0.001;
+  for (auto _ : state)
+  {
+    batched.forwardDynamics(pos, vel, force, accel);
+    pos += vel * dt;
+    vel += accel * dt;
+  }
+  state.counters["env_steps_per_second"] = benchmark::Counter(
+      state.iterations() * batchSize, benchmark::Counter::kIsRate);
+}
+
+static void BM_Cartpole_Batched_Simple_Featherstone(benchmark::State& state)
+{
+  runBatchedSimpleFeatherstone(state, createCartpole());
+}
+BENCHMARK(BM_Cartpole_Batched_Simple_Featherstone)
+    ->RangeMultiplier(4)
+    ->Range(1, 1024);
+
+static void BM_20_Joint_Batched_Simple_Featherstone(benchmark::State& state)
+{
+  runBatchedSimpleFeatherstone(state, createMultiarmRobot(20, 0.2));
+}
+BENCHMARK(BM_20_Joint_Batched_Simple_Featherstone)
+    ->RangeMultiplier(4)
+    ->Range(1, 1024);
+
 BENCHMARK_MAIN();
\ No newline at end of file
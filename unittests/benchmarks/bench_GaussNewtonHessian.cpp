@@ -0,0 +1,179 @@
+#include <functional>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/IPOptOptimizer.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/SingleShot.hpp"
+#include "dart/trajectory/Solution.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/UniversalLoader.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace trajectory;
+
+/// This creates the cartpole from test_Trajectory
+WorldPtr createCartpoleWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  std::shared_ptr<BoxShape> sledShapeBox(
+      new BoxShape(Eigen::Vector3d(0.05, 0.25, 0.05)));
+  sledPair.second->createShapeNodeWith<VisualAspect>(sledShapeBox);
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  std::shared_ptr<BoxShape> armShapeBox(
+      new BoxShape(Eigen::Vector3d(0.05, 0.25, 0.05)));
+  armPair.second->createShapeNodeWith<VisualAspect>(armShapeBox);
+
+  Eigen::Isometry3d armOffset = Eigen::Isometry3d::Identity();
+  armOffset.translation() = Eigen::Vector3d(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+
+  world->addSkeleton(cartpole);
+
+  cartpole->setForceUpperLimit(0, 0);
+  cartpole->setForceLowerLimit(0, 0);
+  cartpole->setVelocityUpperLimit(0, 1000);
+  cartpole->setVelocityLowerLimit(0, -1000);
+  cartpole->setPositionUpperLimit(0, 10);
+  cartpole->setPositionLowerLimit(0, -10);
+
+  cartpole->setForceLowerLimit(1, -1000);
+  cartpole->setForceUpperLimit(1, 1000);
+  cartpole->setVelocityUpperLimit(1, 1000);
+  cartpole->setVelocityLowerLimit(1, -1000);
+  cartpole->setPositionUpperLimit(1, 10);
+  cartpole->setPositionLowerLimit(1, -10);
+
+  cartpole->setPosition(0, 0);
+  cartpole->setPosition(1, 15.0 / 180.0 * 3.1415);
+
+  return world;
+}
+
+/// This is a least-squares loss that drives the final state to the origin,
+/// with a small penalty on effort. The analytical gradient keeps finite
+/// differencing noise out of the Gauss-Newton Hessian.
+LossFn createFinalStateLoss()
+{
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    int steps = rollout->getPosesConst().cols();
+    return rollout->getPosesConst().col(steps - 1).squaredNorm()
+           + rollout->getVelsConst().col(steps - 1).squaredNorm()
+           + 1e-3 * rollout->getForcesConst().squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossGrad = [](const TrajectoryRollout* rollout,
+                                        TrajectoryRollout* gradWrtRollout // OUT
+                                     ) {
+    int steps = rollout->getPosesConst().cols();
+    gradWrtRollout->getPoses().setZero();
+    gradWrtRollout->getVels().setZero();
+    gradWrtRollout->getPoses().col(steps - 1)
+        = 2 * rollout->getPosesConst().col(steps - 1);
+    gradWrtRollout->getVels().col(steps - 1)
+        = 2 * rollout->getVelsConst().col(steps - 1);
+    gradWrtRollout->getForces() = 2e-3 * rollout->getForcesConst();
+    return rollout->getPosesConst().col(steps - 1).squaredNorm()
+           + rollout->getVelsConst().col(steps - 1).squaredNorm()
+           + 1e-3 * rollout->getForcesConst().squaredNorm();
+  };
+  return LossFn(loss, lossGrad);
+}
+
+/// This optimizes a fresh problem from `createProblem` on each iteration, and
+/// reports how many IPOPT iterations that took. Comparing the time and the
+/// iteration count with and without `gaussNewton` shows whether the extra cost
+/// of building the Hessian pays for itself.
+void benchmarkIPOpt(
+    benchmark::State& state,
+    std::function<std::shared_ptr<Problem>()> createProblem,
+    bool gaussNewton)
+{
+  IPOptOptimizer optimizer;
+  optimizer.setGaussNewtonHessian(gaussNewton);
+  optimizer.setLBFGSHistoryLength(5);
+  optimizer.setTolerance(1e-5);
+  optimizer.setIterationLimit(500);
+  optimizer.setSilenceOutput(true);
+
+  long iterations = 0;
+  long runs = 0;
+  double finalLoss = 0.0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    std::shared_ptr<Problem> problem = createProblem();
+    state.ResumeTiming();
+
+    std::shared_ptr<Solution> record = optimizer.optimize(problem.get());
+
+    state.PauseTiming();
+    iterations += record->getNumSteps();
+    finalLoss = record->getStep(record->getNumSteps() - 1).loss;
+    runs++;
+    state.ResumeTiming();
+  }
+
+  state.counters["ipopt_iterations"]
+      = runs == 0 ? 0.0 : static_cast<double>(iterations) / runs;
+  state.counters["final_loss"] = finalLoss;
+}
+
+std::shared_ptr<Problem> createCartpoleShot()
+{
+  WorldPtr world = createCartpoleWorld();
+  return std::make_shared<SingleShot>(world, createFinalStateLoss(), 50, true);
+}
+
+std::shared_ptr<Problem> createHalfCheetahMultiShot()
+{
+  WorldPtr world = dart::utils::UniversalLoader::loadWorld(
+      "dart://sample/skel/half_cheetah.skel");
+  return std::make_shared<MultiShot>(
+      world, createFinalStateLoss(), 40, 10, false);
+}
+
+static void BM_Cartpole_LBFGS(benchmark::State& state)
+{
+  benchmarkIPOpt(state, createCartpoleShot, false);
+}
+BENCHMARK(BM_Cartpole_LBFGS)->Unit(benchmark::kMillisecond);
+
+static void BM_Cartpole_GaussNewton(benchmark::State& state)
+{
+  benchmarkIPOpt(state, createCartpoleShot, true);
+}
+BENCHMARK(BM_Cartpole_GaussNewton)->Unit(benchmark::kMillisecond);
+
+static void BM_HalfCheetah_LBFGS(benchmark::State& state)
+{
+  benchmarkIPOpt(state, createHalfCheetahMultiShot, false);
+}
+BENCHMARK(BM_HalfCheetah_LBFGS)->Unit(benchmark::kMillisecond);
+
+static void BM_HalfCheetah_GaussNewton(benchmark::State& state)
+{
+  benchmarkIPOpt(state, createHalfCheetahMultiShot, true);
+}
+BENCHMARK(BM_HalfCheetah_GaussNewton)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
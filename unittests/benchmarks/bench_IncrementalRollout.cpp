@@ -0,0 +1,164 @@
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/SingleShot.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace trajectory;
+
+/// This adds a link to the catapult arm, like test_CatapultTrajectory does
+BodyNode* createTailSegment(BodyNode* parent)
+{
+  std::pair<RevoluteJoint*, BodyNode*> poleJointPair
+      = parent->createChildJointAndBodyNodePair<RevoluteJoint>();
+  RevoluteJoint* poleJoint = poleJointPair.first;
+  BodyNode* pole = poleJointPair.second;
+  poleJoint->setAxis(Eigen::Vector3d::UnitZ());
+
+  std::shared_ptr<BoxShape> shape(
+      new BoxShape(Eigen::Vector3d(0.05, 0.25, 0.05)));
+  pole->createShapeNodeWith<VisualAspect, CollisionAspect>(shape);
+  poleJoint->setForceUpperLimit(0, 1000.0);
+  poleJoint->setForceLowerLimit(0, -1000.0);
+  poleJoint->setVelocityUpperLimit(0, 10000.0);
+  poleJoint->setVelocityLowerLimit(0, -10000.0);
+
+  Eigen::Isometry3d poleOffset = Eigen::Isometry3d::Identity();
+  poleOffset.translation() = Eigen::Vector3d(0, -0.125, 0);
+  poleJoint->setTransformFromChildBodyNode(poleOffset);
+  poleJoint->setPosition(0, 90 * 3.1415 / 180);
+  poleJoint->setPositionUpperLimit(0, 180 * 3.1415 / 180);
+  poleJoint->setPositionLowerLimit(0, 0 * 3.1415 / 180);
+
+  if (parent->getParentBodyNode() != nullptr)
+  {
+    Eigen::Isometry3d childOffset = Eigen::Isometry3d::Identity();
+    childOffset.translation() = Eigen::Vector3d(0, 0.125, 0);
+    poleJoint->setTransformFromParentBodyNode(childOffset);
+  }
+
+  return pole;
+}
+
+/// This creates the catapult from test_CatapultTrajectory: a projectile
+/// resting on a floor, next to a three link arm
+WorldPtr createCatapultWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  SkeletonPtr projectile = Skeleton::create("projectile");
+  std::pair<TranslationalJoint2D*, BodyNode*> projectilePair
+      = projectile->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  std::shared_ptr<BoxShape> projectileShape(
+      new BoxShape(Eigen::Vector3d(0.1, 0.1, 0.1)));
+  projectilePair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      projectileShape);
+  projectilePair.first->setForceUpperLimit(0, 0);
+  projectilePair.first->setForceLowerLimit(0, 0);
+  projectilePair.first->setForceUpperLimit(1, 0);
+  projectilePair.first->setForceLowerLimit(1, 0);
+  projectile->setPositions(Eigen::Vector2d(0, 0.1));
+  world->addSkeleton(projectile);
+
+  SkeletonPtr catapult = Skeleton::create("catapult");
+  std::pair<WeldJoint*, BodyNode*> rootPair
+      = catapult->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3d rootOffset = Eigen::Isometry3d::Identity();
+  rootOffset.translation() = Eigen::Vector3d(0.5, -0.45, 0);
+  rootPair.first->setTransformFromParentBodyNode(rootOffset);
+  BodyNode* tail1 = createTailSegment(rootPair.second);
+  BodyNode* tail2 = createTailSegment(tail1);
+  createTailSegment(tail2);
+  catapult->setPositions(Eigen::Vector3d(45, 0, 45) * 3.1415 / 180);
+  world->addSkeleton(catapult);
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3d floorOffset = Eigen::Isometry3d::Identity();
+  floorOffset.translation() = Eigen::Vector3d(1.2, -0.7, 0);
+  floorPair.first->setTransformFromParentBodyNode(floorOffset);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3d(3.5, 0.25, 0.5)));
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  world->addSkeleton(floor);
+
+  return world;
+}
+
+/// This mimics the optimizer iterations on a catapult SingleShot, where each
+/// iteration nudges the forces from `editFraction` of the way through the
+/// horizon onwards, and then asks for the snapshots (as computing the loss
+/// gradient would). This reports how many timesteps get re-simulated per
+/// iteration, which was always the whole horizon before getSnapshots() kept
+/// the unchanged prefix.
+void benchmarkCatapultEdits(benchmark::State& state, double editFraction)
+{
+  const int steps = 100;
+  WorldPtr world = createCatapultWorld();
+  SingleShot shot(world, LossFn(), steps, false);
+
+  int staticDim = shot.getFlatStaticProblemDim(world);
+  int dynamicDim = shot.getFlatDynamicProblemDim(world);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Zero(dynamicDim);
+  shot.flatten(world, flatStatic, flatDynamic);
+  shot.getSnapshots(world);
+
+  int forceDim = dynamicDim / steps;
+  int firstEdited = static_cast<int>(editFraction * steps);
+  int recomputedBefore = shot.getNumSnapshotsRecomputed();
+  long iterations = 0;
+
+  srand(42);
+  for (auto _ : state)
+  {
+    flatDynamic.tail((steps - firstEdited) * forceDim)
+        += 0.01 * Eigen::VectorXd::Random((steps - firstEdited) * forceDim);
+    shot.unflatten(world, flatStatic, flatDynamic);
+    benchmark::DoNotOptimize(shot.getSnapshots(world));
+    iterations++;
+  }
+
+  state.counters["horizon"] = steps;
+  state.counters["forward_passes_per_iter"]
+      = iterations == 0
+            ? 0.0
+            : static_cast<double>(
+                  shot.getNumSnapshotsRecomputed() - recomputedBefore)
+                  / iterations;
+}
+
+static void BM_Catapult_EditWholeHorizon(benchmark::State& state)
+{
+  // This is the old behavior: every iteration re-simulates every timestep
+  benchmarkCatapultEdits(state, 0.0);
+}
+BENCHMARK(BM_Catapult_EditWholeHorizon);
+
+static void BM_Catapult_EditSecondHalf(benchmark::State& state)
+{
+  benchmarkCatapultEdits(state, 0.5);
+}
+BENCHMARK(BM_Catapult_EditSecondHalf);
+
+static void BM_Catapult_EditLastTenth(benchmark::State& state)
+{
+  benchmarkCatapultEdits(state, 0.9);
+}
+BENCHMARK(BM_Catapult_EditLastTenth);
+
+BENCHMARK_MAIN();
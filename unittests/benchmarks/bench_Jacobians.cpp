@@ -359,4 +359,51 @@ static void BM_Atlas_Finite_Difference(benchmark::State& state)
 // Register the function as a benchmark
 BENCHMARK(BM_Atlas_Finite_Difference);
 
+std::shared_ptr<dynamics::Skeleton> createMovingAtlas()
+{
+  std::shared_ptr<simulation::World> world = simulation::World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  std::shared_ptr<dynamics::Skeleton> atlas
+      = dart::utils::UniversalLoader::loadSkeleton(
+          world.get(), "dart://sample/sdf/atlas/atlas_v3_no_head.sdf");
+  atlas->setPosition(0, -0.5 * dart::math::constantsd::pi());
+  atlas->setPosition(4, -0.01);
+  // Give every DOF some velocity, so the Coriolis terms are non-trivial
+  atlas->setVelocities(
+      Eigen::VectorXd::LinSpaced(atlas->getNumDofs(), -0.5, 0.5));
+  return atlas;
+}
+
+static void BM_Atlas_Skeleton_Jacobians(benchmark::State& state)
+{
+  std::shared_ptr<dynamics::Skeleton> atlas = createMovingAtlas();
+  Eigen::VectorXd f = Eigen::VectorXd::Ones(atlas->getNumDofs());
+
+  for (auto _ : state)
+  {
+    atlas->getJacobianOfC(WithRespectTo::POSITION);
+    atlas->getVelCJacobian();
+    atlas->getJacobianOfMinv(f, WithRespectTo::POSITION);
+  }
+};
+// Register the function as a benchmark
+BENCHMARK(BM_Atlas_Skeleton_Jacobians);
+
+static void BM_Atlas_Skeleton_Jacobians_Finite_Difference(
+    benchmark::State& state)
+{
+  std::shared_ptr<dynamics::Skeleton> atlas = createMovingAtlas();
+  Eigen::VectorXd f = Eigen::VectorXd::Ones(atlas->getNumDofs());
+
+  for (auto _ : state)
+  {
+    atlas->finiteDifferenceJacobianOfC(WithRespectTo::POSITION);
+    atlas->finiteDifferenceVelCJacobian();
+    atlas->finiteDifferenceJacobianOfMinv(f, WithRespectTo::POSITION);
+  }
+};
+// Register the function as a benchmark
+BENCHMARK(BM_Atlas_Skeleton_Jacobians_Finite_Difference);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/constraint/BoxedLcpConstraintSolver.hpp"
+#include "dart/constraint/ConstrainedGroup.hpp"
+#include "dart/constraint/DantzigBoxedLcpSolver.hpp"
+#include "dart/constraint/PgsBoxedLcpSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/simulation/World.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace constraint;
+
+// We count heap allocations by interposing on malloc(), which catches both
+// Eigen's allocations and (through the default operator new) the standard
+// library's. We only count while gCountAllocations is set, which is only
+// inside BoxedLcpConstraintSolver::solveConstrainedGroup(), so collision
+// detection and the benchmark harness itself don't show up.
+static std::atomic<bool> gCountAllocations(false);
+static std::atomic<long> gNumAllocations(0);
+
+#ifdef __GLIBC__
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t num, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t num, std::size_t size) noexcept
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+/// This is a BoxedLcpConstraintSolver that counts the heap allocations made
+/// while assembling and solving each constrained group's LCP
+class AllocationCountingSolver : public BoxedLcpConstraintSolver
+{
+public:
+  AllocationCountingSolver(
+      BoxedLcpSolverPtr boxedLcpSolver,
+      BoxedLcpSolverPtr secondaryBoxedLcpSolver)
+    : BoxedLcpConstraintSolver(
+        std::move(boxedLcpSolver), std::move(secondaryBoxedLcpSolver)),
+      mNumSolves(0)
+  {
+  }
+
+  long mNumSolves;
+
+protected:
+  void solveConstrainedGroup(
+      ConstrainedGroup& group, simulation::World* world) override
+  {
+    gCountAllocations = true;
+    BoxedLcpConstraintSolver::solveConstrainedGroup(group, world);
+    gCountAllocations = false;
+    mNumSolves++;
+  }
+};
+
+/// This creates a box resting on the ground, so every timestep solves an LCP
+/// of the same size
+WorldPtr createBoxOnGround()
+{
+  WorldPtr world = World::create();
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<FreeJoint*, BodyNode*> boxPair
+      = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3d(1.0, 1.0, 1.0)));
+  boxPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      boxShape);
+  boxPair.second->setFrictionCoeff(0.5);
+  Eigen::Isometry3d boxPosition = Eigen::Isometry3d::Identity();
+  boxPosition.translation() = Eigen::Vector3d(0, 0, 0.499);
+  boxPair.first->setTransformFromParentBodyNode(boxPosition);
+  world->addSkeleton(box);
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3d(10.0, 10.0, 1.0)));
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  floorPair.second->setFrictionCoeff(0.5);
+  Eigen::Isometry3d floorPosition = Eigen::Isometry3d::Identity();
+  floorPosition.translation() = Eigen::Vector3d(0, 0, -0.5);
+  floorPair.first->setTransformFromParentBodyNode(floorPosition);
+  world->addSkeleton(floor);
+
+  return world;
+}
+
+/// This steps a box resting on the ground, and reports the heap allocations
+/// made by the LCP solve for each constrained group, once it's reached a
+/// steady state.
+void benchmarkBoxOnGround(
+    benchmark::State& state,
+    BoxedLcpSolverPtr boxedLcpSolver,
+    BoxedLcpSolverPtr secondaryBoxedLcpSolver)
+{
+  WorldPtr world = createBoxOnGround();
+  std::unique_ptr<AllocationCountingSolver> ownedSolver
+      = std::make_unique<AllocationCountingSolver>(
+          boxedLcpSolver, secondaryBoxedLcpSolver);
+  AllocationCountingSolver* solver = ownedSolver.get();
+  world->setConstraintSolver(std::move(ownedSolver));
+
+  // Let the box settle, and let the workspace grow to fit
+  for (int i = 0; i < 50; i++)
+    world->step();
+
+  gNumAllocations = 0;
+  solver->mNumSolves = 0;
+  std::size_t arenaAllocations
+      = solver->getWorkspace().getNumArenaAllocations();
+
+  for (auto _ : state)
+    world->step();
+
+  state.counters["allocs_per_solve"] = solver->mNumSolves == 0
+                                           ? 0.0
+                                           : static_cast<double>(
+                                               gNumAllocations.load())
+                                                 / solver->mNumSolves;
+  state.counters["arena_allocs"] = static_cast<double>(
+      solver->getWorkspace().getNumArenaAllocations() - arenaAllocations);
+}
+
+static void BM_BoxOnGround_PGS(benchmark::State& state)
+{
+  // PGS keeps its own scratch buffers, so this should report no allocations at
+  // all in the steady state
+  benchmarkBoxOnGround(state, std::make_shared<PgsBoxedLcpSolver>(), nullptr);
+}
+BENCHMARK(BM_BoxOnGround_PGS);
+
+static void BM_BoxOnGround_Dantzig_PGS(benchmark::State& state)
+{
+  // The Dantzig solver (from ODE) allocates its own scratch space on every
+  // call, so this reports only the allocations made inside dSolveLCP()
+  benchmarkBoxOnGround(
+      state,
+      std::make_shared<DantzigBoxedLcpSolver>(),
+      std::make_shared<PgsBoxedLcpSolver>());
+}
+BENCHMARK(BM_BoxOnGround_Dantzig_PGS);
+
+BENCHMARK_MAIN();
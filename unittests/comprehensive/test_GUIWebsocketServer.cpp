@@ -31,6 +31,7 @@
  */
 
 #include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -44,6 +45,7 @@
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
+#include "dart/server/RawBinaryUtils.hpp"
 
 #include "TestHelpers.hpp"
 #include "stdio.h"
@@ -222,3 +224,163 @@ TEST(REALTIME, GUI_SERVER)
   }
 }
 #endif
+
+/// This exposes the batching internals, so we can check what would go out on
+/// the wire without having to connect a client
+class TestGUIWebsocketServer : public GUIWebsocketServer
+{
+public:
+  using GUIWebsocketServer::encodePendingUpdatesBinary;
+  using GUIWebsocketServer::encodePendingUpdatesJson;
+  using GUIWebsocketServer::shouldSendBinary;
+
+  std::size_t getNumPendingUpdates()
+  {
+    return mPendingUpdates.size();
+  }
+
+  const ObjectTransformUpdate& getPendingUpdate(std::size_t i)
+  {
+    return mPendingUpdates[i].update;
+  }
+
+  std::string getQueuedJson()
+  {
+    return mJson.str();
+  }
+
+  std::size_t getNumBinaryIds()
+  {
+    return mBinaryIds.size();
+  }
+};
+
+int countOccurrences(const std::string& haystack, const std::string& needle)
+{
+  int count = 0;
+  for (std::size_t i = haystack.find(needle); i != std::string::npos;
+       i = haystack.find(needle, i + needle.size()))
+  {
+    count++;
+  }
+  return count;
+}
+
+std::uint32_t readUint32(const std::string& frame, std::size_t offset)
+{
+  std::uint32_t value;
+  std::memcpy(&value, frame.data() + offset, sizeof(value));
+  return value;
+}
+
+TEST(GUI_WEBSOCKET_SERVER, COALESCES_TRANSFORM_UPDATES)
+{
+  TestGUIWebsocketServer server;
+  server.setAutoflush(false);
+  server.createBox(
+      "box",
+      Eigen::Vector3d::Ones(),
+      Eigen::Vector3d::Zero(),
+      Eigen::Vector3d::Zero());
+  server.flush();
+
+  server.setObjectPosition("box", Eigen::Vector3d(1, 2, 3));
+  server.setObjectPosition("box", Eigen::Vector3d(4, 5, 6));
+  server.setObjectColor("box", Eigen::Vector3d(0.1, 0.2, 0.3));
+
+  // Both moves land on a single entry, and only the last one survives
+  EXPECT_EQ(1u, server.getNumPendingUpdates());
+  const ObjectTransformUpdate& update = server.getPendingUpdate(0);
+  EXPECT_EQ(TRANSFORM_POS | TRANSFORM_COLOR, update.fields);
+  EXPECT_TRUE(update.pos.isApprox(Eigen::Vector3d(4, 5, 6)));
+
+  // Nobody is connected, so this has to go out as JSON
+  server.setBinaryProtocolEnabled(true);
+  EXPECT_FALSE(server.shouldSendBinary());
+
+  server.encodePendingUpdatesJson();
+  std::string json = server.getQueuedJson();
+  EXPECT_EQ(1, countOccurrences(json, "\"set_object_pos\""));
+  EXPECT_EQ(1, countOccurrences(json, "\"set_object_color\""));
+  EXPECT_EQ(0, countOccurrences(json, "\"set_object_rotation\""));
+  EXPECT_EQ(0, countOccurrences(json, "\"set_binary_id\""));
+
+  // Flushing clears the batch
+  server.flush();
+  EXPECT_EQ(0u, server.getNumPendingUpdates());
+
+  // Deleting an object throws away anything queued for it
+  server.setObjectPosition("box", Eigen::Vector3d(7, 8, 9));
+  server.deleteObject("box");
+  server.encodePendingUpdatesJson();
+  EXPECT_EQ(0, countOccurrences(server.getQueuedJson(), "set_object_pos"));
+}
+
+TEST(GUI_WEBSOCKET_SERVER, BINARY_IDS_ARE_ANNOUNCED_ONCE)
+{
+  TestGUIWebsocketServer server;
+  server.setAutoflush(false);
+  server.createBox(
+      "box",
+      Eigen::Vector3d::Ones(),
+      Eigen::Vector3d::Zero(),
+      Eigen::Vector3d::Zero());
+  server.createBox(
+      "box2",
+      Eigen::Vector3d::Ones(),
+      Eigen::Vector3d::Zero(),
+      Eigen::Vector3d::Zero());
+  server.flush();
+
+  server.setObjectPosition("box", Eigen::Vector3d(1, 2, 3));
+  server.setObjectPosition("box2", Eigen::Vector3d(4, 5, 6));
+  std::string frame = server.encodePendingUpdatesBinary();
+  ASSERT_EQ(
+      BINARY_TRANSFORMS_HEADER_SIZE + 2 * BINARY_TRANSFORM_RECORD_SIZE,
+      frame.size());
+  EXPECT_EQ(BINARY_SET_OBJECT_TRANSFORMS, readUint32(frame, 0));
+  EXPECT_EQ(2u, readUint32(frame, 4));
+  std::uint32_t boxId = readUint32(frame, BINARY_TRANSFORMS_HEADER_SIZE);
+  std::uint32_t box2Id = readUint32(
+      frame, BINARY_TRANSFORMS_HEADER_SIZE + BINARY_TRANSFORM_RECORD_SIZE);
+  EXPECT_NE(boxId, box2Id);
+  EXPECT_EQ(
+      2, countOccurrences(server.getQueuedJson(), "\"set_binary_id\""));
+  server.flush();
+
+  // The second time around the ids are already known, so no JSON is needed
+  server.setObjectPosition("box2", Eigen::Vector3d(7, 8, 9));
+  frame = server.encodePendingUpdatesBinary();
+  ASSERT_EQ(
+      BINARY_TRANSFORMS_HEADER_SIZE + BINARY_TRANSFORM_RECORD_SIZE,
+      frame.size());
+  EXPECT_EQ(box2Id, readUint32(frame, BINARY_TRANSFORMS_HEADER_SIZE));
+  EXPECT_EQ(0, countOccurrences(server.getQueuedJson(), "set_binary_id"));
+  server.flush();
+
+  // Deleting an object forgets its id, so new connections don't replay it
+  EXPECT_EQ(2u, server.getNumBinaryIds());
+  server.deleteObject("box");
+  EXPECT_EQ(1u, server.getNumBinaryIds());
+
+  // Recreating it gets a fresh id, rather than reusing the old one
+  server.createBox(
+      "box",
+      Eigen::Vector3d::Ones(),
+      Eigen::Vector3d::Zero(),
+      Eigen::Vector3d::Zero());
+  server.flush();
+  server.setObjectPosition("box", Eigen::Vector3d(1, 2, 3));
+  frame = server.encodePendingUpdatesBinary();
+  ASSERT_EQ(
+      BINARY_TRANSFORMS_HEADER_SIZE + BINARY_TRANSFORM_RECORD_SIZE,
+      frame.size());
+  std::uint32_t newBoxId = readUint32(frame, BINARY_TRANSFORMS_HEADER_SIZE);
+  EXPECT_NE(boxId, newBoxId);
+  EXPECT_NE(box2Id, newBoxId);
+  server.flush();
+
+  // Clearing the GUI forgets every id
+  server.clear();
+  EXPECT_EQ(0u, server.getNumBinaryIds());
+}
@@ -39,11 +39,13 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/BatchedWorld.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/IKMapping.hpp"
@@ -161,6 +163,436 @@ bool checkOutOfOrderBackprop(WorldPtr world)
   return true;
 }
 
+bool checkBatchedForwardPass(WorldPtr world)
+{
+  const int BATCH_SIZE = 8;
+  const int dofs = world->getNumDofs();
+
+  BatchedWorld batch(world, BATCH_SIZE, 4);
+
+  Eigen::MatrixXd positions = Eigen::MatrixXd::Zero(dofs, BATCH_SIZE);
+  Eigen::MatrixXd velocities = Eigen::MatrixXd::Zero(dofs, BATCH_SIZE);
+  Eigen::MatrixXd torques = Eigen::MatrixXd::Zero(dofs, BATCH_SIZE);
+  for (int i = 0; i < BATCH_SIZE; i++)
+  {
+    positions.col(i) = world->getPositions();
+    velocities.col(i) = world->getVelocities() * (1.0 + 0.1 * i);
+    torques.col(i) = Eigen::VectorXd::Ones(dofs) * 0.05 * i;
+  }
+
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots
+      = batch.forwardPass(positions, velocities, torques);
+
+  std::vector<LossGradient> nextLosses(BATCH_SIZE);
+  for (int i = 0; i < BATCH_SIZE; i++)
+  {
+    nextLosses[i].lossWrtPosition = Eigen::VectorXd::Ones(dofs);
+    nextLosses[i].lossWrtVelocity = Eigen::VectorXd::Ones(dofs) * i;
+    nextLosses[i].lossWrtTorque = Eigen::VectorXd::Zero(dofs);
+  }
+  std::vector<LossGradient> losses = batch.backprop(snapshots, nextLosses);
+
+  ///////////////////////////////////////////////
+  // Test that everything EXACTLY matches a serial step
+  ///////////////////////////////////////////////
+
+  for (int i = 0; i < BATCH_SIZE; i++)
+  {
+    WorldPtr serialWorld = world->clone();
+    serialWorld->setPositions(positions.col(i));
+    serialWorld->setVelocities(velocities.col(i));
+    serialWorld->setExternalForces(torques.col(i));
+    std::shared_ptr<BackpropSnapshot> serialSnapshot
+        = neural::forwardPass(serialWorld);
+    LossGradient serialLoss;
+    serialSnapshot->backprop(serialWorld, serialLoss, nextLosses[i]);
+
+    Eigen::VectorXd batchPos = batch.getPositions().col(i);
+    Eigen::VectorXd batchVel = batch.getVelocities().col(i);
+    Eigen::VectorXd serialPos = serialWorld->getPositions();
+    Eigen::VectorXd serialVel = serialWorld->getVelocities();
+    if (!equals(batchPos, serialPos, 0.0) || !equals(batchVel, serialVel, 0.0))
+    {
+      std::cout << "Batched forward pass off at batch index " << i
+                << std::endl;
+      return false;
+    }
+    if (!equals(losses[i].lossWrtPosition, serialLoss.lossWrtPosition, 0.0)
+        || !equals(losses[i].lossWrtVelocity, serialLoss.lossWrtVelocity, 0.0)
+        || !equals(losses[i].lossWrtTorque, serialLoss.lossWrtTorque, 0.0))
+    {
+      std::cout << "Batched backprop off at batch index " << i << std::endl;
+      return false;
+    }
+  }
+
+  ///////////////////////////////////////////////
+  // Test that the matrix versions match too. This uses a fresh batch, since
+  // stepping clears the external forces on the bodies.
+  ///////////////////////////////////////////////
+
+  BatchedWorld matrixBatch(world, BATCH_SIZE, 4);
+
+  Eigen::MatrixXd lossWrtNextPosition = Eigen::MatrixXd::Zero(dofs, BATCH_SIZE);
+  Eigen::MatrixXd lossWrtNextVelocity = Eigen::MatrixXd::Zero(dofs, BATCH_SIZE);
+  for (int i = 0; i < BATCH_SIZE; i++)
+  {
+    lossWrtNextPosition.col(i) = nextLosses[i].lossWrtPosition;
+    lossWrtNextVelocity.col(i) = nextLosses[i].lossWrtVelocity;
+  }
+  BatchedStep step = matrixBatch.step(positions, velocities, torques);
+  BatchedLossGradient batchedLoss = matrixBatch.backpropStep(
+      step, lossWrtNextPosition, lossWrtNextVelocity);
+  for (int i = 0; i < BATCH_SIZE; i++)
+  {
+    if (!equals(
+            Eigen::VectorXd(step.nextPositions.col(i)),
+            snapshots[i]->getPostStepPosition(),
+            0.0)
+        || !equals(
+            Eigen::VectorXd(step.nextVelocities.col(i)),
+            snapshots[i]->getPostStepVelocity(),
+            0.0))
+    {
+      std::cout << "Batched step off at batch index " << i << std::endl;
+      return false;
+    }
+    if (!equals(
+            Eigen::VectorXd(batchedLoss.lossWrtPosition.col(i)),
+            losses[i].lossWrtPosition,
+            0.0)
+        || !equals(
+            Eigen::VectorXd(batchedLoss.lossWrtVelocity.col(i)),
+            losses[i].lossWrtVelocity,
+            0.0)
+        || !equals(
+            Eigen::VectorXd(batchedLoss.lossWrtTorque.col(i)),
+            losses[i].lossWrtTorque,
+            0.0))
+    {
+      std::cout << "Batched backpropStep off at batch index " << i
+                << std::endl;
+      return false;
+    }
+  }
+
+  ///////////////////////////////////////////////
+  // Test that step() reads inputs in place from a block of a bigger matrix,
+  // like it does from a column-major NumPy view
+  ///////////////////////////////////////////////
+
+  BatchedWorld blockBatch(world, BATCH_SIZE, 4);
+  Eigen::MatrixXd allInputs(dofs, 3 * BATCH_SIZE);
+  allInputs << positions, velocities, torques;
+  BatchedStep blockStep = blockBatch.step(
+      allInputs.leftCols(BATCH_SIZE),
+      allInputs.middleCols(BATCH_SIZE, BATCH_SIZE),
+      allInputs.rightCols(BATCH_SIZE));
+  if (!equals(blockStep.nextPositions, step.nextPositions, 0.0)
+      || !equals(blockStep.nextVelocities, step.nextVelocities, 0.0))
+  {
+    std::cout << "Batched step from matrix blocks doesn't match" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool checkMultiShotThreadPool(WorldPtr world, LossFn loss)
+{
+  MultiShot serial(world, loss, 100, 10, false);
+  MultiShot parallel(world, loss, 100, 10, false);
+  parallel.setParallelOperationsEnabled(true);
+  // Use fewer threads than shots, so several shots share each worker
+  parallel.setNumThreads(3);
+  if (parallel.getNumThreads() != 3)
+  {
+    std::cout << "Expected 3 worker threads, got "
+              << parallel.getNumThreads() << std::endl;
+    return false;
+  }
+
+  int staticDim = serial.getFlatStaticProblemDim(world);
+  int dynamicDim = serial.getFlatDynamicProblemDim(world);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Zero(dynamicDim);
+  serial.getInitialGuess(world, flatStatic, flatDynamic);
+  srand(42);
+  flatDynamic += Eigen::VectorXd::Random(dynamicDim) * 0.01;
+  serial.unflatten(world, flatStatic, flatDynamic);
+  parallel.unflatten(world, flatStatic, flatDynamic);
+
+  ///////////////////////////////////////////////
+  // Test that everything EXACTLY matches the serial MultiShot
+  ///////////////////////////////////////////////
+
+  int constraintDim = serial.getConstraintDim();
+  Eigen::VectorXd constraints1 = Eigen::VectorXd::Zero(constraintDim);
+  Eigen::VectorXd constraints2 = Eigen::VectorXd::Zero(constraintDim);
+  serial.computeConstraints(world, constraints1);
+  parallel.computeConstraints(world, constraints2);
+  if (!equals(constraints1, constraints2, 0.0))
+  {
+    std::cout << "Off on computeConstraints()" << std::endl;
+    return false;
+  }
+
+  Eigen::MatrixXd jacStatic1 = Eigen::MatrixXd::Zero(constraintDim, staticDim);
+  Eigen::MatrixXd jacDynamic1
+      = Eigen::MatrixXd::Zero(constraintDim, dynamicDim);
+  Eigen::MatrixXd jacStatic2 = Eigen::MatrixXd::Zero(constraintDim, staticDim);
+  Eigen::MatrixXd jacDynamic2
+      = Eigen::MatrixXd::Zero(constraintDim, dynamicDim);
+  serial.backpropJacobian(world, jacStatic1, jacDynamic1);
+  parallel.backpropJacobian(world, jacStatic2, jacDynamic2);
+  if (!equals(jacStatic1, jacStatic2, 0.0)
+      || !equals(jacDynamic1, jacDynamic2, 0.0))
+  {
+    std::cout << "Off on backpropJacobian()" << std::endl;
+    return false;
+  }
+
+  int nnzStatic = serial.getNumberNonZeroJacobianStatic(world);
+  int nnzDynamic = serial.getNumberNonZeroJacobianDynamic(world);
+  Eigen::VectorXd sparseStatic1 = Eigen::VectorXd::Zero(nnzStatic);
+  Eigen::VectorXd sparseDynamic1 = Eigen::VectorXd::Zero(nnzDynamic);
+  Eigen::VectorXd sparseStatic2 = Eigen::VectorXd::Zero(nnzStatic);
+  Eigen::VectorXd sparseDynamic2 = Eigen::VectorXd::Zero(nnzDynamic);
+  serial.getSparseJacobian(world, sparseStatic1, sparseDynamic1);
+  parallel.getSparseJacobian(world, sparseStatic2, sparseDynamic2);
+  if (!equals(sparseStatic1, sparseStatic2, 0.0)
+      || !equals(sparseDynamic1, sparseDynamic2, 0.0))
+  {
+    std::cout << "Off on getSparseJacobian()" << std::endl;
+    return false;
+  }
+
+  TrajectoryRolloutReal rollout1 = TrajectoryRolloutReal(&serial);
+  TrajectoryRolloutReal rollout2 = TrajectoryRolloutReal(&parallel);
+  serial.getStates(world, &rollout1);
+  parallel.getStates(world, &rollout2);
+  if (!equals(rollout1.getPoses(), rollout2.getPoses(), 0.0)
+      || !equals(rollout1.getVels(), rollout2.getVels(), 0.0)
+      || !equals(rollout1.getForces(), rollout2.getForces(), 0.0))
+  {
+    std::cout << "Off on getStates()" << std::endl;
+    return false;
+  }
+
+  TrajectoryRolloutReal gradWrtRollout = TrajectoryRolloutReal(&serial);
+  gradWrtRollout.getPoses().setOnes();
+  gradWrtRollout.getVels().setOnes();
+  gradWrtRollout.getForces().setOnes();
+  Eigen::VectorXd gradStatic1 = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd gradDynamic1 = Eigen::VectorXd::Zero(dynamicDim);
+  Eigen::VectorXd gradStatic2 = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd gradDynamic2 = Eigen::VectorXd::Zero(dynamicDim);
+  serial.backpropGradientWrt(world, &gradWrtRollout, gradStatic1, gradDynamic1);
+  parallel.backpropGradientWrt(
+      world, &gradWrtRollout, gradStatic2, gradDynamic2);
+  if (!equals(gradStatic1, gradStatic2, 0.0)
+      || !equals(gradDynamic1, gradDynamic2, 0.0))
+  {
+    std::cout << "Off on backpropGradientWrt()" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool checkGradientThreadPool(WorldPtr world)
+{
+  WorldPtr serialWorld = world->clone();
+  WorldPtr parallelWorld = world->clone();
+  parallelWorld->setGradientThreadPool(
+      std::make_shared<common::ThreadPool>(3));
+
+  std::shared_ptr<BackpropSnapshot> serialSnapshot
+      = neural::forwardPass(serialWorld);
+  std::shared_ptr<BackpropSnapshot> parallelSnapshot
+      = neural::forwardPass(parallelWorld);
+
+  ///////////////////////////////////////////////
+  // Test that everything EXACTLY matches the serial Jacobians
+  ///////////////////////////////////////////////
+
+  if (!equals(
+          serialSnapshot->getPosPosJacobian(serialWorld),
+          parallelSnapshot->getPosPosJacobian(parallelWorld),
+          0.0)
+      || !equals(
+          serialSnapshot->getVelPosJacobian(serialWorld),
+          parallelSnapshot->getVelPosJacobian(parallelWorld),
+          0.0)
+      || !equals(
+          serialSnapshot->getPosVelJacobian(serialWorld),
+          parallelSnapshot->getPosVelJacobian(parallelWorld),
+          0.0)
+      || !equals(
+          serialSnapshot->getVelVelJacobian(serialWorld),
+          parallelSnapshot->getVelVelJacobian(parallelWorld),
+          0.0)
+      || !equals(
+          serialSnapshot->getForceVelJacobian(serialWorld),
+          parallelSnapshot->getForceVelJacobian(parallelWorld),
+          0.0))
+  {
+    std::cout << "Parallel Jacobians don't match the serial ones" << std::endl;
+    return false;
+  }
+
+  ///////////////////////////////////////////////
+  // Test that differencing one skeleton at a time matches differencing the
+  // whole world at once
+  ///////////////////////////////////////////////
+
+  int dofs = parallelWorld->getNumDofs();
+  Eigen::VectorXd tau = Eigen::VectorXd::Ones(dofs);
+  Eigen::MatrixXd perSkeleton
+      = parallelSnapshot->finiteDifferenceJacobianOfMinv(
+          parallelWorld, tau, WithRespectTo::POSITION);
+
+  const double EPS = 5e-7;
+  Eigen::VectorXd before = parallelWorld->getPositions();
+  Eigen::MatrixXd wholeWorld = Eigen::MatrixXd::Zero(dofs, dofs);
+  for (int i = 0; i < dofs; i++)
+  {
+    Eigen::VectorXd perturbed = before;
+    perturbed(i) += EPS;
+    parallelWorld->setPositions(perturbed);
+    Eigen::VectorXd plus = parallelWorld->getInvMassMatrix() * tau;
+    perturbed(i) = before(i) - EPS;
+    parallelWorld->setPositions(perturbed);
+    Eigen::VectorXd minus = parallelWorld->getInvMassMatrix() * tau;
+    wholeWorld.col(i) = (plus - minus) / (2 * EPS);
+  }
+  parallelWorld->setPositions(before);
+
+  if (!equals(perSkeleton, wholeWorld, 1e-7))
+  {
+    std::cout << "Per-skeleton Minv Jacobian doesn't match the whole world:"
+              << std::endl
+              << "Per-skeleton:" << std::endl
+              << perSkeleton << std::endl
+              << "Whole world:" << std::endl
+              << wholeWorld << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool checkAnalyticalJacobiansOfMinvAndC(WorldPtr world)
+{
+  world->setGradientThreadPool(std::make_shared<common::ThreadPool>(3));
+  std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(world);
+
+  // Stepping clears the external forces, so push the poles again. Each pole
+  // hangs off a cart, so the generalized external forces on the carts move
+  // with the pole angles.
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    world->getSkeleton(i)->getBodyNode(1)->addExtForce(
+        Eigen::Vector3d(1, -1, 0), Eigen::Vector3d(0.1, 0.2, 0.3));
+  }
+
+  Eigen::VectorXd tau = Eigen::VectorXd::Ones(world->getNumDofs());
+  std::vector<std::pair<std::string, WithRespectTo*>> wrts;
+  wrts.emplace_back("position", WithRespectTo::POSITION);
+  wrts.emplace_back("velocity", WithRespectTo::VELOCITY);
+  wrts.emplace_back("force", WithRespectTo::FORCE);
+  for (auto& pair : wrts)
+  {
+    WithRespectTo* wrt = pair.second;
+    Eigen::MatrixXd analyticalMinv
+        = snapshot->getJacobianOfMinv(world, tau, wrt);
+    Eigen::MatrixXd bruteForceMinv
+        = snapshot->finiteDifferenceJacobianOfMinv(world, tau, wrt);
+    Eigen::MatrixXd analyticalC = snapshot->getJacobianOfC(world, wrt);
+    Eigen::MatrixXd bruteForceC
+        = snapshot->finiteDifferenceJacobianOfC(world, wrt);
+    Eigen::MatrixXd analyticalMinvC = snapshot->getJacobianOfMinvC(world, wrt);
+    Eigen::MatrixXd bruteForceMinvC
+        = snapshot->finiteDifferenceJacobianOfMinvC(world, wrt);
+    if (!equals(analyticalMinv, bruteForceMinv, 1e-6)
+        || !equals(analyticalC, bruteForceC, 1e-6)
+        || !equals(analyticalMinvC, bruteForceMinvC, 1e-6))
+    {
+      std::cout << "Analytical Jacobians of Minv, C and Minv*C don't match "
+                << "finite differencing wrt " << pair.first << ":"
+                << std::endl
+                << "Minv analytical:" << std::endl
+                << analyticalMinv << std::endl
+                << "Minv brute force:" << std::endl
+                << bruteForceMinv << std::endl
+                << "C analytical:" << std::endl
+                << analyticalC << std::endl
+                << "C brute force:" << std::endl
+                << bruteForceC << std::endl
+                << "Minv*C analytical:" << std::endl
+                << analyticalMinvC << std::endl
+                << "Minv*C brute force:" << std::endl
+                << bruteForceMinvC << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool checkPerGroupVelJacobians(WorldPtr world)
+{
+  WorldPtr serialWorld = world->clone();
+  WorldPtr parallelWorld = world->clone();
+  parallelWorld->setGradientThreadPool(
+      std::make_shared<common::ThreadPool>(3));
+
+  // Leave the worlds in their pre-step state, which finite differencing
+  // starts from
+  std::shared_ptr<BackpropSnapshot> serialSnapshot
+      = neural::forwardPass(serialWorld, true);
+  std::shared_ptr<BackpropSnapshot> parallelSnapshot
+      = neural::forwardPass(parallelWorld, true);
+
+  std::vector<std::pair<std::string, WithRespectTo*>> wrts;
+  wrts.emplace_back("position", WithRespectTo::POSITION);
+  wrts.emplace_back("velocity", WithRespectTo::VELOCITY);
+  wrts.emplace_back("force", WithRespectTo::FORCE);
+  for (auto& pair : wrts)
+  {
+    WithRespectTo* wrt = pair.second;
+    Eigen::MatrixXd serial
+        = serialSnapshot->getVelJacobianWrt(serialWorld, wrt);
+    Eigen::MatrixXd parallel
+        = parallelSnapshot->getVelJacobianWrt(parallelWorld, wrt);
+
+    // The blocks are computed independently, so the order they finish in
+    // can't change the assembled result
+    if (!equals(serial, parallel, 0.0))
+    {
+      std::cout << "Parallel per-group Jacobian wrt " << pair.first
+                << " doesn't match the serial one" << std::endl;
+      return false;
+    }
+
+    Eigen::MatrixXd bruteForce
+        = parallelSnapshot->finiteDifferenceVelJacobianWrt(parallelWorld, wrt);
+    if (!equals(parallel, bruteForce, 5e-7))
+    {
+      std::cout << "Per-group Jacobian wrt " << pair.first
+                << " doesn't match finite differencing:" << std::endl
+                << "Assembled:" << std::endl
+                << parallel << std::endl
+                << "Brute force:" << std::endl
+                << bruteForce << std::endl
+                << "Diff:" << std::endl
+                << parallel - bruteForce << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 TEST(WEB, SIMPLE_BOX)
 {
   // World
@@ -202,6 +634,7 @@ TEST(WEB, SIMPLE_BOX)
   ///////////////////////////////////////////////////
 
   EXPECT_TRUE(checkOutOfOrderBackprop(world));
+  EXPECT_TRUE(checkBatchedForwardPass(world));
 }
 
 BodyNode* createTailSegment(BodyNode* parent, Eigen::Vector3d color)
@@ -375,6 +808,8 @@ TEST(TRAJECTORY, JUMP_WORM)
   EXPECT_TRUE(checkOutOfOrderBackprop(world));
 
   LossFn lossFn(loss);
+  EXPECT_TRUE(checkMultiShotThreadPool(world, lossFn));
+
   MultiShot shot(world, lossFn, 200, 20, false);
   shot.setParallelOperationsEnabled(false);
   std::shared_ptr<IKMapping> ikMap = std::make_shared<IKMapping>(world);
@@ -776,4 +1211,121 @@ TEST(TRAJECTORY, JUMP_WORM)
       std::cout << "Off on force-vel Jac at step " << i << std::endl;
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(GRADIENTS, SEPARATE_PILES)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setPenetrationCorrectionEnabled(false);
+
+  ///////////////////////////////////////////////
+  // Create some boxes sitting on the floor, far enough apart that they each
+  // end up in their own constrained group
+  ///////////////////////////////////////////////
+
+  for (int i = 0; i < 4; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    std::shared_ptr<BoxShape> boxShape(
+        new BoxShape(Eigen::Vector3d(1.0, 1.0, 1.0)));
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+    pair.second->setFrictionCoeff(0.5);
+    pair.second->setMass(1.0 + i);
+    world->addSkeleton(box);
+
+    Eigen::Vector6d pos = Eigen::Vector6d::Zero();
+    pos(1) = 0.1 * i;
+    pos(3) = 3.0 * i;
+    pos(5) = 0.499;
+    box->setPositions(pos);
+    Eigen::Vector6d vel = Eigen::Vector6d::Zero();
+    vel(3) = 0.1 * i;
+    box->setVelocities(vel);
+  }
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3d(20.0, 10.0, 1.0)));
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  floorPair.second->setFrictionCoeff(0.5);
+  Eigen::Isometry3d floorPosition = Eigen::Isometry3d::Identity();
+  floorPosition.translation() = Eigen::Vector3d(5.0, 0, -0.5);
+  floorPair.first->setTransformFromParentBodyNode(floorPosition);
+  world->addSkeleton(floor);
+
+  EXPECT_TRUE(checkGradientThreadPool(world));
+}
+
+TEST(GRADIENTS, ANALYTICAL_MINV_AND_C)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+  for (int i = 0; i < 2; i++)
+  {
+    SkeletonPtr cartpole = createCartpole();
+    cartpole->setName("cartpole_" + std::to_string(i));
+    cartpole->setPosition(0, 0.1 * i);
+    cartpole->setPosition(1, 0.3 + 0.2 * i);
+    cartpole->setVelocity(1, 0.5);
+    world->addSkeleton(cartpole);
+  }
+
+  EXPECT_TRUE(checkAnalyticalJacobiansOfMinvAndC(world));
+}
+
+TEST(GRADIENTS, PER_GROUP_JACOBIANS)
+{
+  WorldPtr world = World::create();
+  world->setPenetrationCorrectionEnabled(false);
+
+  ///////////////////////////////////////////////
+  // Two boxes resting on the floor far apart, so each is its own constrained
+  // group, and a third box in the air that isn't in any group
+  ///////////////////////////////////////////////
+
+  for (int i = 0; i < 3; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    std::shared_ptr<BoxShape> boxShape(
+        new BoxShape(Eigen::Vector3d(1.0, 1.0, 1.0)));
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+    pair.second->setFrictionCoeff(0.5);
+    pair.second->setMass(1.0 + i);
+    world->addSkeleton(box);
+
+    Eigen::Vector6d pos = Eigen::Vector6d::Zero();
+    // Tilt every box a little, since a face resting exactly flat on the
+    // floor makes the contact points jump under finite differencing
+    pos(1) = 0.1 * (i + 1);
+    pos(3) = 3.0 * i;
+    pos(5) = i == 2 ? 5.0 : 0.499;
+    box->setPositions(pos);
+    Eigen::Vector6d vel = Eigen::Vector6d::Zero();
+    vel(0) = 0.05 * i;
+    vel(3) = 0.1 * (i + 1);
+    box->setVelocities(vel);
+  }
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3d(20.0, 10.0, 1.0)));
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  floorPair.second->setFrictionCoeff(0.5);
+  Eigen::Isometry3d floorPosition = Eigen::Isometry3d::Identity();
+  floorPosition.translation() = Eigen::Vector3d(5.0, 0, -0.5);
+  floorPair.first->setTransformFromParentBodyNode(floorPosition);
+  world->addSkeleton(floor);
+
+  EXPECT_TRUE(checkPerGroupVelJacobians(world));
+}
@@ -31,6 +31,7 @@
  */
 
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -42,6 +43,7 @@
 #include "dart/realtime/MPC.hpp"
 #include "dart/realtime/MPCLocal.hpp"
 #include "dart/realtime/MPCRemote.hpp"
+#include "dart/realtime/Millis.hpp"
 #include "dart/realtime/SSID.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -49,6 +51,7 @@
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/LossFn.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/SingleShot.hpp"
 
 #include "TestHelpers.hpp"
 #include "stdio.h"
@@ -521,3 +524,430 @@ TEST(REALTIME, CARTPOLE_SSID)
             << armPair.second->getMass() << std::endl;
 }
 #endif
+
+/// This creates a cartpole running at 100 fps, with the pole tipped 15 degrees
+/// off vertical. Only the cart is actuated.
+WorldPtr createCartpoleWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  std::shared_ptr<BoxShape> sledShapeBox(
+      new BoxShape(Eigen::Vector3d(0.5, 0.1, 0.1)));
+  ShapeNode* sledShape
+      = sledPair.second->createShapeNodeWith<VisualAspect>(sledShapeBox);
+  sledShape->getVisualAspect()->setColor(Eigen::Vector3d(0.5, 0.5, 0.5));
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  std::shared_ptr<BoxShape> armShapeBox(
+      new BoxShape(Eigen::Vector3d(0.1, 1.0, 0.1)));
+  ShapeNode* armShape
+      = armPair.second->createShapeNodeWith<VisualAspect>(armShapeBox);
+  armShape->getVisualAspect()->setColor(Eigen::Vector3d(0.7, 0.7, 0.7));
+
+  Eigen::Isometry3d armOffset = Eigen::Isometry3d::Identity();
+  armOffset.translation() = Eigen::Vector3d(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+
+  world->addSkeleton(cartpole);
+
+  cartpole->setForceUpperLimit(0, 15);
+  cartpole->setForceLowerLimit(0, -15);
+  cartpole->setVelocityUpperLimit(0, 1000);
+  cartpole->setVelocityLowerLimit(0, -1000);
+  cartpole->setPositionUpperLimit(0, 10);
+  cartpole->setPositionLowerLimit(0, -10);
+
+  cartpole->setForceUpperLimit(1, 0);
+  cartpole->setForceLowerLimit(1, 0);
+  cartpole->setVelocityUpperLimit(1, 1000);
+  cartpole->setVelocityLowerLimit(1, -1000);
+  cartpole->setPositionUpperLimit(1, 10);
+  cartpole->setPositionLowerLimit(1, -10);
+
+  cartpole->setPosition(0, 0);
+  cartpole->setPosition(1, 15.0 / 180.0 * 3.1415);
+  cartpole->computeForwardDynamics();
+  cartpole->integrateVelocities(world->getTimeStep());
+
+  // 100 fps
+  world->setTimeStep(1.0 / 100);
+
+  return world;
+}
+
+/// This creates the cartpole we run SSID on, with the mass of the arm tunable
+/// between 0.2 and 3.0. The arm is the cartpole's second body node.
+WorldPtr createSSIDCartpole()
+{
+  WorldPtr world = createCartpoleWorld();
+  world->tuneMass(
+      world->getSkeleton("cartpole")->getBodyNode(1),
+      WrtMassBodyNodeEntryType::INERTIA_MASS,
+      Eigen::VectorXd::Ones(1) * 3.0,
+      Eigen::VectorXd::Ones(1) * 0.2);
+  return world;
+}
+
+/// This exposes the window SSID last ran inference over, so we can check the
+/// sliding window against a cold read of the logs
+class TestSSID : public SSID
+{
+public:
+  using SSID::SSID;
+
+  long getWindowStart()
+  {
+    return mWindowStart;
+  }
+
+  const Eigen::MatrixXd& getForceHistory()
+  {
+    return mForceHistory;
+  }
+
+  const Eigen::MatrixXd& getSensorHistory()
+  {
+    return mSensorHistory;
+  }
+
+  /// This reads the current window from the logs from scratch
+  Eigen::MatrixXd getColdForceHistory()
+  {
+    return mControlLog.getValues(
+        mWindowStart, mForceHistory.cols(), getMillisPerStep());
+  }
+
+  /// This reads the current window from the logs from scratch
+  Eigen::MatrixXd getColdSensorHistory()
+  {
+    return mSensorLog.getValues(
+        mWindowStart, mSensorHistory.cols(), getMillisPerStep());
+  }
+
+  /// A warm start keeps the last Solution, and a cold solve replaces it
+  trajectory::Solution* getSolution()
+  {
+    return mSolution.get();
+  }
+
+  trajectory::Problem* getProblem()
+  {
+    return mProblem.get();
+  }
+
+protected:
+  int getMillisPerStep()
+  {
+    return mWorld->getTimeStep() * 1000;
+  }
+};
+
+/// This runs the cartpole for `steps` timesteps with the arm at its true mass
+/// of 2.0, recording the controls and sensors into `ssid`, and then resets the
+/// arm to a wrong guess of 1.0 for SSID to recover from
+void recordSSIDHistory(WorldPtr world, SSID& ssid, int steps)
+{
+  BodyNode* arm = world->getSkeleton("cartpole")->getBodyNode(1);
+  int millisPerTimestep = world->getTimeStep() * 1000;
+
+  arm->setMass(2.0);
+  for (int i = 0; i < steps; i++)
+  {
+    long time = i * millisPerTimestep;
+    Eigen::VectorXd forces = Eigen::VectorXd::Ones(world->getNumDofs());
+    world->setExternalForces(forces);
+    world->step();
+    ssid.registerControls(time, forces);
+    ssid.registerSensors(time, world->getPositions());
+  }
+  arm->setMass(1.0);
+
+  ssid.setInitialPosEstimator([](Eigen::MatrixXd sensors, long /* time */) {
+    // Use the first column of sensor data as an approximate starting point
+    return sensors.col(0);
+  });
+}
+
+/// This optimizer doesn't move anything, it just counts how many times SSID
+/// asks it for a cold solve and how many times it reoptimizes a Solution. That
+/// lets us check the sliding window bookkeeping without paying for IPOPT.
+class CountingOptimizer : public Optimizer
+{
+public:
+  std::shared_ptr<Solution> optimize(
+      Problem* /* problem */,
+      std::shared_ptr<Solution> /* warmStart */ = nullptr) override
+  {
+    mNumOptimizations++;
+    std::shared_ptr<Solution> solution = std::make_shared<Solution>();
+    solution->registerForReoptimization([this]() {
+      mNumReoptimizations++;
+      return true;
+    });
+    return solution;
+  }
+
+  int mNumOptimizations = 0;
+  int mNumReoptimizations = 0;
+};
+
+TEST(REALTIME, SSID_SLIDING_WINDOW_SHIFT)
+{
+  WorldPtr world = createSSIDCartpole();
+
+  int millisPerTimestep = world->getTimeStep() * 1000;
+  int historySteps = 5;
+  int inferenceHistoryMillis = historySteps * millisPerTimestep;
+
+  TestSSID ssid(
+      world, getSSIDLoss(), inferenceHistoryMillis, world->getNumDofs());
+  recordSSIDHistory(world, ssid, 50);
+  std::shared_ptr<CountingOptimizer> optimizer
+      = std::make_shared<CountingOptimizer>();
+  ssid.setOptimizer(optimizer);
+  ssid.setSlidingWindowEnabled(true);
+
+  ssid.runInference(30 * millisPerTimestep);
+  EXPECT_EQ(1, optimizer->mNumOptimizations);
+  EXPECT_EQ(0, optimizer->mNumReoptimizations);
+  EXPECT_EQ((30 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+  EXPECT_TRUE(equals(ssid.getForceHistory(), ssid.getColdForceHistory()));
+  EXPECT_TRUE(equals(ssid.getSensorHistory(), ssid.getColdSensorHistory()));
+
+  // Sliding forward 2 steps should advance the problem, so it starts from
+  // where the last rollout was 2 steps in, and only read the 2 new columns
+  const TrajectoryRollout* lastRollout
+      = ssid.getProblem()->getRolloutCache(world);
+  Eigen::VectorXd expectedStartPos = lastRollout->getPosesConst().col(2);
+  Eigen::VectorXd expectedStartVel = lastRollout->getVelsConst().col(2);
+  Eigen::MatrixXd lastForces = ssid.getForceHistory();
+  Eigen::MatrixXd lastSensors = ssid.getSensorHistory();
+
+  ssid.runInference(32 * millisPerTimestep);
+  EXPECT_EQ(1, optimizer->mNumOptimizations);
+  EXPECT_EQ(1, optimizer->mNumReoptimizations);
+  EXPECT_EQ((32 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+  EXPECT_TRUE(equals(ssid.getProblem()->getStartPos(), expectedStartPos));
+  EXPECT_TRUE(equals(ssid.getProblem()->getStartVel(), expectedStartVel));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXd(ssid.getForceHistory().leftCols(historySteps - 2)),
+      Eigen::MatrixXd(lastForces.rightCols(historySteps - 2))));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXd(ssid.getSensorHistory().leftCols(historySteps - 2)),
+      Eigen::MatrixXd(lastSensors.rightCols(historySteps - 2))));
+  EXPECT_TRUE(equals(ssid.getForceHistory(), ssid.getColdForceHistory()));
+  EXPECT_TRUE(equals(ssid.getSensorHistory(), ssid.getColdSensorHistory()));
+
+  // A time that isn't on the grid rounds down, so the window stays put
+  ssid.runInference(32 * millisPerTimestep + millisPerTimestep / 2);
+  EXPECT_EQ(1, optimizer->mNumOptimizations);
+  EXPECT_EQ(2, optimizer->mNumReoptimizations);
+  EXPECT_EQ((32 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+
+  // Jumping past the whole window falls back to a cold solve
+  ssid.runInference(49 * millisPerTimestep);
+  EXPECT_EQ(2, optimizer->mNumOptimizations);
+  EXPECT_EQ(2, optimizer->mNumReoptimizations);
+  EXPECT_EQ((49 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+  EXPECT_TRUE(equals(ssid.getForceHistory(), ssid.getColdForceHistory()));
+  EXPECT_TRUE(equals(ssid.getSensorHistory(), ssid.getColdSensorHistory()));
+}
+
+#ifdef ALL_TESTS
+TEST(REALTIME, CARTPOLE_SSID_SLIDING_WINDOW)
+{
+  WorldPtr world = createSSIDCartpole();
+  BodyNode* arm = world->getSkeleton("cartpole")->getBodyNode(1);
+
+  int millisPerTimestep = world->getTimeStep() * 1000;
+  int historySteps = 5;
+  int inferenceHistoryMillis = historySteps * millisPerTimestep;
+
+  TestSSID ssid(
+      world, getSSIDLoss(), inferenceHistoryMillis, world->getNumDofs());
+  recordSSIDHistory(world, ssid, 50);
+  double initialMass = arm->getMass();
+
+  ssid.setSlidingWindowEnabled(true);
+
+  // The first call solves from scratch
+  ssid.runInference(30 * millisPerTimestep);
+  EXPECT_EQ((30 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+  EXPECT_TRUE(equals(ssid.getForceHistory(), ssid.getColdForceHistory()));
+  EXPECT_TRUE(equals(ssid.getSensorHistory(), ssid.getColdSensorHistory()));
+  trajectory::Solution* solution = ssid.getSolution();
+  EXPECT_TRUE(solution != nullptr);
+
+  // Every call after that slides the window forward a couple of steps. The
+  // shifted histories have to match reading the new window cold, and the
+  // optimizer is warm started from the same Solution.
+  for (int i = 32; i <= 40; i += 2)
+  {
+    ssid.runInference(i * millisPerTimestep);
+    EXPECT_EQ((i - historySteps) * millisPerTimestep, ssid.getWindowStart());
+    EXPECT_TRUE(
+        equals(ssid.getForceHistory(), ssid.getColdForceHistory(), 1e-12));
+    EXPECT_TRUE(
+        equals(ssid.getSensorHistory(), ssid.getColdSensorHistory(), 1e-12));
+    EXPECT_EQ(solution, ssid.getSolution());
+  }
+
+  // Jumping ahead by more than the whole window leaves nothing to warm start
+  // from, so this has to fall back to a cold solve
+  ssid.runInference(49 * millisPerTimestep);
+  EXPECT_EQ((49 - historySteps) * millisPerTimestep, ssid.getWindowStart());
+  EXPECT_TRUE(equals(ssid.getForceHistory(), ssid.getColdForceHistory()));
+  EXPECT_TRUE(equals(ssid.getSensorHistory(), ssid.getColdSensorHistory()));
+  EXPECT_NE(solution, ssid.getSolution());
+
+  // The data was recorded with the arm at 2.0, so we should have moved the
+  // mass from our initial guess towards that
+  EXPECT_LT(std::abs(arm->getMass() - 2.0), std::abs(initialMass - 2.0));
+}
+#endif
+
+TEST(REALTIME, IPOPT_PAST_DEADLINE)
+{
+  WorldPtr world = createCartpoleWorld();
+  int steps = 10;
+
+  // A tolerance this tight means a full solve always runs to the iteration
+  // limit, so only the deadline can cut it short
+  IPOptOptimizer optimizer;
+  optimizer.setCheckDerivatives(false);
+  optimizer.setSuppressOutput(true);
+  optimizer.setSilenceOutput(true);
+  optimizer.setTolerance(1e-12);
+  optimizer.setIterationLimit(5);
+  optimizer.setRecordIterations(false);
+  int lastIter = -1;
+  optimizer.registerIntermediateCallback(
+      [&lastIter](
+          Problem* /* problem */,
+          int iter,
+          double /* primal */,
+          double /* dual */) {
+        lastIter = iter;
+        return true;
+      });
+
+  SingleShot fullShot(world, *getMPCLoss(), steps, false);
+  optimizer.optimize(&fullShot);
+  EXPECT_GT(lastIter, 1);
+
+  // With a deadline that's already gone by, IPOPT still takes its first step,
+  // and then stops
+  optimizer.setDeadline(timeSinceEpochMillis() - 1);
+  SingleShot cutShot(world, *getMPCLoss(), steps, false);
+  lastIter = -1;
+  optimizer.optimize(&cutShot);
+  EXPECT_EQ(1, lastIter);
+
+  // Clearing the deadline lets the next solve run to the limit again
+  optimizer.clearDeadline();
+  SingleShot clearedShot(world, *getMPCLoss(), steps, false);
+  lastIter = -1;
+  optimizer.optimize(&clearedShot);
+  EXPECT_GT(lastIter, 1);
+}
+
+#ifdef ALL_TESTS
+TEST(REALTIME, CARTPOLE_MPC_ANYTIME)
+{
+  WorldPtr world = createCartpoleWorld();
+  int millisPerTimestep = world->getTimeStep() * 1000;
+  int steps = 50;
+  int planningHorizonMillis = steps * millisPerTimestep;
+  int iterationLimit = 20;
+
+  // A tolerance this tight means a full solve always runs to the iteration
+  // limit, so only the deadline can cut a replan short
+  std::shared_ptr<IPOptOptimizer> optimizer
+      = std::make_shared<IPOptOptimizer>();
+  optimizer->setCheckDerivatives(false);
+  optimizer->setSuppressOutput(true);
+  optimizer->setSilenceOutput(true);
+  optimizer->setRecoverBest(true);
+  optimizer->setTolerance(1e-12);
+  optimizer->setIterationLimit(iterationLimit);
+  optimizer->setRecordIterations(false);
+  int numIterations = 0;
+  optimizer->registerIntermediateCallback(
+      [&numIterations](
+          Problem* /* problem */,
+          int /* iter */,
+          double /* primal */,
+          double /* dual */) {
+        numIterations++;
+        return true;
+      });
+
+  MPCLocal mpc(world, getMPCLoss(), planningHorizonMillis);
+  mpc.setSilent(true);
+  mpc.setOptimizer(optimizer);
+  mpc.setEnableAnytimeReplanning(true);
+
+  // A copy sharing the optimizer has to clear the deadline left over from our
+  // replan before its own cold solve, or that solve would get cut short
+  MPCLocal copy(mpc);
+  copy.setOptimizer(optimizer);
+
+  // Plan as though we started a whole horizon ago, so by the time we replan
+  // there's no buffer left of the first plan, and the deadline is immediate
+  long startTime = timeSinceEpochMillis() - planningHorizonMillis;
+  mpc.recordGroundTruthState(
+      startTime,
+      world->getPositions(),
+      world->getVelocities(),
+      world->getMasses());
+  mpc.optimizePlan(startTime);
+  int coldIterations = numIterations;
+  EXPECT_GT(coldIterations, 2);
+
+  long publishedAt = -1;
+  Eigen::MatrixXd publishedForces;
+  mpc.registerReplanningListener(
+      [&](long time, const TrajectoryRollout* rollout, long /* duration */) {
+        publishedAt = time;
+        publishedForces = rollout->getForcesConst();
+      });
+
+  long replanTime = startTime + 2 * millisPerTimestep;
+  mpc.recordGroundTruthState(
+      replanTime,
+      world->getPositions(),
+      world->getVelocities(),
+      world->getMasses());
+  EXPECT_LE(mpc.getRemainingPlanBufferMillis(), 0);
+  numIterations = 0;
+  mpc.optimizePlan(replanTime);
+
+  // IPOPT always takes its first step, and then stops at the deadline
+  EXPECT_LE(numIterations, 2);
+  EXPECT_LT(numIterations, coldIterations);
+
+  // The replan still published a full plan
+  EXPECT_EQ(replanTime, publishedAt);
+  EXPECT_EQ(steps, publishedForces.cols());
+  EXPECT_TRUE(publishedForces.allFinite());
+  EXPECT_TRUE(equals(
+      Eigen::VectorXd(publishedForces.col(0)), mpc.getForce(replanTime)));
+
+  copy.recordGroundTruthState(
+      startTime,
+      world->getPositions(),
+      world->getVelocities(),
+      world->getMasses());
+  numIterations = 0;
+  copy.optimizePlan(startTime);
+  EXPECT_EQ(coldIterations, numIterations);
+}
+#endif
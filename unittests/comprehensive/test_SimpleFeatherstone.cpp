@@ -4,10 +4,17 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BatchedSimpleFeatherstone.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PlanarJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
 #include "dart/dynamics/SimpleFeatherstone.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
@@ -142,6 +149,108 @@ TEST(FEATHERSTONE, LINK_5)
 }
 #endif
 
+void verifyBatchedSkeleton(SkeletonPtr skel, int batchSize)
+{
+  dynamics::BatchedSimpleFeatherstone batched(batchSize);
+  batched.populateFromSkeleton(skel);
+  EXPECT_EQ(skel->getNumDofs(), batched.getNumDofs());
+
+  // Every lane gets its own state
+  Eigen::MatrixXd pos = Eigen::MatrixXd::Random(skel->getNumDofs(), batchSize);
+  Eigen::MatrixXd vel = Eigen::MatrixXd::Random(skel->getNumDofs(), batchSize);
+  Eigen::MatrixXd force
+      = Eigen::MatrixXd::Random(skel->getNumDofs(), batchSize);
+  Eigen::MatrixXd accel;
+  batched.forwardDynamics(pos, vel, force, accel);
+  EXPECT_EQ(skel->getNumDofs(), accel.rows());
+  EXPECT_EQ(batchSize, accel.cols());
+
+  for (int k = 0; k < batchSize; k++)
+  {
+    skel->setPositions(pos.col(k));
+    skel->setVelocities(vel.col(k));
+    skel->setForces(force.col(k));
+    skel->computeForwardDynamics();
+    Eigen::VectorXd realAccel = skel->getAccelerations();
+    Eigen::VectorXd batchedAccel = accel.col(k);
+
+    if (!equals(batchedAccel, realAccel))
+    {
+      std::cout << "Lane " << k << " expected acceleration: " << std::endl
+                << realAccel << std::endl;
+      std::cout << "Got acceleration: " << std::endl
+                << batchedAccel << std::endl;
+      EXPECT_TRUE(equals(batchedAccel, realAccel));
+      return;
+    }
+  }
+}
+
+Eigen::Isometry3d randomTransform()
+{
+  Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  transform.linear() = math::expMapRot(Eigen::Vector3d::Random());
+  transform.translation() = Eigen::Vector3d::Random();
+  return transform;
+}
+
+template <class JointType>
+BodyNode* addRandomBody(SkeletonPtr skel, BodyNode* parent)
+{
+  std::pair<JointType*, BodyNode*> pair
+      = skel->createJointAndBodyNodePair<JointType>(parent);
+  pair.first->setTransformFromParentBodyNode(randomTransform());
+  pair.first->setTransformFromChildBodyNode(randomTransform());
+  pair.second->setMass(1.0 + Eigen::Vector2d::Random().cwiseAbs()(0));
+  pair.second->setMomentOfInertia(1.0, 2.0, 3.0, 0.1, 0.2, 0.3);
+  pair.second->setLocalCOM(Eigen::Vector3d::Random() * 0.1);
+  return pair.second;
+}
+
+// This builds a tree with every joint type BatchedSimpleFeatherstone supports,
+// with random offsets everywhere
+SkeletonPtr createMultiDofSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("multi_dof");
+  BodyNode* root = addRandomBody<FreeJoint>(skel, nullptr);
+  BodyNode* ball = addRandomBody<BallJoint>(skel, root);
+  BodyNode* planar = addRandomBody<PlanarJoint>(skel, ball);
+  addRandomBody<RevoluteJoint>(skel, planar);
+  BodyNode* weld = addRandomBody<WeldJoint>(skel, root);
+  BodyNode* prismatic = addRandomBody<PrismaticJoint>(skel, weld);
+  addRandomBody<ScrewJoint>(skel, prismatic);
+  addRandomBody<BallJoint>(skel, weld);
+  return skel;
+}
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCHED_LINK_5)
+{
+  verifyBatchedSkeleton(createMultiarmRobot(5, 0.2), 7);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCHED_CARTPOLE)
+{
+  verifyBatchedSkeleton(createCartpole(), 16);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCHED_MULTI_DOF)
+{
+  SkeletonPtr skel = createMultiDofSkeleton();
+  verifyBatchedSkeleton(skel, 13);
+  // This spans several tiles, with a partial tile at the end
+  verifyBatchedSkeleton(
+      skel, 2 * dynamics::BatchedSimpleFeatherstone::MAX_TILE_SIZE + 3);
+
+  skel->setGravity(Eigen::Vector3d::Zero());
+  verifyBatchedSkeleton(skel, 1);
+}
+#endif
+
 /*
 template <class ConfigSpaceT>
 void GenericJoint<ConfigSpaceT>::addChildArtInertiaImplicitToDynamic(
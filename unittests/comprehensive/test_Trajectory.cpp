@@ -53,6 +53,8 @@
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/trajectory/CommonLossFns.hpp"
+#include "dart/trajectory/ILQROptimizer.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
 #include "dart/trajectory/Problem.hpp"
@@ -348,6 +350,760 @@ TEST(TRAJECTORY, CARTPOLE)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, INCREMENTAL_SNAPSHOTS)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr spinner = Skeleton::create("spinner");
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = spinner->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+
+  world->addSkeleton(spinner);
+
+  spinner->setPosition(0, 15.0 / 180.0 * 3.1415);
+
+  const int steps = 20;
+  SingleShot shot(world, LossFn(), steps, true);
+
+  int staticDim = shot.getFlatStaticProblemDim(world);
+  int dynamicDim = shot.getFlatDynamicProblemDim(world);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Zero(dynamicDim);
+  shot.flatten(world, flatStatic, flatDynamic);
+
+  // The first rollout has to simulate everything
+  shot.getSnapshots(world);
+  EXPECT_EQ(steps, shot.getNumSnapshotsRecomputed());
+
+  // Asking again without changes shouldn't simulate anything
+  shot.getSnapshots(world);
+  EXPECT_EQ(steps, shot.getNumSnapshotsRecomputed());
+
+  // Changing the force at timestep 15 should only re-simulate the last 5 steps
+  int forceDim = world->getNumDofs();
+  int stateDim = world->getNumDofs() * 2;
+  flatDynamic(stateDim + 15 * forceDim) = 0.3;
+  shot.unflatten(world, flatStatic, flatDynamic);
+  std::vector<MappedBackpropSnapshotPtr> snapshots = shot.getSnapshots(world);
+  EXPECT_EQ(steps + 5, shot.getNumSnapshotsRecomputed());
+
+  // The spliced rollout should match a rollout from scratch
+  SingleShot freshShot(world, LossFn(), steps, true);
+  freshShot.unflatten(world, flatStatic, flatDynamic);
+  std::vector<MappedBackpropSnapshotPtr> freshSnapshots
+      = freshShot.getSnapshots(world);
+  EXPECT_EQ(steps, freshShot.getNumSnapshotsRecomputed());
+  ASSERT_EQ(freshSnapshots.size(), snapshots.size());
+  for (int i = 0; i < steps; i++)
+  {
+    EXPECT_TRUE(equals(
+        freshSnapshots[i]->getPostStepPosition("identity"),
+        snapshots[i]->getPostStepPosition("identity"),
+        1e-12));
+    EXPECT_TRUE(equals(
+        freshSnapshots[i]->getPostStepVelocity("identity"),
+        snapshots[i]->getPostStepVelocity("identity"),
+        1e-12));
+  }
+
+  // Changing the starting state invalidates the whole rollout
+  flatDynamic(0) += 0.1;
+  shot.unflatten(world, flatStatic, flatDynamic);
+  shot.getSnapshots(world);
+  EXPECT_EQ(2 * steps + 5, shot.getNumSnapshotsRecomputed());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, SEQUENTIAL_MULTISHOT_MASS_CHANGE)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+
+  std::pair<PrismaticJoint*, BodyNode*> boxPair
+      = box->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  boxPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  BodyNode* boxBody = boxPair.second;
+
+  world->addSkeleton(box);
+
+  Eigen::VectorXd upperBounds = Eigen::VectorXd::Ones(1) * 5.0;
+  Eigen::VectorXd lowerBounds = Eigen::VectorXd::Ones(1) * 0.1;
+  world->getWrtMass()->registerNode(
+      boxBody,
+      neural::WrtMassBodyNodeEntryType::INERTIA_MASS,
+      upperBounds,
+      lowerBounds);
+
+  const int steps = 12;
+  const int shotLength = 4;
+  MultiShot shot(world, LossFn(), steps, shotLength, true);
+  shot.setParallelOperationsEnabled(false);
+
+  int n = shot.getFlatProblemDim(world);
+  Eigen::VectorXd flat = Eigen::VectorXd::Zero(n);
+  shot.Problem::flatten(world, flat);
+  // Push on the box, so that its mass shows up in the trajectory
+  int massDim = world->getMassDims();
+  flat.segment(massDim, n - massDim).setConstant(0.5);
+  shot.Problem::unflatten(world, flat);
+  Eigen::MatrixXd oldPoses
+      = shot.getRolloutCache(world)->getPosesConst("identity");
+
+  // Changing only the mass has to throw out every shot's cached snapshots,
+  // even though the MultiShot writes the new mass into the shared world
+  // before any of the shots see it
+  flat(0) = 2.0;
+  shot.Problem::unflatten(world, flat);
+  Eigen::MatrixXd newPoses
+      = shot.getRolloutCache(world)->getPosesConst("identity");
+  EXPECT_FALSE(equals(oldPoses, newPoses, 1e-8));
+
+  MultiShot freshShot(world, LossFn(), steps, shotLength, true);
+  freshShot.Problem::unflatten(world, flat);
+  Eigen::MatrixXd freshPoses
+      = freshShot.getRolloutCache(world)->getPosesConst("identity");
+  EXPECT_TRUE(equals(freshPoses, newPoses, 1e-12));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, CHECKPOINTED_BACKPROP)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+
+  std::pair<RevoluteJoint*, BodyNode*> upperPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  upperPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> lowerPair
+      = upperPair.second->createChildJointAndBodyNodePair<RevoluteJoint>();
+  lowerPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  Eigen::Isometry3d lowerOffset = Eigen::Isometry3d::Identity();
+  lowerOffset.translation() = Eigen::Vector3d(0, 1.0, 0);
+  lowerPair.first->setTransformFromParentBodyNode(lowerOffset);
+
+  world->addSkeleton(arm);
+
+  arm->setPosition(0, 15.0 / 180.0 * 3.1415);
+  arm->setPosition(1, 15.0 / 180.0 * 3.1415);
+
+  // Put loss on every timestep, so every segment gets a gradient from the loss
+  // as well as from the segments after it
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getPosesConst("identity").squaredNorm()
+           + rollout->getVelsConst("identity").squaredNorm();
+  };
+
+  // Use a horizon that doesn't split evenly into segments
+  const int steps = 23;
+  SingleShot fullShot(world, LossFn(loss), steps, true);
+  SingleShot checkpointedShot(world, LossFn(loss), steps, true);
+  checkpointedShot.setCheckpointInterval(5);
+  EXPECT_EQ(5, checkpointedShot.getCheckpointInterval());
+
+  int dim = fullShot.getFlatProblemDim(world);
+  int staticDim = fullShot.getFlatStaticProblemDim(world);
+  srand(42);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Random(dim - staticDim) * 0.1;
+  fullShot.unflatten(world, flatStatic, flatDynamic);
+  checkpointedShot.unflatten(world, flatStatic, flatDynamic);
+
+  EXPECT_EQ(fullShot.getLoss(world), checkpointedShot.getLoss(world));
+  EXPECT_TRUE(equals(
+      fullShot.getFinalState(world),
+      checkpointedShot.getFinalState(world),
+      1e-12));
+
+  Eigen::VectorXd fullGrad = Eigen::VectorXd::Zero(dim);
+  fullShot.backpropGradient(world, fullGrad);
+  Eigen::VectorXd checkpointedGrad = Eigen::VectorXd::Zero(dim);
+  checkpointedShot.backpropGradient(world, checkpointedGrad);
+  EXPECT_TRUE(equals(fullGrad, checkpointedGrad, 1e-12));
+
+  // The checkpointed shot simulates the trajectory once to get the loss, and
+  // once more, segment by segment, to backprop
+  EXPECT_EQ(2 * steps, checkpointedShot.getNumSnapshotsRecomputed());
+
+  // Changing a late force should only re-simulate from the checkpoint before it
+  flatDynamic(dim - staticDim - 1) += 0.1;
+  checkpointedShot.unflatten(world, flatStatic, flatDynamic);
+  checkpointedShot.getLoss(world);
+  EXPECT_EQ(2 * steps + 3, checkpointedShot.getNumSnapshotsRecomputed());
+
+  // The memory budget should pick an interval that fits that many snapshots
+  std::size_t snapshotBytes = checkpointedShot.estimateSnapshotBytes(world);
+  checkpointedShot.setSnapshotMemoryBudget(world, 4 * snapshotBytes);
+  EXPECT_EQ(4, checkpointedShot.getCheckpointInterval());
+  checkpointedShot.setSnapshotMemoryBudget(world, 0);
+  EXPECT_EQ(1, checkpointedShot.getCheckpointInterval());
+  checkpointedShot.setSnapshotMemoryBudget(world, steps * snapshotBytes);
+  EXPECT_EQ(0, checkpointedShot.getCheckpointInterval());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ILQR)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+
+  std::pair<RevoluteJoint*, BodyNode*> upperPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  upperPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> lowerPair
+      = upperPair.second->createChildJointAndBodyNodePair<RevoluteJoint>();
+  lowerPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  Eigen::Isometry3d lowerOffset = Eigen::Isometry3d::Identity();
+  lowerOffset.translation() = Eigen::Vector3d(0, 1.0, 0);
+  lowerPair.first->setTransformFromParentBodyNode(lowerOffset);
+
+  world->addSkeleton(arm);
+
+  arm->setPosition(0, 15.0 / 180.0 * 3.1415);
+  arm->setPosition(1, 15.0 / 180.0 * 3.1415);
+
+  // Drive the arm to a target pose, with a little effort penalty
+  Eigen::Vector2d target(0.5, -0.5);
+  TrajectoryLossFn loss = [target](const TrajectoryRollout* rollout) {
+    const Eigen::Ref<const Eigen::MatrixXd> poses
+        = rollout->getPosesConst("identity");
+    const Eigen::Ref<const Eigen::MatrixXd> forces
+        = rollout->getForcesConst("identity");
+    return (poses.col(poses.cols() - 1) - target).squaredNorm()
+           + 1e-6 * forces.squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossGrad
+      = [target](
+            const TrajectoryRollout* rollout,
+            TrajectoryRollout* gradWrtRollout // OUT
+        ) {
+          gradWrtRollout->getPoses("identity").setZero();
+          gradWrtRollout->getVels("identity").setZero();
+          const Eigen::Ref<const Eigen::MatrixXd> poses
+              = rollout->getPosesConst("identity");
+          const Eigen::Ref<const Eigen::MatrixXd> forces
+              = rollout->getForcesConst("identity");
+          gradWrtRollout->getPoses("identity").col(poses.cols() - 1)
+              = 2 * (poses.col(poses.cols() - 1) - target);
+          gradWrtRollout->getForces("identity") = 2e-6 * forces;
+          return (poses.col(poses.cols() - 1) - target).squaredNorm()
+                 + 1e-6 * forces.squaredNorm();
+        };
+
+  // Use a coarse timestep, so the arm can get somewhere over a short horizon
+  world->setTimeStep(1e-2);
+  const int steps = 50;
+  SingleShot shot(world, LossFn(loss, lossGrad), steps, false);
+  double initialLoss = shot.getLoss(world);
+
+  ILQROptimizer optimizer;
+  optimizer.setIterationLimit(20);
+  optimizer.setSilenceOutput(true);
+  std::shared_ptr<Solution> record = optimizer.optimize(&shot);
+
+  // The loss is nearly quadratic, so iLQR should get most of the way there in
+  // a handful of iterations
+  EXPECT_TRUE(record->getNumSteps() > 0);
+  EXPECT_TRUE(record->getNumSteps() < 20);
+  double optimizedLoss = shot.getLoss(world);
+  EXPECT_TRUE(optimizedLoss < 0.01 * initialLoss);
+  EXPECT_NEAR(
+      record->getStep(record->getNumSteps() - 1).loss, optimizedLoss, 1e-9);
+  for (int i = 0; i < record->getNumSteps(); i++)
+  {
+    EXPECT_TRUE(record->getStep(i).durationMillis >= 0);
+  }
+
+  // Re-optimizing from the solution should keep the loss where it is
+  record->reoptimize();
+  EXPECT_TRUE(shot.getLoss(world) <= optimizedLoss + 1e-9);
+
+  // Now only allow small forces, and check that the box constrained controls
+  // respect that while still improving the loss
+  upperPair.first->setForceUpperLimit(0, 2.0);
+  upperPair.first->setForceLowerLimit(0, -2.0);
+  lowerPair.first->setForceUpperLimit(0, 2.0);
+  lowerPair.first->setForceLowerLimit(0, -2.0);
+  SingleShot boxShot(world, LossFn(loss, lossGrad), steps, false);
+  double boxInitialLoss = boxShot.getLoss(world);
+
+  optimizer.setBoxConstrainedControls(true);
+  record = optimizer.optimize(&boxShot);
+  EXPECT_TRUE(boxShot.getLoss(world) < boxInitialLoss);
+  Eigen::MatrixXd forces
+      = boxShot.getRolloutCache(world)->getForcesConst("identity");
+  EXPECT_TRUE(forces.maxCoeff() <= 2.0 + 1e-9);
+  EXPECT_TRUE(forces.minCoeff() >= -2.0 - 1e-9);
+}
+#endif
+
+#ifdef ALL_TESTS
+/// This unpacks the lower triangle from getGaussNewtonHessian() into a dense
+/// matrix over the dynamic problem
+Eigen::MatrixXd getDenseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world, Problem& problem)
+{
+  int staticDim = problem.getFlatStaticProblemDim(world);
+  int dynamicDim = problem.getFlatDynamicProblemDim(world);
+  int nnzh = problem.getNumberNonZeroHessian(world);
+  Eigen::VectorXi rows = Eigen::VectorXi::Zero(nnzh);
+  Eigen::VectorXi cols = Eigen::VectorXi::Zero(nnzh);
+  problem.getHessianSparsityStructure(world, rows, cols);
+  Eigen::VectorXd sparse = Eigen::VectorXd::Zero(nnzh);
+  problem.getGaussNewtonHessian(world, sparse);
+
+  Eigen::MatrixXd dense = Eigen::MatrixXd::Zero(dynamicDim, dynamicDim);
+  for (int i = 0; i < nnzh; i++)
+  {
+    // Everything should be in the lower triangle of the dynamic problem
+    EXPECT_TRUE(rows(i) >= cols(i));
+    EXPECT_TRUE(cols(i) >= staticDim);
+    dense(rows(i) - staticDim, cols(i) - staticDim) = sparse(i);
+    dense(cols(i) - staticDim, rows(i) - staticDim) = sparse(i);
+  }
+  return dense;
+}
+
+/// This finite differences the gradient to get the Hessian of the loss with
+/// respect to the dynamic problem
+Eigen::MatrixXd finiteDifferenceDynamicHessian(
+    std::shared_ptr<simulation::World> world, Problem& problem)
+{
+  int dim = problem.getFlatProblemDim(world);
+  int staticDim = problem.getFlatStaticProblemDim(world);
+  int dynamicDim = problem.getFlatDynamicProblemDim(world);
+  Eigen::VectorXd flat = Eigen::VectorXd::Zero(dim);
+  problem.flatten(world, flat);
+
+  const double EPS = 1e-6;
+  Eigen::MatrixXd hessian = Eigen::MatrixXd::Zero(dynamicDim, dynamicDim);
+  for (int i = 0; i < dynamicDim; i++)
+  {
+    Eigen::VectorXd gradPos = Eigen::VectorXd::Zero(dim);
+    flat(staticDim + i) += EPS;
+    problem.unflatten(world, flat);
+    problem.backpropGradient(world, gradPos);
+
+    Eigen::VectorXd gradNeg = Eigen::VectorXd::Zero(dim);
+    flat(staticDim + i) -= 2 * EPS;
+    problem.unflatten(world, flat);
+    problem.backpropGradient(world, gradNeg);
+
+    flat(staticDim + i) += EPS;
+    hessian.col(i) = (gradPos - gradNeg).tail(dynamicDim) / (2 * EPS);
+  }
+  problem.unflatten(world, flat);
+  return hessian;
+}
+
+TEST(TRAJECTORY, GAUSS_NEWTON_HESSIAN)
+{
+  // A sled on a prismatic joint has linear dynamics, so the Gauss-Newton
+  // Hessian of a quadratic loss is exactly the Hessian
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 1, 0));
+  world->addSkeleton(sled);
+
+  // This puts loss directly on the forces too, which also checks that the
+  // gradient picks up the loss' direct dependence on the forces
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getPosesConst("identity").squaredNorm()
+           + 0.5 * rollout->getVelsConst("identity").squaredNorm()
+           + 0.1 * rollout->getForcesConst("identity").squaredNorm();
+  };
+  // Giving an analytical gradient keeps finite differencing noise out of the
+  // Hessians, which are themselves finite differenced
+  TrajectoryLossFnAndGrad lossGrad = [](const TrajectoryRollout* rollout,
+                                        TrajectoryRollout* gradWrtRollout // OUT
+                                     ) {
+    gradWrtRollout->getPoses("identity")
+        = 2 * rollout->getPosesConst("identity");
+    gradWrtRollout->getVels("identity") = rollout->getVelsConst("identity");
+    gradWrtRollout->getForces("identity")
+        = 0.2 * rollout->getForcesConst("identity");
+    return rollout->getPosesConst("identity").squaredNorm()
+           + 0.5 * rollout->getVelsConst("identity").squaredNorm()
+           + 0.1 * rollout->getForcesConst("identity").squaredNorm();
+  };
+
+  const int steps = 8;
+  SingleShot shot(world, LossFn(loss, lossGrad), steps, true);
+  int staticDim = shot.getFlatStaticProblemDim(world);
+  int dynamicDim = shot.getFlatDynamicProblemDim(world);
+  srand(42);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Random(dynamicDim);
+  shot.unflatten(world, flatStatic, flatDynamic);
+
+  Eigen::VectorXd grad = Eigen::VectorXd::Zero(shot.getFlatProblemDim(world));
+  shot.backpropGradient(world, grad);
+  Eigen::VectorXd fdGrad = Eigen::VectorXd::Zero(shot.getFlatProblemDim(world));
+  shot.finiteDifferenceGradient(world, fdGrad);
+  EXPECT_TRUE(equals(grad, fdGrad, 1e-6));
+
+  EXPECT_EQ(
+      dynamicDim * (dynamicDim + 1) / 2, shot.getNumberNonZeroHessian(world));
+  Eigen::MatrixXd hessian = getDenseGaussNewtonHessian(world, shot);
+  Eigen::MatrixXd fdHessian = finiteDifferenceDynamicHessian(world, shot);
+  EXPECT_TRUE(equals(hessian, fdHessian, 1e-5));
+
+  // A MultiShot gets one block per shot, and the knots decouple the shots so
+  // that's exact too
+  MultiShot multishot(world, LossFn(loss, lossGrad), steps, 4, true);
+  int multiStaticDim = multishot.getFlatStaticProblemDim(world);
+  int multiDynamicDim = multishot.getFlatDynamicProblemDim(world);
+  Eigen::VectorXd multiFlatStatic = Eigen::VectorXd::Zero(multiStaticDim);
+  Eigen::VectorXd multiFlatDynamic = Eigen::VectorXd::Random(multiDynamicDim);
+  multishot.unflatten(world, multiFlatStatic, multiFlatDynamic);
+
+  Eigen::MatrixXd multiHessian = getDenseGaussNewtonHessian(world, multishot);
+  Eigen::MatrixXd multiFdHessian
+      = finiteDifferenceDynamicHessian(world, multishot);
+  EXPECT_TRUE(equals(multiHessian, multiFdHessian, 1e-5));
+
+  multishot.setParallelOperationsEnabled(true);
+  Eigen::MatrixXd parallelHessian
+      = getDenseGaussNewtonHessian(world, multishot);
+  EXPECT_TRUE(equals(multiHessian, parallelHessian, 1e-9));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, LOSS_HESSIAN_BLOCKS_SMOOTHNESS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 1, 0));
+  world->addSkeleton(sled);
+
+  // A smoothness penalty only relates neighbouring timesteps, so it's exactly
+  // the kind of term that must not leak into the diagonal blocks
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    Eigen::MatrixXd poses = rollout->getPosesConst("identity");
+    int steps = poses.cols();
+    return (poses.rightCols(steps - 1) - poses.leftCols(steps - 1))
+        .squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossGrad
+      = [loss](
+            const TrajectoryRollout* rollout,
+            TrajectoryRollout* gradWrtRollout // OUT
+        ) {
+    Eigen::MatrixXd poses = rollout->getPosesConst("identity");
+    int steps = poses.cols();
+    Eigen::MatrixXd diff
+        = poses.rightCols(steps - 1) - poses.leftCols(steps - 1);
+    gradWrtRollout->getPoses("identity").setZero();
+    gradWrtRollout->getPoses("identity").rightCols(steps - 1) += 2 * diff;
+    gradWrtRollout->getPoses("identity").leftCols(steps - 1) -= 2 * diff;
+    gradWrtRollout->getVels("identity").setZero();
+    gradWrtRollout->getForces("identity").setZero();
+    return loss(rollout);
+  };
+
+  const int steps = 6;
+  SingleShot shot(world, LossFn(loss, lossGrad), steps, true);
+  srand(42);
+  Eigen::VectorXd flatStatic
+      = Eigen::VectorXd::Zero(shot.getFlatStaticProblemDim(world));
+  Eigen::VectorXd flatDynamic
+      = Eigen::VectorXd::Random(shot.getFlatDynamicProblemDim(world));
+  shot.unflatten(world, flatStatic, flatDynamic);
+
+  // Each block covers (pos, vel, force) of the sled. Only the position has any
+  // curvature on its own timestep: 2 at the ends, and 4 in between.
+  std::vector<Eigen::MatrixXd> blocks = shot.getLossHessianBlocks(world);
+  EXPECT_EQ(steps, blocks.size());
+  for (int t = 0; t < steps; t++)
+  {
+    Eigen::MatrixXd expected = Eigen::MatrixXd::Zero(3, 3);
+    expected(0, 0) = (t == 0 || t == steps - 1) ? 2.0 : 4.0;
+    EXPECT_TRUE(equals(blocks[t], expected, 1e-6));
+  }
+
+  // Without an analytical gradient we don't try to estimate the Hessian at
+  // all, and IPOPT falls back to L-BFGS
+  SingleShot fdShot(world, LossFn(loss), steps, true);
+  fdShot.unflatten(world, flatStatic, flatDynamic);
+  EXPECT_TRUE(shot.hasAnalyticalLossGradient());
+  EXPECT_FALSE(fdShot.hasAnalyticalLossGradient());
+  std::vector<Eigen::MatrixXd> fdBlocks = fdShot.getLossHessianBlocks(world);
+  EXPECT_EQ(steps, fdBlocks.size());
+  for (int t = 0; t < steps; t++)
+  {
+    EXPECT_TRUE(fdBlocks[t].isZero(0));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, FORCE_LOSS_GRADIENT)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 1, 0));
+  world->addSkeleton(sled);
+
+  // The loss only sees the forces directly, so backprop through the dynamics
+  // contributes nothing, and the whole gradient comes from the loss' direct
+  // dependence on the forces
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getForcesConst("identity").squaredNorm();
+  };
+
+  const int steps = 6;
+  SingleShot shot(world, LossFn(loss), steps, true);
+  srand(42);
+  Eigen::VectorXd flatStatic
+      = Eigen::VectorXd::Zero(shot.getFlatStaticProblemDim(world));
+  Eigen::VectorXd flatDynamic
+      = Eigen::VectorXd::Random(shot.getFlatDynamicProblemDim(world));
+  shot.unflatten(world, flatStatic, flatDynamic);
+
+  Eigen::VectorXd grad = Eigen::VectorXd::Zero(shot.getFlatProblemDim(world));
+  shot.backpropGradient(world, grad);
+
+  // The checkpointed backprop goes through the same per-timestep code
+  shot.setCheckpointInterval(2);
+  Eigen::VectorXd checkpointedGrad
+      = Eigen::VectorXd::Zero(shot.getFlatProblemDim(world));
+  shot.backpropGradient(world, checkpointedGrad);
+
+  Eigen::VectorXd fdGrad = Eigen::VectorXd::Zero(shot.getFlatProblemDim(world));
+  shot.finiteDifferenceGradient(world, fdGrad);
+  EXPECT_TRUE(fdGrad.norm() > 0);
+  EXPECT_TRUE(equals(grad, fdGrad, 1e-6));
+  EXPECT_TRUE(equals(checkpointedGrad, fdGrad, 1e-6));
+}
+#endif
+
+#ifdef ALL_TESTS
+/// This central differences `loss` over every pose, vel and force in the
+/// identity mapping of `rollout`, and checks that against the analytical
+/// gradient
+bool verifyLossGradient(
+    LossFn& loss,
+    const TrajectoryRollout* rollout,
+    const std::string& mapping = "identity")
+{
+  TrajectoryRolloutReal grad(rollout);
+  double value = loss.getLossAndGradient(rollout, &grad);
+  if (std::abs(value - loss.getLoss(rollout)) > 1e-9)
+  {
+    std::cout << "getLossAndGradient() disagrees with getLoss()" << std::endl;
+    return false;
+  }
+
+  const double EPS = 1e-6;
+  TrajectoryRolloutReal perturbed(rollout);
+  TrajectoryRolloutReal fdGrad(rollout);
+  std::vector<std::function<Eigen::Ref<Eigen::MatrixXd>(TrajectoryRollout*)>>
+      getters
+      = {[mapping](TrajectoryRollout* r) { return r->getPoses(mapping); },
+         [mapping](TrajectoryRollout* r) { return r->getVels(mapping); },
+         [mapping](TrajectoryRollout* r) { return r->getForces(mapping); }};
+  for (auto& get : getters)
+  {
+    Eigen::Ref<Eigen::MatrixXd> values = get(&perturbed);
+    for (int row = 0; row < values.rows(); row++)
+    {
+      for (int col = 0; col < values.cols(); col++)
+      {
+        double original = values(row, col);
+        values(row, col) = original + EPS;
+        double plus = loss.getLoss(&perturbed);
+        values(row, col) = original - EPS;
+        double minus = loss.getLoss(&perturbed);
+        values(row, col) = original;
+        get(&fdGrad)(row, col) = (plus - minus) / (2 * EPS);
+      }
+    }
+    Eigen::MatrixXd analytical = get(&grad);
+    Eigen::MatrixXd fd = get(&fdGrad);
+    if (!equals(analytical, fd, 1e-6))
+    {
+      std::cout << "Analytical gradient:" << std::endl
+                << analytical << std::endl
+                << "FD gradient:" << std::endl
+                << fd << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(TRAJECTORY, COMMON_LOSS_FNS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> elbowPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  elbowPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  Eigen::Isometry3d elbowOffset = Eigen::Isometry3d::Identity();
+  elbowOffset.translation() = Eigen::Vector3d(0, 1.0, 0);
+  elbowPair.first->setTransformFromParentBodyNode(elbowOffset);
+  world->addSkeleton(arm);
+  arm->setPosition(0, 15.0 / 180.0 * 3.1415);
+
+  const int steps = 6;
+  SingleShot shot(world, controlEffortLoss(), steps, true);
+  // This is a second view of the same positions, under a different name, so
+  // we can check losses that read from a mapping other than "identity"
+  std::shared_ptr<IdentityMapping> copyMapping
+      = std::make_shared<IdentityMapping>(world);
+  shot.addMapping("copy", copyMapping);
+  srand(42);
+  Eigen::VectorXd flatDynamic
+      = Eigen::VectorXd::Random(shot.getFlatDynamicProblemDim(world));
+  shot.unflatten(
+      world,
+      Eigen::VectorXd::Zero(shot.getFlatStaticProblemDim(world)),
+      flatDynamic);
+  TrajectoryRolloutReal rollout(shot.getRolloutCache(world));
+
+  LossFn finalState = finalStateDistanceLoss(
+      Eigen::Vector2d(0.5, -0.3), Eigen::Vector2d(0.1, 0.2), 2.0, 0.5);
+  EXPECT_TRUE(verifyLossGradient(finalState, &rollout));
+
+  LossFn effort = controlEffortLoss(0.1);
+  EXPECT_TRUE(verifyLossGradient(effort, &rollout));
+
+  std::vector<BodyNode*> nodes = {armPair.second, elbowPair.second};
+  Eigen::VectorXd worldPosBefore = world->getPositions();
+  Eigen::MatrixXd trajectoryTargets = Eigen::MatrixXd::Random(6, steps);
+  LossFn tracking = worldSpaceBodyTrackingLoss(world, nodes, trajectoryTargets);
+  EXPECT_TRUE(verifyLossGradient(tracking, &rollout));
+  Eigen::MatrixXd finalTarget = Eigen::MatrixXd::Random(6, 1);
+  LossFn finalTracking
+      = worldSpaceBodyTrackingLoss(world, nodes, finalTarget, 3.0);
+  EXPECT_TRUE(verifyLossGradient(finalTracking, &rollout));
+  LossFn mappedTracking = worldSpaceBodyTrackingLoss(
+      world, nodes, trajectoryTargets, 1.0, "copy", copyMapping);
+  EXPECT_TRUE(verifyLossGradient(mappedTracking, &rollout, "copy"));
+  EXPECT_NEAR(
+      tracking.getLoss(&rollout), mappedTracking.getLoss(&rollout), 1e-12);
+  // The tracking losses set the positions of the world, and should put them
+  // back when they're done
+  EXPECT_TRUE(equals(worldPosBefore, world->getPositions(), 0));
+
+  // Evaluating the tracking loss from several threads at once shouldn't
+  // change the results, even though they all share `world`
+  TrajectoryRolloutReal serialGrad(&rollout);
+  double serialLoss = tracking.getLossAndGradient(&rollout, &serialGrad);
+  std::vector<std::shared_ptr<TrajectoryRolloutReal>> threadGrads;
+  std::vector<double> threadLosses(4);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++)
+  {
+    threadGrads.push_back(std::make_shared<TrajectoryRolloutReal>(&rollout));
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < 20; j++)
+      {
+        threadLosses[i]
+            = tracking.getLossAndGradient(&rollout, threadGrads[i].get());
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_EQ(serialLoss, threadLosses[i]);
+    EXPECT_TRUE(equals(
+        serialGrad.getPosesConst(), threadGrads[i]->getPosesConst(), 0));
+  }
+  EXPECT_TRUE(equals(worldPosBefore, world->getPositions(), 0));
+
+  // The weighted sum should match summing the terms by hand
+  LossFn sum = WeightedLossBuilder()
+                   .add(finalState, 3.0)
+                   .add(effort)
+                   .add(tracking, 0.25)
+                   .build();
+  EXPECT_TRUE(verifyLossGradient(sum, &rollout));
+  EXPECT_NEAR(
+      3.0 * finalState.getLoss(&rollout) + effort.getLoss(&rollout)
+          + 0.25 * tracking.getLoss(&rollout),
+      sum.getLoss(&rollout),
+      1e-9);
+
+  // A term with a custom gradient that only writes the blocks it depends on
+  // shouldn't pick up leftovers from the terms summed before it
+  LossFn finalPose = LossFn(
+      [](const TrajectoryRollout* rollout) {
+        int last = rollout->getPosesConst("identity").cols() - 1;
+        return rollout->getPosesConst("identity").col(last).squaredNorm();
+      },
+      [](const TrajectoryRollout* rollout,
+         /* OUT */ TrajectoryRollout* gradWrtRollout) {
+        int last = rollout->getPosesConst("identity").cols() - 1;
+        gradWrtRollout->getPoses("identity").col(last)
+            = 2 * rollout->getPosesConst("identity").col(last);
+        return rollout->getPosesConst("identity").col(last).squaredNorm();
+      });
+  LossFn partialLast
+      = WeightedLossBuilder().add(tracking).add(finalPose, 2.0).build();
+  EXPECT_TRUE(verifyLossGradient(partialLast, &rollout));
+  // The output buffer starts out holding the rollout itself, so this also
+  // checks that the first term's blocks get cleared
+  LossFn partialFirst
+      = WeightedLossBuilder().add(finalPose).add(effort, 0.5).build();
+  EXPECT_TRUE(verifyLossGradient(partialFirst, &rollout));
+
+  // The sum should also backprop through a whole shot
+  SingleShot sumShot(world, sum, steps, true);
+  sumShot.unflatten(
+      world,
+      Eigen::VectorXd::Zero(sumShot.getFlatStaticProblemDim(world)),
+      flatDynamic);
+  int dim = sumShot.getFlatProblemDim(world);
+  Eigen::VectorXd grad = Eigen::VectorXd::Zero(dim);
+  sumShot.backpropGradient(world, grad);
+  Eigen::VectorXd fdGrad = Eigen::VectorXd::Zero(dim);
+  sumShot.finiteDifferenceGradient(world, fdGrad);
+  EXPECT_TRUE(equals(grad, fdGrad, 1e-5));
+}
+#endif
+
 BodyNode* createTailSegment(BodyNode* parent, Eigen::Vector3d color)
 {
   std::pair<RevoluteJoint*, BodyNode*> poleJointPair
@@ -0,0 +1,95 @@
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/BlockDiagonalMassMatrix.hpp"
+#include "dart/simulation/World.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace neural;
+using namespace simulation;
+
+//==============================================================================
+TEST(BlockDiagonalMassMatrix, MULTIPLY_MATCHES_DENSE)
+{
+  srand(42);
+  BlockDiagonalMassMatrix M(6);
+  M.addBlock(0, Eigen::MatrixXd::Random(2, 2));
+  // This block isn't contiguous, so exercises the gather/scatter path
+  M.addBlock(std::vector<std::size_t>{2, 5}, Eigen::MatrixXd::Random(2, 2));
+  M.addBlock(3, Eigen::MatrixXd::Random(2, 2));
+
+  EXPECT_EQ(M.getNumBlocks(), 3);
+  EXPECT_EQ(M.getNumStoredCoeffs(), 12);
+
+  Eigen::MatrixXd dense = M.toDense();
+  EXPECT_EQ(dense(2, 5), M.getBlock(1)(0, 1));
+  EXPECT_EQ(dense(2, 3), 0.0);
+
+  Eigen::VectorXd v = Eigen::VectorXd::Random(6);
+  Eigen::MatrixXd X = Eigen::MatrixXd::Random(6, 4);
+  Eigen::RowVectorXd r = Eigen::RowVectorXd::Random(6);
+
+  Eigen::VectorXd Mv = M * v;
+  EXPECT_TRUE(equals(Mv, (dense * v).eval(), 1e-12));
+  Eigen::MatrixXd MX = M * X;
+  EXPECT_TRUE(equals(MX, (dense * X).eval(), 1e-12));
+  Eigen::MatrixXd XtM = X.transpose() * M;
+  EXPECT_TRUE(equals(XtM, (X.transpose() * dense).eval(), 1e-12));
+  Eigen::RowVectorXd rM = r * M;
+  EXPECT_TRUE(equals(rM, (r * dense).eval(), 1e-12));
+  Eigen::MatrixXd scaled = (0.5 * M).toDense();
+  EXPECT_TRUE(equals(scaled, (0.5 * dense).eval(), 1e-12));
+}
+
+//==============================================================================
+TEST(BlockDiagonalMassMatrix, MATCHES_WORLD_MASS_MATRIX)
+{
+  WorldPtr world = World::create();
+
+  // A free-floating box
+  SkeletonPtr box = Skeleton::create("box");
+  box->createJointAndBodyNodePair<FreeJoint>();
+  world->addSkeleton(box);
+
+  // A skeleton with two trees, where we add a link to the first tree after
+  // creating the second, so the first tree's DOFs aren't contiguous
+  SkeletonPtr twoTrees = Skeleton::create("twoTrees");
+  std::pair<RevoluteJoint*, BodyNode*> first
+      = twoTrees->createJointAndBodyNodePair<RevoluteJoint>();
+  twoTrees->createJointAndBodyNodePair<RevoluteJoint>();
+  std::pair<RevoluteJoint*, BodyNode*> firstChild
+      = twoTrees->createJointAndBodyNodePair<RevoluteJoint>(first.second);
+  firstChild.first->setAxis(Eigen::Vector3d::UnitX());
+  Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+  offset.translation() = Eigen::Vector3d(0, 0.5, 0);
+  firstChild.first->setTransformFromParentBodyNode(offset);
+  world->addSkeleton(twoTrees);
+
+  world->setPositions(Eigen::VectorXd::Random(world->getNumDofs()));
+
+  BlockDiagonalMassMatrix M = world->getBlockMassMatrix();
+  BlockDiagonalMassMatrix Minv = world->getBlockInvMassMatrix();
+
+  // One block for the box, and one for each tree of the other skeleton
+  EXPECT_EQ(M.getNumBlocks(), 3);
+  EXPECT_LT(M.getNumStoredCoeffs(), world->getNumDofs() * world->getNumDofs());
+
+  Eigen::MatrixXd denseM = world->getMassMatrix();
+  Eigen::MatrixXd denseMinv = world->getInvMassMatrix();
+  EXPECT_TRUE(equals(M.toDense(), denseM, 1e-12));
+  EXPECT_TRUE(equals(Minv.toDense(), denseMinv, 1e-12));
+
+  Eigen::MatrixXd X = Eigen::MatrixXd::Random(world->getNumDofs(), 3);
+  Eigen::MatrixXd MinvX = Minv * X;
+  EXPECT_TRUE(equals(MinvX, (denseMinv * X).eval(), 1e-12));
+  Eigen::MatrixXd XtM = X.transpose() * M;
+  EXPECT_TRUE(equals(XtM, (X.transpose() * denseM).eval(), 1e-12));
+}
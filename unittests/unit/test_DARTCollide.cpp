@@ -9,6 +9,12 @@
 
 #include "dart/collision/CollisionResult.hpp"
 #include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/collision/dart/DARTCollisionGroup.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Geometry.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -3890,6 +3896,124 @@ TEST(DARTCollide, CAPSULE_CCD_SUPPORT_FN)
 }
 #endif
 
+#ifdef ALL_TESTS
+/// This fills `group` with a pile of randomly placed boxes and spheres, some of
+/// which overlap
+std::vector<dynamics::SimpleFramePtr> createRandomPile(
+    CollisionGroup* group, int numObjects, double spread)
+{
+  std::vector<dynamics::SimpleFramePtr> frames;
+  for (int i = 0; i < numObjects; i++)
+  {
+    dynamics::SimpleFramePtr frame = std::make_shared<dynamics::SimpleFrame>(
+        dynamics::Frame::World(), "frame_" + std::to_string(i));
+    if (i % 2 == 0)
+    {
+      frame->setShape(std::make_shared<dynamics::BoxShape>(
+          Eigen::Vector3d::Random().cwiseAbs() + Eigen::Vector3d::Constant(0.2)));
+    }
+    else
+    {
+      frame->setShape(std::make_shared<dynamics::SphereShape>(
+          0.2 + 0.5 * std::abs(Eigen::Vector2d::Random()(0))));
+    }
+    Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+    transform.translation() = Eigen::Vector3d::Random() * spread;
+    transform.linear() = math::expMapRot(Eigen::Vector3d::Random());
+    frame->setRelativeTransform(transform);
+    group->addShapeFrame(frame.get());
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+/// This checks that two collision results have exactly the same contacts, in
+/// the same order
+bool contactsMatch(const CollisionResult& a, const CollisionResult& b)
+{
+  if (a.getNumContacts() != b.getNumContacts())
+  {
+    std::cout << "Got " << a.getNumContacts() << " contacts vs "
+              << b.getNumContacts() << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < a.getNumContacts(); i++)
+  {
+    const Contact& contactA = a.getContact(i);
+    const Contact& contactB = b.getContact(i);
+    if (contactA.collisionObject1 != contactB.collisionObject1
+        || contactA.collisionObject2 != contactB.collisionObject2
+        || contactA.point != contactB.point
+        || contactA.normal != contactB.normal
+        || contactA.penetrationDepth != contactB.penetrationDepth
+        || contactA.type != contactB.type)
+    {
+      std::cout << "Contact " << i << " differs" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(DARTCollide, BROADPHASE_MATCHES_BRUTE_FORCE)
+{
+  srand(42);
+  auto detector = DARTCollisionDetector::create();
+  auto group = detector->createCollisionGroup();
+  auto dartGroup = static_cast<DARTCollisionGroup*>(group.get());
+  std::vector<dynamics::SimpleFramePtr> frames
+      = createRandomPile(group.get(), 90, 4.0);
+
+  for (int trial = 0; trial < 5; trial++)
+  {
+    for (std::size_t maxContacts : {1000u, 7u})
+    {
+      CollisionOption option(true, maxContacts);
+
+      dartGroup->setBroadphaseEnabled(false);
+      CollisionResult bruteForce;
+      bool bruteForceFound = group->collide(option, &bruteForce);
+
+      dartGroup->setBroadphaseEnabled(true);
+      CollisionResult broadphase;
+      bool broadphaseFound = group->collide(option, &broadphase);
+
+      EXPECT_GT(bruteForce.getNumContacts(), 0u);
+      EXPECT_EQ(bruteForceFound, broadphaseFound);
+      EXPECT_TRUE(contactsMatch(bruteForce, broadphase));
+
+      // A binary check should agree too
+      EXPECT_EQ(
+          bruteForceFound, group->collide(CollisionOption(false, 1u), nullptr));
+    }
+
+    // Nudge everything a bit, which exercises the incremental re-sort
+    for (dynamics::SimpleFramePtr& frame : frames)
+    {
+      Eigen::Isometry3d transform = frame->getRelativeTransform();
+      transform.translation() += Eigen::Vector3d::Random() * 0.3;
+      frame->setRelativeTransform(transform);
+    }
+  }
+
+  // Checking one group against another should also match
+  auto otherGroup = detector->createCollisionGroup();
+  auto otherDartGroup = static_cast<DARTCollisionGroup*>(otherGroup.get());
+  std::vector<dynamics::SimpleFramePtr> otherFrames
+      = createRandomPile(otherGroup.get(), 30, 4.0);
+
+  CollisionOption option(true, 1000u);
+  otherDartGroup->setBroadphaseEnabled(false);
+  CollisionResult bruteForce;
+  group->collide(otherGroup.get(), option, &bruteForce);
+  otherDartGroup->setBroadphaseEnabled(true);
+  CollisionResult broadphase;
+  group->collide(otherGroup.get(), option, &broadphase);
+  EXPECT_GT(bruteForce.getNumContacts(), 0u);
+  EXPECT_TRUE(contactsMatch(bruteForce, broadphase));
+}
+#endif
+
 // The number of contacts shouldn't change under tiny perturbations to position,
 // and the contacts should move in predictable ways.
 
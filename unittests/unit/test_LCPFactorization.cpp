@@ -0,0 +1,137 @@
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "dart/neural/LCPFactorization.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace neural;
+
+//==============================================================================
+TEST(LCPFactorization, SPD_USES_LDLT)
+{
+  srand(42);
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 4);
+  Eigen::MatrixXd Q = A.transpose() * A;
+  Eigen::MatrixXd rhs = Eigen::MatrixXd::Random(4, 3);
+
+  LCPFactorization factored(Q);
+  EXPECT_TRUE(factored.isUsingLDLT());
+
+  Eigen::MatrixXd expected = Q.completeOrthogonalDecomposition().solve(rhs);
+  Eigen::MatrixXd result = factored.solve(rhs);
+  EXPECT_TRUE(equals(result, expected, 1e-9));
+
+  Eigen::MatrixXd expectedPinv
+      = Q.completeOrthogonalDecomposition().pseudoInverse();
+  Eigen::MatrixXd pinv = factored.getPseudoInverse();
+  EXPECT_TRUE(equals(pinv, expectedPinv, 1e-9));
+}
+
+//==============================================================================
+TEST(LCPFactorization, RANK_DEFICIENT_FALLS_BACK_TO_LEAST_SQUARES)
+{
+  srand(42);
+  // Q is 4x4, but only rank 2
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(2, 4);
+  Eigen::MatrixXd Q = A.transpose() * A;
+  Eigen::VectorXd b = Eigen::VectorXd::Random(4);
+
+  LCPFactorization factored(Q);
+  EXPECT_FALSE(factored.isUsingLDLT());
+
+  Eigen::VectorXd expected = Q.completeOrthogonalDecomposition().solve(b);
+  Eigen::VectorXd result = factored.solve(b);
+  EXPECT_TRUE(equals(result, expected, 1e-12));
+}
+
+//==============================================================================
+TEST(LCPFactorization, NON_SYMMETRIC_FALLS_BACK)
+{
+  srand(42);
+  // This looks like Q when there are upper bound constraints
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 4);
+  Eigen::MatrixXd B = Eigen::MatrixXd::Random(6, 4);
+  Eigen::MatrixXd Q = A.transpose() * (A + 0.5 * B);
+  Eigen::VectorXd b = Eigen::VectorXd::Random(4);
+
+  LCPFactorization factored(Q);
+  EXPECT_FALSE(factored.isUsingLDLT());
+
+  Eigen::VectorXd expected = Q.completeOrthogonalDecomposition().solve(b);
+  Eigen::VectorXd result = factored.solve(b);
+  EXPECT_TRUE(equals(result, expected, 1e-12));
+}
+
+//==============================================================================
+TEST(LCPFactorization, SOLVE_TRANSPOSE)
+{
+  srand(42);
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 4);
+  Eigen::MatrixXd B = Eigen::MatrixXd::Random(6, 4);
+  Eigen::VectorXd r = Eigen::VectorXd::Random(4);
+
+  // Symmetric, so this goes through LDLT
+  Eigen::MatrixXd Q = A.transpose() * A;
+  LCPFactorization symmetric(Q);
+  EXPECT_TRUE(symmetric.isUsingLDLT());
+  Eigen::VectorXd expected
+      = Q.transpose().completeOrthogonalDecomposition().solve(r);
+  Eigen::VectorXd result = symmetric.solveTranspose(r);
+  EXPECT_TRUE(equals(result, expected, 1e-9));
+
+  // Non-symmetric, so this goes through the pseudo-inverse
+  Q = A.transpose() * (A + 0.5 * B);
+  LCPFactorization nonSymmetric(Q);
+  EXPECT_FALSE(nonSymmetric.isUsingLDLT());
+  expected = Q.transpose().completeOrthogonalDecomposition().solve(r);
+  result = nonSymmetric.solveTranspose(r);
+  EXPECT_TRUE(equals(result, expected, 1e-9));
+
+  // solveTranspose() should be the adjoint of solve()
+  Eigen::VectorXd x = Eigen::VectorXd::Random(4);
+  EXPECT_NEAR(
+      r.dot(nonSymmetric.solve(x)),
+      nonSymmetric.solveTranspose(r).dot(x),
+      1e-9);
+}
+
+//==============================================================================
+TEST(LCPFactorization, CACHE_REUSES_IDENTICAL_MATRICES)
+{
+  srand(42);
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 4);
+  Eigen::MatrixXd Q = A.transpose() * A;
+
+  LCPFactorizationCache cache(2);
+  std::shared_ptr<const LCPFactorization> first = cache.factor(Q);
+  std::shared_ptr<const LCPFactorization> second = cache.factor(Q);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache.getNumHits(), 1);
+  EXPECT_EQ(cache.getNumMisses(), 1);
+
+  // Even a tiny change to Q has to be refactored
+  Eigen::MatrixXd perturbed = Q;
+  perturbed(0, 0) += 1e-12;
+  std::shared_ptr<const LCPFactorization> third = cache.factor(perturbed);
+  EXPECT_NE(first, third);
+  EXPECT_EQ(cache.getNumMisses(), 2);
+
+  // A warm-started cache shares the factorizations it started with, but
+  // doesn't share later insertions with the original
+  LCPFactorizationCache warmStarted(cache);
+  EXPECT_EQ(warmStarted.factor(Q), first);
+  EXPECT_EQ(warmStarted.getNumHits(), 1);
+  EXPECT_EQ(warmStarted.getNumMisses(), 0);
+
+  Eigen::MatrixXd other = 2 * Q;
+  warmStarted.factor(other);
+  cache.factor(other);
+  EXPECT_EQ(cache.getNumMisses(), 3);
+
+  // The capacity is respected, evicting the least recently used entry
+  cache.factor(Q);
+  EXPECT_EQ(cache.getNumMisses(), 4);
+}
@@ -757,4 +757,36 @@ TEST(LCP_UTILS, BLOCK_SYMMETRIC_CASE)
   std::cout << "filtered x:" << std::endl << fx << std::endl;
   std::cout << "A * fx:" << std::endl << A * fx << std::endl;
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, IS_REDUCIBLE)
+{
+  Eigen::MatrixXd A = Eigen::MatrixXd::Zero(6, 6);
+  // clang-format off
+  A <<
+  0.0424296,  -0.0139791,  0,  0.0424296,  -0.0139791,  0,
+  -0.0139791,  0.0698999,  0,  -0.0139791,  0.0698999,  0,
+  0,  0,  0,  0,  0,  0,
+  0.0424296,  -0.0139791,  0,  0.0424296,  -0.0139791,  0,
+  -0.0139791,  0.0698999,  0,  -0.0139791,  0.0698999,  0,
+  0,  0,  0,  0,  0,  0;
+  // clang-format on
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(6);
+  Eigen::VectorXd lo = Eigen::VectorXd::Zero(6);
+  lo << 0, -1, -1, 0, -1, -1;
+  Eigen::VectorXd hi = Eigen::VectorXd::Zero(6);
+  hi << std::numeric_limits<double>::infinity(), 1, 1,
+      std::numeric_limits<double>::infinity(), 1, 1;
+  Eigen::VectorXd b = Eigen::VectorXd::Zero(6);
+  b << 1.67162, 2.08376, 0, 1.67162, 2.08376, 0;
+  Eigen::VectorXi fIndex = Eigen::VectorXi::Zero(6);
+  fIndex << -1, 0, 0, -1, 0, 0;
+
+  EXPECT_TRUE(LCPUtils::isReducible(A, b, hi, lo, fIndex));
+
+  // Once reduced, there's nothing left to merge
+  LCPUtils::reduce(A, x, b, hi, lo, fIndex);
+  EXPECT_TRUE(A.cols() < 6);
+  EXPECT_FALSE(LCPUtils::isReducible(A, b, hi, lo, fIndex));
+}
+#endif
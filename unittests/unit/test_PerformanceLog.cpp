@@ -31,6 +31,8 @@
  */
 
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <PerfUtils/TimeTrace.h>
 #include <gtest/gtest.h>
@@ -95,3 +97,108 @@ TEST(PERFORMANCE, NESTED)
 
   std::cout << finalizedRoot->prettyPrint() << std::endl;
 }
+
+TEST(PERFORMANCE, MULTI_THREADED)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([root]() {
+      PerformanceLog* worker = root->startRun("worker");
+      for (int i = 0; i < 1000; i++)
+      {
+        PerformanceLog* child = worker->startRun("child");
+        child->end();
+      }
+      worker->end();
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  std::shared_ptr<FinalizedPerformanceLog> finalizedRoot
+      = finalizedRoots["root"];
+  EXPECT_EQ(finalizedRoot->getNumRuns(), 1);
+  // Runs on different threads can share an index within their own buffers,
+  // so this catches ids getting truncated and matching the wrong parent
+  EXPECT_EQ(finalizedRoot->getNumChildren(), 1);
+  EXPECT_EQ(finalizedRoot->getChild("worker")->getNumRuns(), 4);
+  EXPECT_EQ(finalizedRoot->getChild("worker")->getNumChildren(), 1);
+  EXPECT_EQ(
+      finalizedRoot->getChild("worker")->getChild("child")->getNumRuns(),
+      4000);
+}
+
+TEST(PERFORMANCE, SINGLE_WORKER_THREAD)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  std::thread thread([root]() {
+    PerformanceLog* worker = root->startRun("worker");
+    PerformanceLog* child = worker->startRun("child");
+    child->end();
+    worker->end();
+  });
+  thread.join();
+  root->end();
+
+  std::shared_ptr<FinalizedPerformanceLog> finalizedRoot
+      = PerformanceLog::finalize()["root"];
+  EXPECT_EQ(finalizedRoot->getNumChildren(), 1);
+  EXPECT_EQ(finalizedRoot->getChild("child"), nullptr);
+  std::shared_ptr<FinalizedPerformanceLog> worker
+      = finalizedRoot->getChild("worker");
+  ASSERT_NE(worker, nullptr);
+  EXPECT_EQ(worker->getNumRuns(), 1);
+  EXPECT_EQ(worker->getNumChildren(), 1);
+  EXPECT_EQ(worker->getChild("worker"), nullptr);
+  EXPECT_EQ(worker->getChild("child")->getNumRuns(), 1);
+}
+
+TEST(PERFORMANCE, INITIALIZE_CLEARS)
+{
+  PerformanceLog::initialize();
+  PerformanceLog::startRoot("old")->end();
+  PerformanceLog::initialize();
+  PerformanceLog::startRoot("new")->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  EXPECT_EQ(finalizedRoots.count("new"), 1);
+}
+
+TEST(PERFORMANCE, EXPORT_TRACES)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  for (int i = 0; i < 3; i++)
+  {
+    PerformanceLog* child = root->startRun("child");
+    child->end();
+  }
+  // This never ends, so it shouldn't show up
+  root->startRun("unfinished");
+  root->end();
+
+  std::string trace = PerformanceLog::toChromeTrace();
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+  EXPECT_NE(trace.find("\"name\":\"root\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"child\""), std::string::npos);
+  EXPECT_EQ(trace.find("unfinished"), std::string::npos);
+
+  std::string stacks = PerformanceLog::toCollapsedStacks();
+  EXPECT_EQ(stacks.find("root "), 0);
+  EXPECT_NE(stacks.find("\nroot;child "), std::string::npos);
+  EXPECT_EQ(stacks.find("unfinished"), std::string::npos);
+  std::cout << trace << std::endl << stacks << std::endl;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/server/RawBinaryUtils.hpp"
+
+using namespace dart;
+
+namespace {
+
+std::uint32_t readUint32(const std::string& frame, std::size_t offset)
+{
+  const unsigned char* bytes
+      = reinterpret_cast<const unsigned char*>(frame.data()) + offset;
+  return static_cast<std::uint32_t>(bytes[0])
+         | (static_cast<std::uint32_t>(bytes[1]) << 8)
+         | (static_cast<std::uint32_t>(bytes[2]) << 16)
+         | (static_cast<std::uint32_t>(bytes[3]) << 24);
+}
+
+float readFloat32(const std::string& frame, std::size_t offset)
+{
+  std::uint32_t bits = readUint32(frame, offset);
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(RawBinaryUtils, EMPTY_FRAME)
+{
+  std::string frame = encodeObjectTransformsBinary({});
+  EXPECT_EQ(BINARY_TRANSFORMS_HEADER_SIZE, frame.size());
+  EXPECT_EQ(BINARY_SET_OBJECT_TRANSFORMS, readUint32(frame, 0));
+  EXPECT_EQ(0u, readUint32(frame, 4));
+}
+
+//==============================================================================
+TEST(RawBinaryUtils, RECORD_LAYOUT)
+{
+  std::vector<ObjectTransformUpdate> updates(2);
+  updates[0].id = 7;
+  updates[0].fields = TRANSFORM_POS | TRANSFORM_COLOR;
+  updates[0].pos = Eigen::Vector3d(1.5, -2.0, 0.25);
+  updates[0].euler = Eigen::Vector3d::Zero();
+  updates[0].color = Eigen::Vector3d(0.1, 0.2, 0.3);
+  updates[1].id = 300000;
+  updates[1].fields = TRANSFORM_EULER;
+  updates[1].pos = Eigen::Vector3d::Zero();
+  updates[1].euler = Eigen::Vector3d(3.0, 2.0, 1.0);
+  updates[1].color = Eigen::Vector3d::Zero();
+
+  std::string frame = encodeObjectTransformsBinary(updates);
+  ASSERT_EQ(
+      BINARY_TRANSFORMS_HEADER_SIZE + 2 * BINARY_TRANSFORM_RECORD_SIZE,
+      frame.size());
+  EXPECT_EQ(BINARY_SET_OBJECT_TRANSFORMS, readUint32(frame, 0));
+  EXPECT_EQ(2u, readUint32(frame, 4));
+
+  for (std::size_t i = 0; i < updates.size(); i++)
+  {
+    std::size_t offset
+        = BINARY_TRANSFORMS_HEADER_SIZE + i * BINARY_TRANSFORM_RECORD_SIZE;
+    EXPECT_EQ(updates[i].id, readUint32(frame, offset));
+    EXPECT_EQ(updates[i].fields, readUint32(frame, offset + 4));
+    for (int j = 0; j < 3; j++)
+    {
+      EXPECT_EQ(
+          static_cast<float>(updates[i].pos(j)),
+          readFloat32(frame, offset + 8 + 4 * j));
+      EXPECT_EQ(
+          static_cast<float>(updates[i].euler(j)),
+          readFloat32(frame, offset + 20 + 4 * j));
+      EXPECT_EQ(
+          static_cast<float>(updates[i].color(j)),
+          readFloat32(frame, offset + 32 + 4 * j));
+    }
+  }
+}
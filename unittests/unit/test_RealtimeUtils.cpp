@@ -40,6 +40,7 @@
 #include "dart/realtime/ControlLog.hpp"
 #include "dart/realtime/ObservationLog.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/SPSCRingBuffer.hpp"
 #include "dart/realtime/VectorLog.hpp"
 #include "dart/simulation/World.hpp"
 
@@ -184,6 +185,25 @@ TEST(REALTIME, CONTROL_LOG_DISCARD_BEFORE_OFF_TIMESTEP)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_LOG_DISCARD_BEFORE_KEEPS_CURRENT)
+{
+  int dim = 2;
+  int dt = 5;
+  ControlLog log = ControlLog(dim, dt);
+  log.record(0L, Eigen::VectorXd::Ones(dim) * 1);
+  log.record(20L, Eigen::VectorXd::Ones(dim) * 3);
+  // The control recorded at 0L is still in effect at 10L, so it has to survive
+  log.discardBefore(10L);
+
+  EXPECT_DOUBLE_EQ(1.0, log.get(10L)(0));
+  EXPECT_DOUBLE_EQ(1.0, log.get(12L)(0));
+  EXPECT_DOUBLE_EQ(1.0, log.get(19L)(0));
+  EXPECT_DOUBLE_EQ(3.0, log.get(20L)(0));
+  EXPECT_DOUBLE_EQ(3.0, log.get(24L)(0));
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_LOG_GET_EMPTY)
 {
@@ -197,6 +217,129 @@ TEST(REALTIME, CONTROL_LOG_GET_EMPTY)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_LOG_BOUNDED)
+{
+  int dim = 2;
+  int dt = 5;
+  ControlLog log = ControlLog(dim, dt, 16);
+  for (int i = 0; i < 1000; i++)
+  {
+    log.record(i * dt, Eigen::VectorXd::Ones(dim) * i);
+  }
+
+  // Old controls fall off the back, and we extend the oldest one we still have
+  EXPECT_DOUBLE_EQ(984.0, log.get(0L)(0));
+  EXPECT_DOUBLE_EQ(990.0, log.get(990L * dt + 2)(0));
+  EXPECT_DOUBLE_EQ(999.0, log.get(2000L * dt)(0));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, RING_BUFFER_WRAP)
+{
+  SPSCRingBuffer buffer = SPSCRingBuffer(3, 8);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(-1, buffer.findLastAtOrBefore(100L));
+
+  for (int i = 0; i < 20; i++)
+  {
+    buffer.push(i * 10L, Eigen::VectorXd::Ones(3) * i);
+  }
+  EXPECT_EQ(12, buffer.begin());
+  EXPECT_EQ(20, buffer.end());
+
+  long time;
+  Eigen::VectorXd value;
+  // Overwritten entries can't be read any more
+  EXPECT_FALSE(buffer.read(4, time, value));
+  EXPECT_TRUE(buffer.read(15, time, value));
+  EXPECT_EQ(150L, time);
+  EXPECT_TRUE(equals(Eigen::VectorXd(Eigen::VectorXd::Ones(3) * 15), value));
+
+  EXPECT_EQ(-1, buffer.findLastAtOrBefore(100L));
+  EXPECT_EQ(12, buffer.findLastAtOrBefore(120L));
+  EXPECT_EQ(15, buffer.findLastAtOrBefore(159L));
+  EXPECT_EQ(19, buffer.findLastAtOrBefore(1000L));
+
+  buffer.discardBefore(17);
+  EXPECT_EQ(17, buffer.begin());
+  EXPECT_EQ(-1, buffer.findLastAtOrBefore(160L));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, RING_BUFFER_CONCURRENT)
+{
+  int dim = 16;
+  int numPushes = 200000;
+  SPSCRingBuffer buffer = SPSCRingBuffer(dim, 64);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < numPushes; i++)
+    {
+      buffer.push(i, Eigen::VectorXd::Ones(dim) * i);
+    }
+  });
+
+  // Every read that succeeds must see a whole entry, never a mix of two
+  long time;
+  Eigen::VectorXd value;
+  long lastTime = -1;
+  bool torn = false;
+  bool outOfOrder = false;
+  while (buffer.end() < numPushes)
+  {
+    long index = buffer.findLastAtOrBefore(numPushes);
+    if (index == -1 || !buffer.read(index, time, value))
+      continue;
+    if (!equals(Eigen::VectorXd(Eigen::VectorXd::Ones(dim) * time), value))
+      torn = true;
+    if (time < lastTime)
+      outOfOrder = true;
+    lastTime = time;
+  }
+  producer.join();
+
+  EXPECT_FALSE(torn);
+  EXPECT_FALSE(outOfOrder);
+  EXPECT_TRUE(buffer.read(numPushes - 1, time, value));
+  EXPECT_EQ(numPushes - 1, time);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, OBSERVATION_LOG_CLOSEST)
+{
+  ObservationLog log = ObservationLog(
+      0L,
+      Eigen::VectorXd::Zero(2),
+      Eigen::VectorXd::Zero(2),
+      Eigen::VectorXd::Ones(1));
+  for (int i = 1; i < 100; i++)
+  {
+    log.observe(
+        i * 10L,
+        Eigen::VectorXd::Ones(2) * i,
+        Eigen::VectorXd::Ones(2) * -i,
+        Eigen::VectorXd::Ones(1));
+  }
+
+  Observation obs = log.getClosestObservationBefore(505L);
+  EXPECT_EQ(500L, obs.time);
+  EXPECT_TRUE(equals(Eigen::VectorXd(Eigen::VectorXd::Ones(2) * 50), obs.pos));
+  EXPECT_TRUE(
+      equals(Eigen::VectorXd(Eigen::VectorXd::Ones(2) * -50), obs.vel));
+
+  log.discardBefore(505L);
+  obs = log.getClosestObservationBefore(2000L);
+  EXPECT_EQ(990L, obs.time);
+  // Asking before the start of the log gets the oldest we have left
+  obs = log.getClosestObservationBefore(0L);
+  EXPECT_EQ(510L, obs.time);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_BUFFER)
 {
@@ -0,0 +1,174 @@
+#include <iostream>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/EulerJoint.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Inertia.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/WithRespectTo.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace neural;
+
+/******************************************************************************
+
+This builds a small branching skeleton with a mix of joint types, offsets
+between the joints, off-center masses and non-trivial inertias, so that every
+term of the inverse dynamics shows up in the Jacobians.
+
+*/
+template <typename JointType>
+BodyNode* addBody(
+    SkeletonPtr skel,
+    BodyNode* parent,
+    const std::string& name,
+    const Eigen::Vector3d& offset)
+{
+  typename JointType::Properties jointProps;
+  jointProps.mName = name + "_joint";
+  jointProps.mT_ParentBodyToJoint.translation() = offset;
+  jointProps.mT_ParentBodyToJoint.linear()
+      = math::expMapRot(Eigen::Vector3d(0.1, -0.2, 0.3));
+  jointProps.mT_ChildBodyToJoint.translation()
+      = Eigen::Vector3d(0.05, -0.1, 0.02);
+
+  BodyNode::Properties bodyProps;
+  bodyProps.mName = name;
+
+  BodyNode* body = skel->createJointAndBodyNodePair<JointType>(
+                           parent, jointProps, bodyProps)
+                       .second;
+  // mass, COM, then the diagonal and off-diagonal moments
+  body->setInertia(dynamics::Inertia(
+      1.5, 0.1, -0.05, 0.2, 0.3, 0.4, 0.5, 0.01, -0.02, 0.03));
+  return body;
+}
+
+SkeletonPtr createMixedSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("mixed");
+  BodyNode* root = addBody<FreeJoint>(
+      skel, nullptr, "root", Eigen::Vector3d(0.0, 0.0, 1.0));
+  BodyNode* arm = addBody<RevoluteJoint>(
+      skel, root, "arm", Eigen::Vector3d(0.3, 0.0, 0.0));
+  addBody<BallJoint>(skel, arm, "hand", Eigen::Vector3d(0.0, 0.4, 0.0));
+  addBody<PrismaticJoint>(
+      skel, root, "leg", Eigen::Vector3d(0.0, -0.2, -0.3));
+
+  skel->setGravity(Eigen::Vector3d(0, -9.81, 0));
+  skel->setPositions(
+      Eigen::VectorXd::LinSpaced(skel->getNumDofs(), -0.5, 0.7));
+  skel->setVelocities(
+      Eigen::VectorXd::LinSpaced(skel->getNumDofs(), 1.2, -0.8));
+  return skel;
+}
+
+//==============================================================================
+void expectMatch(
+    const Eigen::MatrixXd& analytical,
+    const Eigen::MatrixXd& fd,
+    double threshold)
+{
+  if (!equals(analytical, fd, threshold))
+  {
+    std::cout << "Analytical:" << std::endl << analytical << std::endl;
+    std::cout << "Finite difference:" << std::endl << fd << std::endl;
+    std::cout << "Diff:" << std::endl << analytical - fd << std::endl;
+  }
+  EXPECT_TRUE(equals(analytical, fd, threshold));
+}
+
+//==============================================================================
+TEST(SkeletonGradients, JACOBIAN_OF_C)
+{
+  SkeletonPtr skel = createMixedSkeleton();
+  EXPECT_TRUE(
+      skel->canComputeAnalyticalJacobianOfID(WithRespectTo::POSITION));
+  EXPECT_TRUE(
+      skel->canComputeAnalyticalJacobianOfID(WithRespectTo::VELOCITY));
+
+  expectMatch(
+      skel->getJacobianOfC(WithRespectTo::POSITION),
+      skel->finiteDifferenceJacobianOfC(WithRespectTo::POSITION),
+      1e-6);
+  expectMatch(
+      skel->getJacobianOfC(WithRespectTo::VELOCITY),
+      skel->finiteDifferenceJacobianOfC(WithRespectTo::VELOCITY),
+      1e-6);
+  expectMatch(
+      skel->getVelCJacobian(), skel->finiteDifferenceVelCJacobian(), 1e-6);
+}
+
+//==============================================================================
+TEST(SkeletonGradients, JACOBIAN_OF_MINV)
+{
+  SkeletonPtr skel = createMixedSkeleton();
+  Eigen::VectorXd f
+      = Eigen::VectorXd::LinSpaced(skel->getNumDofs(), 2.0, -3.0);
+
+  expectMatch(
+      skel->getJacobianOfMinv(f, WithRespectTo::POSITION),
+      skel->finiteDifferenceJacobianOfMinv(f, WithRespectTo::POSITION),
+      1e-5);
+  EXPECT_TRUE(skel->getJacobianOfMinv(f, WithRespectTo::VELOCITY).isZero());
+}
+
+//==============================================================================
+TEST(SkeletonGradients, JACOBIANS_WRT_MASS)
+{
+  SkeletonPtr skel = createMixedSkeleton();
+  Eigen::VectorXd f
+      = Eigen::VectorXd::LinSpaced(skel->getNumDofs(), 2.0, -3.0);
+
+  std::shared_ptr<WithRespectToMass> mass
+      = std::make_shared<WithRespectToMass>();
+  Eigen::VectorXd bounds = Eigen::VectorXd::Ones(10) * 100;
+  mass->registerNode(skel->getBodyNode("root"), INERTIA_FULL, bounds, -bounds);
+  mass->registerNode(
+      skel->getBodyNode("hand"),
+      INERTIA_COM,
+      bounds.head<3>(),
+      -bounds.head<3>());
+  mass->registerNode(
+      skel->getBodyNode("leg"),
+      INERTIA_MASS,
+      bounds.head<1>(),
+      -bounds.head<1>());
+  EXPECT_TRUE(skel->canComputeAnalyticalJacobianOfID(mass.get()));
+
+  expectMatch(
+      skel->getJacobianOfC(mass.get()),
+      skel->finiteDifferenceJacobianOfC(mass.get()),
+      1e-6);
+  expectMatch(
+      skel->getJacobianOfMinv(f, mass.get()),
+      skel->finiteDifferenceJacobianOfMinv(f, mass.get()),
+      1e-5);
+}
+
+//==============================================================================
+TEST(SkeletonGradients, FALLS_BACK_FOR_UNSUPPORTED_JOINTS)
+{
+  SkeletonPtr skel = createMixedSkeleton();
+  addBody<EulerJoint>(
+      skel, skel->getBodyNode("leg"), "foot", Eigen::Vector3d(0.0, 0.0, -0.4));
+  skel->setVelocities(
+      Eigen::VectorXd::LinSpaced(skel->getNumDofs(), 1.2, -0.8));
+  EXPECT_FALSE(
+      skel->canComputeAnalyticalJacobianOfID(WithRespectTo::POSITION));
+
+  expectMatch(
+      skel->getJacobianOfC(WithRespectTo::POSITION),
+      skel->finiteDifferenceJacobianOfC(WithRespectTo::POSITION),
+      1e-9);
+}
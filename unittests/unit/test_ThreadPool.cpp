@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/ThreadPool.hpp"
+
+using namespace dart;
+using namespace common;
+
+//==============================================================================
+TEST(ThreadPool, PARALLEL_FOR_VISITS_EVERY_INDEX_ONCE)
+{
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.getNumThreads(), 4u);
+
+  std::vector<std::atomic<int>> visits(1000);
+  for (std::atomic<int>& visit : visits)
+    visit = 0;
+  pool.parallelFor(visits.size(), [&](std::size_t i) { visits[i]++; });
+
+  for (std::atomic<int>& visit : visits)
+    EXPECT_EQ(visit.load(), 1);
+}
+
+//==============================================================================
+TEST(ThreadPool, PINNED_TASKS_RUN_ON_THEIR_WORKER)
+{
+  ThreadPool pool(3);
+  EXPECT_EQ(pool.getCurrentWorkerIndex(), -1);
+
+  std::vector<int> ranOn(30, -1);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < ranOn.size(); i++)
+  {
+    futures.push_back(pool.submitToWorker(
+        i, [&, i]() { ranOn[i] = pool.getCurrentWorkerIndex(); }));
+  }
+  for (std::future<void>& future : futures)
+    future.wait();
+
+  for (int i = 0; i < ranOn.size(); i++)
+    EXPECT_EQ(ranOn[i], i % 3);
+}
+
+//==============================================================================
+TEST(ThreadPool, NESTED_PARALLEL_FOR_DOES_NOT_DEADLOCK)
+{
+  ThreadPool pool(2);
+  std::atomic<int> count(0);
+  pool.parallelFor(4, [&](std::size_t) {
+    pool.parallelFor(4, [&](std::size_t) { count++; });
+  });
+  EXPECT_EQ(count.load(), 16);
+}
+
+//==============================================================================
+TEST(ThreadPool, PARALLEL_FOR_RETHROWS)
+{
+  ThreadPool pool(2);
+  std::atomic<int> count(0);
+  EXPECT_THROW(
+      pool.parallelFor(
+          10,
+          [&](std::size_t i) {
+            count++;
+            if (i == 3)
+              throw std::runtime_error("Failed");
+          }),
+      std::runtime_error);
+  // Every call still ran before the exception was rethrown
+  EXPECT_EQ(count.load(), 10);
+}
+
+//==============================================================================
+TEST(ThreadPool, IDLE_WORKERS_STEAL_FROM_BLOCKED_WORKERS)
+{
+  ThreadPool pool(2);
+
+  // Whichever worker picks this up is stuck until we release it, so the other
+  // worker has to steal everything that got queued behind it
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::future<void> blocker = pool.submit([released]() { released.wait(); });
+
+  std::atomic<int> count(0);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 100; i++)
+    futures.push_back(pool.submit([&]() { count++; }));
+
+  bool allRan = true;
+  for (std::future<void>& future : futures)
+  {
+    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+      allRan = false;
+  }
+  release.set_value();
+  blocker.wait();
+  for (std::future<void>& future : futures)
+    future.wait();
+
+  EXPECT_TRUE(allRan);
+  EXPECT_EQ(count.load(), 100);
+}
+
+//==============================================================================
+TEST(ThreadPool, SUBMIT_FROM_MANY_THREADS)
+{
+  ThreadPool pool(4);
+  std::atomic<int> count(0);
+
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < 4; t++)
+  {
+    submitters.emplace_back([&, t]() {
+      std::vector<std::future<void>> futures;
+      for (int i = 0; i < 500; i++)
+      {
+        if (i % 5 == 0)
+          futures.push_back(pool.submitToWorker(t, [&]() { count++; }));
+        else
+          futures.push_back(pool.submit([&]() { count++; }));
+      }
+      for (std::future<void>& future : futures)
+        future.wait();
+    });
+  }
+  for (std::thread& submitter : submitters)
+    submitter.join();
+
+  EXPECT_EQ(count.load(), 2000);
+}
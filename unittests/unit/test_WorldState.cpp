@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
+#include "dart/neural/WorldState.hpp"
+#include "dart/simulation/World.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace neural;
+
+namespace {
+
+WorldPtr createCartpoleWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  sledPair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.5, 0.1, 0.1)));
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  armPair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.1, 1.0, 0.1)));
+
+  world->addSkeleton(cartpole);
+
+  world->tuneMass(
+      armPair.second,
+      WrtMassBodyNodeEntryType::INERTIA_MASS,
+      Eigen::VectorXd::Ones(1) * 3.0,
+      Eigen::VectorXd::Ones(1) * 0.2);
+
+  return world;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(WORLD_STATE, SAVE_AND_RESTORE)
+{
+  WorldPtr world = createCartpoleWorld();
+  world->setPositions(Eigen::Vector2d(0.3, -0.2));
+  world->setVelocities(Eigen::Vector2d(1.5, 0.7));
+  world->setExternalForces(Eigen::Vector2d(2.0, 0.0));
+  world->setMasses(Eigen::VectorXd::Ones(1) * 1.7);
+  world->setCachedLCPSolution(Eigen::Vector3d(0.1, 0.2, 0.3));
+
+  WorldState state(world);
+  EXPECT_EQ(2, state.getNumDofs());
+  EXPECT_EQ(1, state.getMassDims());
+  EXPECT_EQ(3, state.getLCPCacheSize());
+  EXPECT_EQ(2 * 3 + 1 + 3, state.getBuffer().size());
+  EXPECT_EQ(world->getPositions(), state.getPositions());
+  EXPECT_EQ(world->getVelocities(), state.getVelocities());
+  EXPECT_EQ(world->getExternalForces(), state.getExternalForces());
+  EXPECT_EQ(world->getMasses(), state.getMasses());
+  EXPECT_EQ(world->getCachedLCPSolution(), state.getCachedLCPSolution());
+
+  // Scribble over the world, then restore it
+  WorldState original = state;
+  world->setPositions(Eigen::Vector2d::Random());
+  world->setVelocities(Eigen::Vector2d::Random());
+  world->setExternalForces(Eigen::Vector2d::Random());
+  world->setMasses(Eigen::VectorXd::Ones(1) * 0.5);
+  world->setCachedLCPSolution(Eigen::VectorXd::Zero(0));
+
+  state.restore(world);
+  EXPECT_EQ(original.getPositions(), world->getPositions());
+  EXPECT_EQ(original.getVelocities(), world->getVelocities());
+  EXPECT_EQ(original.getExternalForces(), world->getExternalForces());
+  EXPECT_EQ(original.getMasses(), world->getMasses());
+  EXPECT_EQ(original.getCachedLCPSolution(), world->getCachedLCPSolution());
+}
+
+//==============================================================================
+TEST(WORLD_STATE, RESTORE_INTO_WORKER_WORLD)
+{
+  WorldPtr world = createCartpoleWorld();
+  WorldPtr worker = world->clone();
+  WorldState state;
+
+  // Syncing a worker world should give the same rollout as a fresh clone,
+  // even after the worker has been stepped around in some other state
+  for (int i = 0; i < 3; i++)
+  {
+    world->setPositions(Eigen::Vector2d::Random());
+    world->setVelocities(Eigen::Vector2d::Random());
+    world->setExternalForces(Eigen::Vector2d::Random());
+    world->setMasses(Eigen::VectorXd::Ones(1) * (1.0 + i));
+    for (int t = 0; t < 5; t++)
+    {
+      worker->step();
+    }
+
+    state.save(world);
+    EXPECT_TRUE(state.isCompatible(worker));
+    state.restore(worker);
+    WorldPtr clone = world->clone();
+
+    for (int t = 0; t < 10; t++)
+    {
+      worker->step();
+      clone->step();
+    }
+    EXPECT_TRUE(worker->getPositions().isApprox(clone->getPositions()));
+    EXPECT_TRUE(worker->getVelocities().isApprox(clone->getVelocities()));
+    EXPECT_EQ(worker->getMasses(), clone->getMasses());
+  }
+
+  WorldPtr other = World::create();
+  EXPECT_FALSE(state.isCompatible(other));
+}